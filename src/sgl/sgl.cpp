@@ -2375,6 +2375,371 @@ double distance(const geometry* lhs_p, const geometry* rhs_p) {
 }
 
 
+//----------------------------------------------------------------------------------------------------------------------
+// Point Location
+//----------------------------------------------------------------------------------------------------------------------
+// The orientation test and the ray crossing rules follow GEOS (Orientation::index and RayCrossingCounter), so that
+// points on, or very close to, an edge are located the same way as GEOS would locate them.
+
+struct dd_real {
+	double hi;
+	double lo;
+};
+
+static dd_real dd_normalize(double hi, double lo) {
+	const auto s = hi + lo;
+	return {s, lo - (s - hi)};
+}
+
+// Exact difference of two doubles
+static dd_real dd_diff(double a, double b) {
+	const auto s = a - b;
+	const auto bb = s - a;
+	return {s, (a - (s - bb)) - (b + bb)};
+}
+
+static dd_real dd_sub(const dd_real &a, const dd_real &b) {
+	const auto s = dd_diff(a.hi, b.hi);
+	return dd_normalize(s.hi, s.lo + (a.lo - b.lo));
+}
+
+static dd_real dd_mul(const dd_real &a, const dd_real &b) {
+	const auto p = a.hi * b.hi;
+	const auto err = std::fma(a.hi, b.hi, -p);
+	return dd_normalize(p, err + (a.hi * b.lo + a.lo * b.hi));
+}
+
+// Returns 1 if q is to the left of p1 -> p2, -1 if it is to the right and 0 if the three are collinear
+static int orientation_index(const vertex_xy &p1, const vertex_xy &p2, const vertex_xy &q) {
+	// Fast path, only fails when the determinant is very close to zero
+	const auto det_l = (p1.x - q.x) * (p2.y - q.y);
+	const auto det_r = (p1.y - q.y) * (p2.x - q.x);
+	const auto det = det_l - det_r;
+
+	double det_sum;
+	if (det_l > 0.0) {
+		if (det_r <= 0.0) {
+			return (det > 0.0) - (det < 0.0);
+		}
+		det_sum = det_l + det_r;
+	} else if (det_l < 0.0) {
+		if (det_r >= 0.0) {
+			return (det > 0.0) - (det < 0.0);
+		}
+		det_sum = -det_l - det_r;
+	} else {
+		return (det > 0.0) - (det < 0.0);
+	}
+
+	const auto err_bound = 1e-15 * det_sum;
+	if (det >= err_bound || -det >= err_bound) {
+		return (det > 0.0) - (det < 0.0);
+	}
+
+	// Slow path, compute the determinant in double-double precision
+	const auto dx1 = dd_diff(p2.x, p1.x);
+	const auto dy1 = dd_diff(p2.y, p1.y);
+	const auto dx2 = dd_diff(q.x, p2.x);
+	const auto dy2 = dd_diff(q.y, p2.y);
+	const auto dd_det = dd_sub(dd_mul(dx1, dy2), dd_mul(dy1, dx2));
+	if (dd_det.hi != 0.0) {
+		return (dd_det.hi > 0.0) - (dd_det.hi < 0.0);
+	}
+	return (dd_det.lo > 0.0) - (dd_det.lo < 0.0);
+}
+
+static bool is_point_on_segment(const vertex_xy &p, const vertex_xy &a, const vertex_xy &b) {
+	if (p.x < std::min(a.x, b.x) || p.x > std::max(a.x, b.x) || p.y < std::min(a.y, b.y) ||
+	    p.y > std::max(a.y, b.y)) {
+		return false;
+	}
+	return orientation_index(a, b, p) == 0;
+}
+
+// Counts the crossings of the edges of a polygon with a ray from the point towards positive x
+struct ray_crossing_counter {
+	vertex_xy point;
+	uint32_t crossings;
+	bool on_boundary;
+};
+
+static void ray_crossing_count(ray_crossing_counter *counter, const vertex_xy &p1, const vertex_xy &p2) {
+	const auto &p = counter->point;
+
+	// The segment is strictly to the left of the point
+	if (p1.x < p.x && p2.x < p.x) {
+		return;
+	}
+
+	// The point is on the end vertex of the segment (the start vertex is the end of the previous one)
+	if (p == p2) {
+		counter->on_boundary = true;
+		return;
+	}
+
+	// Horizontal segment at the height of the point
+	if (p1.y == p.y && p2.y == p.y) {
+		if (std::min(p1.x, p2.x) <= p.x && p.x <= std::max(p1.x, p2.x)) {
+			counter->on_boundary = true;
+		}
+		return;
+	}
+
+	// Segment that crosses the ray. The upper vertex is excluded, so that a ray through a vertex is only counted once
+	if ((p1.y > p.y && p2.y <= p.y) || (p2.y > p.y && p1.y <= p.y)) {
+		auto orientation = orientation_index(p1, p2, p);
+		if (orientation == 0) {
+			counter->on_boundary = true;
+			return;
+		}
+		if (p2.y < p1.y) {
+			orientation = -orientation;
+		}
+		if (orientation > 0) {
+			counter->crossings++;
+		}
+	}
+}
+
+static point_location ray_crossing_get_location(const ray_crossing_counter *counter) {
+	if (counter->on_boundary) {
+		return point_location::BOUNDARY;
+	}
+	return (counter->crossings % 2) == 1 ? point_location::INTERIOR : point_location::EXTERIOR;
+}
+
+// Visit every edge of every ring of a POLYGON or MULTI_POLYGON.
+// Returns false if a ring has too few vertices or is not closed.
+template <class CALLBACK>
+static bool try_visit_polygon_edges(const geometry *geom, CALLBACK &&callback) {
+	const auto tail = geom->get_last_part();
+	if (!tail) {
+		return true;
+	}
+
+	if (geom->get_type() == geometry_type::MULTI_POLYGON) {
+		auto part = tail;
+		do {
+			part = part->get_next();
+			if (!try_visit_polygon_edges(part, callback)) {
+				return false;
+			}
+		} while (part != tail);
+		return true;
+	}
+
+	SGL_ASSERT(geom->get_type() == geometry_type::POLYGON);
+
+	auto ring = tail;
+	do {
+		ring = ring->get_next();
+		const auto count = ring->get_count();
+		if (count == 0) {
+			continue;
+		}
+		if (count < 4 || !(ring->get_vertex_xy(0) == ring->get_vertex_xy(count - 1))) {
+			return false;
+		}
+		auto prev = ring->get_vertex_xy(0);
+		for (uint32_t i = 1; i < count; i++) {
+			const auto next = ring->get_vertex_xy(i);
+			callback(prev, next);
+			prev = next;
+		}
+	} while (ring != tail);
+
+	return true;
+}
+
+static bool try_locate_point_in_linestring(const geometry *geom, const vertex_xy *point, point_location *out) {
+	const auto count = geom->get_count();
+	if (count == 0) {
+		*out = point_location::EXTERIOR;
+		return true;
+	}
+	if (count == 1) {
+		// Not a valid linestring
+		return false;
+	}
+
+	// The endpoints of an open linestring are its boundary
+	const auto first = geom->get_vertex_xy(0);
+	const auto last = geom->get_vertex_xy(count - 1);
+	if (!(first == last) && (*point == first || *point == last)) {
+		*out = point_location::BOUNDARY;
+		return true;
+	}
+
+	auto prev = first;
+	for (uint32_t i = 1; i < count; i++) {
+		const auto next = geom->get_vertex_xy(i);
+		if (is_point_on_segment(*point, prev, next)) {
+			*out = point_location::INTERIOR;
+			return true;
+		}
+		prev = next;
+	}
+
+	*out = point_location::EXTERIOR;
+	return true;
+}
+
+bool try_locate_point(const geometry *geom, const vertex_xy *point, point_location *out) {
+	switch (geom->get_type()) {
+	case geometry_type::POINT: {
+		const auto is_equal = !geom->is_empty() && geom->get_vertex_xy(0) == *point;
+		*out = is_equal ? point_location::INTERIOR : point_location::EXTERIOR;
+		return true;
+	}
+	case geometry_type::LINESTRING:
+		return try_locate_point_in_linestring(geom, point, out);
+	case geometry_type::POLYGON:
+	case geometry_type::MULTI_POLYGON: {
+		ray_crossing_counter counter = {*point, 0, false};
+		const auto ok = try_visit_polygon_edges(
+		    geom, [&](const vertex_xy &p1, const vertex_xy &p2) { ray_crossing_count(&counter, p1, p2); });
+		if (!ok) {
+			return false;
+		}
+		*out = ray_crossing_get_location(&counter);
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+static uint32_t polygon_index_get_band(const polygon_index *index, double y) {
+	if (!(index->band_height > 0.0)) {
+		return 0;
+	}
+	const auto band = (y - index->min_y) / index->band_height;
+	if (band >= static_cast<double>(index->band_count - 1)) {
+		return index->band_count - 1;
+	}
+	return band > 0.0 ? static_cast<uint32_t>(band) : 0;
+}
+
+bool polygon_index_try_build(polygon_index *index, allocator *alloc, const geometry *geom) {
+	const auto type = geom->get_type();
+	if (type != geometry_type::POLYGON && type != geometry_type::MULTI_POLYGON) {
+		return false;
+	}
+
+	// Count the edges and compute the vertical extent
+	uint32_t edge_count = 0;
+	auto min_y = std::numeric_limits<double>::infinity();
+	auto max_y = -std::numeric_limits<double>::infinity();
+	auto all_finite = true;
+
+	const auto ok = try_visit_polygon_edges(geom, [&](const vertex_xy &p1, const vertex_xy &p2) {
+		all_finite &= std::isfinite(p1.y) && std::isfinite(p2.y);
+		min_y = std::min(min_y, std::min(p1.y, p2.y));
+		max_y = std::max(max_y, std::max(p1.y, p2.y));
+		edge_count++;
+	});
+	if (!ok || !all_finite) {
+		return false;
+	}
+
+	index->edge_count = edge_count;
+	index->min_y = min_y;
+	index->max_y = max_y;
+
+	if (edge_count == 0) {
+		index->band_count = 0;
+		index->band_height = 0;
+		index->edges = nullptr;
+		index->band_offsets = nullptr;
+		index->band_edges = nullptr;
+		return true;
+	}
+
+	index->edges = static_cast<vertex_xy *>(alloc->alloc(sizeof(vertex_xy) * 2 * edge_count));
+	uint32_t edge_idx = 0;
+	try_visit_polygon_edges(geom, [&](const vertex_xy &p1, const vertex_xy &p2) {
+		index->edges[edge_idx * 2] = p1;
+		index->edges[edge_idx * 2 + 1] = p2;
+		edge_idx++;
+	});
+
+	// Aim for a handful of edges per band. Edges are added to every band they overlap, so use fewer bands if that
+	// would duplicate too many of them (e.g. for polygons with many long edges)
+	uint32_t band_count = std::max<uint32_t>(1, std::min<uint32_t>(edge_count / 4, 1 << 16));
+	size_t entry_count;
+	while (true) {
+		index->band_count = band_count;
+		index->band_height = (max_y - min_y) / band_count;
+
+		entry_count = 0;
+		for (uint32_t i = 0; i < edge_count; i++) {
+			const auto y1 = index->edges[i * 2].y;
+			const auto y2 = index->edges[i * 2 + 1].y;
+			const auto beg = polygon_index_get_band(index, std::min(y1, y2));
+			const auto end = polygon_index_get_band(index, std::max(y1, y2));
+			entry_count += end - beg + 1;
+		}
+
+		if (band_count == 1 || entry_count <= static_cast<size_t>(edge_count) * 4) {
+			break;
+		}
+		band_count /= 2;
+	}
+
+	// Bucket the edges by band
+	index->band_offsets = static_cast<uint32_t *>(alloc->alloc(sizeof(uint32_t) * (band_count + 1)));
+	index->band_edges = static_cast<uint32_t *>(alloc->alloc(sizeof(uint32_t) * entry_count));
+	memset(index->band_offsets, 0, sizeof(uint32_t) * (band_count + 1));
+
+	for (uint32_t i = 0; i < edge_count; i++) {
+		const auto y1 = index->edges[i * 2].y;
+		const auto y2 = index->edges[i * 2 + 1].y;
+		const auto beg = polygon_index_get_band(index, std::min(y1, y2));
+		const auto end = polygon_index_get_band(index, std::max(y1, y2));
+		for (auto band = beg; band <= end; band++) {
+			index->band_offsets[band + 1]++;
+		}
+	}
+	for (uint32_t band = 0; band < band_count; band++) {
+		index->band_offsets[band + 1] += index->band_offsets[band];
+	}
+
+	// Use the offsets as write cursors, and shift them back afterwards
+	for (uint32_t i = 0; i < edge_count; i++) {
+		const auto y1 = index->edges[i * 2].y;
+		const auto y2 = index->edges[i * 2 + 1].y;
+		const auto beg = polygon_index_get_band(index, std::min(y1, y2));
+		const auto end = polygon_index_get_band(index, std::max(y1, y2));
+		for (auto band = beg; band <= end; band++) {
+			index->band_edges[index->band_offsets[band]++] = i;
+		}
+	}
+	for (uint32_t band = band_count; band > 0; band--) {
+		index->band_offsets[band] = index->band_offsets[band - 1];
+	}
+	index->band_offsets[0] = 0;
+
+	return true;
+}
+
+point_location polygon_index_locate(const polygon_index *index, const vertex_xy *point) {
+	if (index->edge_count == 0 || !(point->y >= index->min_y && point->y <= index->max_y)) {
+		return point_location::EXTERIOR;
+	}
+
+	const auto band = polygon_index_get_band(index, point->y);
+
+	ray_crossing_counter counter = {*point, 0, false};
+	for (auto i = index->band_offsets[band]; i < index->band_offsets[band + 1]; i++) {
+		const auto edge = index->band_edges[i];
+		ray_crossing_count(&counter, index->edges[edge * 2], index->edges[edge * 2 + 1]);
+		if (counter.on_boundary) {
+			return point_location::BOUNDARY;
+		}
+	}
+	return ray_crossing_get_location(&counter);
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 // Validity
 //----------------------------------------------------------------------------------------------------------------------
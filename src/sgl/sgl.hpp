@@ -1003,6 +1003,32 @@ bool is_valid(const sgl::geometry *geom);
 
 bool get_centroid(const sgl::geometry *geom, vertex_xyzm *out);
 
+// The location of a point relative to a geometry
+enum class point_location : uint8_t { EXTERIOR = 0, BOUNDARY = 1, INTERIOR = 2 };
+
+// Locate a point relative to a POINT, LINESTRING, POLYGON or MULTI_POLYGON, considering only the XY ordinates.
+// Polygons are assumed to be valid, the location is computed with the even-odd rule over all rings.
+// Returns false if the geometry is of another type, or is malformed (e.g. has an unclosed ring), in which case the
+// caller should fall back to a general implementation.
+bool try_locate_point(const geometry *geom, const vertex_xy *point, point_location *out);
+
+// An index of the edges of a POLYGON or MULTI_POLYGON, to locate many points in the same polygon.
+// The edges are bucketed into horizontal bands, so only the edges overlapping the band of a point have to be tested.
+struct polygon_index {
+	vertex_xy *edges;        // start and end vertex of each edge
+	uint32_t *band_offsets;  // offset of the first edge of each band in band_edges, band_count + 1 entries
+	uint32_t *band_edges;    // edge indices, grouped by band
+	uint32_t edge_count;
+	uint32_t band_count;
+	double min_y;
+	double max_y;
+	double band_height;
+};
+
+// Returns false for the same reasons as try_locate_point
+bool polygon_index_try_build(polygon_index *index, allocator *alloc, const geometry *geom);
+point_location polygon_index_locate(const polygon_index *index, const vertex_xy *point);
+
 } // namespace ops
 
 } // namespace sgl
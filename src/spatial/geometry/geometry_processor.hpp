@@ -1,6 +1,7 @@
 #pragma once
 
 #include "spatial/util/cursor.hpp"
+#include "spatial/geometry/geometry_serialization.hpp"
 #include "spatial/geometry/geometry_type.hpp"
 
 namespace duckdb {
@@ -108,6 +109,9 @@ private:
 	GeometryType current_type = GeometryType::POINT;
 	GeometryType parent_type = GeometryType::POINT;
 
+	// The vertices of version 1 geometries are encoded, so they are decoded into this buffer before processing
+	vector<char> decoded_buffer;
+
 protected:
 	bool HasZ() const {
 		return has_z;
@@ -214,13 +218,21 @@ protected:
 	virtual RESULT ProcessCollection(CollectionState &state, ARGS... args) = 0;
 
 public:
-	RESULT Process(const geometry_t &geom, ARGS... args) {
+	RESULT Process(const geometry_t &geom_p, ARGS... args) {
 
-		const auto props = geom.GetProperties();
+		auto geom = geom_p;
+		auto props = geom.GetProperties();
 
 		// Check the version
 		props.CheckVersion();
 
+		if (props.IsVersion1()) {
+			const auto blob = static_cast<string_t>(geom);
+			Serde::DecodeToVersion0(blob.GetData(), blob.GetSize(), decoded_buffer);
+			geom = geometry_t(string_t(decoded_buffer.data(), UnsafeNumericCast<uint32_t>(decoded_buffer.size())));
+			props = geom.GetProperties();
+		}
+
 		has_z = props.HasZ();
 		has_m = props.HasM();
 		nesting_level = 0;
@@ -235,7 +247,7 @@ public:
 		cursor.Skip<uint32_t>();
 
 		auto dims = 2 + (has_z ? 1 : 0) + (has_m ? 1 : 0);
-		auto has_bbox = geom.GetProperties().HasBBox();
+		auto has_bbox = props.HasBBox();
 		auto bbox_size = has_bbox ? dims * 2 * sizeof(float) : 0;
 		cursor.Skip(bbox_size);
 
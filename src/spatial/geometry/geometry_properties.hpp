@@ -25,10 +25,10 @@ public:
 		SetM(has_m);
 	}
 
+	// Version 0 (raw vertices) sets neither of the version bits, version 1 (encoded vertices) only sets VERSION_1
 	inline void CheckVersion() const {
-		const auto v0 = (flags & VERSION_0);
-		const auto v1 = (flags & VERSION_1);
-		if ((v1 | v0) != GEOMETRY_VERSION) {
+		const auto version = flags & (VERSION_0 | VERSION_1);
+		if (version != GEOMETRY_VERSION && version != VERSION_1) {
 			throw NotImplementedException(
 			    "This geometry seems to be written with a newer version of the DuckDB spatial library that is not "
 			    "compatible with this version. Please upgrade your DuckDB installation.");
@@ -44,6 +44,9 @@ public:
 	inline bool HasBBox() const {
 		return (flags & BBOX) != 0;
 	}
+	inline bool IsVersion1() const {
+		return (flags & VERSION_1) != 0;
+	}
 	inline void SetZ(bool value) {
 		flags = value ? (flags | Z) : (flags & ~Z);
 	}
@@ -53,6 +56,9 @@ public:
 	inline void SetBBox(bool value) {
 		flags = value ? (flags | BBOX) : (flags & ~BBOX);
 	}
+	inline void SetVersion1(bool value) {
+		flags = value ? (flags | VERSION_1) : (flags & ~VERSION_1);
+	}
 
 	uint32_t VertexSize() const {
 		return sizeof(double) * (2 + HasZ() + HasM());
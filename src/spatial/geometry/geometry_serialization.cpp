@@ -2,11 +2,19 @@
 #include "spatial/util/binary_reader.hpp"
 #include "spatial/util/binary_writer.hpp"
 #include "spatial/util/math.hpp"
+#include "spatial/geometry/geometry_type.hpp"
 #include "spatial/geometry/sgl.hpp"
 
 #include "duckdb/common/exception.hpp"
+#include "duckdb/common/limits.hpp"
+#include "duckdb/common/types/hash.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/config.hpp"
+#include "duckdb/main/database.hpp"
 #include "duckdb/storage/arena_allocator.hpp"
 
+#include <cmath>
+
 namespace duckdb {
 
 // TODO: Make non-recursive
@@ -208,7 +216,7 @@ void Serde::Serialize(const sgl::geometry &geom, char *buffer, size_t buffer_siz
 	// but now it starts with INVALID = 0, so we need to subtract 1
 	cursor.Write<uint8_t>(static_cast<uint8_t>(type) - 1);
 	cursor.Write<uint8_t>(flags);
-	cursor.Write<uint16_t>(0); // unused for now
+	cursor.Write<uint16_t>(0); // always 0 in version 0, see GetBodyHash
 	cursor.Write<uint32_t>(0); // padding
 
 	const auto dims = 2 + (has_z ? 1 : 0) + (has_m ? 1 : 0);
@@ -287,6 +295,445 @@ static void DeserializeRecursive(BinaryReader &cursor, sgl::geometry &geom, cons
 	}
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+// Format Version 1
+//----------------------------------------------------------------------------------------------------------------------
+// Version 1 has the same header and bounding box as version 0 (but also stores the bounding box of points), followed
+// by a varint encoded body:
+// - points and linestrings: the vertex count, followed by the vertices
+// - polygons: the ring count, followed by the vertex count and vertices of each ring
+// - collections: the part count, followed by the type (a single byte) and body of each part
+// Each ordinate is quantized to an integer at the precision (the number of decimal digits) stored in the first byte of
+// the header padding, and written as the zigzag encoded difference to the same ordinate of the previous vertex. The
+// first vertex is written as is, so it is the origin the rest of the geometry is relative to.
+
+static constexpr uint8_t MAX_FORMAT_PRECISION = 15;
+
+static double GetPrecisionScale(uint8_t precision) {
+	return std::pow(10.0, precision);
+}
+
+static int64_t Quantize(double value, double scale) {
+	return static_cast<int64_t>(std::llround(value * scale));
+}
+
+static uint64_t ZigZagEncode(int64_t value) {
+	return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+static int64_t ZigZagDecode(uint64_t value) {
+	return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+namespace {
+
+// Only counts the bytes that would be written, to compute the size of the encoded geometry
+struct VarintSizeWriter {
+	size_t size = 0;
+	void WriteByte(uint8_t) {
+		size++;
+	}
+};
+
+struct VarintBufferWriter {
+	BinaryWriter &cursor;
+	void WriteByte(uint8_t byte) {
+		cursor.Write<uint8_t>(byte);
+	}
+};
+
+template <class WRITER>
+class VertexEncoder {
+public:
+	VertexEncoder(WRITER &writer, uint32_t dims, double scale) : writer(writer), dims(dims), scale(scale) {
+	}
+
+	void Encode(const sgl::geometry *geom) {
+		switch (geom->get_type()) {
+		case sgl::geometry_type::POINT:
+		case sgl::geometry_type::LINESTRING:
+			EncodeVertices(geom);
+			break;
+		case sgl::geometry_type::POLYGON:
+		case sgl::geometry_type::MULTI_POINT:
+		case sgl::geometry_type::MULTI_LINESTRING:
+		case sgl::geometry_type::MULTI_POLYGON:
+		case sgl::geometry_type::MULTI_GEOMETRY: {
+			const auto is_polygon = geom->get_type() == sgl::geometry_type::POLYGON;
+			WriteVarint(geom->get_count());
+			const auto tail = geom->get_last_part();
+			if (!tail) {
+				break;
+			}
+			auto part = tail;
+			do {
+				part = part->get_next();
+				if (is_polygon) {
+					EncodeVertices(part);
+				} else {
+					// The GeometryType enum used to start with POINT = 0, so we need to subtract 1
+					writer.WriteByte(static_cast<uint8_t>(static_cast<uint8_t>(part->get_type()) - 1));
+					Encode(part);
+				}
+			} while (part != tail);
+		} break;
+		default:
+			D_ASSERT(false);
+		}
+	}
+
+private:
+	void WriteVarint(uint64_t value) {
+		while (value >= 0x80) {
+			writer.WriteByte(static_cast<uint8_t>(value | 0x80));
+			value >>= 7;
+		}
+		writer.WriteByte(static_cast<uint8_t>(value));
+	}
+
+	void EncodeVertices(const sgl::geometry *geom) {
+		const auto count = geom->get_count();
+		const auto verts = geom->get_vertex_data();
+
+		WriteVarint(count);
+		for (uint32_t i = 0; i < count; i++) {
+			for (uint32_t d = 0; d < dims; d++) {
+				double value;
+				memcpy(&value, verts + (i * dims + d) * sizeof(double), sizeof(double));
+				const auto quantized = Quantize(value, scale);
+				WriteVarint(ZigZagEncode(quantized - prev[d]));
+				prev[d] = quantized;
+			}
+		}
+	}
+
+	WRITER &writer;
+	uint32_t dims;
+	double scale;
+	int64_t prev[4] = {0, 0, 0, 0};
+};
+
+struct VarintReader {
+	BinaryReader &cursor;
+
+	uint64_t ReadVarint() {
+		uint64_t result = 0;
+		for (uint32_t shift = 0; shift < 64; shift += 7) {
+			const auto byte = cursor.Read<uint8_t>();
+			result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0) {
+				return result;
+			}
+		}
+		throw SerializationException("Invalid varint in geometry");
+	}
+
+	uint32_t ReadCount() {
+		const auto count = ReadVarint();
+		if (count > NumericLimits<uint32_t>::Maximum()) {
+			throw SerializationException("Invalid count in geometry");
+		}
+		return static_cast<uint32_t>(count);
+	}
+
+	sgl::geometry_type ReadPartType() {
+		// The GeometryType enum used to start with POINT = 0, so we need to add 1
+		const auto part_type = static_cast<sgl::geometry_type>(cursor.Read<uint8_t>() + 1);
+		if (part_type < sgl::geometry_type::POINT || part_type > sgl::geometry_type::MULTI_GEOMETRY) {
+			throw SerializationException("Unknown geometry type (%d)", static_cast<int>(part_type));
+		}
+		return part_type;
+	}
+};
+
+class VertexDecoder {
+public:
+	VertexDecoder(BinaryReader &cursor, ArenaAllocator &arena, bool has_z, bool has_m, double scale)
+	    : reader {cursor}, arena(arena), has_z(has_z), has_m(has_m), dims(2 + has_z + has_m), scale(scale) {
+	}
+
+	void Decode(sgl::geometry &geom) {
+		switch (geom.get_type()) {
+		case sgl::geometry_type::POINT:
+		case sgl::geometry_type::LINESTRING:
+			DecodeVertices(geom);
+			break;
+		case sgl::geometry_type::POLYGON:
+		case sgl::geometry_type::MULTI_POINT:
+		case sgl::geometry_type::MULTI_LINESTRING:
+		case sgl::geometry_type::MULTI_POLYGON:
+		case sgl::geometry_type::MULTI_GEOMETRY: {
+			const auto is_polygon = geom.get_type() == sgl::geometry_type::POLYGON;
+			const auto count = reader.ReadCount();
+			for (uint32_t i = 0; i < count; i++) {
+				const auto part_type = is_polygon ? sgl::geometry_type::LINESTRING : reader.ReadPartType();
+				const auto part_mem = arena.AllocateAligned(sizeof(sgl::geometry));
+				const auto part = new (part_mem) sgl::geometry(part_type, has_z, has_m);
+				Decode(*part);
+				geom.append_part(part);
+			}
+		} break;
+		default:
+			break;
+		}
+	}
+
+private:
+	void DecodeVertices(sgl::geometry &geom) {
+		const auto count = reader.ReadCount();
+		if (count == 0) {
+			geom.set_vertex_data(static_cast<const uint8_t *>(nullptr), 0);
+			return;
+		}
+		if (geom.get_type() == sgl::geometry_type::POINT && count != 1) {
+			throw SerializationException("Invalid point in geometry");
+		}
+
+		const auto verts = reinterpret_cast<double *>(arena.AllocateAligned(count * dims * sizeof(double)));
+		for (uint32_t i = 0; i < count; i++) {
+			for (uint32_t d = 0; d < dims; d++) {
+				prev[d] += ZigZagDecode(reader.ReadVarint());
+				verts[i * dims + d] = static_cast<double>(prev[d]) / scale;
+			}
+		}
+		geom.set_vertex_data(reinterpret_cast<const uint8_t *>(verts), count);
+	}
+
+	VarintReader reader;
+	ArenaAllocator &arena;
+	bool has_z;
+	bool has_m;
+	uint32_t dims;
+	double scale;
+	int64_t prev[4] = {0, 0, 0, 0};
+};
+
+// Decodes a version 1 body straight into the version 0 layout, without materializing the geometry in between
+class Version0Transcoder {
+public:
+	Version0Transcoder(BinaryReader &cursor, vector<char> &result, uint32_t dims, double scale)
+	    : reader {cursor}, result(result), dims(dims), scale(scale) {
+	}
+
+	void Transcode(sgl::geometry_type type) {
+		// The GeometryType enum used to start with POINT = 0, so we need to subtract 1
+		Write<uint32_t>(static_cast<uint32_t>(type) - 1);
+
+		switch (type) {
+		case sgl::geometry_type::POINT:
+		case sgl::geometry_type::LINESTRING: {
+			const auto count_offset = Reserve(sizeof(uint32_t));
+			const auto count = TranscodeVertices();
+			if (type == sgl::geometry_type::POINT && count > 1) {
+				throw SerializationException("Invalid point in geometry");
+			}
+			Store<uint32_t>(count, GetPtr(count_offset));
+		} break;
+		case sgl::geometry_type::POLYGON: {
+			// The ring counts come first, padded to a multiple of 8 bytes, followed by the vertices of each ring
+			const auto ring_count = reader.ReadCount();
+			Write<uint32_t>(ring_count);
+			const auto ring_offset = Reserve(ring_count * sizeof(uint32_t) + (ring_count % 2 == 1 ? 4 : 0));
+			for (uint32_t i = 0; i < ring_count; i++) {
+				const auto count = TranscodeVertices();
+				Store<uint32_t>(count, GetPtr(ring_offset + i * sizeof(uint32_t)));
+			}
+		} break;
+		case sgl::geometry_type::MULTI_POINT:
+		case sgl::geometry_type::MULTI_LINESTRING:
+		case sgl::geometry_type::MULTI_POLYGON:
+		case sgl::geometry_type::MULTI_GEOMETRY: {
+			const auto part_count = reader.ReadCount();
+			Write<uint32_t>(part_count);
+			for (uint32_t i = 0; i < part_count; i++) {
+				Transcode(reader.ReadPartType());
+			}
+		} break;
+		default:
+			throw SerializationException("Unknown geometry type (%d)", static_cast<int>(type));
+		}
+	}
+
+private:
+	// Grow the result by the given number of zeroed bytes, and return the offset of the first one. The caller reuses
+	// the result buffer, so this rarely has to allocate.
+	idx_t Reserve(idx_t size) {
+		const auto offset = result.size();
+		result.resize(offset + size);
+		return offset;
+	}
+
+	data_ptr_t GetPtr(idx_t offset) {
+		return reinterpret_cast<data_ptr_t>(result.data() + offset);
+	}
+
+	template <class T>
+	void Write(T value) {
+		Store<T>(value, GetPtr(Reserve(sizeof(T))));
+	}
+
+	uint32_t TranscodeVertices() {
+		const auto count = reader.ReadCount();
+		const auto verts_offset = Reserve(count * dims * sizeof(double));
+		for (uint32_t i = 0; i < count; i++) {
+			for (uint32_t d = 0; d < dims; d++) {
+				prev[d] += ZigZagDecode(reader.ReadVarint());
+				Store<double>(static_cast<double>(prev[d]) / scale,
+				              GetPtr(verts_offset + (i * dims + d) * sizeof(double)));
+			}
+		}
+		return count;
+	}
+
+	VarintReader reader;
+	vector<char> &result;
+	uint32_t dims;
+	double scale;
+	int64_t prev[4] = {0, 0, 0, 0};
+};
+
+} // namespace
+
+// Check that every ordinate can be quantized, and compute the extent of the quantized vertices.
+// The extent has to include the vertices as they are decoded, not as they were before they were quantized.
+static bool TryGetQuantizedExtent(const sgl::geometry *geom, uint32_t dims, double scale, double min[4],
+                                  double max[4]) {
+	// Keep all quantized ordinates (and their deltas) exactly representable
+	constexpr auto MAX_QUANTIZED = static_cast<double>(1LL << 52);
+
+	switch (geom->get_type()) {
+	case sgl::geometry_type::POINT:
+	case sgl::geometry_type::LINESTRING: {
+		const auto count = geom->get_count();
+		const auto verts = geom->get_vertex_data();
+		for (uint32_t i = 0; i < count; i++) {
+			for (uint32_t d = 0; d < dims; d++) {
+				double value;
+				memcpy(&value, verts + (i * dims + d) * sizeof(double), sizeof(double));
+				const auto scaled = value * scale;
+				if (!std::isfinite(scaled) || std::abs(scaled) > MAX_QUANTIZED) {
+					return false;
+				}
+				const auto decoded = static_cast<double>(Quantize(value, scale)) / scale;
+				min[d] = std::min(min[d], decoded);
+				max[d] = std::max(max[d], decoded);
+			}
+		}
+		return true;
+	}
+	case sgl::geometry_type::POLYGON:
+	case sgl::geometry_type::MULTI_POINT:
+	case sgl::geometry_type::MULTI_LINESTRING:
+	case sgl::geometry_type::MULTI_POLYGON:
+	case sgl::geometry_type::MULTI_GEOMETRY: {
+		const auto tail = geom->get_last_part();
+		if (!tail) {
+			return true;
+		}
+		auto part = tail;
+		do {
+			part = part->get_next();
+			if (!TryGetQuantizedExtent(part, dims, scale, min, max)) {
+				return false;
+			}
+		} while (part != tail);
+		return true;
+	}
+	default:
+		throw InvalidInputException("Cannot serialize geometry of type %d", static_cast<int>(geom->get_type()));
+	}
+}
+
+template <class WRITER>
+static void EncodeVersion1(const sgl::geometry &geom, const SerdeFormat &format, WRITER &writer) {
+	const auto dims = 2 + (geom.has_z() ? 1 : 0) + (geom.has_m() ? 1 : 0);
+	VertexEncoder<WRITER> encoder(writer, dims, GetPrecisionScale(format.precision));
+	encoder.Encode(&geom);
+}
+
+size_t Serde::GetRequiredSize(const sgl::geometry &geom, const SerdeFormat &format) {
+	if (format.version == 0) {
+		return GetRequiredSize(geom);
+	}
+
+	const auto dims = 2 + (geom.has_z() ? 1 : 0) + (geom.has_m() ? 1 : 0);
+	constexpr auto dmax = std::numeric_limits<double>::max();
+	constexpr auto dmin = std::numeric_limits<double>::lowest();
+	double min[4] = {dmax, dmax, dmax, dmax};
+	double max[4] = {dmin, dmin, dmin, dmin};
+	if (!TryGetQuantizedExtent(&geom, dims, GetPrecisionScale(format.precision), min, max)) {
+		return GetRequiredSize(geom);
+	}
+
+	const auto has_bbox = !geom.is_empty();
+	const auto head_size = 4 + 4; // type + props + hash + padding
+	const auto bbox_size = has_bbox ? dims * sizeof(float) * 2 : 0;
+
+	VarintSizeWriter writer;
+	EncodeVersion1(geom, format, writer);
+
+	return head_size + bbox_size + writer.size;
+}
+
+void Serde::Serialize(const sgl::geometry &geom, const SerdeFormat &format, char *buffer, size_t buffer_size) {
+	if (format.version == 0) {
+		Serialize(geom, buffer, buffer_size);
+		return;
+	}
+
+	const auto type = geom.get_type();
+	if (type < sgl::geometry_type::POINT || type > sgl::geometry_type::MULTI_GEOMETRY) {
+		throw InvalidInputException("Cannot serialize geometry of type %d", static_cast<int>(type));
+	}
+
+	const auto has_z = geom.has_z();
+	const auto has_m = geom.has_m();
+	const auto dims = 2 + (has_z ? 1 : 0) + (has_m ? 1 : 0);
+
+	constexpr auto dmax = std::numeric_limits<double>::max();
+	constexpr auto dmin = std::numeric_limits<double>::lowest();
+	double min[4] = {dmax, dmax, dmax, dmax};
+	double max[4] = {dmin, dmin, dmin, dmin};
+	if (!TryGetQuantizedExtent(&geom, dims, GetPrecisionScale(format.precision), min, max)) {
+		// Fall back to the raw vertices
+		Serialize(geom, buffer, buffer_size);
+		return;
+	}
+
+	const auto has_bbox = !geom.is_empty();
+
+	GeometryProperties props(has_z, has_m);
+	props.SetBBox(has_bbox);
+	props.SetVersion1(true);
+
+	BinaryWriter cursor(buffer, buffer_size);
+
+	// The GeometryType enum used to start with POINT = 0
+	// but now it starts with INVALID = 0, so we need to subtract 1
+	cursor.Write<uint8_t>(static_cast<uint8_t>(type) - 1);
+	cursor.Write<GeometryProperties>(props);
+	auto hash_cursor = cursor;
+	cursor.Write<uint16_t>(0); // hash, written once we have the body
+	cursor.Write<uint8_t>(format.precision);
+	cursor.Skip(3, true); // padding
+
+	if (has_bbox) {
+		cursor.Write<float>(MathUtil::DoubleToFloatDown(min[0])); // xmin
+		cursor.Write<float>(MathUtil::DoubleToFloatDown(min[1])); // ymin
+		cursor.Write<float>(MathUtil::DoubleToFloatUp(max[0]));   // xmax
+		cursor.Write<float>(MathUtil::DoubleToFloatUp(max[1]));   // ymax
+		for (uint32_t d = 2; d < dims; d++) {
+			cursor.Write<float>(MathUtil::DoubleToFloatDown(min[d])); // zmin or mmin
+			cursor.Write<float>(MathUtil::DoubleToFloatUp(max[d]));   // zmax or mmax
+		}
+	}
+
+	const auto body = cursor.GetPtr();
+	VarintBufferWriter writer {cursor};
+	EncodeVersion1(geom, format, writer);
+	hash_cursor.Write<uint16_t>(GetBodyHash(body, cursor.GetPtr() - body));
+}
+
 void Serde::Deserialize(sgl::geometry &result, ArenaAllocator &arena, const char *buffer, size_t buffer_size) {
 
 	BinaryReader cursor(buffer, buffer_size);
@@ -294,7 +741,8 @@ void Serde::Deserialize(sgl::geometry &result, ArenaAllocator &arena, const char
 	const auto type = static_cast<sgl::geometry_type>(cursor.Read<uint8_t>() + 1);
 	const auto flags = cursor.Read<uint8_t>();
 	cursor.Skip(sizeof(uint16_t));
-	cursor.Skip(sizeof(uint32_t)); // padding
+	const auto precision = cursor.Read<uint8_t>();
+	cursor.Skip(3); // padding
 
 	// Parse flags
 	const auto has_z = (flags & 0x01) != 0;
@@ -304,7 +752,7 @@ void Serde::Deserialize(sgl::geometry &result, ArenaAllocator &arena, const char
 	const auto format_v1 = (flags & 0x40) != 0;
 	const auto format_v0 = (flags & 0x80) != 0;
 
-	if (format_v1 || format_v0) {
+	if (format_v0 || (format_v1 && precision > MAX_FORMAT_PRECISION)) {
 		// Unsupported version, throw an error
 		throw NotImplementedException(
 		    "This geometry seems to be written with a newer version of the DuckDB spatial library that is not "
@@ -321,6 +769,13 @@ void Serde::Deserialize(sgl::geometry &result, ArenaAllocator &arena, const char
 	result.set_z(has_z);
 	result.set_m(has_m);
 
+	if (format_v1) {
+		// Decode the vertices into buffers allocated in the arena
+		VertexDecoder decoder(cursor, arena, has_z, has_m, GetPrecisionScale(precision));
+		decoder.Decode(result);
+		return;
+	}
+
 	// Read the first type
 	cursor.Read<uint32_t>();
 
@@ -328,4 +783,98 @@ void Serde::Deserialize(sgl::geometry &result, ArenaAllocator &arena, const char
 	DeserializeRecursive(cursor, result, has_z, has_m, arena);
 }
 
+void Serde::DecodeToVersion0(const char *buffer, size_t buffer_size, vector<char> &result) {
+	BinaryReader cursor(buffer, buffer_size);
+
+	const auto type = static_cast<sgl::geometry_type>(cursor.Read<uint8_t>() + 1);
+	const auto flags = cursor.Read<uint8_t>();
+	cursor.Skip(sizeof(uint16_t));
+	const auto precision = cursor.Read<uint8_t>();
+	cursor.Skip(3); // padding
+
+	const auto has_z = (flags & 0x01) != 0;
+	const auto has_m = (flags & 0x02) != 0;
+	const auto has_bbox = (flags & 0x04) != 0;
+	const auto dims = 2 + (has_z ? 1 : 0) + (has_m ? 1 : 0);
+
+	D_ASSERT((flags & 0x40) != 0);
+	if (precision > MAX_FORMAT_PRECISION) {
+		throw NotImplementedException(
+		    "This geometry seems to be written with a newer version of the DuckDB spatial library that is not "
+		    "compatible with this version. Please upgrade your DuckDB installation.");
+	}
+
+	// Version 0 does not store the bounding box of points, but otherwise it is the same. Both are rounded from the
+	// extent of the decoded vertices.
+	const auto bbox_size = has_bbox ? dims * sizeof(float) * 2 : 0;
+	const auto bbox = cursor.Reserve(bbox_size);
+	const auto keep_bbox = has_bbox && type != sgl::geometry_type::POINT;
+
+	result.clear();
+	result.push_back(static_cast<char>(static_cast<uint8_t>(type) - 1));
+	result.push_back(static_cast<char>((has_z ? 0x01 : 0) | (has_m ? 0x02 : 0) | (keep_bbox ? 0x04 : 0)));
+	result.resize(result.size() + sizeof(uint16_t) + sizeof(uint32_t)); // hash and padding, always 0 in version 0
+	if (keep_bbox) {
+		result.insert(result.end(), bbox, bbox + bbox_size);
+	}
+
+	Version0Transcoder transcoder(cursor, result, dims, GetPrecisionScale(precision));
+	transcoder.Transcode(type);
+}
+
+uint16_t Serde::GetBodyHash(const char *body, size_t size) {
+	// Fold the 64-bit hash into 16 bits
+	auto hash = Hash(body, size);
+	hash ^= hash >> 32;
+	hash ^= hash >> 16;
+	const auto result = static_cast<uint16_t>(hash);
+	return result == 0 ? 1 : result;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Settings
+//----------------------------------------------------------------------------------------------------------------------
+
+static void SetFormatVersion(ClientContext &context, SetScope scope, Value &parameter) {
+	const auto version = parameter.GetValue<int64_t>();
+	if (version != 0 && version != 1) {
+		throw InvalidInputException("Unsupported geometry format version %d, expected 0 or 1", version);
+	}
+}
+
+static void SetFormatPrecision(ClientContext &context, SetScope scope, Value &parameter) {
+	const auto precision = parameter.GetValue<int64_t>();
+	if (precision < 0 || precision > MAX_FORMAT_PRECISION) {
+		throw InvalidInputException("Geometry format precision must be between 0 and %d, got %d",
+		                            static_cast<int64_t>(MAX_FORMAT_PRECISION), precision);
+	}
+}
+
+void SerdeFormat::RegisterSettings(DatabaseInstance &db) {
+	auto &config = DBConfig::GetConfig(db);
+	config.AddExtensionOption("geometry_format_version",
+	                          "The format version new geometries are written in. Version 0 stores raw vertices, version "
+	                          "1 stores vertices quantized to 'geometry_format_precision' decimal digits as "
+	                          "varint encoded deltas, which is a lot smaller but lossy. Functions backed by GEOS "
+	                          "always write version 0, and the same geometry in different versions is not equal as a "
+	                          "blob",
+	                          LogicalType::INTEGER, Value::INTEGER(0), SetFormatVersion);
+	config.AddExtensionOption("geometry_format_precision",
+	                          "The number of decimal digits the vertices of new geometries are quantized to, if "
+	                          "'geometry_format_version' is 1",
+	                          LogicalType::INTEGER, Value::INTEGER(7), SetFormatPrecision);
+}
+
+SerdeFormat SerdeFormat::Get(ClientContext &context) {
+	SerdeFormat format;
+	Value value;
+	if (context.TryGetCurrentSetting("geometry_format_version", value) && !value.IsNull()) {
+		format.version = value.GetValue<uint8_t>();
+	}
+	if (context.TryGetCurrentSetting("geometry_format_precision", value) && !value.IsNull()) {
+		format.precision = value.GetValue<uint8_t>();
+	}
+	return format;
+}
+
 } // namespace duckdb
\ No newline at end of file
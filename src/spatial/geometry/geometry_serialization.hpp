@@ -1,6 +1,9 @@
 #pragma once
 
+#include "duckdb/common/vector.hpp"
+
 #include <cstddef>
+#include <cstdint>
 
 namespace sgl {
 class geometry;
@@ -9,12 +12,39 @@ class geometry;
 namespace duckdb {
 
 class ArenaAllocator;
+class ClientContext;
+class DatabaseInstance;
+
+// The format new geometries are serialized in
+struct SerdeFormat {
+	// 0: raw vertices, 1: vertices quantized to "precision" decimal digits and stored as varint encoded deltas
+	uint8_t version = 0;
+	uint8_t precision = 0;
+
+	// Get the format configured by the "geometry_format_version" and "geometry_format_precision" settings
+	static SerdeFormat Get(ClientContext &context);
+	static void RegisterSettings(DatabaseInstance &db);
+};
 
 // todo:
 struct Serde {
 	static size_t GetRequiredSize(const sgl::geometry &geom);
 	static void Serialize(const sgl::geometry &geom, char *buffer, size_t buffer_size);
 	static void Deserialize(sgl::geometry &result, ArenaAllocator &arena, const char *buffer, size_t buffer_size);
+
+	// Serialize in the given format. Geometries with vertices that can not be quantized in version 1 (e.g. NaN) are
+	// written in version 0 instead.
+	static size_t GetRequiredSize(const sgl::geometry &geom, const SerdeFormat &format);
+	static void Serialize(const sgl::geometry &geom, const SerdeFormat &format, char *buffer, size_t buffer_size);
+
+	// Decode a version 1 geometry into the version 0 format, for code that reads the raw vertices in place. The varints
+	// are decoded straight into the result, which the caller should reuse so that it rarely has to allocate.
+	static void DecodeToVersion0(const char *buffer, size_t buffer_size, vector<char> &result);
+
+	// Compute the hash stored in the header of a version 1 geometry from its body (everything after the bounding box).
+	// Never returns 0. Version 0 geometries always store 0 there, so that they stay byte-for-byte identical to the
+	// geometries written by earlier versions, and keep comparing equal to them as blobs.
+	static uint16_t GetBodyHash(const char *body, size_t size);
 };
 
-} // namespace duckdb
\ No newline at end of file
+} // namespace duckdb
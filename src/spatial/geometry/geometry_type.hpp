@@ -122,7 +122,8 @@ public:
 			return true;
 		}
 
-		if (header_type == GeometryType::POINT) {
+		// Version 1 stores the bounding box of points too, so only version 0 points have to be read here
+		if (header_type == GeometryType::POINT && !properties.IsVersion1()) {
 			cursor.Skip(4); // skip padding
 
 			// Read the point
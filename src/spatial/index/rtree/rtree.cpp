@@ -1,6 +1,8 @@
 #include "spatial/index/rtree/rtree.hpp"
 #include "duckdb/common/printer.hpp"
 
+#include "sgl/sgl.hpp"
+
 namespace duckdb {
 
 struct InsertResult {
@@ -410,6 +412,228 @@ void RTree::RootInsert(RTreeEntry &root_entry, const RTreeEntry &new_entry) {
 	}
 }
 
+//------------------------------------------------------------------------------
+// Bulk Insert
+//------------------------------------------------------------------------------
+
+// Returns the number of page levels below (and including) the given entry. Returns 0 if the entry is not set,
+// and INVALID_INDEX if the height cant be determined because we hit an empty branch.
+idx_t RTree::GetHeight(const RTreeEntry &entry) const {
+	idx_t height = 0;
+	auto pointer = entry.pointer;
+	while (pointer.IsSet() && pointer.IsPage()) {
+		height++;
+		if (pointer.IsLeafPage()) {
+			break;
+		}
+		const auto &node = Ref(pointer);
+		if (node.GetCount() == 0) {
+			// This can only happen if the min capacity is zero
+			return DConstants::INVALID_INDEX;
+		}
+		// All leaves are at the same depth, so we only need to follow the first child
+		pointer = node[0].pointer;
+	}
+	return height;
+}
+
+// Pack a sorted layer of entries into pages, spreading the entries evenly so that no page falls below the minimum
+// capacity (as long as there are at least max_node_capacity entries). The entries pointing to the new pages are
+// written back to the front of the array, and the number of pages created is returned.
+idx_t RTree::PackLayer(RTreeEntry *entries, idx_t count, RTreeNodeType type) const {
+	D_ASSERT(count != 0);
+
+	const auto node_count = (count + config.max_node_capacity - 1) / config.max_node_capacity;
+	const auto node_base = count / node_count;
+	const auto node_rest = count % node_count;
+
+	idx_t entry_idx = 0;
+	for (idx_t node_idx = 0; node_idx < node_count; node_idx++) {
+		const auto node_size = node_base + (node_idx < node_rest ? 1 : 0);
+
+		const auto pointer = MakePage(type);
+		auto &node = RefMutable(pointer);
+		for (idx_t i = 0; i < node_size; i++) {
+			node.PushEntry(entries[entry_idx++]);
+		}
+
+		if (type == RTreeNodeType::LEAF_PAGE) {
+			node.SortEntriesByRowId();
+		} else {
+			node.SortEntriesByXMin();
+		}
+		node.Verify(config.max_node_capacity);
+
+		// We've already consumed all entries up to this position, so its safe to overwrite
+		D_ASSERT(node_idx < entry_idx);
+		entries[node_idx] = RTreeEntry(pointer, node.GetBounds());
+	}
+	D_ASSERT(entry_idx == count);
+	return node_count;
+}
+
+// Insert a page into the branch node at the level right above it
+InsertResult RTree::BranchGraft(RTreeEntry &entry, idx_t entry_height, const RTreeEntry &new_entry,
+                                idx_t new_entry_height) {
+	D_ASSERT(entry.pointer.IsBranchPage());
+	D_ASSERT(entry_height > new_entry_height);
+
+	// Dereference the node
+	auto &node = RefMutable(entry.pointer);
+
+	if (entry_height - 1 == new_entry_height) {
+		// The children of this node are at the same level as the new page, insert it here
+		if (node.GetCount() == config.max_node_capacity) {
+			return InsertResult {true, false};
+		}
+		node.PushEntry(new_entry);
+		node.SortEntriesByXMin();
+
+		const auto grown = !entry.bounds.Contains(new_entry.bounds);
+		return InsertResult {false, grown};
+	}
+
+	// Otherwise, choose a subtree and descend
+	auto &target = PickSubtree(node, new_entry);
+
+	const auto result = BranchGraft(target, entry_height - 1, new_entry, new_entry_height);
+	if (result.split) {
+		if (node.GetCount() == config.max_node_capacity) {
+			// This node is also full!, we need to split it first.
+			return InsertResult {true, false};
+		}
+
+		// Otherwise, split the selected child
+		auto right = SplitNode(target);
+		node.PushEntry(right);
+		node.SortEntriesByXMin();
+
+		// Now graft again
+		return BranchGraft(entry, entry_height, new_entry, new_entry_height);
+	}
+
+	if (result.grown) {
+		// Update the bounding box of the child
+		target.bounds.Union(new_entry.bounds);
+
+		// Do we need to grow the bounding box?
+		const auto grown = !entry.bounds.Contains(new_entry.bounds);
+		return InsertResult {false, grown};
+	}
+
+	return InsertResult {false, false};
+}
+
+void RTree::RootGraft(RTreeEntry &root_entry, const RTreeEntry &new_entry, idx_t new_entry_height) {
+	// If there is no root node, the new page becomes the root
+	if (!root_entry.pointer.IsSet()) {
+		root_entry = new_entry;
+		return;
+	}
+
+	const auto root_height = GetHeight(root_entry);
+	D_ASSERT(root_height != DConstants::INVALID_INDEX);
+
+	if (root_height < new_entry_height) {
+		// The new page is taller than the tree, so make it the root and graft the old tree into it instead
+		const auto old_root = root_entry;
+		root_entry = new_entry;
+		RootGraft(root_entry, old_root, root_height);
+		return;
+	}
+
+	if (root_height == new_entry_height) {
+		// Same height, create a new root holding both
+		auto new_root_ptr = MakePage(RTreeNodeType::BRANCH_PAGE);
+		auto &new_root = RefMutable(new_root_ptr);
+		new_root.PushEntry(root_entry);
+		new_root.PushEntry(new_entry);
+		new_root.SortEntriesByXMin();
+
+		root_entry = RTreeEntry(new_root_ptr, RTreeBounds::Union(root_entry.bounds, new_entry.bounds));
+		return;
+	}
+
+	const auto result = BranchGraft(root_entry, root_height, new_entry, new_entry_height);
+	if (result.split) {
+		// The root node was split, we need to create a new root node
+		auto new_root_ptr = MakePage(RTreeNodeType::BRANCH_PAGE);
+		auto &new_root = RefMutable(new_root_ptr);
+
+		// Insert the old root into the new root, and split it
+		new_root.PushEntry(root_entry);
+		auto right = SplitNode(new_root[0]);
+		new_root.PushEntry(right);
+
+		// Update the root pointer
+		root_entry.pointer = new_root_ptr;
+
+		// Graft the new page into the new root now that we have space
+		RootGraft(root_entry, new_entry, new_entry_height);
+		return;
+	}
+
+	if (result.grown) {
+		// Update the root bounding box
+		root_entry.bounds.Union(new_entry.bounds);
+	}
+}
+
+void RTree::BulkInsert(RTreeEntry *entries, idx_t count) {
+	const auto tree_height = GetHeight(root);
+
+	// If we cant fill a single page there is nothing to gain from packing, just insert the entries one by one
+	if (count < config.max_node_capacity || tree_height == DConstants::INVALID_INDEX) {
+		for (idx_t i = 0; i < count; i++) {
+			RootInsert(root, entries[i]);
+		}
+		return;
+	}
+
+	// Sort the entries along a hilbert curve spanning the bounds of the batch
+	RTreeBounds batch_bounds;
+	for (idx_t i = 0; i < count; i++) {
+		batch_bounds.Union(entries[i].bounds);
+	}
+
+	constexpr auto max_hilbert = std::numeric_limits<uint16_t>::max();
+	const auto batch_w = batch_bounds.max.x - batch_bounds.min.x;
+	const auto batch_h = batch_bounds.max.y - batch_bounds.min.y;
+	const auto hw = batch_w > 0 ? max_hilbert / batch_w : 0;
+	const auto hh = batch_h > 0 ? max_hilbert / batch_h : 0;
+
+	vector<pair<uint32_t, RTreeEntry>> curve;
+	curve.reserve(count);
+	for (idx_t i = 0; i < count; i++) {
+		const auto center = entries[i].bounds.Center();
+		const auto hx = static_cast<uint32_t>(hw * (center.x - batch_bounds.min.x));
+		const auto hy = static_cast<uint32_t>(hh * (center.y - batch_bounds.min.y));
+		curve.emplace_back(sgl::util::hilbert_encode(16, hx, hy), entries[i]);
+	}
+
+	std::sort(curve.begin(), curve.end(),
+	          [](const pair<uint32_t, RTreeEntry> &a, const pair<uint32_t, RTreeEntry> &b) { return a.first < b.first; });
+
+	for (idx_t i = 0; i < count; i++) {
+		entries[i] = curve[i].second;
+	}
+
+	// Pack the leaves, and then as many branch layers as we can while every page stays above the minimum capacity
+	// and the subtree stays shorter than the tree we are grafting it into.
+	auto layer_count = PackLayer(entries, count, RTreeNodeType::LEAF_PAGE);
+	idx_t layer_height = 1;
+
+	while (layer_count >= config.max_node_capacity && (tree_height == 0 || layer_height + 1 < tree_height)) {
+		layer_count = PackLayer(entries, layer_count, RTreeNodeType::BRANCH_PAGE);
+		layer_height++;
+	}
+
+	// Graft the top layer of the packed subtree into the tree
+	for (idx_t i = 0; i < layer_count; i++) {
+		RootGraft(root, entries[i], layer_height);
+	}
+}
+
 //------------------------------------------------------------------------------
 // Delete
 //------------------------------------------------------------------------------
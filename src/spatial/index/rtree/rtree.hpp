@@ -14,6 +14,9 @@ struct RTreeConfig {
 	idx_t max_node_capacity = 128;
 	idx_t min_node_capacity = 50;
 
+	// Pack appended batches into subtrees and graft them into the tree, instead of inserting row by row
+	bool bulk_insert = false;
+
 	// TODO: Allow setting leaf capacity separately
 	// idx_t max_leaf_capacity;
 	// idx_t min_leaf_capacity;
@@ -39,6 +42,10 @@ public:
 		RootInsert(root, entry);
 	}
 
+	// Hilbert-sort and pack a batch of row id entries into a subtree, and graft it into the tree.
+	// This reorders the entries in-place.
+	void BulkInsert(RTreeEntry *entries, idx_t count);
+
 	void Delete(const RTreeEntry &entry) {
 		RootDelete(root, entry);
 	}
@@ -97,6 +104,12 @@ private:
 	InsertResult BranchInsert(RTreeEntry &entry, const RTreeEntry &new_entry);
 	RTreeEntry &PickSubtree(RTreeNode &node, const RTreeEntry &new_entry) const;
 
+	idx_t GetHeight(const RTreeEntry &entry) const;
+	idx_t PackLayer(RTreeEntry *entries, idx_t count, RTreeNodeType type) const;
+	void RootGraft(RTreeEntry &root_entry, const RTreeEntry &new_entry, idx_t new_entry_height);
+	InsertResult BranchGraft(RTreeEntry &entry, idx_t entry_height, const RTreeEntry &new_entry,
+	                         idx_t new_entry_height);
+
 	RTreeEntry SplitNode(RTreeEntry &entry) const;
 	void RebalanceSplitNodes(RTreeNode &src, RTreeNode &dst, bool split_axis, PointXY<float> &split_point) const;
 
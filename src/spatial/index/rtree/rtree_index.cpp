@@ -21,6 +21,9 @@ class RTreeIndexScanState final : public IndexScanState {
 public:
 	RTreeBounds query_bounds;
 	RTreeScanner scanner;
+
+	bool is_knn = false;
+	RTreeKNNScanner knn_scanner;
 };
 
 //------------------------------------------------------------------------------
@@ -59,6 +62,11 @@ static RTreeConfig ParseOptions(const case_insensitive_map_t<Value> &options) {
 		}
 	}
 
+	const auto bulk_insert_search = options.find("bulk_insert");
+	if (bulk_insert_search != options.end()) {
+		config.bulk_insert = bulk_insert_search->second.GetValue<bool>();
+	}
+
 	return config;
 }
 
@@ -113,10 +121,81 @@ unique_ptr<IndexScanState> RTreeIndex::InitializeScan(const RTreeBounds &query)
 	return std::move(state);
 }
 
+unique_ptr<IndexScanState> RTreeIndex::InitializeScan(const RTreeBounds &query, const RTreeEntry &partition) const {
+	auto state = make_uniq<RTreeIndexScanState>();
+	state->query_bounds = query;
+	state->scanner.Init(partition);
+	return std::move(state);
+}
+
+vector<RTreeEntry> RTreeIndex::GetScanPartitions(const RTreeBounds &query, idx_t target_count) const {
+	lock_guard<mutex> guard(scan_lock);
+	vector<RTreeEntry> result;
+
+	auto &root = tree->GetRoot();
+	if (root.pointer.Get() == 0 || !query.Intersects(root.bounds)) {
+		return result;
+	}
+	result.push_back(root);
+
+	// The tree is balanced, so all the partitions are always on the same level
+	vector<RTreeEntry> next;
+	while (result.size() < target_count && result[0].pointer.IsBranchPage()) {
+		next.clear();
+		for (auto &partition : result) {
+			auto &node = tree->Ref(partition.pointer);
+			for (idx_t i = 0; i < node.GetCount(); i++) {
+				if (query.Intersects(node[i].bounds)) {
+					next.push_back(node[i]);
+				}
+			}
+		}
+		std::swap(result, next);
+		if (result.empty()) {
+			break;
+		}
+	}
+	return result;
+}
+
+unique_ptr<IndexScanState> RTreeIndex::InitializeKNNScan(const RTreeBounds &query, idx_t k) const {
+	auto state = make_uniq<RTreeIndexScanState>();
+	state->query_bounds = query;
+	state->is_knn = true;
+	auto &root = tree->GetRoot();
+	if (root.pointer.Get() != 0) {
+		state->knn_scanner.Init(root, query, k);
+	}
+	return std::move(state);
+}
+
+idx_t RTreeIndex::Scan(IndexScanState &state, Vector &result, const std::function<bool(row_t)> &is_visible) const {
+	auto &sstate = state.Cast<RTreeIndexScanState>();
+	D_ASSERT(sstate.is_knn);
+	const auto row_ids = FlatVector::GetData<row_t>(result);
+
+	lock_guard<mutex> guard(scan_lock);
+	idx_t output_idx = 0;
+	sstate.knn_scanner.Scan(*tree, [&](const RTreeEntry &entry) {
+		const auto row_id = entry.pointer.GetRowId();
+		if (!is_visible(row_id)) {
+			return RTreeScanResult::SKIP;
+		}
+		row_ids[output_idx++] = row_id;
+		return output_idx == STANDARD_VECTOR_SIZE ? RTreeScanResult::YIELD : RTreeScanResult::CONTINUE;
+	});
+	return output_idx;
+}
+
 idx_t RTreeIndex::Scan(IndexScanState &state, Vector &result) const {
 	auto &sstate = state.Cast<RTreeIndexScanState>();
+	if (sstate.is_knn) {
+		return Scan(state, result, [](row_t) { return true; });
+	}
+
 	const auto row_ids = FlatVector::GetData<row_t>(result);
 
+	lock_guard<mutex> guard(scan_lock);
 	idx_t output_idx = 0;
 	sstate.scanner.Scan(*tree, [&](const RTreeEntry &entry, const idx_t &) {
 		// Does this entry intersect with the query bounds?
@@ -156,11 +235,10 @@ ErrorData RTreeIndex::Insert(IndexLock &lock, DataChunk &input, Vector &rowid_ve
 	}
 
 	RTreeEntry entry_buffer[STANDARD_VECTOR_SIZE];
-	bool valid_buffer[STANDARD_VECTOR_SIZE];
+	idx_t entry_count = 0;
 
 	for (idx_t i = 0; i < input.size(); i++) {
 		if (FlatVector::IsNull(geom_vec, i) || FlatVector::IsNull(rowid_vec, i)) {
-			valid_buffer[i] = false;
 			continue;
 		}
 
@@ -168,23 +246,22 @@ ErrorData RTreeIndex::Insert(IndexLock &lock, DataChunk &input, Vector &rowid_ve
 
 		Box2D<float> bbox;
 		if (!geom_data[i].TryGetCachedBounds(bbox)) {
-			valid_buffer[i] = false;
 			continue;
 		}
 
-		entry_buffer[i] = {RTree::MakeRowId(rowid), bbox};
-		valid_buffer[i] = true;
+		entry_buffer[entry_count++] = {RTree::MakeRowId(rowid), bbox};
 	}
 
-	// TODO: Investigate this more, is there a better way to insert multiple entries
-	// so that they produce a better tree?
-	// E.g. sort by x coordinate, or hilbert sort? or STR packing?
-	// Or insert by smallest first? or largest first?
-	// Or even create a separate subtree entirely, and then insert that into the root?
-	for (idx_t i = 0; i < input.size(); i++) {
-		if (valid_buffer[i]) {
-			tree->Insert(entry_buffer[i]);
-		}
+	if (tree->GetConfig().bulk_insert) {
+		// Pack the whole chunk into a subtree and graft it into the tree
+		tree->BulkInsert(entry_buffer, entry_count);
+		return ErrorData {};
+	}
+
+	// TODO: Investigate this more, is there a better way to insert multiple entries one by one
+	// so that they produce a better tree? E.g. insert by smallest first? or largest first?
+	for (idx_t i = 0; i < entry_count; i++) {
+		tree->Insert(entry_buffer[i]);
 	}
 
 	return ErrorData {};
@@ -4,6 +4,7 @@
 #include "spatial/index/rtree/rtree_node.hpp"
 #include "spatial/index/rtree/rtree.hpp"
 
+#include "duckdb/common/mutex.hpp"
 #include "duckdb/execution/index/bound_index.hpp"
 #include "duckdb/execution/index/fixed_size_allocator.hpp"
 #include "duckdb/execution/index/index_pointer.hpp"
@@ -24,9 +25,23 @@ public:
 	           const IndexStorageInfo &info = IndexStorageInfo(), idx_t estimated_cardinality = 0);
 
 	unique_ptr<RTree> tree;
+	//! The allocators pin the buffers of the nodes lazily when they are first accessed, which is not thread-safe.
+	//! Scans can run on multiple threads at once, so they only access the nodes while holding this lock.
+	mutable mutex scan_lock;
 
 	unique_ptr<IndexScanState> InitializeScan(const Box2D<float> &query) const;
+	//! Initialize a scan of only the given subtree, as returned by GetScanPartitions
+	unique_ptr<IndexScanState> InitializeScan(const Box2D<float> &query, const RTreeEntry &partition) const;
+	//! Split the part of the tree that intersects the query into disjoint subtrees that can be scanned independently.
+	//! Descends level by level until there are at least "target_count" subtrees, or the leaf pages are reached.
+	vector<RTreeEntry> GetScanPartitions(const Box2D<float> &query, idx_t target_count) const;
+	//! Initialize a scan returning the row ids in ascending order of their box distance to the query box, stopping
+	//! once the remaining rows can no longer be among the k nearest (see RTreeKNNScanner)
+	unique_ptr<IndexScanState> InitializeKNNScan(const Box2D<float> &query, idx_t k) const;
 	idx_t Scan(IndexScanState &state, Vector &result) const;
+	//! Scan the next row ids of a KNN scan, skipping the rows for which "is_visible" returns false. The skipped rows
+	//! do not count towards the k nearest, so the scan still returns k rows if some of them were deleted.
+	idx_t Scan(IndexScanState &state, Vector &result, const std::function<bool(row_t)> &is_visible) const;
 
 	static unique_ptr<BoundIndex> Create(CreateIndexInput &input) {
 		auto res = make_uniq<RTreeIndex>(input.name, input.constraint_type, input.column_ids, input.table_io_manager,
@@ -0,0 +1,584 @@
+#include "spatial/index/rtree/rtree_index_create_hilbert.hpp"
+#include "spatial/index/rtree/rtree_index_create_physical.hpp"
+#include "spatial/index/rtree/rtree_index.hpp"
+#include "spatial/index/rtree/rtree_node.hpp"
+#include "spatial/geometry/sgl.hpp"
+#include "spatial/util/managed_collection.hpp"
+
+#include "duckdb/catalog/catalog_entry/duck_table_entry.hpp"
+#include "duckdb/catalog/catalog_entry/table_catalog_entry.hpp"
+#include "duckdb/common/mutex.hpp"
+#include "duckdb/main/attached_database.hpp"
+#include "duckdb/parallel/base_pipeline_event.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
+#include "duckdb/storage/buffer_manager.hpp"
+#include "duckdb/storage/table_io_manager.hpp"
+
+namespace duckdb {
+
+//-------------------------------------------------------------
+// Physical Create RTree Index (Hilbert)
+//-------------------------------------------------------------
+PhysicalCreateRTreeIndexHilbert::PhysicalCreateRTreeIndexHilbert(LogicalOperator &op, TableCatalogEntry &table,
+                                                                 const vector<column_t> &column_ids,
+                                                                 unique_ptr<CreateIndexInfo> info,
+                                                                 vector<unique_ptr<Expression>> unbound_expressions,
+                                                                 idx_t estimated_cardinality)
+    // Declare this operators as a EXTENSION operator
+    : PhysicalOperator(PhysicalOperatorType::EXTENSION, op.types, estimated_cardinality),
+      table(table.Cast<DuckTableEntry>()), info(std::move(info)), unbound_expressions(std::move(unbound_expressions)) {
+
+	// convert virtual column ids to storage column ids
+	for (auto &column_id : column_ids) {
+		storage_ids.push_back(table.GetColumns().LogicalToPhysical(LogicalIndex(column_id)).index);
+	}
+}
+
+//-------------------------------------------------------------
+// Global State
+//-------------------------------------------------------------
+namespace {
+
+struct RTreeSortEntry {
+	uint32_t key;
+	RTreeEntry entry;
+};
+
+} // namespace
+
+class CreateRTreeIndexHilbertGlobalState final : public GlobalSinkState {
+public:
+	explicit CreateRTreeIndexHilbertGlobalState(ClientContext &context)
+	    : manager(BufferManager::GetBufferManager(context)) {
+	}
+
+	//! Global index to be added to the table
+	unique_ptr<RTreeIndex> rtree;
+	BufferManager &manager;
+
+	//! The total number of entries in the RTree, and their bounds
+	idx_t rtree_size = 0;
+	RTreeBounds rtree_bounds;
+
+	//! The entries sunk by each thread
+	mutex runs_lock;
+	vector<unique_ptr<ManagedCollection<RTreeEntry>>> runs;
+
+	//! The entries, radix partitioned by the most significant bits of their hilbert key
+	idx_t radix_bits = 0;
+	vector<unique_ptr<ManagedCollection<RTreeSortEntry>>> partitions;
+	vector<ManagedCollectionAppendState> partition_append_states;
+	unsafe_unique_array<mutex> partition_locks;
+
+	//! The leaf pages produced from each partition
+	vector<vector<RTreeEntry>> partition_pages;
+
+	//! The layer currently being packed, and the layer above it
+	vector<RTreeEntry> curr_layer;
+	vector<RTreeEntry> next_layer;
+
+	//! The node allocators are not thread-safe, so pages are allocated in batches under this lock
+	mutex alloc_lock;
+
+	idx_t max_node_capacity = 0;
+
+	idx_t PartitionCount() const {
+		return idx_t(1) << radix_bits;
+	}
+
+	uint32_t GetHilbertKey(const RTreeBounds &bounds) const {
+		constexpr auto max_hilbert = std::numeric_limits<uint16_t>::max();
+
+		const auto tree_w = rtree_bounds.max.x - rtree_bounds.min.x;
+		const auto tree_h = rtree_bounds.max.y - rtree_bounds.min.y;
+		const auto hw = tree_w > 0 ? max_hilbert / tree_w : 0;
+		const auto hh = tree_h > 0 ? max_hilbert / tree_h : 0;
+
+		const auto center = bounds.Center();
+		const auto hx = static_cast<uint32_t>(hw * (center.x - rtree_bounds.min.x));
+		const auto hy = static_cast<uint32_t>(hh * (center.y - rtree_bounds.min.y));
+		return sgl::util::hilbert_encode(16, hx, hy);
+	}
+
+	idx_t GetPartition(const uint32_t key) const {
+		return radix_bits == 0 ? 0 : key >> (32 - radix_bits);
+	}
+};
+
+unique_ptr<GlobalSinkState> PhysicalCreateRTreeIndexHilbert::GetGlobalSinkState(ClientContext &context) const {
+	auto gstate = make_uniq<CreateRTreeIndexHilbertGlobalState>(context);
+
+	// Create the index
+	auto &storage = table.GetStorage();
+	auto &table_manager = TableIOManager::Get(storage);
+	auto &constraint_type = info->constraint_type;
+	auto &db = storage.db;
+	gstate->rtree =
+	    make_uniq<RTreeIndex>(info->index_name, constraint_type, storage_ids, table_manager, unbound_expressions, db,
+	                          info->options, IndexStorageInfo(), estimated_cardinality);
+
+	gstate->max_node_capacity = gstate->rtree->tree->GetConfig().max_node_capacity;
+
+	return std::move(gstate);
+}
+
+//-------------------------------------------------------------
+// Local State
+//-------------------------------------------------------------
+class CreateRTreeIndexHilbertLocalState final : public LocalSinkState {
+public:
+	explicit CreateRTreeIndexHilbertLocalState(ClientContext &context)
+	    : collection(make_uniq<ManagedCollection<RTreeEntry>>(BufferManager::GetBufferManager(context))) {
+		collection->InitializeAppend(append_state);
+	}
+
+	unique_ptr<ManagedCollection<RTreeEntry>> collection;
+	ManagedCollectionAppendState append_state;
+	RTreeBounds bounds;
+};
+
+unique_ptr<LocalSinkState> PhysicalCreateRTreeIndexHilbert::GetLocalSinkState(ExecutionContext &context) const {
+	return make_uniq<CreateRTreeIndexHilbertLocalState>(context.client);
+}
+
+//-------------------------------------------------------------
+// Sink
+//-------------------------------------------------------------
+SinkResultType PhysicalCreateRTreeIndexHilbert::Sink(ExecutionContext &context, DataChunk &chunk,
+                                                     OperatorSinkInput &input) const {
+	auto &lstate = input.local_state.Cast<CreateRTreeIndexHilbertLocalState>();
+
+	if (chunk.size() == 0) {
+		return SinkResultType::NEED_MORE_INPUT;
+	}
+
+	// TODO: Dont flatten chunk
+	chunk.Flatten();
+
+	const auto &bbox_vecs = StructVector::GetEntries(chunk.data[0]);
+	const auto &rowid_data = FlatVector::GetData<row_t>(chunk.data[1]);
+	const auto min_x_data = FlatVector::GetData<float>(*bbox_vecs[0]);
+	const auto min_y_data = FlatVector::GetData<float>(*bbox_vecs[1]);
+	const auto max_x_data = FlatVector::GetData<float>(*bbox_vecs[2]);
+	const auto max_y_data = FlatVector::GetData<float>(*bbox_vecs[3]);
+
+	// Vectorized conversion from columnar to row-wise
+	RTreeEntry entries[STANDARD_VECTOR_SIZE];
+	for (idx_t elem_idx = 0; elem_idx < chunk.size(); elem_idx++) {
+		auto &entry = entries[elem_idx];
+		entry.pointer = RTree::MakeRowId(rowid_data[elem_idx]);
+		entry.bounds.min.x = min_x_data[elem_idx];
+		entry.bounds.min.y = min_y_data[elem_idx];
+		entry.bounds.max.x = max_x_data[elem_idx];
+		entry.bounds.max.y = max_y_data[elem_idx];
+
+		lstate.bounds.Union(entry.bounds);
+	}
+
+	// Append the chunk to the thread-local run
+	lstate.collection->Append(lstate.append_state, entries, entries + chunk.size());
+
+	return SinkResultType::NEED_MORE_INPUT;
+}
+
+//-------------------------------------------------------------
+// Combine
+//-------------------------------------------------------------
+SinkCombineResultType PhysicalCreateRTreeIndexHilbert::Combine(ExecutionContext &context,
+                                                               OperatorSinkCombineInput &input) const {
+	auto &gstate = input.global_state.Cast<CreateRTreeIndexHilbertGlobalState>();
+	auto &lstate = input.local_state.Cast<CreateRTreeIndexHilbertLocalState>();
+
+	// Unpin the last block of the run
+	lstate.append_state.handle.Destroy();
+
+	const auto count = lstate.collection->Count();
+	if (count == 0) {
+		return SinkCombineResultType::FINISHED;
+	}
+
+	lock_guard<mutex> guard(gstate.runs_lock);
+	gstate.runs.push_back(std::move(lstate.collection));
+	gstate.rtree_bounds.Union(lstate.bounds);
+	gstate.rtree_size += count;
+
+	return SinkCombineResultType::FINISHED;
+}
+
+//-------------------------------------------------------------
+// RTree Construction
+//-------------------------------------------------------------
+
+// Pack the entries into pages of max_node_capacity entries each (except the last one), writing the entries pointing
+// to the new pages to the output. The allocation of the pages is serialized, but filling them is not.
+static void PackPages(CreateRTreeIndexHilbertGlobalState &gstate, const RTreeNodeType type, const RTreeEntry *entries,
+                      const idx_t count, RTreeEntry *output) {
+	auto &tree = *gstate.rtree->tree;
+	const auto capacity = gstate.max_node_capacity;
+	const auto page_count = (count + capacity - 1) / capacity;
+
+	static constexpr idx_t PAGE_BATCH_SIZE = 64;
+	RTreePointer pointers[PAGE_BATCH_SIZE];
+	RTreeNode *nodes[PAGE_BATCH_SIZE];
+
+	idx_t entry_idx = 0;
+	for (idx_t batch_beg = 0; batch_beg < page_count; batch_beg += PAGE_BATCH_SIZE) {
+		const auto batch_size = MinValue<idx_t>(PAGE_BATCH_SIZE, page_count - batch_beg);
+
+		// Allocate a batch of pages
+		{
+			lock_guard<mutex> guard(gstate.alloc_lock);
+			for (idx_t i = 0; i < batch_size; i++) {
+				pointers[i] = tree.MakePage(type);
+				nodes[i] = &tree.RefMutable(pointers[i]);
+			}
+		}
+
+		// Now fill them
+		for (idx_t i = 0; i < batch_size; i++) {
+			auto &node = *nodes[i];
+			const auto node_size = MinValue<idx_t>(capacity, count - entry_idx);
+			for (idx_t j = 0; j < node_size; j++) {
+				node.PushEntry(entries[entry_idx++]);
+			}
+			if (type == RTreeNodeType::LEAF_PAGE) {
+				// If the node is a leaf node, sort it by row id
+				node.SortEntriesByRowId();
+			}
+			node.Verify(capacity);
+			output[batch_beg + i] = RTreeEntry(pointers[i], node.GetBounds());
+		}
+	}
+	D_ASSERT(entry_idx == count);
+}
+
+static void FinishRTree(ClientContext &context, CreateRTreeIndexHilbertGlobalState &gstate, CreateIndexInfo &info,
+                        DuckTableEntry &table) {
+	D_ASSERT(gstate.curr_layer.size() == 1);
+	D_ASSERT(gstate.curr_layer[0].pointer.IsPage());
+
+	gstate.rtree->tree->SetRoot(gstate.curr_layer[0]);
+	gstate.curr_layer.clear();
+
+	AddRTreeIndexToCatalog(context, gstate.rtree, info, table);
+}
+
+//-------------------------------------------------------------
+// Branch layers
+//-------------------------------------------------------------
+class RTreeIndexLayerTask final : public ExecutorTask {
+public:
+	RTreeIndexLayerTask(shared_ptr<Event> event_p, ClientContext &context, CreateRTreeIndexHilbertGlobalState &gstate,
+	                    const PhysicalOperator &op, idx_t page_beg_p, idx_t page_end_p)
+	    : ExecutorTask(context, std::move(event_p), op), gstate(gstate), page_beg(page_beg_p), page_end(page_end_p) {
+	}
+
+	TaskExecutionResult ExecuteTask(TaskExecutionMode mode) override {
+		const auto capacity = gstate.max_node_capacity;
+		const auto entry_beg = page_beg * capacity;
+		const auto entry_end = MinValue<idx_t>(page_end * capacity, gstate.curr_layer.size());
+
+		PackPages(gstate, RTreeNodeType::BRANCH_PAGE, gstate.curr_layer.data() + entry_beg, entry_end - entry_beg,
+		          gstate.next_layer.data() + page_beg);
+
+		event->FinishTask();
+		return TaskExecutionResult::TASK_FINISHED;
+	}
+
+private:
+	CreateRTreeIndexHilbertGlobalState &gstate;
+	idx_t page_beg;
+	idx_t page_end;
+};
+
+class RTreeIndexLayerEvent final : public BasePipelineEvent {
+public:
+	RTreeIndexLayerEvent(CreateRTreeIndexHilbertGlobalState &gstate_p, Pipeline &pipeline_p, CreateIndexInfo &info_p,
+	                     DuckTableEntry &table_p, const PhysicalOperator &op_p)
+	    : BasePipelineEvent(pipeline_p), gstate(gstate_p), info(info_p), table(table_p), op(op_p) {
+	}
+
+	void Schedule() override {
+		auto &context = pipeline->GetClientContext();
+
+		const auto capacity = gstate.max_node_capacity;
+		const auto page_count = (gstate.curr_layer.size() + capacity - 1) / capacity;
+		gstate.next_layer.resize(page_count);
+
+		// Every task packs a contiguous range of pages, so the layer stays in hilbert order
+		static constexpr idx_t PAGES_PER_TASK = 1024;
+
+		vector<shared_ptr<Task>> tasks;
+		for (idx_t page_beg = 0; page_beg < page_count; page_beg += PAGES_PER_TASK) {
+			const auto page_end = MinValue<idx_t>(page_beg + PAGES_PER_TASK, page_count);
+			tasks.push_back(
+			    make_uniq<RTreeIndexLayerTask>(shared_from_this(), context, gstate, op, page_beg, page_end));
+		}
+		SetTasks(std::move(tasks));
+	}
+
+	void FinishEvent() override {
+		std::swap(gstate.curr_layer, gstate.next_layer);
+		gstate.next_layer.clear();
+
+		if (gstate.curr_layer.size() == 1) {
+			FinishRTree(pipeline->GetClientContext(), gstate, info, table);
+			return;
+		}
+
+		// Otherwise, pack the next layer
+		InsertEvent(make_shared_ptr<RTreeIndexLayerEvent>(gstate, *pipeline, info, table, op));
+	}
+
+private:
+	CreateRTreeIndexHilbertGlobalState &gstate;
+	CreateIndexInfo &info;
+	DuckTableEntry &table;
+	const PhysicalOperator &op;
+};
+
+//-------------------------------------------------------------
+// Leaf layer
+//-------------------------------------------------------------
+class RTreeIndexSortTask final : public ExecutorTask {
+public:
+	RTreeIndexSortTask(shared_ptr<Event> event_p, ClientContext &context, CreateRTreeIndexHilbertGlobalState &gstate,
+	                   const PhysicalOperator &op, idx_t partition_idx_p)
+	    : ExecutorTask(context, std::move(event_p), op), gstate(gstate), partition_idx(partition_idx_p) {
+	}
+
+	TaskExecutionResult ExecuteTask(TaskExecutionMode mode) override {
+		auto &partition = *gstate.partitions[partition_idx];
+		const auto count = partition.Count();
+
+		// Materialize the partition
+		auto buffer = gstate.manager.GetBufferAllocator().Allocate(count * sizeof(RTreeSortEntry));
+		const auto sort_beg = reinterpret_cast<RTreeSortEntry *>(buffer.get());
+		const auto sort_end = sort_beg + count;
+
+		ManagedCollectionScanState scan_state;
+		partition.InitializeScan(scan_state, true);
+		const auto scan_count = partition.Scan(scan_state, sort_beg, sort_end);
+		D_ASSERT(scan_count == count);
+		(void)scan_count;
+		partition.Clear();
+
+		// Sort the partition on the hilbert key
+		std::sort(sort_beg, sort_end,
+		          [](const RTreeSortEntry &a, const RTreeSortEntry &b) { return a.key < b.key; });
+
+		// Strip the keys, compacting the entries in-place. Every entry is read before it can be overwritten.
+		const auto entry_ptr = buffer.get();
+		for (idx_t i = 0; i < count; i++) {
+			const auto entry = sort_beg[i].entry;
+			Store<RTreeEntry>(entry, entry_ptr + i * sizeof(RTreeEntry));
+		}
+		const auto entries = reinterpret_cast<const RTreeEntry *>(entry_ptr);
+
+		// Pack the leaf pages
+		auto &pages = gstate.partition_pages[partition_idx];
+		pages.resize((count + gstate.max_node_capacity - 1) / gstate.max_node_capacity);
+		PackPages(gstate, RTreeNodeType::LEAF_PAGE, entries, count, pages.data());
+
+		event->FinishTask();
+		return TaskExecutionResult::TASK_FINISHED;
+	}
+
+private:
+	CreateRTreeIndexHilbertGlobalState &gstate;
+	idx_t partition_idx;
+};
+
+class RTreeIndexSortEvent final : public BasePipelineEvent {
+public:
+	RTreeIndexSortEvent(CreateRTreeIndexHilbertGlobalState &gstate_p, Pipeline &pipeline_p, CreateIndexInfo &info_p,
+	                    DuckTableEntry &table_p, const PhysicalOperator &op_p)
+	    : BasePipelineEvent(pipeline_p), gstate(gstate_p), info(info_p), table(table_p), op(op_p) {
+	}
+
+	void Schedule() override {
+		auto &context = pipeline->GetClientContext();
+
+		// Flush the partitions
+		for (auto &append_state : gstate.partition_append_states) {
+			append_state.handle.Destroy();
+		}
+
+		gstate.partition_pages.resize(gstate.PartitionCount());
+
+		// One task per non-empty partition
+		vector<shared_ptr<Task>> tasks;
+		for (idx_t partition_idx = 0; partition_idx < gstate.PartitionCount(); partition_idx++) {
+			if (gstate.partitions[partition_idx]->Count() == 0) {
+				continue;
+			}
+			tasks.push_back(make_uniq<RTreeIndexSortTask>(shared_from_this(), context, gstate, op, partition_idx));
+		}
+		D_ASSERT(!tasks.empty());
+		SetTasks(std::move(tasks));
+	}
+
+	void FinishEvent() override {
+		// Concatenate the leaf pages of all partitions, in partition order
+		for (auto &pages : gstate.partition_pages) {
+			gstate.curr_layer.insert(gstate.curr_layer.end(), pages.begin(), pages.end());
+		}
+		gstate.partition_pages.clear();
+		gstate.partitions.clear();
+		gstate.partition_append_states.clear();
+
+		if (gstate.curr_layer.size() == 1) {
+			FinishRTree(pipeline->GetClientContext(), gstate, info, table);
+			return;
+		}
+
+		// Otherwise, pack the branch layers
+		InsertEvent(make_shared_ptr<RTreeIndexLayerEvent>(gstate, *pipeline, info, table, op));
+	}
+
+private:
+	CreateRTreeIndexHilbertGlobalState &gstate;
+	CreateIndexInfo &info;
+	DuckTableEntry &table;
+	const PhysicalOperator &op;
+};
+
+//-------------------------------------------------------------
+// Partitioning
+//-------------------------------------------------------------
+class RTreeIndexPartitionTask final : public ExecutorTask {
+public:
+	RTreeIndexPartitionTask(shared_ptr<Event> event_p, ClientContext &context,
+	                        CreateRTreeIndexHilbertGlobalState &gstate, const PhysicalOperator &op, idx_t run_idx_p)
+	    : ExecutorTask(context, std::move(event_p), op), gstate(gstate), run_idx(run_idx_p) {
+	}
+
+	TaskExecutionResult ExecuteTask(TaskExecutionMode mode) override {
+		auto &run = *gstate.runs[run_idx];
+
+		// Buffer a few entries per partition locally, so that we dont have to lock on every entry
+		static constexpr idx_t FLUSH_SIZE = 128;
+		const auto partition_count = gstate.PartitionCount();
+		vector<vector<RTreeSortEntry>> buffers(partition_count);
+
+		RTreeEntry entries[STANDARD_VECTOR_SIZE];
+		ManagedCollectionScanState scan_state;
+		run.InitializeScan(scan_state, true);
+
+		auto scan_count = run.Scan(scan_state, entries, entries + STANDARD_VECTOR_SIZE);
+		while (scan_count != 0) {
+			for (idx_t i = 0; i < scan_count; i++) {
+				const auto key = gstate.GetHilbertKey(entries[i].bounds);
+				const auto partition_idx = gstate.GetPartition(key);
+
+				auto &buffer = buffers[partition_idx];
+				buffer.push_back({key, entries[i]});
+				if (buffer.size() == FLUSH_SIZE) {
+					Flush(partition_idx, buffer);
+				}
+			}
+			scan_count = run.Scan(scan_state, entries, entries + STANDARD_VECTOR_SIZE);
+		}
+
+		for (idx_t partition_idx = 0; partition_idx < partition_count; partition_idx++) {
+			Flush(partition_idx, buffers[partition_idx]);
+		}
+
+		// We are done with this run
+		gstate.runs[run_idx].reset();
+
+		event->FinishTask();
+		return TaskExecutionResult::TASK_FINISHED;
+	}
+
+private:
+	void Flush(idx_t partition_idx, vector<RTreeSortEntry> &buffer) {
+		if (buffer.empty()) {
+			return;
+		}
+		lock_guard<mutex> guard(gstate.partition_locks[partition_idx]);
+		auto &partition = *gstate.partitions[partition_idx];
+		auto &append_state = gstate.partition_append_states[partition_idx];
+		if (!append_state.block) {
+			// Lazily initialize the partition, most partitions are small if the data is skewed
+			partition.InitializeAppend(append_state);
+		}
+		partition.Append(append_state, buffer.data(), buffer.data() + buffer.size());
+		buffer.clear();
+	}
+
+	CreateRTreeIndexHilbertGlobalState &gstate;
+	idx_t run_idx;
+};
+
+class RTreeIndexPartitionEvent final : public BasePipelineEvent {
+public:
+	RTreeIndexPartitionEvent(CreateRTreeIndexHilbertGlobalState &gstate_p, Pipeline &pipeline_p,
+	                         CreateIndexInfo &info_p, DuckTableEntry &table_p, const PhysicalOperator &op_p)
+	    : BasePipelineEvent(pipeline_p), gstate(gstate_p), info(info_p), table(table_p), op(op_p) {
+	}
+
+	void Schedule() override {
+		auto &context = pipeline->GetClientContext();
+
+		// One task per thread-local run
+		vector<shared_ptr<Task>> tasks;
+		for (idx_t run_idx = 0; run_idx < gstate.runs.size(); run_idx++) {
+			tasks.push_back(make_uniq<RTreeIndexPartitionTask>(shared_from_this(), context, gstate, op, run_idx));
+		}
+		SetTasks(std::move(tasks));
+	}
+
+	void FinishEvent() override {
+		gstate.runs.clear();
+		InsertEvent(make_shared_ptr<RTreeIndexSortEvent>(gstate, *pipeline, info, table, op));
+	}
+
+private:
+	CreateRTreeIndexHilbertGlobalState &gstate;
+	CreateIndexInfo &info;
+	DuckTableEntry &table;
+	const PhysicalOperator &op;
+};
+
+//-------------------------------------------------------------
+// Finalize
+//-------------------------------------------------------------
+SinkFinalizeType PhysicalCreateRTreeIndexHilbert::Finalize(Pipeline &pipeline, Event &event, ClientContext &context,
+                                                           OperatorSinkFinalizeInput &input) const {
+	auto &gstate = input.global_state.Cast<CreateRTreeIndexHilbertGlobalState>();
+	info->column_ids = storage_ids;
+
+	if (gstate.rtree_size == 0) {
+		// No entries to build the RTree from, we are done
+		AddRTreeIndexToCatalog(context, gstate.rtree, *info, table);
+		return SinkFinalizeType::READY;
+	}
+
+	// Pick the number of partitions to sort in parallel. Aim for a few partitions per thread so that skew in the
+	// hilbert key distribution does not leave threads idle, but dont bother partitioning small inputs.
+	static constexpr idx_t MIN_PARTITION_SIZE = 1ULL << 16;
+	static constexpr idx_t MAX_RADIX_BITS = 10;
+
+	const auto thread_count = NumericCast<idx_t>(TaskScheduler::GetScheduler(context).NumberOfThreads());
+	gstate.radix_bits = 0;
+	while (gstate.radix_bits < MAX_RADIX_BITS && (idx_t(1) << gstate.radix_bits) < thread_count * 4 &&
+	       (gstate.rtree_size >> (gstate.radix_bits + 1)) >= MIN_PARTITION_SIZE) {
+		gstate.radix_bits++;
+	}
+
+	const auto partition_count = gstate.PartitionCount();
+	for (idx_t partition_idx = 0; partition_idx < partition_count; partition_idx++) {
+		gstate.partitions.push_back(make_uniq<ManagedCollection<RTreeSortEntry>>(gstate.manager));
+	}
+	gstate.partition_append_states.resize(partition_count);
+	gstate.partition_locks = make_unsafe_uniq_array<mutex>(partition_count);
+
+	// Schedule the construction of the RTree
+	auto partition_event = make_uniq<RTreeIndexPartitionEvent>(gstate, pipeline, *info, table, *this);
+	event.InsertEvent(std::move(partition_event));
+
+	return SinkFinalizeType::READY;
+}
+
+} // namespace duckdb
@@ -0,0 +1,57 @@
+#pragma once
+#include "duckdb/execution/physical_operator.hpp"
+#include "duckdb/storage/data_table.hpp"
+
+namespace duckdb {
+
+class DuckTableEntry;
+
+// Builds an RTree index bottom-up by packing the entries in hilbert curve order.
+// Unlike PhysicalCreateRTreeIndex this does not rely on a preceding ORDER BY, the entries are sunk in parallel,
+// radix-partitioned on their hilbert key, and then sorted and packed into pages by parallel tasks.
+class PhysicalCreateRTreeIndexHilbert final : public PhysicalOperator {
+public:
+	static constexpr auto TYPE = PhysicalOperatorType::EXTENSION;
+
+public:
+	PhysicalCreateRTreeIndexHilbert(LogicalOperator &op, TableCatalogEntry &table, const vector<column_t> &column_ids,
+	                                unique_ptr<CreateIndexInfo> info, vector<unique_ptr<Expression>> unbound_expressions,
+	                                idx_t estimated_cardinality);
+
+	//! The table to create the index for
+	DuckTableEntry &table;
+	//! The list of column IDs required for the index
+	vector<column_t> storage_ids;
+	//! Info for index creation
+	unique_ptr<CreateIndexInfo> info;
+	//! Unbound expressions to be used in the optimizer
+	vector<unique_ptr<Expression>> unbound_expressions;
+
+public:
+	//! Source interface, NOOP for this operator
+	SourceResultType GetData(ExecutionContext &context, DataChunk &chunk, OperatorSourceInput &input) const override {
+		return SourceResultType::FINISHED;
+	}
+	bool IsSource() const override {
+		return true;
+	}
+
+public:
+	//! Sink interface, global sink state
+	unique_ptr<GlobalSinkState> GetGlobalSinkState(ClientContext &context) const override;
+	unique_ptr<LocalSinkState> GetLocalSinkState(ExecutionContext &context) const override;
+	SinkResultType Sink(ExecutionContext &context, DataChunk &chunk, OperatorSinkInput &input) const override;
+	SinkCombineResultType Combine(ExecutionContext &context, OperatorSinkCombineInput &input) const override;
+	SinkFinalizeType Finalize(Pipeline &pipeline, Event &event, ClientContext &context,
+	                          OperatorSinkFinalizeInput &input) const override;
+
+	bool IsSink() const override {
+		return true;
+	}
+	bool ParallelSink() const override {
+		// The sink order does not matter, we sort the entries ourselves
+		return true;
+	}
+};
+
+} // namespace duckdb
@@ -1,6 +1,7 @@
 #include "spatial/index/rtree/rtree_index_create_logical.hpp"
 #include "spatial/index/rtree/rtree_index.hpp"
 #include "spatial/index/rtree/rtree_index_create_physical.hpp"
+#include "spatial/index/rtree/rtree_index_create_hilbert.hpp"
 #include "spatial/spatial_types.hpp"
 
 #include "duckdb/catalog/catalog_entry/table_catalog_entry.hpp"
@@ -14,6 +15,7 @@
 #include "duckdb/planner/expression/bound_conjunction_expression.hpp"
 #include "duckdb/planner/operator/logical_create_index.hpp"
 #include "duckdb/catalog/catalog_entry/scalar_function_catalog_entry.hpp"
+#include "duckdb/common/string_util.hpp"
 
 namespace duckdb {
 
@@ -132,6 +134,23 @@ static PhysicalOperator &CreateOrderByMinX(PhysicalPlanGenerator &planner, const
 	return planner.Make<PhysicalOrder>(types, std::move(orders), projections, op.estimated_cardinality);
 }
 
+// Returns true if the index should be built by packing the entries in hilbert order, in parallel, instead of
+// sorting them on the x-coordinate first (the default)
+static bool UseHilbertBuild(const CreateIndexInfo &info) {
+	const auto build_mode_search = info.options.find("build_mode");
+	if (build_mode_search == info.options.end()) {
+		return false;
+	}
+	const auto build_mode = StringUtil::Lower(build_mode_search->second.ToString());
+	if (build_mode == "str") {
+		return false;
+	}
+	if (build_mode == "hilbert") {
+		return true;
+	}
+	throw InvalidInputException("RTree: build_mode must be either 'str' or 'hilbert'");
+}
+
 PhysicalOperator &RTreeIndex::CreatePlan(PlanIndexInput &input) {
 
 	auto &op = input.op;
@@ -188,6 +207,15 @@ PhysicalOperator &RTreeIndex::CreatePlan(PlanIndexInput &input) {
 	auto &bbox_proj = CreateBoundingBoxProjection(planner, op, projected_types, context);
 	bbox_proj.children.push_back(null_filter);
 
+	if (UseHilbertBuild(*op.info)) {
+		// No need to sort up front, the entries are partitioned and sorted in parallel by the create index operator
+		auto &physical_create_index =
+		    planner.Make<PhysicalCreateRTreeIndexHilbert>(op, op.table, op.info->column_ids, std::move(op.info),
+		                                                  std::move(op.unbound_expressions), op.estimated_cardinality);
+		physical_create_index.children.push_back(bbox_proj);
+		return physical_create_index;
+	}
+
 	// Create an ORDER_BY operator to sort the bounding boxes by the xmin value
 	auto &physical_order = CreateOrderByMinX(planner, op, projected_types, context);
 	physical_order.children.push_back(bbox_proj);
@@ -265,6 +293,15 @@ PhysicalOperator &LogicalCreateRTreeIndex::CreatePlan(ClientContext &context, Ph
 	auto &bbox_proj = CreateBoundingBoxProjection(planner, op, projected_types, context);
 	bbox_proj.children.push_back(null_filter);
 
+	if (UseHilbertBuild(*op.info)) {
+		// No need to sort up front, the entries are partitioned and sorted in parallel by the create index operator
+		auto &physical_create_index =
+		    planner.Make<PhysicalCreateRTreeIndexHilbert>(op, op.table, op.info->column_ids, std::move(op.info),
+		                                                  std::move(op.unbound_expressions), op.estimated_cardinality);
+		physical_create_index.children.push_back(bbox_proj);
+		return physical_create_index;
+	}
+
 	// Create an ORDER_BY operator to sort the bounding boxes by the xmin value
 	auto &physical_order = CreateOrderByMinX(planner, op, projected_types, context);
 	physical_order.children.push_back(bbox_proj);
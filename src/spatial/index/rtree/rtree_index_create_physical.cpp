@@ -270,8 +270,8 @@ private:
 	CreateRTreeIndexGlobalState &state;
 };
 
-static void AddIndexToCatalog(ClientContext &context, CreateRTreeIndexGlobalState &gstate, CreateIndexInfo &info,
-                              DuckTableEntry &table) {
+void AddRTreeIndexToCatalog(ClientContext &context, unique_ptr<RTreeIndex> &rtree, CreateIndexInfo &info,
+                            DuckTableEntry &table) {
 
 	// Now actually add the index to the storage
 	auto &storage = table.GetStorage();
@@ -295,10 +295,10 @@ static void AddIndexToCatalog(ClientContext &context, CreateRTreeIndexGlobalStat
 	const auto index_entry = schema.CreateIndex(schema.GetCatalogTransaction(context), info, table).get();
 	D_ASSERT(index_entry);
 	auto &duck_index = index_entry->Cast<DuckIndexEntry>();
-	duck_index.initial_index_size = gstate.rtree->Cast<BoundIndex>().GetInMemorySize();
+	duck_index.initial_index_size = rtree->Cast<BoundIndex>().GetInMemorySize();
 
 	// Finally add it to storage
-	storage.AddIndex(std::move(gstate.rtree));
+	storage.AddIndex(std::move(rtree));
 }
 
 class RTreeIndexConstructionEvent final : public BasePipelineEvent {
@@ -318,7 +318,7 @@ public:
 	}
 
 	void FinishEvent() override {
-		AddIndexToCatalog(pipeline->GetClientContext(), gstate, info, table);
+		AddRTreeIndexToCatalog(pipeline->GetClientContext(), gstate.rtree, info, table);
 	}
 
 private:
@@ -338,7 +338,7 @@ SinkFinalizeType PhysicalCreateRTreeIndex::Finalize(Pipeline &pipeline, Event &e
 
 	if (gstate.rtree_size == 0) {
 		// No entries to build the RTree from, we are done
-		AddIndexToCatalog(context, gstate, *info, table);
+		AddRTreeIndexToCatalog(context, gstate.rtree, *info, table);
 		return SinkFinalizeType::READY;
 	}
 
@@ -5,6 +5,11 @@
 namespace duckdb {
 
 class DuckTableEntry;
+class RTreeIndex;
+
+//! Add a fully constructed RTree index to the catalog and hand it over to the table storage
+void AddRTreeIndexToCatalog(ClientContext &context, unique_ptr<RTreeIndex> &rtree, CreateIndexInfo &info,
+                            DuckTableEntry &table);
 
 class PhysicalCreateRTreeIndex final : public PhysicalOperator {
 public:
@@ -6,14 +6,18 @@
 #include "duckdb/optimizer/optimizer.hpp"
 #include "duckdb/optimizer/optimizer_extension.hpp"
 #include "duckdb/optimizer/remove_unused_columns.hpp"
+#include "duckdb/planner/expression/bound_columnref_expression.hpp"
 #include "duckdb/planner/expression/bound_constant_expression.hpp"
 #include "duckdb/planner/expression/bound_function_expression.hpp"
+#include "duckdb/planner/expression/bound_operator_expression.hpp"
 #include "duckdb/planner/expression/bound_reference_expression.hpp"
 #include "duckdb/planner/operator/logical_filter.hpp"
 #include "duckdb/planner/operator/logical_get.hpp"
 #include "duckdb/planner/operator/logical_projection.hpp"
+#include "duckdb/planner/operator/logical_top_n.hpp"
 #include "duckdb/planner/operator_extension.hpp"
 #include "duckdb/storage/data_table.hpp"
+#include "duckdb/planner/filter/conjunction_filter.hpp"
 #include "duckdb/planner/filter/expression_filter.hpp"
 #include "duckdb/main/database.hpp"
 
@@ -286,12 +290,238 @@ public:
 	}
 };
 
+//-----------------------------------------------------------------------------
+// KNN plan rewriter
+//-----------------------------------------------------------------------------
+// Rewrites "ORDER BY ST_Distance(<indexed geometry>, <constant>) LIMIT k" to scan the rtree index best-first, only
+// returning the rows that can be among the k nearest. The TOP_N is kept, to sort these by their actual distance.
+// As the index does not contain NULL or empty geometries, the query has to filter those out with
+// "WHERE NOT ST_IsEmpty(<indexed geometry>)" for the rewrite to apply.
+class RTreeIndexKNNScanOptimizer : public OptimizerExtension {
+public:
+	RTreeIndexKNNScanOptimizer() {
+		optimize_function = RTreeIndexKNNScanOptimizer::Optimize;
+	}
+
+	// Check for "NOT ST_IsEmpty(<geom>)"
+	static bool IsNotEmptyCheck(const Expression &expr, const Expression &geom_expr) {
+		if (expr.type != ExpressionType::OPERATOR_NOT) {
+			return false;
+		}
+		auto &not_expr = expr.Cast<BoundOperatorExpression>();
+		if (not_expr.children.size() != 1 || not_expr.children[0]->type != ExpressionType::BOUND_FUNCTION) {
+			return false;
+		}
+		auto &func_expr = not_expr.children[0]->Cast<BoundFunctionExpression>();
+		return func_expr.function.name == "ST_IsEmpty" && func_expr.children.size() == 1 &&
+		       func_expr.children[0]->Equals(geom_expr);
+	}
+
+	// Check for "<geom> IS NOT NULL"
+	static bool IsNotNullCheck(const Expression &expr, const Expression &geom_expr) {
+		if (expr.type != ExpressionType::OPERATOR_IS_NOT_NULL) {
+			return false;
+		}
+		auto &op_expr = expr.Cast<BoundOperatorExpression>();
+		return op_expr.children.size() == 1 && op_expr.children[0]->Equals(geom_expr);
+	}
+
+	// Check if a filter only removes rows that are not part of the index anyway (NULL and empty geometries).
+	// Sets "excludes_empty" if the filter removes the empty geometries.
+	static bool IsImpliedByIndex(const Expression &expr, const Expression &geom_expr, bool &excludes_empty) {
+		if (IsNotEmptyCheck(expr, geom_expr)) {
+			excludes_empty = true;
+			return true;
+		}
+		return IsNotNullCheck(expr, geom_expr);
+	}
+
+	static bool IsImpliedByIndex(const TableFilter &filter, const Expression &geom_ref, bool &excludes_empty) {
+		switch (filter.filter_type) {
+		case TableFilterType::IS_NOT_NULL:
+			return true;
+		case TableFilterType::CONJUNCTION_AND: {
+			auto &and_filter = filter.Cast<ConjunctionAndFilter>();
+			for (auto &child : and_filter.child_filters) {
+				if (!IsImpliedByIndex(*child, geom_ref, excludes_empty)) {
+					return false;
+				}
+			}
+			return true;
+		}
+		case TableFilterType::EXPRESSION_FILTER:
+			return IsImpliedByIndex(*filter.Cast<ExpressionFilter>().expr, geom_ref, excludes_empty);
+		default:
+			return false;
+		}
+	}
+
+	static bool TryOptimize(ClientContext &context, LogicalOperator &op) {
+		// Look for a TOP_N, ordered by a distance computed in a projection directly on top of a table scan
+		if (op.type != LogicalOperatorType::LOGICAL_TOP_N) {
+			return false;
+		}
+		auto &top_n = op.Cast<LogicalTopN>();
+		if (top_n.orders.empty() || top_n.orders[0].type != OrderType::ASCENDING) {
+			return false;
+		}
+		const auto knn_count = top_n.limit + top_n.offset;
+		if (knn_count == 0) {
+			return false;
+		}
+
+		if (top_n.children[0]->type != LogicalOperatorType::LOGICAL_PROJECTION) {
+			return false;
+		}
+		auto &proj = top_n.children[0]->Cast<LogicalProjection>();
+
+		// There may be a filter between the projection and the scan, which is checked below
+		optional_ptr<LogicalFilter> filter;
+		auto proj_child = proj.children[0].get();
+		if (proj_child->type == LogicalOperatorType::LOGICAL_FILTER) {
+			filter = &proj_child->Cast<LogicalFilter>();
+			proj_child = filter->children[0].get();
+		}
+		if (proj_child->type != LogicalOperatorType::LOGICAL_GET) {
+			return false;
+		}
+		auto &get = proj_child->Cast<LogicalGet>();
+		if (get.function.name != "seq_scan") {
+			return false;
+		}
+		if (get.dynamic_filters && get.dynamic_filters->HasFilters()) {
+			return false;
+		}
+
+		// The first order expression has to be a ST_Distance(<geometry>, <constant>) call computed by the projection
+		auto &order_expr = *top_n.orders[0].expression;
+		if (order_expr.type != ExpressionType::BOUND_COLUMN_REF) {
+			return false;
+		}
+		auto &order_ref = order_expr.Cast<BoundColumnRefExpression>();
+		if (order_ref.binding.table_index != proj.table_index) {
+			return false;
+		}
+		auto &dist_expr = *proj.expressions[order_ref.binding.column_index];
+		if (dist_expr.type != ExpressionType::BOUND_FUNCTION) {
+			return false;
+		}
+		auto &dist_func = dist_expr.Cast<BoundFunctionExpression>();
+		if (dist_func.function.name != "ST_Distance" || dist_func.children.size() != 2 ||
+		    dist_func.children[0]->return_type != GeoTypes::GEOMETRY() ||
+		    dist_func.children[1]->return_type != GeoTypes::GEOMETRY()) {
+			return false;
+		}
+
+		idx_t const_idx;
+		if (dist_func.children[1]->type == ExpressionType::VALUE_CONSTANT) {
+			const_idx = 1;
+		} else if (dist_func.children[0]->type == ExpressionType::VALUE_CONSTANT) {
+			const_idx = 0;
+		} else {
+			return false;
+		}
+		const auto &constant_value = dist_func.children[const_idx]->Cast<BoundConstantExpression>().value;
+		auto &geom_expr = *dist_func.children[1 - const_idx];
+		if (constant_value.IsNull()) {
+			return false;
+		}
+
+		// Rows with NULL or empty geometries are not part of the index, but a full sort would return them (the empty
+		// geometries even first, as their distance is 0). So we can only use the index if the query filters them out.
+		// Any other filter would remove rows after the index scan, leaving less than k candidates.
+		bool excludes_empty = false;
+		if (filter) {
+			for (auto &expr : filter->expressions) {
+				if (!IsImpliedByIndex(*expr, geom_expr, excludes_empty)) {
+					return false;
+				}
+			}
+		}
+		if (!get.table_filters.filters.empty()) {
+			if (geom_expr.type != ExpressionType::BOUND_COLUMN_REF) {
+				return false;
+			}
+			const auto &geom_binding = geom_expr.Cast<BoundColumnRefExpression>().binding;
+			const auto geom_column = get.GetColumnIds()[geom_binding.column_index].GetPrimaryIndex();
+			const BoundReferenceExpression geom_ref(geom_expr.return_type, 0ULL);
+			for (auto &entry : get.table_filters.filters) {
+				if (entry.first != geom_column || !IsImpliedByIndex(*entry.second, geom_ref, excludes_empty)) {
+					return false;
+				}
+			}
+		}
+		if (!excludes_empty) {
+			return false;
+		}
+
+		Box2D<float> bbox;
+		if (!RTreeIndexScanOptimizer::TryGetBoundingBox(constant_value, bbox)) {
+			return false;
+		}
+
+		auto &table = *get.GetTable();
+		if (!table.IsDuckTable()) {
+			return false;
+		}
+		auto &duck_table = table.Cast<DuckTableEntry>();
+		auto &table_info = *table.GetStorage().GetDataTableInfo();
+		unique_ptr<RTreeIndexScanBindData> bind_data = nullptr;
+
+		table_info.GetIndexes().BindAndScan<RTreeIndex>(context, table_info, [&](RTreeIndex &index_entry) {
+			auto &index_column_expr = *index_entry.unbound_expressions[0];
+			if (index_column_expr.type != ExpressionType::BOUND_COLUMN_REF) {
+				return false;
+			}
+
+			bool rewrite_possible = true;
+			auto index_expr = index_column_expr.Copy();
+			RTreeIndexScanOptimizer::RewriteIndexExpression(index_entry, get, *index_expr, rewrite_possible);
+			if (!rewrite_possible || !index_expr->Equals(geom_expr)) {
+				return false;
+			}
+
+			bind_data = make_uniq<RTreeIndexScanBindData>(duck_table, index_entry, bbox, knn_count);
+			return true;
+		});
+
+		if (!bind_data) {
+			// No index found
+			return false;
+		}
+
+		get.function = RTreeIndexScanFunction::GetFunction();
+		const auto cardinality = get.function.cardinality(context, bind_data.get());
+		get.has_estimated_cardinality = cardinality->has_estimated_cardinality;
+		get.estimated_cardinality = cardinality->estimated_cardinality;
+		get.bind_data = std::move(bind_data);
+
+		// The index scan does not support filter pushdown, but the filters hold for every row in the index anyway
+		get.table_filters.filters.clear();
+		return true;
+	}
+
+	static void OptimizeRecursive(OptimizerExtensionInput &input, unique_ptr<LogicalOperator> &plan) {
+		if (!TryOptimize(input.context, *plan)) {
+			// No match: continue with the children
+			for (auto &child : plan->children) {
+				OptimizeRecursive(input, child);
+			}
+		}
+	}
+
+	static void Optimize(OptimizerExtensionInput &input, unique_ptr<LogicalOperator> &plan) {
+		OptimizeRecursive(input, plan);
+	}
+};
+
 //-----------------------------------------------------------------------------
 // Register
 //-----------------------------------------------------------------------------
 void RTreeModule::RegisterIndexPlanScan(DatabaseInstance &db) {
-	// Register the optimizer extension
+	// Register the optimizer extensions
 	db.config.optimizer_extensions.push_back(RTreeIndexScanOptimizer());
+	db.config.optimizer_extensions.push_back(RTreeIndexKNNScanOptimizer());
 }
 
 } // namespace duckdb
\ No newline at end of file
@@ -13,6 +13,7 @@
 #include "duckdb/transaction/duck_transaction.hpp"
 #include "duckdb/transaction/local_storage.hpp"
 #include "duckdb/main/extension_util.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
 #include "duckdb/catalog/catalog_entry/duck_index_entry.hpp"
 #include "duckdb/storage/data_table.hpp"
 
@@ -26,19 +27,46 @@ BindInfo RTreeIndexScanBindInfo(const optional_ptr<FunctionData> bind_data_p) {
 //-------------------------------------------------------------------------
 // Global State
 //-------------------------------------------------------------------------
+// The subtrees of the index intersecting the query are handed out to the threads, which each scan them on their own.
+// The nodes are only accessed by one thread at a time (see RTreeIndex::scan_lock), but the rows are fetched in
+// parallel.
+// KNN scans have to visit the tree in distance order, and are therefore always scanned by a single thread.
 struct RTreeIndexScanGlobalState final : public GlobalTableFunctionState {
-	//! The DataChunk containing all read columns.
-	//! This includes filter columns, which are immediately removed.
-	DataChunk all_columns;
+	//! The types of all read columns, including filter columns (empty if there are none to remove)
+	vector<LogicalType> scanned_types;
 	vector<idx_t> projection_ids;
 
-	ColumnFetchState fetch_state;
 	TableScanState local_storage_state;
 	vector<StorageIndex> column_ids;
 
-	// Index scan state
-	unique_ptr<IndexScanState> index_state;
-	Vector row_ids = Vector(LogicalType::ROW_TYPE);
+	//! The subtrees to scan
+	mutex lock;
+	vector<RTreeEntry> partitions;
+	idx_t next_partition = 0;
+	bool knn_scan_started = false;
+
+	idx_t MaxThreads() const override {
+		return MaxValue<idx_t>(partitions.size(), 1);
+	}
+
+	//! Initializes the scan of the next subtree, returns false if there is nothing left to scan
+	bool TryInitializeNextScan(const RTreeIndexScanBindData &bind_data, unique_ptr<IndexScanState> &index_state) {
+		lock_guard<mutex> guard(lock);
+		auto &rtree_index = bind_data.index.Cast<RTreeIndex>();
+		if (bind_data.knn_count != 0) {
+			if (knn_scan_started) {
+				return false;
+			}
+			knn_scan_started = true;
+			index_state = rtree_index.InitializeKNNScan(bind_data.bbox, bind_data.knn_count);
+			return true;
+		}
+		if (next_partition == partitions.size()) {
+			return false;
+		}
+		index_state = rtree_index.InitializeScan(bind_data.bbox, partitions[next_partition++]);
+		return true;
+	}
 };
 
 static unique_ptr<GlobalTableFunctionState> RTreeIndexScanInitGlobal(ClientContext &context,
@@ -63,8 +91,11 @@ static unique_ptr<GlobalTableFunctionState> RTreeIndexScanInitGlobal(ClientConte
 	result->local_storage_state.Initialize(result->column_ids, context, input.filters);
 	local_storage.InitializeScan(bind_data.table.GetStorage(), result->local_storage_state.local_state, input.filters);
 
-	// Initialize the scan state for the index
-	result->index_state = bind_data.index.Cast<RTreeIndex>().InitializeScan(bind_data.bbox);
+	// Split the index into subtrees to scan in parallel. Create a couple more than we have threads to balance the load
+	if (bind_data.knn_count == 0) {
+		const auto thread_count = NumericCast<idx_t>(TaskScheduler::GetScheduler(context).NumberOfThreads());
+		result->partitions = bind_data.index.Cast<RTreeIndex>().GetScanPartitions(bind_data.bbox, thread_count * 8);
+	}
 
 	// Early out if there is nothing to project
 	if (!input.CanRemoveFilterColumns()) {
@@ -84,40 +115,87 @@ static unique_ptr<GlobalTableFunctionState> RTreeIndexScanInitGlobal(ClientConte
 			scanned_types.push_back(columns.GetColumn(col_idx.ToLogical()).Type());
 		}
 	}
-	result->all_columns.Initialize(context, scanned_types);
+	result->scanned_types = std::move(scanned_types);
 
 	return std::move(result);
 }
 
+//-------------------------------------------------------------------------
+// Local State
+//-------------------------------------------------------------------------
+struct RTreeIndexScanLocalState final : public LocalTableFunctionState {
+	//! The DataChunk containing all read columns.
+	//! This includes filter columns, which are immediately removed.
+	DataChunk all_columns;
+	ColumnFetchState fetch_state;
+
+	// Index scan state of the subtree we are currently scanning
+	unique_ptr<IndexScanState> index_state;
+	Vector row_ids = Vector(LogicalType::ROW_TYPE);
+};
+
+static unique_ptr<LocalTableFunctionState> RTreeIndexScanInitLocal(ExecutionContext &context,
+                                                                   TableFunctionInitInput &input,
+                                                                   GlobalTableFunctionState *gstate_p) {
+	auto &gstate = gstate_p->Cast<RTreeIndexScanGlobalState>();
+	auto result = make_uniq<RTreeIndexScanLocalState>();
+	if (!gstate.scanned_types.empty()) {
+		result->all_columns.Initialize(context.client, gstate.scanned_types);
+	}
+	return std::move(result);
+}
+
 //-------------------------------------------------------------------------
 // Execute
 //-------------------------------------------------------------------------
 static void RTreeIndexScanExecute(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
 
 	auto &bind_data = data_p.bind_data->Cast<RTreeIndexScanBindData>();
-	auto &state = data_p.global_state->Cast<RTreeIndexScanGlobalState>();
+	auto &gstate = data_p.global_state->Cast<RTreeIndexScanGlobalState>();
+	auto &lstate = data_p.local_state->Cast<RTreeIndexScanLocalState>();
 	auto &transaction = DuckTransaction::Get(context, bind_data.table.catalog);
-
-	// Scan the index for row id's
-	auto row_count = bind_data.index.Cast<RTreeIndex>().Scan(*state.index_state, state.row_ids);
-	if (row_count == 0) {
-		// Short-circuit if the index had no more rows
-		output.SetCardinality(0);
-		return;
+	auto &rtree_index = bind_data.index.Cast<RTreeIndex>();
+
+	// Rows deleted by (or invisible to) this transaction are dropped by the fetch below. Skip them in KNN scans already,
+	// so that they do not count towards the k nearest
+	auto &storage = bind_data.table.GetStorage();
+	const auto is_visible = [&](const row_t row_id) { return storage.CanFetch(transaction, row_id); };
+
+	// Scan the index for row id's, moving on to the next subtree once the current one is exhausted
+	idx_t row_count = 0;
+	while (true) {
+		if (lstate.index_state) {
+			if (bind_data.knn_count != 0) {
+				row_count = rtree_index.Scan(*lstate.index_state, lstate.row_ids, is_visible);
+			} else {
+				row_count = rtree_index.Scan(*lstate.index_state, lstate.row_ids);
+			}
+			if (row_count != 0) {
+				break;
+			}
+			lstate.index_state = nullptr;
+		}
+		if (!gstate.TryInitializeNextScan(bind_data, lstate.index_state)) {
+			// Short-circuit if the index had no more rows
+			output.SetCardinality(0);
+			return;
+		}
 	}
 
+	// Sort the row ids so that we fetch the rows in storage order
+	const auto row_ids = FlatVector::GetData<row_t>(lstate.row_ids);
+	std::sort(row_ids, row_ids + row_count);
+
 	// Fetch the data from the local storage given the row ids
-	if (state.projection_ids.empty()) {
-		bind_data.table.GetStorage().Fetch(transaction, output, state.column_ids, state.row_ids, row_count,
-		                                   state.fetch_state);
+	if (gstate.projection_ids.empty()) {
+		storage.Fetch(transaction, output, gstate.column_ids, lstate.row_ids, row_count, lstate.fetch_state);
 		return;
 	}
 
 	// Otherwise, we need to first fetch into our scan chunk, and then project out the result
-	state.all_columns.Reset();
-	bind_data.table.GetStorage().Fetch(transaction, state.all_columns, state.column_ids, state.row_ids, row_count,
-	                                   state.fetch_state);
-	output.ReferenceColumns(state.all_columns, state.projection_ids);
+	lstate.all_columns.Reset();
+	storage.Fetch(transaction, lstate.all_columns, gstate.column_ids, lstate.row_ids, row_count, lstate.fetch_state);
+	output.ReferenceColumns(lstate.all_columns, gstate.projection_ids);
 }
 
 //-------------------------------------------------------------------------
@@ -153,6 +231,10 @@ unique_ptr<NodeStatistics> RTreeIndexScanCardinality(ClientContext &context, con
 	const auto &storage = bind_data.table.GetStorage();
 	idx_t table_rows = storage.GetTotalRows();
 	idx_t estimated_cardinality = table_rows + local_storage.AddedRows(bind_data.table.GetStorage());
+	if (bind_data.knn_count != 0) {
+		// We return at least the k nearest rows, but usually not many more
+		estimated_cardinality = MinValue(estimated_cardinality, bind_data.knn_count);
+	}
 	return make_uniq<NodeStatistics>(table_rows, estimated_cardinality);
 }
 
@@ -165,6 +247,9 @@ static InsertionOrderPreservingMap<string> RTreeIndexScanToString(TableFunctionT
 	auto &bind_data = input.bind_data->Cast<RTreeIndexScanBindData>();
 	result["Table"] = bind_data.table.name;
 	result["Index"] = bind_data.index.GetIndexName();
+	if (bind_data.knn_count != 0) {
+		result["Nearest"] = to_string(bind_data.knn_count);
+	}
 	return result;
 }
 
@@ -185,6 +270,7 @@ static void RTreeScanSerialize(Serializer &serializer, const optional_ptr<Functi
 		ser.WriteProperty<float>(20, "max_x", bind_data.bbox.max.x);
 		ser.WriteProperty<float>(21, "max_y", bind_data.bbox.max.y);
 	});
+	serializer.WritePropertyWithDefault<idx_t>(105, "knn_count", bind_data.knn_count, 0);
 }
 
 static unique_ptr<FunctionData> RTreeScanDeserialize(Deserializer &deserializer, TableFunction &function) {
@@ -207,6 +293,7 @@ static unique_ptr<FunctionData> RTreeScanDeserialize(Deserializer &deserializer,
 		bbox.max.x = ser.ReadProperty<float>(20, "max_x");
 		bbox.max.y = ser.ReadProperty<float>(21, "max_y");
 	});
+	const auto knn_count = deserializer.ReadPropertyWithExplicitDefault<idx_t>(105, "knn_count", 0);
 
 	auto &duck_table = catalog_entry.Cast<DuckTableEntry>();
 	auto &table_info = *catalog_entry.GetStorage().GetDataTableInfo();
@@ -215,7 +302,7 @@ static unique_ptr<FunctionData> RTreeScanDeserialize(Deserializer &deserializer,
 
 	table_info.GetIndexes().BindAndScan<RTreeIndex>(context, table_info, [&](RTreeIndex &index_entry) {
 		if (index_entry.GetIndexName() == index_name) {
-			result = make_uniq<RTreeIndexScanBindData>(duck_table, index_entry, bbox);
+			result = make_uniq<RTreeIndexScanBindData>(duck_table, index_entry, bbox, knn_count);
 			return true;
 		}
 		return false;
@@ -232,7 +319,7 @@ static unique_ptr<FunctionData> RTreeScanDeserialize(Deserializer &deserializer,
 //-------------------------------------------------------------------------
 TableFunction RTreeIndexScanFunction::GetFunction() {
 	TableFunction func("rtree_index_scan", {}, RTreeIndexScanExecute);
-	func.init_local = nullptr;
+	func.init_local = RTreeIndexScanInitLocal;
 	func.init_global = RTreeIndexScanInitGlobal;
 	func.statistics = RTreeIndexScanStatistics;
 	func.dependency = RTreeIndexScanDependency;
@@ -9,8 +9,8 @@ class Index;
 
 // This is created by the optimizer rule
 struct RTreeIndexScanBindData final : public TableFunctionData {
-	explicit RTreeIndexScanBindData(DuckTableEntry &table, Index &index, const RTreeBounds &bbox)
-	    : table(table), index(index), bbox(bbox) {
+	explicit RTreeIndexScanBindData(DuckTableEntry &table, Index &index, const RTreeBounds &bbox, idx_t knn_count = 0)
+	    : table(table), index(index), bbox(bbox), knn_count(knn_count) {
 	}
 
 	//! The table to scan
@@ -22,6 +22,10 @@ struct RTreeIndexScanBindData final : public TableFunctionData {
 	//! The bounds to scan
 	RTreeBounds bbox;
 
+	//! If non-zero, scan for the rows nearest to the bounds instead, returning (a superset of) the knn_count nearest
+	//! rows in ascending order of their box distance
+	idx_t knn_count;
+
 public:
 	bool Equals(const FunctionData &other_p) const override {
 		auto &other = other_p.Cast<RTreeIndexScanBindData>();
@@ -2,6 +2,8 @@
 
 #include "spatial/index/rtree/rtree.hpp"
 
+#include <queue>
+
 namespace duckdb {
 
 class RTreeScanner {
@@ -82,4 +84,109 @@ inline void RTreeScanner::Scan(const RTree &tree, FUNC &&handler) {
 	}
 }
 
-} // namespace duckdb
\ No newline at end of file
+//----------------------------------------------------------------------------------------------------------------------
+// KNN Scanner
+//----------------------------------------------------------------------------------------------------------------------
+// Best-first scan of the RTree, returning the row ids in ascending order of the (minimum) distance between their
+// bounding box and the query box. The box distance is only a lower bound of the distance between the geometries,
+// so the caller has to sort the returned rows by their actual distance. The scan stops once the remaining rows
+// can no longer be among the k nearest, i.e. when their box distance exceeds the k-th smallest upper bound (maximum
+// box distance) of the rows returned so far. The handler can return SKIP for rows that are not part of the result,
+// which then do not count towards the k nearest.
+class RTreeKNNScanner {
+public:
+	void Init(const RTreeEntry &root, const RTreeBounds &query, idx_t k);
+	template <class FUNC>
+	void Scan(const RTree &tree, FUNC &&handler);
+	void Reset();
+
+	static double MinDistance(const RTreeBounds &a, const RTreeBounds &b);
+	static double MaxDistance(const RTreeBounds &a, const RTreeBounds &b);
+
+private:
+	struct QueueEntry {
+		double distance;
+		RTreeEntry entry;
+		QueueEntry(double distance_p, const RTreeEntry &entry_p) : distance(distance_p), entry(entry_p) {
+		}
+		// Reversed, so that the priority queue pops the closest entry first
+		bool operator<(const QueueEntry &other) const {
+			return distance > other.distance;
+		}
+	};
+	std::priority_queue<QueueEntry> queue;
+	// The k smallest upper bounds of the distance of the rows returned so far, largest on top
+	std::priority_queue<double> upper_bounds;
+	RTreeBounds query;
+	idx_t k = 0;
+};
+
+inline double RTreeKNNScanner::MinDistance(const RTreeBounds &a, const RTreeBounds &b) {
+	const auto dx = MaxValue(0.0, MaxValue(static_cast<double>(a.min.x) - static_cast<double>(b.max.x),
+	                                       static_cast<double>(b.min.x) - static_cast<double>(a.max.x)));
+	const auto dy = MaxValue(0.0, MaxValue(static_cast<double>(a.min.y) - static_cast<double>(b.max.y),
+	                                       static_cast<double>(b.min.y) - static_cast<double>(a.max.y)));
+	return std::sqrt(dx * dx + dy * dy);
+}
+
+inline double RTreeKNNScanner::MaxDistance(const RTreeBounds &a, const RTreeBounds &b) {
+	const auto dx = MaxValue(std::abs(static_cast<double>(a.max.x) - static_cast<double>(b.min.x)),
+	                         std::abs(static_cast<double>(b.max.x) - static_cast<double>(a.min.x)));
+	const auto dy = MaxValue(std::abs(static_cast<double>(a.max.y) - static_cast<double>(b.min.y)),
+	                         std::abs(static_cast<double>(b.max.y) - static_cast<double>(a.min.y)));
+	return std::sqrt(dx * dx + dy * dy);
+}
+
+inline void RTreeKNNScanner::Init(const RTreeEntry &root, const RTreeBounds &query_p, idx_t k_p) {
+	Reset();
+	query = query_p;
+	k = k_p;
+	if (k != 0) {
+		queue.emplace(MinDistance(query, root.bounds), root);
+	}
+}
+
+inline void RTreeKNNScanner::Reset() {
+	queue = std::priority_queue<QueueEntry>();
+	upper_bounds = std::priority_queue<double>();
+}
+
+template <class FUNC>
+inline void RTreeKNNScanner::Scan(const RTree &tree, FUNC &&handler) {
+	while (!queue.empty()) {
+		// We already have k rows that are at most upper_bounds.top() away, nothing further away can be among them
+		if (upper_bounds.size() == k && queue.top().distance > upper_bounds.top()) {
+			Reset();
+			return;
+		}
+
+		const auto top = queue.top();
+		queue.pop();
+
+		if (top.entry.pointer.IsRowId()) {
+			const auto result = handler(top.entry);
+			if (result == RTreeScanResult::SKIP) {
+				// The row was not returned (e.g. it is deleted), so it does not count towards the k nearest
+				continue;
+			}
+			upper_bounds.push(MaxDistance(query, top.entry.bounds));
+			if (upper_bounds.size() > k) {
+				upper_bounds.pop();
+			}
+			if (result == RTreeScanResult::YIELD) {
+				// Yield!
+				return;
+			}
+			continue;
+		}
+
+		// Push all the children of this node into the queue
+		const auto &node = tree.Ref(top.entry.pointer);
+		for (idx_t i = 0; i < node.GetCount(); i++) {
+			auto &entry = node[i];
+			queue.emplace(MinDistance(query, entry.bounds), entry);
+		}
+	}
+}
+
+} // namespace duckdb
@@ -872,6 +872,7 @@ struct ST_Read : ArrowTableFunction {
 	struct LocalState final : ArrowScanLocalState {
 		ArenaAllocator arena;
 		GeometryAllocator alloc;
+		SerdeFormat format;
 
 		static constexpr auto MAX_WKB_STACK_DEPTH = 128;
 		uint32_t wkb_stack[MAX_WKB_STACK_DEPTH] = {};
@@ -879,7 +880,7 @@ struct ST_Read : ArrowTableFunction {
 
 		explicit LocalState(unique_ptr<ArrowArrayWrapper> current_chunk, ClientContext &context)
 		    : ArrowScanLocalState(std::move(current_chunk), context), arena(BufferAllocator::Get(context)),
-		      alloc(arena) {
+		      alloc(arena), format(SerdeFormat::Get(context)) {
 
 			// Setup WKB reader
 			wkb_reader.copy_vertices = false;
@@ -914,9 +915,9 @@ struct ST_Read : ArrowTableFunction {
 				}
 
 				// Serialize the geometry into a blob
-				const auto size = Serde::GetRequiredSize(geom);
+				const auto size = Serde::GetRequiredSize(geom, format);
 				auto blob = StringVector::EmptyString(target, size);
-				Serde::Serialize(geom, blob.GetDataWriteable(), size);
+				Serde::Serialize(geom, format, blob.GetDataWriteable(), size);
 				blob.Finalize();
 				return blob;
 			});
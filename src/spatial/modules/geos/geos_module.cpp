@@ -1,13 +1,20 @@
 #include "spatial/modules/geos/geos_module.hpp"
 #include "spatial/modules/geos/geos_geometry.hpp"
 #include "spatial/modules/geos/geos_serde.hpp"
+#include "spatial/geometry/geometry_serialization.hpp"
+#include "spatial/geometry/geometry_type.hpp"
+#include "spatial/geometry/sgl.hpp"
 #include "spatial/spatial_types.hpp"
 #include "spatial/util/function_builder.hpp"
 
+#include "duckdb/common/unordered_map.hpp"
 #include "duckdb/common/vector_operations/senary_executor.hpp"
 #include "duckdb/common/vector_operations/generic_executor.hpp"
 #include "duckdb/planner/expression/bound_constant_expression.hpp"
 
+#include <algorithm>
+#include <list>
+
 namespace duckdb {
 
 //------------------------------------------------------------------------------
@@ -16,6 +23,85 @@ namespace duckdb {
 
 namespace {
 
+struct PreparedGeometryEntry {
+	const char *key;
+	// The blob is copied to verify cache hits, as its address may hold another geometry in a later chunk
+	string blob;
+	// The prepared geometry references the geometry, so it has to be declared (and thus destroyed) after it
+	GeosGeometry geom;
+	PreparedGeosGeometry prepared;
+
+	PreparedGeometryEntry(const char *key_p, string blob_p, GeosGeometry geom_p)
+	    : key(key_p), blob(std::move(blob_p)), geom(std::move(geom_p)), prepared(geom.get_prepared()) {
+	}
+};
+
+// Decides whether at least half of the rows of a chunk repeat a (non-inlined) blob of a previous row. This is the case
+// for dictionary vectors, or the build side of a join against a small table. Then it pays off to prepare the geometries
+// once and reuse them, even though the vector is not constant.
+class RepeatedBlobDetector {
+public:
+	bool HasRepeatedBlobs(Vector &vec, idx_t count) {
+		if (vec.GetVectorType() == VectorType::DICTIONARY_VECTOR) {
+			// Every row beyond the size of the dictionary repeats one of its entries
+			const auto dictionary_size = DictionaryVector::DictionarySize(vec);
+			if (dictionary_size.IsValid()) {
+				return dictionary_size.GetIndex() * 2 <= count;
+			}
+		}
+
+		// Don't check every chunk once the input has shown not to repeat its geometries
+		if (skip_count > 0) {
+			skip_count--;
+			return false;
+		}
+
+		if (SampleHasRepeats(vec, count)) {
+			backoff = 1;
+			return true;
+		}
+
+		skip_count = backoff;
+		backoff = MinValue<idx_t>(backoff * 2, MAX_BACKOFF);
+		return false;
+	}
+
+private:
+	// Only a prefix of the chunk is checked, which is representative enough
+	static constexpr idx_t SAMPLE_SIZE = 256;
+	// The maximum number of chunks to skip after a chunk without repeats
+	static constexpr idx_t MAX_BACKOFF = 64;
+
+	bool SampleHasRepeats(Vector &vec, idx_t count) {
+		UnifiedVectorFormat format;
+		vec.ToUnifiedFormat(count, format);
+		const auto data = UnifiedVectorFormat::GetData<string_t>(format);
+
+		idx_t sample_count = 0;
+		for (idx_t i = 0; i < MinValue<idx_t>(count, SAMPLE_SIZE); i++) {
+			const auto idx = format.sel->get_index(i);
+			if (!format.validity.RowIsValid(idx) || data[idx].IsInlined()) {
+				continue;
+			}
+			sample[sample_count++] = data[idx].GetData();
+		}
+
+		// Count the addresses that are the same as the previous one once sorted
+		std::sort(sample, sample + sample_count);
+		idx_t repeated = 0;
+		for (idx_t i = 1; i < sample_count; i++) {
+			if (sample[i] == sample[i - 1]) {
+				repeated++;
+			}
+		}
+		return repeated > 0 && repeated * 2 >= MinValue<idx_t>(count, SAMPLE_SIZE);
+	}
+
+	const char *sample[SAMPLE_SIZE];
+	idx_t skip_count = 0;
+	idx_t backoff = 1;
+};
+
 class LocalState final : public FunctionLocalState {
 public:
 	static unique_ptr<FunctionLocalState> Init(ExpressionState &state, const BoundFunctionExpression &expr,
@@ -25,6 +111,7 @@ public:
 
 	static LocalState &ResetAndGet(ExpressionState &state) {
 		auto &local_state = ExecuteFunctionState::GetFunctionState(state)->Cast<LocalState>();
+		local_state.arena.Reset();
 		return local_state;
 	}
 
@@ -35,8 +122,23 @@ public:
 	GeosGeometry Deserialize(const string_t &blob) const;
 	string_t Serialize(Vector &result, const GeosGeometry &geom) const;
 
-	// Most GEOS functions do not use an arena, so just use the default allocator
-	explicit LocalState(ClientContext &context) {
+	// Deserialize into an sgl geometry, for the predicates that are evaluated without GEOS
+	void Deserialize(const string_t &blob, sgl::geometry &geom);
+
+	GeometryAllocator &GetAllocator() {
+		return allocator;
+	}
+
+	// Get the prepared geometry of a blob that repeats across rows, e.g. in a dictionary vector or after a join.
+	// Prepared geometries are cached by the address of the blob, so this should not be called for inlined blobs.
+	const PreparedGeosGeometry &GetPrepared(const string_t &blob);
+
+	// Whether the geometries of the left or right argument repeat across the rows of the current chunk
+	RepeatedBlobDetector lhs_repeats;
+	RepeatedBlobDetector rhs_repeats;
+
+	// GEOS allocates its geometries itself, the arena is only used for sgl geometries
+	explicit LocalState(ClientContext &context) : arena(BufferAllocator::Get(context)), allocator(arena) {
 		ctx = GEOS_init_r();
 
 		GEOSContext_setErrorMessageHandler_r(
@@ -44,11 +146,22 @@ public:
 	}
 
 	~LocalState() override {
+		// Destroy all cached geometries before the context they belong to
+		prepared_map.clear();
+		prepared_entries.clear();
 		GEOS_finish_r(ctx);
 	}
 
 private:
+	static constexpr idx_t PREPARED_CACHE_SIZE = 32;
+
 	GEOSContextHandle_t ctx;
+	ArenaAllocator arena;
+	GeometryAllocator allocator;
+
+	// Most recently used entries are kept at the front
+	std::list<PreparedGeometryEntry> prepared_entries;
+	unordered_map<const char *, std::list<PreparedGeometryEntry>::iterator> prepared_map;
 };
 
 string_t LocalState::Serialize(Vector &result, const GeosGeometry &geom) const {
@@ -81,6 +194,38 @@ GeosGeometry LocalState::Deserialize(const string_t &blob) const {
 	return GeosGeometry(ctx, geom);
 }
 
+void LocalState::Deserialize(const string_t &blob, sgl::geometry &geom) {
+	Serde::Deserialize(geom, arena, blob.GetData(), blob.GetSize());
+}
+
+const PreparedGeosGeometry &LocalState::GetPrepared(const string_t &blob) {
+	const auto key = blob.GetData();
+	const auto size = blob.GetSize();
+
+	const auto it = prepared_map.find(key);
+	if (it != prepared_map.end()) {
+		const auto entry = it->second;
+		if (entry->blob.size() == size && memcmp(entry->blob.data(), key, size) == 0) {
+			// Move the entry to the front of the LRU list
+			prepared_entries.splice(prepared_entries.begin(), prepared_entries, entry);
+			return entry->prepared;
+		}
+		// The address holds another geometry now
+		prepared_entries.erase(entry);
+		prepared_map.erase(it);
+	}
+
+	// Evict the least recently used entry
+	if (prepared_entries.size() >= PREPARED_CACHE_SIZE) {
+		prepared_map.erase(prepared_entries.back().key);
+		prepared_entries.pop_back();
+	}
+
+	prepared_entries.emplace_front(key, string(key, size), Deserialize(blob));
+	prepared_map[key] = prepared_entries.begin();
+	return prepared_entries.front().prepared;
+}
+
 } // namespace
 
 //------------------------------------------------------------------------------
@@ -89,11 +234,153 @@ GeosGeometry LocalState::Deserialize(const string_t &blob) const {
 
 namespace {
 
+// The bounds cached in the geometry headers are rounded outwards, so if they are disjoint, the geometries are too.
+// Predicates that can only be true for intersecting geometries can then return false without deserializing them.
+static bool HasDisjointBounds(const string_t &lhs_blob, const string_t &rhs_blob) {
+	Box2D<float> lhs_bounds;
+	Box2D<float> rhs_bounds;
+	return geometry_t(lhs_blob).TryGetCachedBounds(lhs_bounds) &&
+	       geometry_t(rhs_blob).TryGetCachedBounds(rhs_bounds) && !lhs_bounds.Intersects(rhs_bounds);
+}
+
+static bool HasDisjointBounds(const Box2D<float> &bounds, const string_t &blob) {
+	Box2D<float> blob_bounds;
+	return geometry_t(blob).TryGetCachedBounds(blob_bounds) && !blob_bounds.Intersects(bounds);
+}
+
+// Equal geometries cover the same points, and thus have the same exact bounds. The cached bounds are rounded from the
+// exact bounds in the same way, so if they differ, the geometries are not equal.
+static bool HasDifferentBounds(const string_t &lhs_blob, const string_t &rhs_blob) {
+	Box2D<float> lhs_bounds;
+	Box2D<float> rhs_bounds;
+	return geometry_t(lhs_blob).TryGetCachedBounds(lhs_bounds) &&
+	       geometry_t(rhs_blob).TryGetCachedBounds(rhs_bounds) &&
+	       (lhs_bounds.min.x != rhs_bounds.min.x || lhs_bounds.min.y != rhs_bounds.min.y ||
+	        lhs_bounds.max.x != rhs_bounds.max.x || lhs_bounds.max.y != rhs_bounds.max.y);
+}
+
+// Predicates between a point and a point, linestring, polygon or multipolygon only depend on where the point is located
+// in the other geometry, which is cheap to compute on the serialized geometries directly. Only the other type pairs
+// have to be converted to GEOS.
+enum class PointPredicate : uint8_t {
+	// Not supported, always use GEOS
+	NONE,
+	// The point is on the other geometry
+	INTERSECTS,
+	// The second geometry is a point in the interior of the first
+	CONTAINS,
+	// The first geometry is a point in the interior of the second
+	WITHIN
+};
+
+static bool IsPointLocatable(GeometryType type) {
+	return type == GeometryType::POINT || type == GeometryType::LINESTRING || type == GeometryType::POLYGON ||
+	       type == GeometryType::MULTIPOLYGON;
+}
+
+static bool IsPointOnSide(PointPredicate predicate, bool point_is_lhs) {
+	return predicate == PointPredicate::INTERSECTS || (predicate == PointPredicate::CONTAINS && !point_is_lhs) ||
+	       (predicate == PointPredicate::WITHIN && point_is_lhs);
+}
+
+static bool GetPointPredicateResult(PointPredicate predicate, sgl::ops::point_location location) {
+	if (predicate == PointPredicate::INTERSECTS) {
+		return location != sgl::ops::point_location::EXTERIOR;
+	}
+	return location == sgl::ops::point_location::INTERIOR;
+}
+
+// Returns false if the pair has to be evaluated with GEOS instead
+static bool TryExecutePointPredicate(PointPredicate predicate, LocalState &lstate, const string_t &lhs_blob,
+                                     const string_t &rhs_blob, bool &result) {
+	if (predicate == PointPredicate::NONE) {
+		return false;
+	}
+
+	const auto lhs_type = geometry_t(lhs_blob).GetType();
+	const auto rhs_type = geometry_t(rhs_blob).GetType();
+
+	bool point_is_lhs;
+	if (rhs_type == GeometryType::POINT && IsPointOnSide(predicate, false) && IsPointLocatable(lhs_type)) {
+		point_is_lhs = false;
+	} else if (lhs_type == GeometryType::POINT && IsPointOnSide(predicate, true) && IsPointLocatable(rhs_type)) {
+		point_is_lhs = true;
+	} else {
+		return false;
+	}
+
+	sgl::geometry point;
+	sgl::geometry other;
+	lstate.Deserialize(point_is_lhs ? lhs_blob : rhs_blob, point);
+	lstate.Deserialize(point_is_lhs ? rhs_blob : lhs_blob, other);
+
+	if (point.is_empty()) {
+		result = false;
+		return true;
+	}
+
+	const auto vertex = point.get_vertex_xy(0);
+	sgl::ops::point_location location;
+	if (!sgl::ops::try_locate_point(&other, &vertex, &location)) {
+		return false;
+	}
+
+	result = GetPointPredicateResult(predicate, location);
+	return true;
+}
+
+// Locates the points of a vector in a constant (multi)polygon, using an index of its edges
+class PointInPolygonIndex {
+public:
+	// Returns false if the predicate can not be evaluated on points on that side, or if the geometry is not a
+	// (well-formed) polygon
+	bool TryBuild(PointPredicate predicate_p, bool point_is_lhs, LocalState &lstate, const string_t &polygon_blob) {
+		predicate = predicate_p;
+		if (!IsPointOnSide(predicate, point_is_lhs)) {
+			return false;
+		}
+		const auto type = geometry_t(polygon_blob).GetType();
+		if (type != GeometryType::POLYGON && type != GeometryType::MULTIPOLYGON) {
+			return false;
+		}
+		sgl::geometry polygon;
+		lstate.Deserialize(polygon_blob, polygon);
+		return sgl::ops::polygon_index_try_build(&index, &lstate.GetAllocator(), &polygon);
+	}
+
+	// Returns false if the geometry is not a point
+	bool TryExecute(LocalState &lstate, const string_t &point_blob, bool &result) const {
+		if (geometry_t(point_blob).GetType() != GeometryType::POINT) {
+			return false;
+		}
+
+		sgl::geometry point;
+		lstate.Deserialize(point_blob, point);
+		if (point.is_empty()) {
+			result = false;
+			return true;
+		}
+
+		const auto vertex = point.get_vertex_xy(0);
+		result = GetPointPredicateResult(predicate, sgl::ops::polygon_index_locate(&index, &vertex));
+		return true;
+	}
+
+private:
+	PointPredicate predicate = PointPredicate::NONE;
+	sgl::ops::polygon_index index = {};
+};
+
 template <class IMPL, class RETURN_TYPE = bool>
 class SymmetricPreparedBinaryFunction {
 public:
+	// Whether the predicate is always false if the geometries are disjoint. Implementations can override this.
+	static constexpr bool REQUIRES_INTERSECTION = true;
+	// Whether the predicate can be evaluated without GEOS if one of the geometries is a point
+	static constexpr PointPredicate POINT_PREDICATE = PointPredicate::NONE;
+
 	static void Execute(DataChunk &args, ExpressionState &state, Vector &result) {
-		const auto &lstate = LocalState::ResetAndGet(state);
+		auto &lstate = LocalState::ResetAndGet(state);
 
 		auto &lhs_vec = args.data[0];
 		auto &rhs_vec = args.data[1];
@@ -108,6 +395,11 @@ public:
 			result.SetVectorType(VectorType::CONSTANT_VECTOR);
 			const auto &lhs_blob = ConstantVector::GetData<string_t>(lhs_vec)[0];
 			const auto &rhs_blob = ConstantVector::GetData<string_t>(rhs_vec)[0];
+			bool point_result;
+			if (TryExecutePointPredicate(IMPL::POINT_PREDICATE, lstate, lhs_blob, rhs_blob, point_result)) {
+				ConstantVector::GetData<RETURN_TYPE>(result)[0] = RETURN_TYPE(point_result);
+				return;
+			}
 			const auto lhs_geom = lstate.Deserialize(lhs_blob);
 			const auto rhs_geom = lstate.Deserialize(rhs_blob);
 			ConstantVector::GetData<RETURN_TYPE>(result)[0] = IMPL::ExecutePredicateNormal(lhs_geom, rhs_geom);
@@ -121,15 +413,56 @@ public:
 			const auto const_geom = lstate.Deserialize(const_blob);
 			const auto const_prep = const_geom.get_prepared();
 
+			// Skip the rows that are outside the bounds of the const geometry
+			Box2D<float> const_bounds;
+			const auto has_const_bounds =
+			    IMPL::REQUIRES_INTERSECTION && geometry_t(const_blob).TryGetCachedBounds(const_bounds);
+
+			// Locate probe points in a const polygon with an index instead
+			PointInPolygonIndex const_index;
+			const auto has_const_index = const_index.TryBuild(IMPL::POINT_PREDICATE, !lhs_is_const, lstate, const_blob);
+
 			UnaryExecutor::Execute<string_t, RETURN_TYPE>(
 			    probe_vec, result, args.size(), [&](const string_t &probe_blob) {
+				    if (has_const_bounds && HasDisjointBounds(const_bounds, probe_blob)) {
+					    return RETURN_TYPE(false);
+				    }
+				    bool point_result;
+				    if (has_const_index && const_index.TryExecute(lstate, probe_blob, point_result)) {
+					    return RETURN_TYPE(point_result);
+				    }
+				    const auto &lhs_blob = lhs_is_const ? const_blob : probe_blob;
+				    const auto &rhs_blob = lhs_is_const ? probe_blob : const_blob;
+				    if (TryExecutePointPredicate(IMPL::POINT_PREDICATE, lstate, lhs_blob, rhs_blob, point_result)) {
+					    return RETURN_TYPE(point_result);
+				    }
 				    const auto probe_geom = lstate.Deserialize(probe_blob);
 				    return IMPL::ExecutePredicatePrepared(const_prep, probe_geom);
 			    });
 		} else {
-			// Both are non-const, just execute normally
+			// Both are non-const, but if either side repeats its geometries, prepare and cache them
+			const auto prepare_lhs = lstate.lhs_repeats.HasRepeatedBlobs(lhs_vec, args.size());
+			const auto prepare_rhs = !prepare_lhs && lstate.rhs_repeats.HasRepeatedBlobs(rhs_vec, args.size());
+
 			BinaryExecutor::Execute<string_t, string_t, RETURN_TYPE>(
 			    lhs_vec, rhs_vec, result, args.size(), [&](const string_t &lhs_blob, const string_t &rhs_blob) {
+				    if (IMPL::REQUIRES_INTERSECTION && HasDisjointBounds(lhs_blob, rhs_blob)) {
+					    return RETURN_TYPE(false);
+				    }
+				    bool point_result;
+				    if (TryExecutePointPredicate(IMPL::POINT_PREDICATE, lstate, lhs_blob, rhs_blob, point_result)) {
+					    return RETURN_TYPE(point_result);
+				    }
+				    if (prepare_lhs && !lhs_blob.IsInlined()) {
+					    const auto &lhs_prep = lstate.GetPrepared(lhs_blob);
+					    const auto rhs = lstate.Deserialize(rhs_blob);
+					    return IMPL::ExecutePredicatePrepared(lhs_prep, rhs);
+				    }
+				    if (prepare_rhs && !rhs_blob.IsInlined()) {
+					    const auto &rhs_prep = lstate.GetPrepared(rhs_blob);
+					    const auto lhs = lstate.Deserialize(lhs_blob);
+					    return IMPL::ExecutePredicatePrepared(rhs_prep, lhs);
+				    }
 				    const auto lhs = lstate.Deserialize(lhs_blob);
 				    const auto rhs = lstate.Deserialize(rhs_blob);
 				    return IMPL::ExecutePredicateNormal(lhs, rhs);
@@ -141,8 +474,15 @@ public:
 template <class IMPL, class RETURN_TYPE = bool>
 class AsymmetricPreparedBinaryFunction {
 public:
+	// Whether the predicate is always false if the geometries are disjoint. Implementations can override this.
+	static constexpr bool REQUIRES_INTERSECTION = true;
+	// Whether the predicate can be evaluated without GEOS if one of the geometries is a point
+	static constexpr PointPredicate POINT_PREDICATE = PointPredicate::NONE;
+	// Whether ExecutePredicatePrepared can evaluate the predicate with the left geometry prepared
+	static constexpr bool CAN_PREPARE_LHS = true;
+
 	static void Execute(DataChunk &args, ExpressionState &state, Vector &result) {
-		const auto &lstate = LocalState::ResetAndGet(state);
+		auto &lstate = LocalState::ResetAndGet(state);
 
 		auto &lhs_vec = args.data[0];
 		auto &rhs_vec = args.data[1];
@@ -157,25 +497,73 @@ public:
 			result.SetVectorType(VectorType::CONSTANT_VECTOR);
 			const auto &lhs_blob = ConstantVector::GetData<string_t>(lhs_vec)[0];
 			const auto &rhs_blob = ConstantVector::GetData<string_t>(rhs_vec)[0];
+			bool point_result;
+			if (TryExecutePointPredicate(IMPL::POINT_PREDICATE, lstate, lhs_blob, rhs_blob, point_result)) {
+				ConstantVector::GetData<RETURN_TYPE>(result)[0] = RETURN_TYPE(point_result);
+				return;
+			}
 			const auto lhs_geom = lstate.Deserialize(lhs_blob);
 			const auto rhs_geom = lstate.Deserialize(rhs_blob);
 			ConstantVector::GetData<RETURN_TYPE>(result)[0] = IMPL::ExecutePredicateNormal(lhs_geom, rhs_geom);
 
-		} else if (lhs_is_const) {
+		} else if (lhs_is_const && IMPL::CAN_PREPARE_LHS) {
 			// Prepare the left const and run on the non-const right
 			// Because this predicate is not symmetric, we can't just swap the two, so we only prepare the left
 			const auto lhs_blob = ConstantVector::GetData<string_t>(lhs_vec)[0];
 			const auto lhs_geom = lstate.Deserialize(lhs_blob);
 			const auto lhs_prep = lhs_geom.get_prepared();
 
+			// Skip the rows that are outside the bounds of the const geometry
+			Box2D<float> lhs_bounds;
+			const auto has_lhs_bounds =
+			    IMPL::REQUIRES_INTERSECTION && geometry_t(lhs_blob).TryGetCachedBounds(lhs_bounds);
+
+			// Locate right points in a const left polygon with an index instead
+			PointInPolygonIndex lhs_index;
+			const auto has_lhs_index = lhs_index.TryBuild(IMPL::POINT_PREDICATE, false, lstate, lhs_blob);
+
 			UnaryExecutor::Execute<string_t, RETURN_TYPE>(rhs_vec, result, args.size(), [&](const string_t &rhs_blob) {
+				if (has_lhs_bounds && HasDisjointBounds(lhs_bounds, rhs_blob)) {
+					return RETURN_TYPE(false);
+				}
+				bool point_result;
+				if (has_lhs_index && lhs_index.TryExecute(lstate, rhs_blob, point_result)) {
+					return RETURN_TYPE(point_result);
+				}
+				if (TryExecutePointPredicate(IMPL::POINT_PREDICATE, lstate, lhs_blob, rhs_blob, point_result)) {
+					return RETURN_TYPE(point_result);
+				}
 				const auto rhs_geom = lstate.Deserialize(rhs_blob);
 				return IMPL::ExecutePredicatePrepared(lhs_prep, rhs_geom);
 			});
 		} else {
-			// Both are non-const, just execute normally
+			// Both are non-const (or only one is), just execute normally
+			// If the right one is a const polygon, we can still locate left points in it with an index
+			PointInPolygonIndex rhs_index;
+			const auto has_rhs_index =
+			    rhs_is_const &&
+			    rhs_index.TryBuild(IMPL::POINT_PREDICATE, true, lstate, ConstantVector::GetData<string_t>(rhs_vec)[0]);
+
+			// If the left side repeats its geometries, prepare and cache them
+			const auto prepare_lhs = IMPL::CAN_PREPARE_LHS && lstate.lhs_repeats.HasRepeatedBlobs(lhs_vec, args.size());
+
 			BinaryExecutor::Execute<string_t, string_t, RETURN_TYPE>(
 			    lhs_vec, rhs_vec, result, args.size(), [&](const string_t &lhs_blob, const string_t &rhs_blob) {
+				    if (IMPL::REQUIRES_INTERSECTION && HasDisjointBounds(lhs_blob, rhs_blob)) {
+					    return RETURN_TYPE(false);
+				    }
+				    bool point_result;
+				    if (has_rhs_index && rhs_index.TryExecute(lstate, lhs_blob, point_result)) {
+					    return RETURN_TYPE(point_result);
+				    }
+				    if (TryExecutePointPredicate(IMPL::POINT_PREDICATE, lstate, lhs_blob, rhs_blob, point_result)) {
+					    return RETURN_TYPE(point_result);
+				    }
+				    if (prepare_lhs && !lhs_blob.IsInlined()) {
+					    const auto &lhs_prep = lstate.GetPrepared(lhs_blob);
+					    const auto rhs = lstate.Deserialize(rhs_blob);
+					    return IMPL::ExecutePredicatePrepared(lhs_prep, rhs);
+				    }
 				    const auto lhs = lstate.Deserialize(lhs_blob);
 				    const auto rhs = lstate.Deserialize(rhs_blob);
 				    return IMPL::ExecutePredicateNormal(lhs, rhs);
@@ -384,6 +772,8 @@ struct ST_BuildArea {
 };
 
 struct ST_Contains : AsymmetricPreparedBinaryFunction<ST_Contains> {
+	static constexpr PointPredicate POINT_PREDICATE = PointPredicate::CONTAINS;
+
 	static bool ExecutePredicateNormal(const GeosGeometry &lhs, const GeosGeometry &rhs) {
 		return lhs.contains(rhs);
 	}
@@ -449,6 +839,9 @@ struct ST_ContainsProperly : AsymmetricPreparedBinaryFunction<ST_ContainsProperl
 };
 
 struct ST_WithinProperly : AsymmetricPreparedBinaryFunction<ST_WithinProperly> {
+	// GEOS can only prepare the containing geometry, which is the right one
+	static constexpr bool CAN_PREPARE_LHS = false;
+
 	static bool ExecutePredicateNormal(const GeosGeometry &lhs, const GeosGeometry &rhs) {
 		// We have no choice but to prepare the right geometry
 		const auto rhs_prep = rhs.get_prepared();
@@ -894,6 +1287,8 @@ struct ST_Difference {
 };
 
 struct ST_Disjoint : SymmetricPreparedBinaryFunction<ST_Disjoint> {
+	static constexpr bool REQUIRES_INTERSECTION = false;
+
 	static bool ExecutePredicateNormal(const GeosGeometry &lhs, const GeosGeometry &rhs) {
 		return lhs.disjoint(rhs);
 	}
@@ -919,6 +1314,8 @@ struct ST_Disjoint : SymmetricPreparedBinaryFunction<ST_Disjoint> {
 };
 
 struct ST_Distance : SymmetricPreparedBinaryFunction<ST_Distance, double> {
+	static constexpr bool REQUIRES_INTERSECTION = false;
+
 	static double ExecutePredicateNormal(const GeosGeometry &lhs, const GeosGeometry &rhs) {
 		return lhs.distance_to(rhs);
 	}
@@ -1043,6 +1440,16 @@ struct ST_Equals {
 
 		BinaryExecutor::Execute<string_t, string_t, bool>(args.data[0], args.data[1], result, args.size(),
 		                                                  [&](const string_t &lhs_blob, const string_t &rhs_blob) {
+			                                                  // Identical blobs are equal. For version 1 geometries,
+			                                                  // the body hash is stored in the inlined prefix, so
+			                                                  // blobs that differ are usually told apart without
+			                                                  // comparing the rest of the bytes.
+			                                                  if (lhs_blob == rhs_blob) {
+				                                                  return true;
+			                                                  }
+			                                                  if (HasDifferentBounds(lhs_blob, rhs_blob)) {
+				                                                  return false;
+			                                                  }
 			                                                  const auto lhs = lstate.Deserialize(lhs_blob);
 			                                                  const auto rhs = lstate.Deserialize(rhs_blob);
 			                                                  return lhs.equals(rhs);
@@ -1126,6 +1533,8 @@ struct ST_Intersection {
 };
 
 struct ST_Intersects : SymmetricPreparedBinaryFunction<ST_Intersects> {
+	static constexpr PointPredicate POINT_PREDICATE = PointPredicate::INTERSECTS;
+
 	static bool ExecutePredicateNormal(const GeosGeometry &lhs, const GeosGeometry &rhs) {
 		return lhs.intersects(rhs);
 	}
@@ -1883,6 +2292,8 @@ struct ST_VoronoiDiagram {
 };
 
 struct ST_Within : AsymmetricPreparedBinaryFunction<ST_Within> {
+	static constexpr PointPredicate POINT_PREDICATE = PointPredicate::WITHIN;
+
 	static bool ExecutePredicateNormal(const GeosGeometry &lhs, const GeosGeometry &rhs) {
 		return lhs.within(rhs);
 	}
@@ -2013,16 +2424,253 @@ struct GeosUnaryAggFunction {
 //======================================================================================================================
 // ST_Union_Agg
 //======================================================================================================================
+// Merging each input into a running union is quadratic, as the running union is re-noded for every input.
+// Instead, we buffer the inputs and union them in batches using a cascaded (unary) union, and then merge the batch
+// results pairwise in a binary tree, where levels[i] holds the union of 2^i batches. The buffer is flushed once it
+// holds too many geometries or coordinates, which keeps the memory usage of each state bounded by the batch size
+// (plus the partial unions, which are rarely larger than their inputs).
 
-struct ST_Union_Agg : GeosUnaryAggFunction {
-	static GEOSGeometry *Merge(const GEOSContextHandle_t context, const GEOSGeometry *curr, const GEOSGeometry *next) {
-		return GEOSUnion_r(context, curr, next);
+struct ST_Union_Agg {
+
+	static constexpr idx_t BUFFER_GEOMETRY_LIMIT = 2048;
+	static constexpr idx_t BUFFER_COORDINATE_LIMIT = 1024 * 1024;
+
+	struct State {
+		GEOSContextHandle_t context = nullptr;
+		// The inputs that have not been unioned yet
+		vector<GEOSGeometry *> buffer;
+		idx_t buffer_coordinates = 0;
+		// The partial unions of the previously flushed batches
+		vector<GEOSGeometry *> levels;
+	};
+
+	// Union the geometries of the collection, which takes ownership of them (also if the union fails)
+	static GeosGeometry UnaryUnion(const GEOSContextHandle_t context, GeosCollection &geoms) {
+		const auto collection = geoms.get_collection();
+		if (!collection.get_raw()) {
+			throw InvalidInputException("Could not compute union: failed to create geometry collection");
+		}
+		auto result = GeosGeometry(context, GEOSUnaryUnion_r(context, collection.get_raw()));
+		if (!result.get_raw()) {
+			throw InvalidInputException("Could not compute union");
+		}
+		return result;
+	}
+
+	static void Flush(State &state) {
+		if (state.buffer.empty()) {
+			return;
+		}
+
+		GeosCollection batch(state.context);
+		batch.reserve(state.buffer.size());
+		for (const auto geom : state.buffer) {
+			batch.add(GeosGeometry(state.context, geom));
+		}
+		state.buffer.clear();
+		state.buffer_coordinates = 0;
+
+		auto geom = UnaryUnion(state.context, batch);
+
+		// Carry the result up the levels, merging it with the partial unions of the same size
+		for (idx_t level = 0;; level++) {
+			if (level == state.levels.size()) {
+				state.levels.push_back(nullptr);
+			}
+			if (!state.levels[level]) {
+				state.levels[level] = geom.get_raw();
+				geom.leak();
+				return;
+			}
+			GeosCollection pair(state.context);
+			pair.reserve(2);
+			pair.add(GeosGeometry(state.context, state.levels[level]));
+			state.levels[level] = nullptr;
+			pair.add(std::move(geom));
+			geom = UnaryUnion(state.context, pair);
+		}
+	}
+
+	static void Append(State &state, GeosGeometry geom) {
+		state.buffer.push_back(geom.get_raw());
+		geom.leak();
+		const auto coordinates = GEOSGetNumCoordinates_r(state.context, state.buffer.back());
+		state.buffer_coordinates += coordinates > 0 ? static_cast<idx_t>(coordinates) : 0;
+
+		if (state.buffer.size() >= BUFFER_GEOMETRY_LIMIT || state.buffer_coordinates >= BUFFER_COORDINATE_LIMIT) {
+			Flush(state);
+		}
+	}
+
+	static idx_t StateSize(const AggregateFunction &) {
+		return sizeof(State);
+	}
+
+	static void Initialize(const AggregateFunction &, data_ptr_t state_mem) {
+		const auto state_ptr = new (state_mem) State();
+		state_ptr->context = GEOS_init_r();
+	}
+
+	static void Update(Vector inputs[], AggregateInputData &aggr_input_data, idx_t input_count, Vector &state_vec,
+	                   idx_t count) {
+
+		auto &geom_vec = inputs[0];
+
+		// Union is idempotent, so if the same geometry is added to the same state, we only need to add it once
+		if (geom_vec.GetVectorType() == VectorType::CONSTANT_VECTOR &&
+		    state_vec.GetVectorType() == VectorType::CONSTANT_VECTOR) {
+			count = MinValue<idx_t>(count, 1);
+		}
+
+		UnifiedVectorFormat geom_format;
+		geom_vec.ToUnifiedFormat(count, geom_format);
+
+		UnifiedVectorFormat state_format;
+		state_vec.ToUnifiedFormat(count, state_format);
+
+		const auto state_ptr = UnifiedVectorFormat::GetData<State *>(state_format);
+		const auto geom_ptr = UnifiedVectorFormat::GetData<string_t>(geom_format);
+
+		for (idx_t raw_idx = 0; raw_idx < count; raw_idx++) {
+			const auto state_idx = state_format.sel->get_index(raw_idx);
+			const auto geom_idx = geom_format.sel->get_index(raw_idx);
+
+			if (!geom_format.validity.RowIsValid(geom_idx)) {
+				continue;
+			}
+
+			auto &state = *state_ptr[state_idx];
+			const auto &blob = geom_ptr[geom_idx];
+			const auto raw_geom = GeosSerde::Deserialize(state.context, blob.GetData(), blob.GetSize());
+			auto geom = GeosGeometry(state.context, raw_geom);
+			if (!geom.get_raw()) {
+				throw InvalidInputException("Could not deserialize geometry");
+			}
+			Append(state, std::move(geom));
+		}
+	}
+
+	static void Combine(Vector &state_vec, Vector &combined, AggregateInputData &aggr_input_data, idx_t count) {
+		UnifiedVectorFormat state_format;
+		state_vec.ToUnifiedFormat(count, state_format);
+
+		const auto state_ptr = UnifiedVectorFormat::GetData<State *>(state_format);
+		const auto combined_ptr = FlatVector::GetData<State *>(combined);
+
+		const auto destructive = aggr_input_data.combine_type == AggregateCombineType::ALLOW_DESTRUCTIVE;
+
+		for (idx_t raw_idx = 0; raw_idx < count; raw_idx++) {
+			auto &state = *state_ptr[state_format.sel->get_index(raw_idx)];
+			auto &combined_state = *combined_ptr[raw_idx];
+
+			// Add the partial unions and the pending inputs of the source state to the combined state.
+			// If we are allowed to, steal them instead of cloning them
+			for (auto list : {&state.levels, &state.buffer}) {
+				for (auto &geom : *list) {
+					if (!geom) {
+						continue;
+					}
+					// The source state no longer owns a stolen geometry, even if appending it fails
+					auto input = destructive ? geom : GEOSGeom_clone_r(combined_state.context, geom);
+					if (destructive) {
+						geom = nullptr;
+					}
+					Append(combined_state, GeosGeometry(combined_state.context, input));
+				}
+				if (destructive) {
+					list->clear();
+				}
+			}
+			if (destructive) {
+				state.buffer_coordinates = 0;
+			}
+		}
+	}
+
+	static void Finalize(Vector &state_vec, AggregateInputData &aggr_input_data, Vector &result, idx_t count,
+	                     idx_t offset) {
+
+		UnifiedVectorFormat state_format;
+		state_vec.ToUnifiedFormat(count, state_format);
+
+		const auto state_ptr = UnifiedVectorFormat::GetData<State *>(state_format);
+		const auto result_ptr = FlatVector::GetData<string_t>(result);
+
+		for (idx_t raw_idx = 0; raw_idx < count; raw_idx++) {
+			auto &state = *state_ptr[state_format.sel->get_index(raw_idx)];
+			const auto out_idx = raw_idx + offset;
+
+			// Gather everything that is left, and union it all together
+			const GEOSGeometry *last = nullptr;
+			idx_t geom_count = 0;
+			for (auto list : {&state.levels, &state.buffer}) {
+				for (const auto geom : *list) {
+					if (geom) {
+						last = geom;
+						geom_count++;
+					}
+				}
+			}
+
+			if (geom_count == 0) {
+				FlatVector::SetNull(result, out_idx, true);
+				continue;
+			}
+
+			if (geom_count == 1) {
+				// A single input is returned as-is
+				result_ptr[out_idx] = GeosUnaryAggFunction::Serialize(state.context, result, last);
+				continue;
+			}
+
+			// Move the geometries out of the state, they are destroyed with the union collection
+			GeosCollection geoms(state.context);
+			geoms.reserve(geom_count);
+			for (auto list : {&state.levels, &state.buffer}) {
+				for (const auto geom : *list) {
+					if (geom) {
+						geoms.add(GeosGeometry(state.context, geom));
+					}
+				}
+				list->clear();
+			}
+			state.buffer_coordinates = 0;
+
+			auto geom = UnaryUnion(state.context, geoms);
+
+			// Keep the result in the state, in case we are finalized again (e.g. in a window)
+			state.levels.push_back(geom.get_raw());
+			geom.leak();
+
+			result_ptr[out_idx] = GeosUnaryAggFunction::Serialize(state.context, result, state.levels.back());
+		}
+	}
+
+	static void Destroy(Vector &state_vec, AggregateInputData &aggr, idx_t count) {
+		UnifiedVectorFormat state_format;
+		state_vec.ToUnifiedFormat(count, state_format);
+
+		const auto state_ptr = UnifiedVectorFormat::GetData<State *>(state_format);
+		for (idx_t raw_idx = 0; raw_idx < count; raw_idx++) {
+			auto &state = *state_ptr[state_format.sel->get_index(raw_idx)];
+
+			for (auto list : {&state.levels, &state.buffer}) {
+				for (auto &geom : *list) {
+					if (geom) {
+						GEOSGeom_destroy_r(state.context, geom);
+					}
+				}
+			}
+			if (state.context) {
+				GEOS_finish_r(state.context);
+			}
+			state.~State();
+		}
 	}
 
 	static void Register(DatabaseInstance &db) {
-		const auto agg =
-		    AggregateFunction::UnaryAggregateDestructor<GeosUnaryAggState, string_t, string_t, ST_Union_Agg>(
-		        GeoTypes::GEOMETRY(), GeoTypes::GEOMETRY());
+		const AggregateFunction agg({GeoTypes::GEOMETRY()}, GeoTypes::GEOMETRY(), StateSize, Initialize, Update,
+		                            Combine, Finalize, nullptr, nullptr, Destroy);
 
 		FunctionBuilder::RegisterAggregate(db, "ST_Union_Agg", [&](AggregateFunctionBuilder &func) {
 			func.SetFunction(agg);
@@ -0,0 +1,221 @@
+#include "spatial/modules/geos/geos_prepared_cache.hpp"
+#include "spatial/modules/geos/geos_geometry.hpp"
+#include "spatial/modules/geos/geos_serde.hpp"
+
+#include "duckdb/common/types/vector.hpp"
+#include "duckdb/common/unordered_map.hpp"
+
+#include <list>
+
+namespace duckdb {
+
+namespace {
+
+//------------------------------------------------------------------------------
+// Predicates
+//------------------------------------------------------------------------------
+// The build side geometry is the second argument of the join predicate, so every predicate has to be expressed as
+// a prepared predicate on the build side geometry: e.g. ST_Contains(probe, build) becomes build.within(probe).
+// Predicates that have no prepared equivalent in that direction (ST_Equals, ST_ContainsProperly) are not cached.
+// ST_Crosses is not symmetric for mixed dimensions, so it is not cached either.
+
+struct PreparedIntersects {
+	static bool Execute(const PreparedGeosGeometry &build, const GeosGeometry &probe) {
+		return build.intersects(probe);
+	}
+};
+
+struct PreparedTouches {
+	static bool Execute(const PreparedGeosGeometry &build, const GeosGeometry &probe) {
+		return build.touches(probe);
+	}
+};
+
+struct PreparedOverlaps {
+	static bool Execute(const PreparedGeosGeometry &build, const GeosGeometry &probe) {
+		return build.overlaps(probe);
+	}
+};
+
+// ST_Contains(probe, build) => build within probe
+struct PreparedContains {
+	static bool Execute(const PreparedGeosGeometry &build, const GeosGeometry &probe) {
+		return build.within(probe);
+	}
+};
+
+// ST_Within(probe, build) => build contains probe
+struct PreparedWithin {
+	static bool Execute(const PreparedGeosGeometry &build, const GeosGeometry &probe) {
+		return build.contains(probe);
+	}
+};
+
+// ST_Covers(probe, build) => build covered by probe
+struct PreparedCovers {
+	static bool Execute(const PreparedGeosGeometry &build, const GeosGeometry &probe) {
+		return build.covered_by(probe);
+	}
+};
+
+// ST_CoveredBy(probe, build) => build covers probe
+struct PreparedCoveredBy {
+	static bool Execute(const PreparedGeosGeometry &build, const GeosGeometry &probe) {
+		return build.covers(probe);
+	}
+};
+
+// ST_WithinProperly(probe, build) => build contains probe properly
+struct PreparedWithinProperly {
+	static bool Execute(const PreparedGeosGeometry &build, const GeosGeometry &probe) {
+		return build.contains_properly(probe);
+	}
+};
+
+//------------------------------------------------------------------------------
+// Cache Implementation
+//------------------------------------------------------------------------------
+
+struct PreparedCacheEntry {
+	data_ptr_t key;
+	idx_t size;
+	// The prepared geometry references the geometry, so it has to be declared (and thus destroyed) after it
+	GeosGeometry geom;
+	PreparedGeosGeometry prepared;
+
+	PreparedCacheEntry(data_ptr_t key_p, idx_t size_p, GeosGeometry geom_p)
+	    : key(key_p), size(size_p), geom(std::move(geom_p)), prepared(geom.get_prepared()) {
+	}
+};
+
+template <class OP>
+class GeosPreparedCacheImpl final : public GeosPreparedCache {
+public:
+	explicit GeosPreparedCacheImpl(idx_t memory_limit_p) : memory_limit(memory_limit_p) {
+		ctx = GEOS_init_r();
+		GEOSContext_setErrorMessageHandler_r(
+		    ctx, [](const char *message, void *) { throw InvalidInputException(message); }, nullptr);
+	}
+
+	~GeosPreparedCacheImpl() override {
+		// Destroy all geometries before the context they belong to
+		map.clear();
+		entries.clear();
+		GEOS_finish_r(ctx);
+	}
+
+	idx_t Select(const UnifiedVectorFormat &probe_format, const SelectionVector &probe_sel, Vector &build_keys,
+	             const data_ptr_t *build_ptrs, idx_t count, SelectionVector &result) override {
+
+		UnifiedVectorFormat build_format;
+		build_keys.ToUnifiedFormat(count, build_format);
+
+		const auto probe_data = UnifiedVectorFormat::GetData<string_t>(probe_format);
+		const auto build_data = UnifiedVectorFormat::GetData<string_t>(build_format);
+
+		// The candidates of a probe row are consecutive, so only deserialize each probe geometry once
+		unique_ptr<GeosGeometry> probe_geom;
+		idx_t probe_geom_idx = DConstants::INVALID_INDEX;
+
+		idx_t result_count = 0;
+		for (idx_t i = 0; i < count; i++) {
+			const auto probe_idx = probe_format.sel->get_index(probe_sel.get_index(i));
+			const auto build_idx = build_format.sel->get_index(i);
+			if (!probe_format.validity.RowIsValid(probe_idx) || !build_format.validity.RowIsValid(build_idx)) {
+				// NULL never matches
+				continue;
+			}
+
+			if (probe_idx != probe_geom_idx || !probe_geom) {
+				probe_geom = make_uniq<GeosGeometry>(Deserialize(probe_data[probe_idx]));
+				probe_geom_idx = probe_idx;
+			}
+
+			const auto &prepared = GetOrPrepare(build_ptrs[i], build_data[build_idx]);
+			if (OP::Execute(prepared, *probe_geom)) {
+				result.set_index(result_count++, i);
+			}
+		}
+		return result_count;
+	}
+
+private:
+	GeosGeometry Deserialize(const string_t &blob) const {
+		const auto geom = GeosSerde::Deserialize(ctx, blob.GetData(), blob.GetSize());
+		if (geom == nullptr) {
+			throw InvalidInputException("Could not deserialize geometry");
+		}
+		return GeosGeometry(ctx, geom);
+	}
+
+	const PreparedGeosGeometry &GetOrPrepare(data_ptr_t key, const string_t &blob) {
+		const auto it = map.find(key);
+		if (it != map.end()) {
+			// Move the entry to the front of the LRU list
+			hit_count++;
+			entries.splice(entries.begin(), entries, it->second);
+			return it->second->prepared;
+		}
+
+		miss_count++;
+
+		// We dont know the actual size of the GEOS geometry and its prepared index, so estimate it from the serialized
+		// size. The in-memory representation (with the prepared index) is usually a couple times larger.
+		const auto size = blob.GetSize() * 4;
+
+		// Evict the least recently used entries until the new one fits
+		while (!entries.empty() && memory_usage + size > memory_limit) {
+			auto &last = entries.back();
+			memory_usage -= last.size;
+			map.erase(last.key);
+			entries.pop_back();
+		}
+
+		entries.emplace_front(key, size, Deserialize(blob));
+		map[key] = entries.begin();
+		memory_usage += size;
+
+		return entries.front().prepared;
+	}
+
+private:
+	GEOSContextHandle_t ctx;
+	idx_t memory_limit;
+	idx_t memory_usage = 0;
+
+	// Most recently used entries are kept at the front
+	std::list<PreparedCacheEntry> entries;
+	unordered_map<data_ptr_t, typename std::list<PreparedCacheEntry>::iterator> map;
+};
+
+} // namespace
+
+unique_ptr<GeosPreparedCache> GeosPreparedCache::TryCreate(const string &predicate_name, idx_t memory_limit) {
+	if (predicate_name == "ST_Intersects") {
+		return make_uniq<GeosPreparedCacheImpl<PreparedIntersects>>(memory_limit);
+	}
+	if (predicate_name == "ST_Touches") {
+		return make_uniq<GeosPreparedCacheImpl<PreparedTouches>>(memory_limit);
+	}
+	if (predicate_name == "ST_Overlaps") {
+		return make_uniq<GeosPreparedCacheImpl<PreparedOverlaps>>(memory_limit);
+	}
+	if (predicate_name == "ST_Contains") {
+		return make_uniq<GeosPreparedCacheImpl<PreparedContains>>(memory_limit);
+	}
+	if (predicate_name == "ST_Within") {
+		return make_uniq<GeosPreparedCacheImpl<PreparedWithin>>(memory_limit);
+	}
+	if (predicate_name == "ST_Covers") {
+		return make_uniq<GeosPreparedCacheImpl<PreparedCovers>>(memory_limit);
+	}
+	if (predicate_name == "ST_CoveredBy") {
+		return make_uniq<GeosPreparedCacheImpl<PreparedCoveredBy>>(memory_limit);
+	}
+	if (predicate_name == "ST_WithinProperly") {
+		return make_uniq<GeosPreparedCacheImpl<PreparedWithinProperly>>(memory_limit);
+	}
+	return nullptr;
+}
+
+} // namespace duckdb
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "duckdb/common/common.hpp"
+
+namespace duckdb {
+
+class Vector;
+class SelectionVector;
+struct UnifiedVectorFormat;
+
+// Evaluates a binary spatial predicate on candidate (probe, build) geometry pairs, keeping the build side geometries
+// deserialized and GEOS-prepared across calls. Build side geometries are keyed by a caller provided pointer (e.g. the
+// address of the row in a TupleDataCollection) that must stay valid and unique for the lifetime of the cache.
+// Once the estimated size of the cached geometries exceeds the memory limit, the least recently used ones are evicted.
+//
+// The cache is not thread-safe, it owns its own GEOS context and is meant to be kept in a thread-local state.
+class GeosPreparedCache {
+public:
+	virtual ~GeosPreparedCache() = default;
+
+	// Returns nullptr if the predicate can not be evaluated by preparing its second (build side) argument
+	static unique_ptr<GeosPreparedCache> TryCreate(const string &predicate_name, idx_t memory_limit);
+
+	// Evaluates predicate(probe, build) for each of the "count" candidate pairs, and writes the index of each pair
+	// that matched to the result selection vector. Returns the number of matches.
+	// - probe_format/probe_sel: the i'th probe geometry is at probe_format.sel->get_index(probe_sel.get_index(i))
+	// - build_keys/build_ptrs: the i'th build geometry is at row i of build_keys, with build_ptrs[i] as its cache key
+	virtual idx_t Select(const UnifiedVectorFormat &probe_format, const SelectionVector &probe_sel, Vector &build_keys,
+	                     const data_ptr_t *build_ptrs, idx_t count, SelectionVector &result) = 0;
+
+	idx_t GetHitCount() const {
+		return hit_count;
+	}
+	idx_t GetMissCount() const {
+		return miss_count;
+	}
+
+protected:
+	idx_t hit_count = 0;
+	idx_t miss_count = 0;
+};
+
+} // namespace duckdb
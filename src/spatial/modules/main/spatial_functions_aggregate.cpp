@@ -42,30 +42,94 @@ struct ExtentAggFunction {
 		target.ymax = std::max(target.ymax, source.ymax);
 	}
 
-	template <class INPUT_TYPE, class STATE, class OP>
-	static void Operation(STATE &state, const INPUT_TYPE &input, AggregateUnaryInput &aggregate) {
+	static bool Contains(const ExtentAggState &state, const Box2D<float> &bbox) {
+		return state.is_set && state.xmin <= bbox.min.x && state.ymin <= bbox.min.y && state.xmax >= bbox.max.x &&
+		       state.ymax >= bbox.max.y;
+	}
+
+	static void Absorb(ExtentAggState &state, const string_t &blob, ArenaAllocator &arena) {
+
+		// The bounding box cached in the header is rounded outwards to float precision, so if it is already contained
+		// in the current extent, the geometry cannot grow it and we dont have to look at its vertices at all.
+		Box2D<float> cached;
+		if (geometry_t(blob).TryGetCachedBounds(cached) && Contains(state, cached)) {
+			return;
+		}
 
-		// TODO: Vectorize this so we dont clear the arena after each row
 		sgl::geometry geom;
-		Serde::Deserialize(geom, aggregate.input.allocator, input.GetDataUnsafe(), input.GetSize());
+		Serde::Deserialize(geom, arena, blob.GetDataUnsafe(), blob.GetSize());
 
 		auto bbox = sgl::box_xy::smallest();
-		if (sgl::ops::try_get_extent_xy(&geom, &bbox)) {
-
-			if (!state.is_set) {
-				state.is_set = true;
-				state.xmin = bbox.min.x;
-				state.xmax = bbox.max.x;
-				state.ymin = bbox.min.y;
-				state.ymax = bbox.max.y;
-			} else {
-				state.xmin = std::min(state.xmin, bbox.min.x);
-				state.xmax = std::max(state.xmax, bbox.max.x);
-				state.ymin = std::min(state.ymin, bbox.min.y);
-				state.ymax = std::max(state.ymax, bbox.max.y);
+		if (!sgl::ops::try_get_extent_xy(&geom, &bbox)) {
+			return;
+		}
+
+		if (!state.is_set) {
+			state.is_set = true;
+			state.xmin = bbox.min.x;
+			state.xmax = bbox.max.x;
+			state.ymin = bbox.min.y;
+			state.ymax = bbox.max.y;
+		} else {
+			state.xmin = std::min(state.xmin, bbox.min.x);
+			state.xmax = std::max(state.xmax, bbox.max.x);
+			state.ymin = std::min(state.ymin, bbox.min.y);
+			state.ymax = std::max(state.ymax, bbox.max.y);
+		}
+	}
+
+	// Vectorized updates, so that we only reset the arena once per vector
+	static void Update(Vector inputs[], AggregateInputData &aggr_input_data, idx_t, Vector &state_vec, idx_t count) {
+		UnifiedVectorFormat geom_format;
+		inputs[0].ToUnifiedFormat(count, geom_format);
+
+		UnifiedVectorFormat state_format;
+		state_vec.ToUnifiedFormat(count, state_format);
+
+		const auto geom_data = UnifiedVectorFormat::GetData<string_t>(geom_format);
+		const auto state_data = UnifiedVectorFormat::GetData<ExtentAggState *>(state_format);
+
+		for (idx_t i = 0; i < count; i++) {
+			const auto geom_idx = geom_format.sel->get_index(i);
+			if (!geom_format.validity.RowIsValid(geom_idx)) {
+				continue;
+			}
+			auto &state = *state_data[state_format.sel->get_index(i)];
+			Absorb(state, geom_data[geom_idx], aggr_input_data.allocator);
+		}
+
+		aggr_input_data.allocator.Reset();
+	}
+
+	static void SimpleUpdate(Vector inputs[], AggregateInputData &aggr_input_data, idx_t, data_ptr_t state_ptr,
+	                         idx_t count) {
+		auto &input = inputs[0];
+		auto &state = *reinterpret_cast<ExtentAggState *>(state_ptr);
+
+		if (input.GetVectorType() == VectorType::CONSTANT_VECTOR) {
+			// The extent of the same geometry is the same, no matter how many times we add it
+			count = MinValue<idx_t>(count, 1);
+		}
+
+		UnifiedVectorFormat geom_format;
+		input.ToUnifiedFormat(count, geom_format);
+
+		const auto geom_data = UnifiedVectorFormat::GetData<string_t>(geom_format);
+
+		for (idx_t i = 0; i < count; i++) {
+			const auto geom_idx = geom_format.sel->get_index(i);
+			if (geom_format.validity.RowIsValid(geom_idx)) {
+				Absorb(state, geom_data[geom_idx], aggr_input_data.allocator);
 			}
 		}
 
+		aggr_input_data.allocator.Reset();
+	}
+
+	// Only used if the aggregate is executed row-by-row, the vectorized updates above are used otherwise
+	template <class INPUT_TYPE, class STATE, class OP>
+	static void Operation(STATE &state, const INPUT_TYPE &input, AggregateUnaryInput &aggregate) {
+		Absorb(state, input, aggregate.input.allocator);
 		aggregate.input.allocator.Reset();
 	}
 
@@ -142,8 +206,10 @@ static constexpr const char *DOC_ALIAS_DESCRIPTION = R"(
 void RegisterSpatialAggregateFunctions(DatabaseInstance &db) {
 
 	// TODO: Dont use geometry_t here
-	const auto agg = AggregateFunction::UnaryAggregate<ExtentAggState, string_t, string_t, ExtentAggFunction>(
+	auto agg = AggregateFunction::UnaryAggregate<ExtentAggState, string_t, string_t, ExtentAggFunction>(
 	    GeoTypes::GEOMETRY(), GeoTypes::GEOMETRY());
+	agg.update = ExtentAggFunction::Update;
+	agg.simple_update = ExtentAggFunction::SimpleUpdate;
 
 	FunctionBuilder::RegisterAggregate(db, "ST_Extent_Agg", [&](AggregateFunctionBuilder &func) {
 		func.SetFunction(agg);
@@ -25,7 +25,8 @@ namespace {
 
 class LocalState final : public FunctionLocalState {
 public:
-	explicit LocalState(ClientContext &context) : arena(BufferAllocator::Get(context)), allocator(arena) {
+	explicit LocalState(ClientContext &context)
+	    : arena(BufferAllocator::Get(context)), allocator(arena), format(SerdeFormat::Get(context)) {
 	}
 
 	static unique_ptr<FunctionLocalState> InitCast(CastLocalStateParameters &params);
@@ -45,6 +46,7 @@ public:
 private:
 	ArenaAllocator arena;
 	GeometryAllocator allocator;
+	SerdeFormat format;
 };
 
 unique_ptr<FunctionLocalState> LocalState::InitCast(CastLocalStateParameters &parameters) {
@@ -62,9 +64,9 @@ void LocalState::Deserialize(const string_t &blob, sgl::geometry &geom) {
 }
 
 string_t LocalState::Serialize(Vector &vector, const sgl::geometry &geom) {
-	const auto size = Serde::GetRequiredSize(geom);
+	const auto size = Serde::GetRequiredSize(geom, format);
 	auto blob = StringVector::EmptyString(vector, size);
-	Serde::Serialize(geom, blob.GetDataWriteable(), size);
+	Serde::Serialize(geom, format, blob.GetDataWriteable(), size);
 	blob.Finalize();
 	return blob;
 }
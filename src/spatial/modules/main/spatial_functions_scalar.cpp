@@ -32,7 +32,8 @@ namespace {
 
 class LocalState final : public FunctionLocalState {
 public:
-	explicit LocalState(ClientContext &context) : arena(BufferAllocator::Get(context)), allocator(arena) {
+	explicit LocalState(ClientContext &context)
+	    : arena(BufferAllocator::Get(context)), allocator(arena), format(SerdeFormat::Get(context)) {
 	}
 
 	static unique_ptr<FunctionLocalState> Init(ExpressionState &state, const BoundFunctionExpression &expr,
@@ -54,6 +55,7 @@ public:
 private:
 	ArenaAllocator arena;
 	GeometryAllocator allocator;
+	SerdeFormat format;
 };
 
 unique_ptr<FunctionLocalState> LocalState::Init(ExpressionState &state, const BoundFunctionExpression &expr,
@@ -79,9 +81,9 @@ sgl::geometry *LocalState::DeserializeToHeap(const string_t &blob) {
 }
 
 string_t LocalState::Serialize(Vector &vector, const sgl::geometry &geom) {
-	const auto size = Serde::GetRequiredSize(geom);
+	const auto size = Serde::GetRequiredSize(geom, format);
 	auto blob = StringVector::EmptyString(vector, size);
-	Serde::Serialize(geom, blob.GetDataWriteable(), size);
+	Serde::Serialize(geom, format, blob.GetDataWriteable(), size);
 	blob.Finalize();
 	return blob;
 }
@@ -0,0 +1,1246 @@
+#include "spatial/modules/mvt/mvt_module.hpp"
+
+#include "spatial/geometry/geometry_serialization.hpp"
+#include "spatial/geometry/sgl.hpp"
+#include "spatial/spatial_types.hpp"
+#include "spatial/util/function_builder.hpp"
+
+#include "duckdb/common/types/vector.hpp"
+#include "duckdb/common/unordered_map.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/planner/expression/bound_function_expression.hpp"
+
+#include "protozero/pbf_writer.hpp"
+
+namespace duckdb {
+
+namespace {
+
+//######################################################################################################################
+// Mapbox Vector Tiles
+//######################################################################################################################
+// See https://github.com/mapbox/vector-tile-spec/tree/master/2.1 for the specification.
+//
+// ST_AsMVTGeom transforms a geometry into the integer coordinate space of a tile, and ST_AsMVT aggregates rows of
+// (tile space) geometries and properties into a single layer of an encoded tile. Both are plain DuckDB functions, so a
+// whole tile pyramid can be generated in parallel with a single GROUP BY z, x, y query.
+
+//======================================================================================================================
+// Local State
+//======================================================================================================================
+
+class LocalState final : public FunctionLocalState {
+public:
+	explicit LocalState(ClientContext &context) : arena(BufferAllocator::Get(context)), allocator(arena) {
+	}
+
+	static unique_ptr<FunctionLocalState> Init(ExpressionState &state, const BoundFunctionExpression &expr,
+	                                           FunctionData *bind_data) {
+		return make_uniq_base<FunctionLocalState, LocalState>(state.GetContext());
+	}
+
+	static LocalState &ResetAndGet(ExpressionState &state) {
+		auto &local_state = ExecuteFunctionState::GetFunctionState(state)->Cast<LocalState>();
+		local_state.arena.Reset();
+		return local_state;
+	}
+
+	void Deserialize(const string_t &blob, sgl::geometry &geom) {
+		Serde::Deserialize(geom, arena, blob.GetDataUnsafe(), blob.GetSize());
+	}
+
+	string_t Serialize(Vector &vector, const sgl::geometry &geom) {
+		const auto size = Serde::GetRequiredSize(geom);
+		auto blob = StringVector::EmptyString(vector, size);
+		Serde::Serialize(geom, blob.GetDataWriteable(), size);
+		blob.Finalize();
+		return blob;
+	}
+
+	GeometryAllocator &GetAllocator() {
+		return allocator;
+	}
+
+private:
+	ArenaAllocator arena;
+	GeometryAllocator allocator;
+};
+
+//======================================================================================================================
+// ST_AsMVTGeom
+//======================================================================================================================
+
+struct ST_AsMVTGeom {
+
+	static constexpr int32_t DEFAULT_EXTENT = 4096;
+	static constexpr int32_t DEFAULT_BUFFER = 256;
+
+	using Ring = vector<sgl::vertex_xy>;
+
+	// Accumulates the parts of the output geometry in tile space
+	struct TileGeometry {
+		vector<sgl::vertex_xy> points;
+		vector<Ring> lines;
+		vector<vector<Ring>> polygons;
+	};
+
+	//------------------------------------------------------------------------------------------------------------------
+	// Clipping
+	//------------------------------------------------------------------------------------------------------------------
+	// Clip a segment to the [lo, hi] square (Liang-Barsky), returns false if the segment is completely outside
+	static bool ClipSegment(const sgl::vertex_xy &a, const sgl::vertex_xy &b, double lo, double hi, double &t0,
+	                        double &t1) {
+		const auto dx = b.x - a.x;
+		const auto dy = b.y - a.y;
+		const double p[4] = {-dx, dx, -dy, dy};
+		const double q[4] = {a.x - lo, hi - a.x, a.y - lo, hi - a.y};
+
+		t0 = 0;
+		t1 = 1;
+
+		for (idx_t k = 0; k < 4; k++) {
+			if (p[k] == 0) {
+				// Parallel to this edge
+				if (q[k] < 0) {
+					return false;
+				}
+				continue;
+			}
+			const auto r = q[k] / p[k];
+			if (p[k] < 0) {
+				if (r > t1) {
+					return false;
+				}
+				t0 = MaxValue(t0, r);
+			} else {
+				if (r < t0) {
+					return false;
+				}
+				t1 = MinValue(t1, r);
+			}
+		}
+		return true;
+	}
+
+	static sgl::vertex_xy Lerp(const sgl::vertex_xy &a, const sgl::vertex_xy &b, double t) {
+		return {a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t};
+	}
+
+	// Clip a line to the [lo, hi] square. A line that leaves and re-enters the square is split into multiple lines.
+	static void ClipLine(const Ring &line, double lo, double hi, vector<Ring> &result) {
+		Ring run;
+		for (idx_t i = 1; i < line.size(); i++) {
+			const auto &a = line[i - 1];
+			const auto &b = line[i];
+
+			double t0;
+			double t1;
+			if (!ClipSegment(a, b, lo, hi, t0, t1)) {
+				if (run.size() > 1) {
+					result.push_back(std::move(run));
+				}
+				run.clear();
+				continue;
+			}
+
+			if (!run.empty() && t0 > 0) {
+				// The segment re-enters the square, start a new line
+				if (run.size() > 1) {
+					result.push_back(std::move(run));
+				}
+				run.clear();
+			}
+			if (run.empty()) {
+				run.push_back(Lerp(a, b, t0));
+			}
+			run.push_back(Lerp(a, b, t1));
+
+			if (t1 < 1) {
+				// The segment leaves the square
+				if (run.size() > 1) {
+					result.push_back(std::move(run));
+				}
+				run.clear();
+			}
+		}
+		if (run.size() > 1) {
+			result.push_back(std::move(run));
+		}
+	}
+
+	// Clip an (open) ring to the [lo, hi] square (Sutherland-Hodgman)
+	static void ClipRing(Ring &ring, double lo, double hi) {
+		Ring input;
+		for (idx_t edge = 0; edge < 4; edge++) {
+			if (ring.empty()) {
+				return;
+			}
+
+			std::swap(input, ring);
+			ring.clear();
+
+			const auto is_x = edge < 2;
+			const auto bound = edge % 2 == 0 ? lo : hi;
+			const auto inside = [&](const sgl::vertex_xy &v) {
+				const auto c = is_x ? v.x : v.y;
+				return edge % 2 == 0 ? c >= bound : c <= bound;
+			};
+			const auto intersect = [&](const sgl::vertex_xy &a, const sgl::vertex_xy &b) {
+				const auto ca = is_x ? a.x : a.y;
+				const auto cb = is_x ? b.x : b.y;
+				return Lerp(a, b, (bound - ca) / (cb - ca));
+			};
+
+			for (idx_t i = 0; i < input.size(); i++) {
+				const auto &curr = input[i];
+				const auto &prev = input[(i + input.size() - 1) % input.size()];
+				const auto curr_inside = inside(curr);
+				const auto prev_inside = inside(prev);
+				if (curr_inside) {
+					if (!prev_inside) {
+						ring.push_back(intersect(prev, curr));
+					}
+					ring.push_back(curr);
+				} else if (prev_inside) {
+					ring.push_back(intersect(prev, curr));
+				}
+			}
+		}
+	}
+
+	//------------------------------------------------------------------------------------------------------------------
+	// Quantization
+	//------------------------------------------------------------------------------------------------------------------
+	// Snap the vertices to the integer grid and remove repeated vertices
+	static void Quantize(Ring &ring) {
+		idx_t count = 0;
+		for (auto &vertex : ring) {
+			const sgl::vertex_xy snapped = {std::round(vertex.x), std::round(vertex.y)};
+			if (count == 0 || !(ring[count - 1] == snapped)) {
+				ring[count++] = snapped;
+			}
+		}
+		ring.resize(count);
+	}
+
+	static double SignedArea(const Ring &ring) {
+		double area = 0;
+		for (idx_t i = 0; i < ring.size(); i++) {
+			const auto &a = ring[i];
+			const auto &b = ring[(i + 1) % ring.size()];
+			area += a.x * b.y - b.x * a.y;
+		}
+		return area / 2;
+	}
+
+	//------------------------------------------------------------------------------------------------------------------
+	// Transform
+	//------------------------------------------------------------------------------------------------------------------
+	struct TileTransform {
+		double min_x;
+		double max_y;
+		double scale_x;
+		double scale_y;
+		// The clip square, in tile space
+		bool clip;
+		double lo;
+		double hi;
+
+		sgl::vertex_xy Apply(const sgl::vertex_xy &vertex) const {
+			// Tile space has its origin in the top left corner, with the y axis pointing down
+			return {(vertex.x - min_x) * scale_x, (max_y - vertex.y) * scale_y};
+		}
+
+		Ring Apply(const sgl::geometry &part) const {
+			Ring result;
+			result.reserve(part.get_count());
+			for (uint32_t i = 0; i < part.get_count(); i++) {
+				result.push_back(Apply(part.get_vertex_xy(i)));
+			}
+			return result;
+		}
+	};
+
+	static void AddPoint(const TileTransform &transform, const sgl::geometry &point, TileGeometry &result) {
+		if (point.is_empty()) {
+			return;
+		}
+		auto vertex = transform.Apply(point.get_vertex_xy(0));
+		if (transform.clip &&
+		    (vertex.x < transform.lo || vertex.x > transform.hi || vertex.y < transform.lo || vertex.y > transform.hi)) {
+			return;
+		}
+		result.points.push_back({std::round(vertex.x), std::round(vertex.y)});
+	}
+
+	static void AddLine(const TileTransform &transform, const sgl::geometry &line, TileGeometry &result) {
+		if (line.get_count() < 2) {
+			return;
+		}
+		vector<Ring> lines;
+		if (transform.clip) {
+			ClipLine(transform.Apply(line), transform.lo, transform.hi, lines);
+		} else {
+			lines.push_back(transform.Apply(line));
+		}
+		for (auto &part : lines) {
+			Quantize(part);
+			if (part.size() > 1) {
+				result.lines.push_back(std::move(part));
+			}
+		}
+	}
+
+	static void AddPolygon(const TileTransform &transform, const sgl::geometry &polygon, TileGeometry &result) {
+		vector<Ring> rings;
+
+		const auto tail = polygon.get_last_part();
+		auto ring_part = tail;
+		if (!ring_part) {
+			return;
+		}
+		do {
+			ring_part = ring_part->get_next();
+
+			auto ring = transform.Apply(*ring_part);
+			// Work on the open ring, and close it again at the end
+			if (ring.size() > 1 && ring.front() == ring.back()) {
+				ring.pop_back();
+			}
+			if (transform.clip) {
+				ClipRing(ring, transform.lo, transform.hi);
+			}
+			Quantize(ring);
+			if (ring.size() > 1 && ring.front() == ring.back()) {
+				ring.pop_back();
+			}
+
+			if (ring.size() < 3 || SignedArea(ring) == 0) {
+				if (rings.empty()) {
+					// The shell collapsed, so does the whole polygon
+					return;
+				}
+				continue;
+			}
+
+			ring.push_back(ring.front());
+			rings.push_back(std::move(ring));
+		} while (ring_part != tail);
+
+		result.polygons.push_back(std::move(rings));
+	}
+
+	static void AddParts(const TileTransform &transform, const sgl::geometry &geom, TileGeometry &result) {
+		switch (geom.get_type()) {
+		case sgl::geometry_type::POINT:
+			AddPoint(transform, geom, result);
+			break;
+		case sgl::geometry_type::LINESTRING:
+			AddLine(transform, geom, result);
+			break;
+		case sgl::geometry_type::POLYGON:
+			AddPolygon(transform, geom, result);
+			break;
+		case sgl::geometry_type::MULTI_POINT:
+		case sgl::geometry_type::MULTI_LINESTRING:
+		case sgl::geometry_type::MULTI_POLYGON:
+		case sgl::geometry_type::MULTI_GEOMETRY: {
+			const auto tail = geom.get_last_part();
+			auto part = tail;
+			if (!part) {
+				return;
+			}
+			do {
+				part = part->get_next();
+				AddParts(transform, *part, result);
+			} while (part != tail);
+		} break;
+		default:
+			throw InvalidInputException("ST_AsMVTGeom: unsupported geometry type");
+		}
+	}
+
+	//------------------------------------------------------------------------------------------------------------------
+	// Output
+	//------------------------------------------------------------------------------------------------------------------
+	static sgl::geometry *MakeGeometry(GeometryAllocator &alloc, sgl::geometry_type type) {
+		const auto mem = alloc.alloc(sizeof(sgl::geometry));
+		return new (mem) sgl::geometry(type, false, false);
+	}
+
+	static sgl::geometry *MakeVertexGeometry(GeometryAllocator &alloc, sgl::geometry_type type, const Ring &vertices) {
+		const auto geom = MakeGeometry(alloc, type);
+		const auto size = vertices.size() * sizeof(sgl::vertex_xy);
+		const auto data = static_cast<uint8_t *>(alloc.alloc(size));
+		memcpy(data, vertices.data(), size);
+		geom->set_vertex_data(data, static_cast<uint32_t>(vertices.size()));
+		return geom;
+	}
+
+	static sgl::geometry *MakePolygon(GeometryAllocator &alloc, const vector<Ring> &rings) {
+		const auto polygon = MakeGeometry(alloc, sgl::geometry_type::POLYGON);
+		for (const auto &ring : rings) {
+			polygon->append_part(MakeVertexGeometry(alloc, sgl::geometry_type::LINESTRING, ring));
+		}
+		return polygon;
+	}
+
+	// Only the parts of the highest dimension are kept, as a tile feature can only hold a single kind of geometry
+	static sgl::geometry *Build(GeometryAllocator &alloc, const TileGeometry &geom) {
+		if (!geom.polygons.empty()) {
+			if (geom.polygons.size() == 1) {
+				return MakePolygon(alloc, geom.polygons[0]);
+			}
+			const auto multi = MakeGeometry(alloc, sgl::geometry_type::MULTI_POLYGON);
+			for (const auto &polygon : geom.polygons) {
+				multi->append_part(MakePolygon(alloc, polygon));
+			}
+			return multi;
+		}
+		if (!geom.lines.empty()) {
+			if (geom.lines.size() == 1) {
+				return MakeVertexGeometry(alloc, sgl::geometry_type::LINESTRING, geom.lines[0]);
+			}
+			const auto multi = MakeGeometry(alloc, sgl::geometry_type::MULTI_LINESTRING);
+			for (const auto &line : geom.lines) {
+				multi->append_part(MakeVertexGeometry(alloc, sgl::geometry_type::LINESTRING, line));
+			}
+			return multi;
+		}
+		if (!geom.points.empty()) {
+			if (geom.points.size() == 1) {
+				return MakeVertexGeometry(alloc, sgl::geometry_type::POINT, geom.points);
+			}
+			const auto multi = MakeGeometry(alloc, sgl::geometry_type::MULTI_POINT);
+			for (const auto &point : geom.points) {
+				multi->append_part(MakeVertexGeometry(alloc, sgl::geometry_type::POINT, {point}));
+			}
+			return multi;
+		}
+		return nullptr;
+	}
+
+	//------------------------------------------------------------------------------------------------------------------
+	// Execute
+	//------------------------------------------------------------------------------------------------------------------
+	static void Execute(DataChunk &args, ExpressionState &state, Vector &result) {
+		auto &lstate = LocalState::ResetAndGet(state);
+		auto &alloc = lstate.GetAllocator();
+
+		const auto count = args.size();
+		const auto arg_count = args.ColumnCount();
+
+		auto all_constant = true;
+		for (idx_t arg_idx = 0; arg_idx < arg_count; arg_idx++) {
+			all_constant &= args.data[arg_idx].GetVectorType() == VectorType::CONSTANT_VECTOR;
+		}
+
+		args.Flatten();
+
+		auto &geom_vec = args.data[0];
+		auto &bounds_vec = args.data[1];
+
+		const auto geom_data = FlatVector::GetData<string_t>(geom_vec);
+		const auto &bounds_children = StructVector::GetEntries(bounds_vec);
+		const auto min_x_data = FlatVector::GetData<double>(*bounds_children[0]);
+		const auto min_y_data = FlatVector::GetData<double>(*bounds_children[1]);
+		const auto max_x_data = FlatVector::GetData<double>(*bounds_children[2]);
+		const auto max_y_data = FlatVector::GetData<double>(*bounds_children[3]);
+
+		const auto result_data = FlatVector::GetData<string_t>(result);
+
+		for (idx_t row_idx = 0; row_idx < count; row_idx++) {
+			bool is_null = false;
+			for (idx_t arg_idx = 0; arg_idx < arg_count; arg_idx++) {
+				is_null |= FlatVector::IsNull(args.data[arg_idx], row_idx);
+			}
+			if (is_null) {
+				FlatVector::SetNull(result, row_idx, true);
+				continue;
+			}
+
+			const auto extent = arg_count > 2 ? FlatVector::GetData<int32_t>(args.data[2])[row_idx] : DEFAULT_EXTENT;
+			const auto buffer = arg_count > 3 ? FlatVector::GetData<int32_t>(args.data[3])[row_idx] : DEFAULT_BUFFER;
+			const auto clip = arg_count > 4 ? FlatVector::GetData<bool>(args.data[4])[row_idx] : true;
+
+			if (extent <= 0) {
+				throw InvalidInputException("ST_AsMVTGeom: extent must be greater than zero");
+			}
+			if (buffer < 0) {
+				throw InvalidInputException("ST_AsMVTGeom: buffer must not be negative");
+			}
+
+			const auto width = max_x_data[row_idx] - min_x_data[row_idx];
+			const auto height = max_y_data[row_idx] - min_y_data[row_idx];
+			if (!(width > 0) || !(height > 0)) {
+				throw InvalidInputException("ST_AsMVTGeom: bounds must have a positive width and height");
+			}
+
+			TileTransform transform;
+			transform.min_x = min_x_data[row_idx];
+			transform.max_y = max_y_data[row_idx];
+			transform.scale_x = extent / width;
+			transform.scale_y = extent / height;
+			transform.clip = clip;
+			transform.lo = -static_cast<double>(buffer);
+			transform.hi = static_cast<double>(extent) + buffer;
+
+			sgl::geometry geom;
+			lstate.Deserialize(geom_data[row_idx], geom);
+
+			TileGeometry tile_geom;
+			AddParts(transform, geom, tile_geom);
+
+			const auto output = Build(alloc, tile_geom);
+			if (!output) {
+				// Nothing left of the geometry in this tile
+				FlatVector::SetNull(result, row_idx, true);
+				continue;
+			}
+			result_data[row_idx] = lstate.Serialize(result, *output);
+		}
+
+		if (all_constant) {
+			result.SetVectorType(VectorType::CONSTANT_VECTOR);
+		}
+	}
+
+	//------------------------------------------------------------------------------------------------------------------
+	// Documentation
+	//------------------------------------------------------------------------------------------------------------------
+	static constexpr auto DESCRIPTION = R"(
+	Transforms a geometry into the coordinate space of a Mapbox Vector Tile
+
+	The `bounds` are the extent of the tile in the coordinate system of the geometry. The geometry is scaled to the integer `extent` x `extent` grid of the tile, with the origin in the top-left corner, and snapped to the grid.
+
+	If `clip_geom` is true (the default), the geometry is clipped to the tile, expanded by `buffer` units on each side. Only the parts of the highest dimension are kept, and parts that collapse when snapped to the grid are removed. Returns NULL if nothing remains of the geometry.
+	)";
+
+	static constexpr auto EXAMPLE = R"(
+	SELECT ST_AsText(ST_AsMVTGeom(
+	    ST_GeomFromText('LINESTRING(-5 5, 5 5)'),
+	    {'min_x': 0, 'min_y': 0, 'max_x': 10, 'max_y': 10}::BOX_2D,
+	    4096,
+	    0
+	));
+	----
+	LINESTRING (0 2048, 2048 2048)
+	)";
+
+	//------------------------------------------------------------------------------------------------------------------
+	// Register
+	//------------------------------------------------------------------------------------------------------------------
+	static void Register(DatabaseInstance &db) {
+		FunctionBuilder::RegisterScalar(db, "ST_AsMVTGeom", [](ScalarFunctionBuilder &func) {
+			// Add the variants with and without the optional parameters
+			for (idx_t param_count = 2; param_count <= 5; param_count++) {
+				func.AddVariant([&](ScalarFunctionVariantBuilder &variant) {
+					variant.AddParameter("geom", GeoTypes::GEOMETRY());
+					variant.AddParameter("bounds", GeoTypes::BOX_2D());
+					if (param_count > 2) {
+						variant.AddParameter("extent", LogicalType::INTEGER);
+					}
+					if (param_count > 3) {
+						variant.AddParameter("buffer", LogicalType::INTEGER);
+					}
+					if (param_count > 4) {
+						variant.AddParameter("clip_geom", LogicalType::BOOLEAN);
+					}
+					variant.SetReturnType(GeoTypes::GEOMETRY());
+					variant.SetInit(LocalState::Init);
+					variant.SetFunction(Execute);
+				});
+			}
+
+			func.SetDescription(DESCRIPTION);
+			func.SetExample(EXAMPLE);
+
+			func.SetTag("ext", "spatial");
+			func.SetTag("category", "conversion");
+		});
+	}
+};
+
+//======================================================================================================================
+// ST_AsMVT
+//======================================================================================================================
+// The aggregate state buffers the encoded features of the layer, together with the dictionaries of property keys and
+// values the feature tags refer to. Values are deduplicated on their encoded protobuf message, so e.g. the integer 1
+// and the string '1' are kept apart. When combining states, the tags of the source features are remapped to the
+// dictionaries of the target state.
+
+namespace mvt {
+
+// Protobuf field numbers of the vector tile messages
+enum TileField : uint32_t { TILE_LAYERS = 3 };
+
+enum LayerField : uint32_t {
+	LAYER_NAME = 1,
+	LAYER_FEATURES = 2,
+	LAYER_KEYS = 3,
+	LAYER_VALUES = 4,
+	LAYER_EXTENT = 5,
+	LAYER_VERSION = 15
+};
+
+enum FeatureField : uint32_t { FEATURE_TAGS = 2, FEATURE_TYPE = 3, FEATURE_GEOMETRY = 4 };
+
+enum ValueField : uint32_t {
+	VALUE_STRING = 1,
+	VALUE_FLOAT = 2,
+	VALUE_DOUBLE = 3,
+	VALUE_UINT = 5,
+	VALUE_SINT = 6,
+	VALUE_BOOL = 7
+};
+
+enum GeomType : uint32_t { UNKNOWN = 0, POINT = 1, LINESTRING = 2, POLYGON = 3 };
+
+enum Command : uint32_t { MOVE_TO = 1, LINE_TO = 2, CLOSE_PATH = 7 };
+
+} // namespace mvt
+
+struct ST_AsMVT {
+
+	static constexpr auto DEFAULT_LAYER_NAME = "default";
+
+	//------------------------------------------------------------------------------------------------------------------
+	// Bind
+	//------------------------------------------------------------------------------------------------------------------
+	struct BindData final : FunctionData {
+		string layer_name = DEFAULT_LAYER_NAME;
+		uint32_t extent = ST_AsMVTGeom::DEFAULT_EXTENT;
+		idx_t geom_idx = 0;
+		// The struct fields holding the properties of the features
+		vector<idx_t> property_idxs;
+		vector<string> property_names;
+
+		unique_ptr<FunctionData> Copy() const override {
+			auto result = make_uniq<BindData>();
+			result->layer_name = layer_name;
+			result->extent = extent;
+			result->geom_idx = geom_idx;
+			result->property_idxs = property_idxs;
+			result->property_names = property_names;
+			return std::move(result);
+		}
+
+		bool Equals(const FunctionData &other_p) const override {
+			auto &other = other_p.Cast<BindData>();
+			return layer_name == other.layer_name && extent == other.extent && geom_idx == other.geom_idx &&
+			       property_idxs == other.property_idxs && property_names == other.property_names;
+		}
+	};
+
+	static bool IsSupportedPropertyType(const LogicalType &type) {
+		switch (type.id()) {
+		case LogicalTypeId::VARCHAR:
+		case LogicalTypeId::BOOLEAN:
+		case LogicalTypeId::TINYINT:
+		case LogicalTypeId::SMALLINT:
+		case LogicalTypeId::INTEGER:
+		case LogicalTypeId::BIGINT:
+		case LogicalTypeId::UTINYINT:
+		case LogicalTypeId::USMALLINT:
+		case LogicalTypeId::UINTEGER:
+		case LogicalTypeId::UBIGINT:
+		case LogicalTypeId::FLOAT:
+		case LogicalTypeId::DOUBLE:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	static Value EvaluateConstant(ClientContext &context, const Expression &expr, const char *name) {
+		if (expr.HasParameter() || !expr.IsFoldable()) {
+			throw BinderException("ST_AsMVT: the '%s' parameter must be a constant", name);
+		}
+		const auto value = ExpressionExecutor::EvaluateScalar(context, expr);
+		if (value.IsNull()) {
+			throw BinderException("ST_AsMVT: the '%s' parameter must not be NULL", name);
+		}
+		return value;
+	}
+
+	static unique_ptr<FunctionData> Bind(ClientContext &context, AggregateFunction &function,
+	                                     vector<unique_ptr<Expression>> &arguments) {
+		auto result = make_uniq<BindData>();
+
+		const auto &row_type = arguments[0]->return_type;
+		if (row_type.id() != LogicalTypeId::STRUCT) {
+			throw BinderException("ST_AsMVT: the first argument must be a STRUCT holding a geometry and properties");
+		}
+
+		string geom_name;
+		if (arguments.size() > 1) {
+			result->layer_name = StringValue::Get(EvaluateConstant(context, *arguments[1], "name"));
+		}
+		if (arguments.size() > 2) {
+			const auto extent = IntegerValue::Get(EvaluateConstant(context, *arguments[2], "extent"));
+			if (extent <= 0) {
+				throw BinderException("ST_AsMVT: extent must be greater than zero");
+			}
+			result->extent = static_cast<uint32_t>(extent);
+		}
+		if (arguments.size() > 3) {
+			geom_name = StringValue::Get(EvaluateConstant(context, *arguments[3], "geom_name"));
+		}
+
+		// Find the geometry column, and use all other columns as properties
+		const auto &fields = StructType::GetChildTypes(row_type);
+		optional_idx geom_idx;
+		for (idx_t field_idx = 0; field_idx < fields.size(); field_idx++) {
+			const auto &field = fields[field_idx];
+			const auto is_geom = field.second == GeoTypes::GEOMETRY() &&
+			                     (geom_name.empty() ? !geom_idx.IsValid() : field.first == geom_name);
+			if (is_geom) {
+				geom_idx = field_idx;
+				continue;
+			}
+			if (!IsSupportedPropertyType(field.second)) {
+				throw BinderException("ST_AsMVT: unsupported type %s for property '%s'", field.second.ToString(),
+				                      field.first);
+			}
+			result->property_idxs.push_back(field_idx);
+			result->property_names.push_back(field.first);
+		}
+		if (!geom_idx.IsValid()) {
+			if (geom_name.empty()) {
+				throw BinderException("ST_AsMVT: the input row does not contain a GEOMETRY column");
+			}
+			throw BinderException("ST_AsMVT: the input row does not contain a GEOMETRY column named '%s'", geom_name);
+		}
+		result->geom_idx = geom_idx.GetIndex();
+
+		// The remaining parameters are constant and have been read, so we dont need them during execution
+		while (arguments.size() > 1) {
+			Function::EraseArgument(function, arguments, arguments.size() - 1);
+		}
+		function.arguments[0] = row_type;
+
+		return std::move(result);
+	}
+
+	//------------------------------------------------------------------------------------------------------------------
+	// State
+	//------------------------------------------------------------------------------------------------------------------
+	struct Feature {
+		mvt::GeomType type;
+		idx_t tags_offset;
+		idx_t tags_count;
+		idx_t geom_offset;
+		idx_t geom_count;
+	};
+
+	struct State {
+		vector<string> keys;
+		unordered_map<string, uint32_t> key_map;
+		vector<string> values;
+		unordered_map<string, uint32_t> value_map;
+
+		// The tags and geometry commands of all features are stored back to back
+		vector<Feature> features;
+		vector<uint32_t> tags;
+		vector<uint32_t> commands;
+
+		uint32_t GetOrAddKey(const string &key) {
+			const auto entry = key_map.find(key);
+			if (entry != key_map.end()) {
+				return entry->second;
+			}
+			const auto idx = static_cast<uint32_t>(keys.size());
+			keys.push_back(key);
+			key_map.emplace(key, idx);
+			return idx;
+		}
+
+		uint32_t GetOrAddValue(const string &value) {
+			const auto entry = value_map.find(value);
+			if (entry != value_map.end()) {
+				return entry->second;
+			}
+			const auto idx = static_cast<uint32_t>(values.size());
+			values.push_back(value);
+			value_map.emplace(value, idx);
+			return idx;
+		}
+	};
+
+	//------------------------------------------------------------------------------------------------------------------
+	// Geometry Encoding
+	//------------------------------------------------------------------------------------------------------------------
+	class GeometryEncoder {
+	public:
+		explicit GeometryEncoder(vector<uint32_t> &commands_p) : commands(commands_p) {
+		}
+
+		void EncodePoints(const sgl::geometry &geom) {
+			vector<sgl::vertex_xy> points;
+			CollectPoints(geom, points);
+			if (points.empty()) {
+				return;
+			}
+			commands.push_back(MakeCommand(mvt::MOVE_TO, points.size()));
+			for (const auto &point : points) {
+				AddVertex(point);
+			}
+		}
+
+		void EncodeLines(const sgl::geometry &geom) {
+			if (geom.get_type() == sgl::geometry_type::MULTI_LINESTRING) {
+				ForEachPart(geom, [&](const sgl::geometry &part) { EncodeLines(part); });
+				return;
+			}
+			auto line = Snap(geom);
+			if (line.size() < 2) {
+				return;
+			}
+			commands.push_back(MakeCommand(mvt::MOVE_TO, 1));
+			AddVertex(line[0]);
+			commands.push_back(MakeCommand(mvt::LINE_TO, line.size() - 1));
+			for (idx_t i = 1; i < line.size(); i++) {
+				AddVertex(line[i]);
+			}
+		}
+
+		void EncodePolygons(const sgl::geometry &geom) {
+			if (geom.get_type() == sgl::geometry_type::MULTI_POLYGON) {
+				ForEachPart(geom, [&](const sgl::geometry &part) { EncodePolygons(part); });
+				return;
+			}
+
+			const auto tail = geom.get_last_part();
+			auto ring_part = tail;
+			if (!ring_part) {
+				return;
+			}
+
+			auto is_shell = true;
+			do {
+				ring_part = ring_part->get_next();
+
+				auto ring = Snap(*ring_part);
+				if (ring.size() > 1 && ring.front() == ring.back()) {
+					ring.pop_back();
+				}
+
+				const auto area = ring.size() < 3 ? 0 : ST_AsMVTGeom::SignedArea(ring);
+				if (area == 0) {
+					if (is_shell) {
+						// The shell collapsed, so does the whole polygon
+						return;
+					}
+					continue;
+				}
+
+				// In tile space (y down), the shell has to have a positive area, and the holes a negative area
+				if ((area > 0) != is_shell) {
+					std::reverse(ring.begin(), ring.end());
+				}
+				is_shell = false;
+
+				commands.push_back(MakeCommand(mvt::MOVE_TO, 1));
+				AddVertex(ring[0]);
+				commands.push_back(MakeCommand(mvt::LINE_TO, ring.size() - 1));
+				for (idx_t i = 1; i < ring.size(); i++) {
+					AddVertex(ring[i]);
+				}
+				commands.push_back(MakeCommand(mvt::CLOSE_PATH, 1));
+			} while (ring_part != tail);
+		}
+
+	private:
+		static uint32_t MakeCommand(mvt::Command id, idx_t count) {
+			return (id & 0x7) | (static_cast<uint32_t>(count) << 3);
+		}
+
+		static uint32_t ZigZag(int32_t value) {
+			return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+		}
+
+		static int32_t ToInt(double value) {
+			constexpr auto min = static_cast<double>(NumericLimits<int32_t>::Minimum());
+			constexpr auto max = static_cast<double>(NumericLimits<int32_t>::Maximum());
+			return static_cast<int32_t>(MinValue(MaxValue(value, min), max));
+		}
+
+		void AddVertex(const sgl::vertex_xy &vertex) {
+			const auto x = ToInt(vertex.x);
+			const auto y = ToInt(vertex.y);
+			commands.push_back(ZigZag(x - cursor_x));
+			commands.push_back(ZigZag(y - cursor_y));
+			cursor_x = x;
+			cursor_y = y;
+		}
+
+		template <class CALLBACK>
+		static void ForEachPart(const sgl::geometry &geom, CALLBACK &&callback) {
+			const auto tail = geom.get_last_part();
+			auto part = tail;
+			if (!part) {
+				return;
+			}
+			do {
+				part = part->get_next();
+				callback(*part);
+			} while (part != tail);
+		}
+
+		static void CollectPoints(const sgl::geometry &geom, vector<sgl::vertex_xy> &points) {
+			if (geom.get_type() == sgl::geometry_type::MULTI_POINT) {
+				ForEachPart(geom, [&](const sgl::geometry &part) { CollectPoints(part, points); });
+				return;
+			}
+			if (!geom.is_empty()) {
+				const auto vertex = geom.get_vertex_xy(0);
+				points.push_back({std::round(vertex.x), std::round(vertex.y)});
+			}
+		}
+
+		// Snap the vertices to integers, and remove repeated vertices
+		static ST_AsMVTGeom::Ring Snap(const sgl::geometry &part) {
+			ST_AsMVTGeom::Ring result;
+			result.reserve(part.get_count());
+			for (uint32_t i = 0; i < part.get_count(); i++) {
+				result.push_back(part.get_vertex_xy(i));
+			}
+			ST_AsMVTGeom::Quantize(result);
+			return result;
+		}
+
+		vector<uint32_t> &commands;
+		int32_t cursor_x = 0;
+		int32_t cursor_y = 0;
+	};
+
+	//------------------------------------------------------------------------------------------------------------------
+	// Value Encoding
+	//------------------------------------------------------------------------------------------------------------------
+	template <class T>
+	static const T &GetValue(const UnifiedVectorFormat &format, idx_t idx) {
+		return UnifiedVectorFormat::GetData<T>(format)[idx];
+	}
+
+	static void EncodeValue(const LogicalType &type, const UnifiedVectorFormat &format, idx_t idx, std::string &buffer) {
+		buffer.clear();
+		protozero::pbf_writer writer(buffer);
+		switch (type.id()) {
+		case LogicalTypeId::VARCHAR: {
+			const auto &str = GetValue<string_t>(format, idx);
+			writer.add_string(mvt::VALUE_STRING, str.GetData(), str.GetSize());
+		} break;
+		case LogicalTypeId::BOOLEAN:
+			writer.add_bool(mvt::VALUE_BOOL, GetValue<bool>(format, idx));
+			break;
+		case LogicalTypeId::TINYINT:
+			writer.add_sint64(mvt::VALUE_SINT, GetValue<int8_t>(format, idx));
+			break;
+		case LogicalTypeId::SMALLINT:
+			writer.add_sint64(mvt::VALUE_SINT, GetValue<int16_t>(format, idx));
+			break;
+		case LogicalTypeId::INTEGER:
+			writer.add_sint64(mvt::VALUE_SINT, GetValue<int32_t>(format, idx));
+			break;
+		case LogicalTypeId::BIGINT:
+			writer.add_sint64(mvt::VALUE_SINT, GetValue<int64_t>(format, idx));
+			break;
+		case LogicalTypeId::UTINYINT:
+			writer.add_uint64(mvt::VALUE_UINT, GetValue<uint8_t>(format, idx));
+			break;
+		case LogicalTypeId::USMALLINT:
+			writer.add_uint64(mvt::VALUE_UINT, GetValue<uint16_t>(format, idx));
+			break;
+		case LogicalTypeId::UINTEGER:
+			writer.add_uint64(mvt::VALUE_UINT, GetValue<uint32_t>(format, idx));
+			break;
+		case LogicalTypeId::UBIGINT:
+			writer.add_uint64(mvt::VALUE_UINT, GetValue<uint64_t>(format, idx));
+			break;
+		case LogicalTypeId::FLOAT:
+			writer.add_float(mvt::VALUE_FLOAT, GetValue<float>(format, idx));
+			break;
+		case LogicalTypeId::DOUBLE:
+			writer.add_double(mvt::VALUE_DOUBLE, GetValue<double>(format, idx));
+			break;
+		default:
+			throw InternalException("ST_AsMVT: unsupported property type");
+		}
+	}
+
+	//------------------------------------------------------------------------------------------------------------------
+	// Aggregate
+	//------------------------------------------------------------------------------------------------------------------
+	static idx_t StateSize(const AggregateFunction &) {
+		return sizeof(State);
+	}
+
+	static void Initialize(const AggregateFunction &, data_ptr_t state_mem) {
+		new (state_mem) State();
+	}
+
+	static void Update(Vector inputs[], AggregateInputData &aggr_input_data, idx_t input_count, Vector &state_vec,
+	                   idx_t count) {
+		const auto &bind_data = aggr_input_data.bind_data->Cast<BindData>();
+		auto &arena = aggr_input_data.allocator;
+
+		auto &row_vec = inputs[0];
+		const auto &fields = StructVector::GetEntries(row_vec);
+
+		UnifiedVectorFormat row_format;
+		row_vec.ToUnifiedFormat(count, row_format);
+
+		UnifiedVectorFormat state_format;
+		state_vec.ToUnifiedFormat(count, state_format);
+		const auto state_ptr = UnifiedVectorFormat::GetData<State *>(state_format);
+
+		// The fields are indexed by the (dictionary) index of the struct row
+		UnifiedVectorFormat geom_format;
+		fields[bind_data.geom_idx]->ToUnifiedFormat(count, geom_format);
+		const auto geom_data = UnifiedVectorFormat::GetData<string_t>(geom_format);
+
+		vector<UnifiedVectorFormat> property_formats(bind_data.property_idxs.size());
+		for (idx_t prop_idx = 0; prop_idx < bind_data.property_idxs.size(); prop_idx++) {
+			fields[bind_data.property_idxs[prop_idx]]->ToUnifiedFormat(count, property_formats[prop_idx]);
+		}
+
+		std::string value_buffer;
+
+		for (idx_t raw_idx = 0; raw_idx < count; raw_idx++) {
+			const auto row_idx = row_format.sel->get_index(raw_idx);
+			if (!row_format.validity.RowIsValid(row_idx)) {
+				continue;
+			}
+			const auto geom_idx = geom_format.sel->get_index(row_idx);
+			if (!geom_format.validity.RowIsValid(geom_idx)) {
+				continue;
+			}
+
+			auto &state = *state_ptr[state_format.sel->get_index(raw_idx)];
+
+			sgl::geometry geom;
+			Serde::Deserialize(geom, arena, geom_data[geom_idx].GetDataUnsafe(), geom_data[geom_idx].GetSize());
+
+			Feature feature = {};
+			feature.geom_offset = state.commands.size();
+
+			GeometryEncoder encoder(state.commands);
+			switch (geom.get_type()) {
+			case sgl::geometry_type::POINT:
+			case sgl::geometry_type::MULTI_POINT:
+				feature.type = mvt::POINT;
+				encoder.EncodePoints(geom);
+				break;
+			case sgl::geometry_type::LINESTRING:
+			case sgl::geometry_type::MULTI_LINESTRING:
+				feature.type = mvt::LINESTRING;
+				encoder.EncodeLines(geom);
+				break;
+			case sgl::geometry_type::POLYGON:
+			case sgl::geometry_type::MULTI_POLYGON:
+				feature.type = mvt::POLYGON;
+				encoder.EncodePolygons(geom);
+				break;
+			default:
+				// Geometry collections can not be represented in a vector tile
+				continue;
+			}
+
+			feature.geom_count = state.commands.size() - feature.geom_offset;
+			if (feature.geom_count == 0) {
+				// Nothing left after snapping to the tile grid
+				continue;
+			}
+
+			feature.tags_offset = state.tags.size();
+			for (idx_t prop_idx = 0; prop_idx < bind_data.property_idxs.size(); prop_idx++) {
+				const auto &format = property_formats[prop_idx];
+				const auto value_idx = format.sel->get_index(row_idx);
+				if (!format.validity.RowIsValid(value_idx)) {
+					// NULL properties are omitted
+					continue;
+				}
+				const auto &type = StructType::GetChildType(row_vec.GetType(), bind_data.property_idxs[prop_idx]);
+				EncodeValue(type, format, value_idx, value_buffer);
+
+				state.tags.push_back(state.GetOrAddKey(bind_data.property_names[prop_idx]));
+				state.tags.push_back(state.GetOrAddValue(value_buffer));
+			}
+			feature.tags_count = state.tags.size() - feature.tags_offset;
+
+			state.features.push_back(feature);
+		}
+
+		arena.Reset();
+	}
+
+	static void Combine(Vector &state_vec, Vector &combined, AggregateInputData &aggr_input_data, idx_t count) {
+		UnifiedVectorFormat state_format;
+		state_vec.ToUnifiedFormat(count, state_format);
+
+		const auto state_ptr = UnifiedVectorFormat::GetData<State *>(state_format);
+		const auto combined_ptr = FlatVector::GetData<State *>(combined);
+
+		for (idx_t raw_idx = 0; raw_idx < count; raw_idx++) {
+			auto &source = *state_ptr[state_format.sel->get_index(raw_idx)];
+			auto &target = *combined_ptr[raw_idx];
+
+			if (source.features.empty()) {
+				continue;
+			}
+
+			// Map the dictionaries of the source to the dictionaries of the target
+			vector<uint32_t> key_map(source.keys.size());
+			for (idx_t i = 0; i < source.keys.size(); i++) {
+				key_map[i] = target.GetOrAddKey(source.keys[i]);
+			}
+			vector<uint32_t> value_map(source.values.size());
+			for (idx_t i = 0; i < source.values.size(); i++) {
+				value_map[i] = target.GetOrAddValue(source.values[i]);
+			}
+
+			for (const auto &source_feature : source.features) {
+				auto feature = source_feature;
+
+				feature.tags_offset = target.tags.size();
+				for (idx_t i = 0; i < source_feature.tags_count; i += 2) {
+					target.tags.push_back(key_map[source.tags[source_feature.tags_offset + i]]);
+					target.tags.push_back(value_map[source.tags[source_feature.tags_offset + i + 1]]);
+				}
+
+				feature.geom_offset = target.commands.size();
+				const auto commands_begin = source.commands.begin() + static_cast<int64_t>(source_feature.geom_offset);
+				target.commands.insert(target.commands.end(), commands_begin,
+				                       commands_begin + static_cast<int64_t>(source_feature.geom_count));
+
+				target.features.push_back(feature);
+			}
+		}
+	}
+
+	static void Finalize(Vector &state_vec, AggregateInputData &aggr_input_data, Vector &result, idx_t count,
+	                     idx_t offset) {
+		const auto &bind_data = aggr_input_data.bind_data->Cast<BindData>();
+
+		UnifiedVectorFormat state_format;
+		state_vec.ToUnifiedFormat(count, state_format);
+
+		const auto state_ptr = UnifiedVectorFormat::GetData<State *>(state_format);
+		const auto result_ptr = FlatVector::GetData<string_t>(result);
+
+		std::string tile;
+
+		for (idx_t raw_idx = 0; raw_idx < count; raw_idx++) {
+			auto &state = *state_ptr[state_format.sel->get_index(raw_idx)];
+			const auto out_idx = raw_idx + offset;
+
+			tile.clear();
+
+			// A tile without features is empty
+			if (!state.features.empty()) {
+				protozero::pbf_writer tile_writer(tile);
+				protozero::pbf_writer layer_writer(tile_writer, mvt::TILE_LAYERS);
+
+				layer_writer.add_uint32(mvt::LAYER_VERSION, 2);
+				layer_writer.add_string(mvt::LAYER_NAME, bind_data.layer_name);
+
+				for (const auto &feature : state.features) {
+					protozero::pbf_writer feature_writer(layer_writer, mvt::LAYER_FEATURES);
+					if (feature.tags_count != 0) {
+						const auto tags_begin = state.tags.begin() + static_cast<int64_t>(feature.tags_offset);
+						feature_writer.add_packed_uint32(mvt::FEATURE_TAGS, tags_begin,
+						                                 tags_begin + static_cast<int64_t>(feature.tags_count));
+					}
+					feature_writer.add_enum(mvt::FEATURE_TYPE, static_cast<int32_t>(feature.type));
+
+					const auto geom_begin = state.commands.begin() + static_cast<int64_t>(feature.geom_offset);
+					feature_writer.add_packed_uint32(mvt::FEATURE_GEOMETRY, geom_begin,
+					                                 geom_begin + static_cast<int64_t>(feature.geom_count));
+				}
+
+				for (const auto &key : state.keys) {
+					layer_writer.add_string(mvt::LAYER_KEYS, key);
+				}
+				for (const auto &value : state.values) {
+					layer_writer.add_message(mvt::LAYER_VALUES, value);
+				}
+
+				layer_writer.add_uint32(mvt::LAYER_EXTENT, bind_data.extent);
+			}
+
+			result_ptr[out_idx] = StringVector::AddStringOrBlob(result, tile.data(), tile.size());
+		}
+	}
+
+	static void Destroy(Vector &state_vec, AggregateInputData &, idx_t count) {
+		UnifiedVectorFormat state_format;
+		state_vec.ToUnifiedFormat(count, state_format);
+
+		const auto state_ptr = UnifiedVectorFormat::GetData<State *>(state_format);
+		for (idx_t raw_idx = 0; raw_idx < count; raw_idx++) {
+			auto &state = *state_ptr[state_format.sel->get_index(raw_idx)];
+			state.~State();
+		}
+	}
+
+	//------------------------------------------------------------------------------------------------------------------
+	// Documentation
+	//------------------------------------------------------------------------------------------------------------------
+	static constexpr auto DESCRIPTION = R"(
+	Aggregates a set of rows into a single layer of a Mapbox Vector Tile, returned as a BLOB
+
+	The rows are passed as a STRUCT, holding a GEOMETRY and the properties of the feature. The geometry is expected to be in tile space already, e.g. as returned by `ST_AsMVTGeom`. If `geom_name` is not given, the first GEOMETRY field is used as the geometry. All other fields are encoded as properties, NULL properties are omitted.
+
+	Properties can be of type VARCHAR, BOOLEAN, FLOAT, DOUBLE or any signed or unsigned integer type.
+
+	The optional `name` (default 'default') and `extent` (default 4096) parameters set the name and extent of the layer, and must be constant. Layers of the same tile can be concatenated (e.g. with `||`) to produce a tile with multiple layers.
+	)";
+
+	static constexpr auto EXAMPLE = R"(
+	-- Given a table of tiles with their bounds (a BOX_2D in the coordinate system of the roads),
+	-- generate all tiles at once
+	SELECT z, x, y, ST_AsMVT({'geom': ST_AsMVTGeom(roads.geom, tiles.bounds), 'name': roads.name}, 'roads')
+	FROM tiles JOIN roads ON ST_Intersects(roads.geom, tiles.bounds::GEOMETRY)
+	GROUP BY z, x, y;
+	)";
+
+	//------------------------------------------------------------------------------------------------------------------
+	// Register
+	//------------------------------------------------------------------------------------------------------------------
+	static void Register(DatabaseInstance &db) {
+		FunctionBuilder::RegisterAggregate(db, "ST_AsMVT", [&](AggregateFunctionBuilder &func) {
+			// ST_AsMVT(row [, name [, extent [, geom_name]]])
+			const vector<LogicalType> optional_params = {LogicalType::VARCHAR, LogicalType::INTEGER,
+			                                             LogicalType::VARCHAR};
+
+			vector<LogicalType> arguments = {LogicalType::ANY};
+			for (idx_t param_idx = 0; param_idx <= optional_params.size(); param_idx++) {
+				if (param_idx > 0) {
+					arguments.push_back(optional_params[param_idx - 1]);
+				}
+				const AggregateFunction agg(arguments, LogicalType::BLOB, StateSize, Initialize, Update, Combine,
+				                            Finalize, nullptr, Bind, Destroy);
+				func.SetFunction(agg);
+			}
+
+			func.SetDescription(DESCRIPTION);
+			func.SetExample(EXAMPLE);
+
+			func.SetTag("ext", "spatial");
+			func.SetTag("category", "conversion");
+		});
+	}
+};
+
+} // namespace
+
+//######################################################################################################################
+// Register
+//######################################################################################################################
+
+void RegisterMapboxVectorTileModule(DatabaseInstance &db) {
+	ST_AsMVTGeom::Register(db);
+	ST_AsMVT::Register(db);
+}
+
+} // namespace duckdb
@@ -0,0 +1,9 @@
+#pragma once
+
+namespace duckdb {
+
+class DatabaseInstance;
+
+void RegisterMapboxVectorTileModule(DatabaseInstance &db);
+
+} // namespace duckdb
@@ -1,16 +1,31 @@
 #include "spatial/modules/osm/osm_module.hpp"
+#include "spatial/modules/osm/osm_node_store.hpp"
 
+#include "duckdb/common/unordered_map.hpp"
+#include "duckdb/common/unordered_set.hpp"
 #include "duckdb/function/replacement_scan.hpp"
 #include "duckdb/main/database.hpp"
 #include "duckdb/main/extension_util.hpp"
 #include "duckdb/parser/expression/constant_expression.hpp"
 #include "duckdb/parser/expression/function_expression.hpp"
 #include "duckdb/parser/tableref/table_function_ref.hpp"
+#include "duckdb/planner/expression/bound_cast_expression.hpp"
+#include "duckdb/planner/expression/bound_columnref_expression.hpp"
+#include "duckdb/planner/expression/bound_comparison_expression.hpp"
+#include "duckdb/planner/expression/bound_constant_expression.hpp"
+#include "duckdb/planner/expression/bound_operator_expression.hpp"
+#include "duckdb/planner/operator/logical_get.hpp"
+#include "duckdb/storage/arena_allocator.hpp"
 #include "duckdb/storage/buffer_manager.hpp"
 #include "protozero/pbf_reader.hpp"
+#include "spatial/geometry/geometry_serialization.hpp"
+#include "spatial/geometry/sgl.hpp"
 #include "spatial/spatial_types.hpp"
 #include "zlib.h"
 
+#include <algorithm>
+#include <condition_variable>
+
 #include <spatial/util/function_builder.hpp>
 
 namespace duckdb {
@@ -30,9 +45,39 @@ static int32_t ReadInt32BigEndian(data_ptr_t ptr) {
 // OSM Table Function
 //------------------------------------------------------------------------------
 
+// The output columns, in the order they are returned from Bind
+enum : column_t {
+	KIND_COLUMN = 0,
+	ID_COLUMN = 1,
+	TAGS_COLUMN = 2,
+	REFS_COLUMN = 3,
+	LAT_COLUMN = 4,
+	LON_COLUMN = 5,
+	REF_ROLES_COLUMN = 6,
+	REF_TYPES_COLUMN = 7,
+	// Only returned when assembling geometries
+	GEOM_COLUMN = 8,
+	COLUMN_COUNT = 9
+};
+
+// The values of the "kind" enum column
+enum class OsmKind : uint8_t { NODE = 0, WAY = 1, RELATION = 2, CHANGESET = 3 };
+
+static constexpr uint8_t ALL_KINDS = 0x0F;
+
+static constexpr uint8_t KindBit(OsmKind kind) {
+	return static_cast<uint8_t>(1 << static_cast<uint8_t>(kind));
+}
+
 struct BindData final : TableFunctionData {
 	string file_name;
 
+	// The entity kinds that can pass the filters on the "kind" column, one bit per OsmKind
+	uint8_t kind_mask = ALL_KINDS;
+
+	// Whether to assemble the geometries of the entities into an additional "geom" column
+	bool assemble_geometry = false;
+
 	explicit BindData(string file_name) : file_name(std::move(file_name)) {
 	}
 };
@@ -87,6 +132,16 @@ static unique_ptr<FunctionData> Bind(ClientContext &context, TableFunctionBindIn
 	// Create bind data
 	auto file_name = StringValue::Get(input.inputs[0]);
 	auto result = make_uniq<BindData>(file_name);
+
+	auto assemble_param = input.named_parameters.find("assemble_geometry");
+	if (assemble_param != input.named_parameters.end()) {
+		result->assemble_geometry = BooleanValue::Get(assemble_param->second);
+	}
+	if (result->assemble_geometry) {
+		return_types.push_back(GeoTypes::GEOMETRY());
+		names.push_back("geom");
+	}
+
 	return std::move(result);
 }
 
@@ -147,39 +202,226 @@ static unique_ptr<FileBlock> DecompressBlob(ClientContext &context, OsmBlob &blo
 	return make_uniq<FileBlock>(blob.type, std::move(uncompressed_handle), blob_uncompressed_size, blob.blob_idx);
 };
 
+// The location of a blob in the file
+struct OsmBlobRange {
+	FileBlockType type;
+	idx_t offset;
+	idx_t size;
+	idx_t blob_idx;
+	// The kinds of entities to emit from the blob
+	uint8_t kinds;
+};
+
+// The state shared between the threads when assembling geometries
+struct OsmAssemblyState {
+	OsmNodeStore nodes;
+
+	mutex lock;
+	// The ways that are members of multipolygon relations, and their refs once the ways have been scanned
+	unordered_set<int64_t> member_way_ids;
+	unordered_map<int64_t, vector<int64_t>> member_way_refs;
+
+	explicit OsmAssemblyState(BufferManager &manager) : nodes(manager) {
+	}
+};
+
+// When assembling geometries the file is scanned in phases, each emitting a single kind of entity. The nodes (and the
+// members of multipolygon relations) are indexed in the first phase, so that the ways can be assembled in the second
+// phase. The ways that are members of multipolygon relations are indexed in the second phase, so that the relations
+// can be assembled in the third. Only the blobs that contain ways or relations are read again in the later phases.
+enum class ScanPhase : uint8_t { NODES, WAYS, RELATIONS, DONE };
+
 class GlobalState final : public GlobalTableFunctionState {
 	mutex lock;
 	unique_ptr<FileHandle> handle;
+	string file_name;
 	idx_t file_size;
 	idx_t offset;
 	bool done;
 	idx_t blob_index;
 	atomic<idx_t> bytes_read;
+	atomic<idx_t> bytes_total;
 	idx_t max_threads;
 
+	// Only set when assembling geometries
+	unique_ptr<OsmAssemblyState> assembly;
+	uint8_t kind_mask;
+	ScanPhase phase;
+	idx_t pending_blobs;
+	bool failed;
+	std::condition_variable phase_done;
+	vector<OsmBlobRange> way_blobs;
+	vector<OsmBlobRange> relation_blobs;
+	idx_t phase_blob_index;
+	idx_t phase_batch_offset;
+
 public:
-	GlobalState(unique_ptr<FileHandle> handle, idx_t file_size, idx_t max_threads)
-	    : handle(std::move(handle)), file_size(file_size), offset(0), done(false), blob_index(0), bytes_read(0),
-	      max_threads(max_threads) {
+	GlobalState(unique_ptr<FileHandle> handle, string file_name, idx_t file_size, idx_t max_threads)
+	    : handle(std::move(handle)), file_name(std::move(file_name)), file_size(file_size), offset(0), done(false),
+	      blob_index(0), bytes_read(0), bytes_total(file_size), max_threads(max_threads), kind_mask(ALL_KINDS),
+	      phase(ScanPhase::NODES), pending_blobs(0), failed(false), phase_blob_index(0), phase_batch_offset(0) {
 	}
 
 	double GetProgress() const {
-		return 100 * ((double)bytes_read / (double)file_size);
+		return 100 * ((double)bytes_read / (double)bytes_total);
 	}
 
 	idx_t MaxThreads() const override {
 		return max_threads;
 	}
 
-	unique_ptr<OsmBlob> GetNextBlob(ClientContext &context) {
+	void EnableAssembly(BufferManager &manager, uint8_t kind_mask_p) {
+		assembly = make_uniq<OsmAssemblyState>(manager);
+		kind_mask = kind_mask_p;
+	}
+
+	OsmAssemblyState *GetAssemblyState() const {
+		return assembly.get();
+	}
+
+	// Each thread reads the blobs through its own file handle, so that the reads can happen in parallel
+	unique_ptr<FileHandle> OpenFile(ClientContext &context) const {
+		auto &fs = FileSystem::GetFileSystem(context);
+		return fs.OpenFile(file_name, FileFlags::FILE_FLAGS_READ | FileLockType::READ_LOCK);
+	}
+
+	void ReadFileHeader(ClientContext &context) {
+		OsmBlobRange range;
+		{
+			lock_guard<mutex> glock(lock);
+			if (!ReadNextBlobRange(context, range)) {
+				throw ParserException("File is empty");
+			}
+		}
+		if (range.type != FileBlockType::Header) {
+			throw ParserException("First blob in file is not a header");
+		}
+		ReadBlob(context, *handle, range);
+	}
+
+	// Find the next blob to scan. When assembling geometries, this blocks until all the blobs of the current phase
+	// have been indexed before moving on to the next phase.
+	bool GetNextBlobRange(ClientContext &context, OsmBlobRange &result) {
+		unique_lock<mutex> glock(lock);
+
+		if (!assembly) {
+			return ReadNextBlobRange(context, result);
+		}
+
+		while (!failed) {
+			switch (phase) {
+			case ScanPhase::NODES:
+				if (ReadNextBlobRange(context, result)) {
+					result.kinds = KindBit(OsmKind::NODE);
+					pending_blobs++;
+					return true;
+				}
+				break;
+			case ScanPhase::WAYS:
+			case ScanPhase::RELATIONS: {
+				auto &blobs = phase == ScanPhase::WAYS ? way_blobs : relation_blobs;
+				if (phase_blob_index < blobs.size()) {
+					result = blobs[phase_blob_index++];
+					result.kinds = phase == ScanPhase::WAYS ? KindBit(OsmKind::WAY) : KindBit(OsmKind::RELATION);
+					// Keep the batch indices increasing across phases
+					result.blob_idx += phase_batch_offset;
+					pending_blobs++;
+					return true;
+				}
+			} break;
+			case ScanPhase::DONE:
+			default:
+				return false;
+			}
+
+			// Wait for the other threads to finish indexing their blobs, then (if no one else did) move on
+			const auto current_phase = phase;
+			phase_done.wait(glock, [&] { return pending_blobs == 0 || phase != current_phase || failed; });
+			if (phase == current_phase && !failed) {
+				NextPhase();
+			}
+		}
+		return false;
+	}
+
+	// Must be called once a blob returned by GetNextBlobRange has been indexed, with the kinds of entities it contains
+	void FinishBlobRange(const OsmBlobRange &range, uint8_t contained_kinds, bool error) {
+		if (!assembly) {
+			return;
+		}
 		lock_guard<mutex> glock(lock);
+		if (error) {
+			failed = true;
+		}
+		if (phase == ScanPhase::NODES) {
+			if (contained_kinds & KindBit(OsmKind::WAY)) {
+				way_blobs.push_back(range);
+			}
+			if (contained_kinds & KindBit(OsmKind::RELATION)) {
+				relation_blobs.push_back(range);
+			}
+		}
+		if (--pending_blobs == 0 || failed) {
+			phase_done.notify_all();
+		}
+	}
+
+	unique_ptr<OsmBlob> ReadBlob(ClientContext &context, FileHandle &blob_handle, const OsmBlobRange &range) {
+		auto &buffer_manager = BufferManager::GetBufferManager(context);
+		auto blob_buffer = buffer_manager.GetBufferAllocator().Allocate(range.size);
+		blob_handle.Read(blob_buffer.get(), range.size, range.offset);
+		bytes_read += range.size;
+
+		return make_uniq<OsmBlob>(range.type, std::move(blob_buffer), range.size, range.blob_idx);
+	}
 
+private:
+	void NextPhase() {
+		const auto needs_ways = (kind_mask & (KindBit(OsmKind::WAY) | KindBit(OsmKind::RELATION))) != 0;
+		const auto needs_relations = (kind_mask & KindBit(OsmKind::RELATION)) != 0;
+
+		phase_blob_index = 0;
+		phase_batch_offset += blob_index;
+
+		if (phase == ScanPhase::NODES) {
+			assembly->nodes.Finalize();
+
+			// The blobs were indexed in parallel, so restore the file order
+			const auto by_index = [](const OsmBlobRange &a, const OsmBlobRange &b) {
+				return a.blob_idx < b.blob_idx;
+			};
+			std::sort(way_blobs.begin(), way_blobs.end(), by_index);
+			std::sort(relation_blobs.begin(), relation_blobs.end(), by_index);
+
+			if (!needs_ways) {
+				way_blobs.clear();
+			}
+			if (!needs_relations) {
+				relation_blobs.clear();
+			}
+			for (auto &blob : way_blobs) {
+				bytes_total += blob.size;
+			}
+			for (auto &blob : relation_blobs) {
+				bytes_total += blob.size;
+			}
+			phase = ScanPhase::WAYS;
+		} else if (phase == ScanPhase::WAYS) {
+			phase = ScanPhase::RELATIONS;
+		} else {
+			phase = ScanPhase::DONE;
+		}
+	}
+
+	// Find the next blob in the file. Only the (small) BlobHeader is read while holding the lock, the Blob itself is
+	// read afterwards by the calling thread.
+	bool ReadNextBlobRange(ClientContext &context, OsmBlobRange &result) {
 		if (done) {
-			return nullptr;
+			return false;
 		}
 		if (offset >= file_size) {
 			done = true;
-			return nullptr;
+			return false;
 		}
 
 		auto &buffer_manager = BufferManager::GetBufferManager(context);
@@ -204,11 +446,10 @@ public:
 		// 1 - type of the blob
 		reader.next(1);
 		auto type_str = reader.get_string();
-		FileBlockType type;
 		if (type_str == "OSMHeader") {
-			type = FileBlockType::Header;
+			result.type = FileBlockType::Header;
 		} else if (type_str == "OSMData") {
-			type = FileBlockType::Data;
+			result.type = FileBlockType::Data;
 		} else {
 			throw ParserException("Unexpected fileblock type in Blob");
 		}
@@ -217,15 +458,16 @@ public:
 		auto blob_length = reader.get_int32(); // size of the next blob
 
 		offset += header_length;
+		bytes_read += sizeof(int32_t) + header_length;
 
-		// Read the Blob
-		auto blob_buffer = buffer_manager.GetBufferAllocator().Allocate(blob_length);
-		handle->Read(blob_buffer.get(), blob_length, offset);
+		// Skip past the Blob, it is read by the caller
+		result.offset = offset;
+		result.size = blob_length;
+		result.blob_idx = blob_index++;
+		result.kinds = ALL_KINDS;
 
 		offset += blob_length;
-		bytes_read = offset;
-
-		return make_uniq<OsmBlob>(type, std::move(blob_buffer), blob_length, blob_index++);
+		return true;
 	}
 };
 
@@ -240,26 +482,53 @@ static unique_ptr<GlobalTableFunctionState> InitGlobal(ClientContext &context, T
 
 	auto max_threads = context.db->NumberOfThreads();
 
-	auto global_state = make_uniq<GlobalState>(std::move(handle), file_size, max_threads);
+	auto global_state = make_uniq<GlobalState>(std::move(handle), file_name, file_size, max_threads);
 
-	// Read the first blob to get the header
-	auto blob = global_state->GetNextBlob(context);
-	if (blob->type != FileBlockType::Header) {
-		throw ParserException("First blob in file is not a header");
+	// Only assemble geometries if they are actually projected
+	const auto &column_ids = input.column_ids;
+	if (bind_data.assemble_geometry &&
+	    std::find(column_ids.begin(), column_ids.end(), GEOM_COLUMN) != column_ids.end()) {
+		global_state->EnableAssembly(BufferManager::GetBufferManager(context), bind_data.kind_mask);
 	}
 
+	// Read the first blob to get the header
+	global_state->ReadFileHeader(context);
+
 	return std::move(global_state);
 }
 
 struct LocalState final : LocalTableFunctionState {
+	unique_ptr<FileHandle> handle;
 	unique_ptr<FileBlock> block;
 	vector<string> string_table;
 	int32_t granularity;
 	int64_t lat_offset;
 	int64_t lon_offset;
 
-	explicit LocalState(unique_ptr<FileBlock> block) : block(std::move(block)) {
-		Reset();
+	// The projected columns, and the output vectors they are written to (or nullptr if they are not projected)
+	vector<column_t> column_ids;
+	Vector *columns[COLUMN_COUNT] = {};
+
+	// The entity kinds that can pass the filters on the "kind" column
+	uint8_t kind_mask;
+	// The entity kinds to emit from the current block
+	uint8_t scan_mask;
+
+	// Only set when assembling geometries
+	OsmAssemblyState *assembly;
+	OsmNodeStoreAppendState node_append_state;
+	OsmNodeStoreLookupState node_lookup_state;
+	vector<OsmNodeLocation> node_buffer;
+	vector<int64_t> way_refs;
+
+	ArenaAllocator arena;
+	SerdeFormat format;
+
+	LocalState(ClientContext &context, unique_ptr<FileHandle> handle, vector<column_t> column_ids_p,
+	           uint8_t kind_mask, OsmAssemblyState *assembly)
+	    : handle(std::move(handle)), column_ids(std::move(column_ids_p)), kind_mask(kind_mask),
+	      scan_mask(kind_mask), assembly(assembly), arena(BufferAllocator::Get(context)),
+	      format(SerdeFormat::Get(context)) {
 	}
 
 	void SetBlock(unique_ptr<FileBlock> block) {
@@ -267,6 +536,44 @@ struct LocalState final : LocalTableFunctionState {
 		Reset();
 	}
 
+	// Move on to the next block, returns false if there are no blocks left
+	bool Next(ClientContext &context, GlobalState &global) {
+		OsmBlobRange range;
+		if (!global.GetNextBlobRange(context, range)) {
+			return false;
+		}
+
+		uint8_t contained_kinds = 0;
+		try {
+			const auto blob = global.ReadBlob(context, *handle, range);
+			SetBlock(DecompressBlob(context, *blob));
+			if (assembly) {
+				contained_kinds = IndexBlock(range.kinds);
+			}
+		} catch (...) {
+			// Dont leave the other threads waiting for this blob to be indexed
+			global.FinishBlobRange(range, contained_kinds, true);
+			throw;
+		}
+		global.FinishBlobRange(range, contained_kinds, false);
+
+		scan_mask = kind_mask & range.kinds;
+		return true;
+	}
+
+	void SetOutput(DataChunk &output) {
+		arena.Reset();
+		for (auto &column : columns) {
+			column = nullptr;
+		}
+		for (idx_t col_idx = 0; col_idx < column_ids.size(); col_idx++) {
+			const auto column_id = column_ids[col_idx];
+			if (column_id < COLUMN_COUNT) {
+				columns[column_id] = &output.data[col_idx];
+			}
+		}
+	}
+
 	void Reset() {
 		string_table.clear();
 		granularity = 100;
@@ -320,6 +627,11 @@ struct LocalState final : LocalTableFunctionState {
 			case ParseState::Block:
 				if (block_reader.next(2)) {
 					group_reader = block_reader.get_message();
+					// A group only contains entities of a single kind, so skip the whole group if it is filtered out
+					auto group_copy = group_reader;
+					if (!group_copy.next() || IsKindFiltered(group_copy.tag())) {
+						break;
+					}
 					state = ParseState::Group;
 				} else {
 					state = ParseState::End;
@@ -327,6 +639,10 @@ struct LocalState final : LocalTableFunctionState {
 				break;
 			case ParseState::Group:
 				if (group_reader.next()) {
+					if (IsKindFiltered(group_reader.tag())) {
+						group_reader.skip();
+						break;
+					}
 					switch (group_reader.tag()) {
 						// Nodes
 					case 1: {
@@ -372,19 +688,588 @@ struct LocalState final : LocalTableFunctionState {
 		return false;
 	}
 
+	// Whether the entities stored under a PrimitiveGroup field tag are not emitted from the current block
+	bool IsKindFiltered(pz::pbf_tag_type group_tag) const {
+		switch (group_tag) {
+		case 1: // Nodes
+		case 2: // Dense nodes
+			return (scan_mask & KindBit(OsmKind::NODE)) == 0;
+		case 3: // Ways
+			return (scan_mask & KindBit(OsmKind::WAY)) == 0;
+		case 4: // Relations
+			return (scan_mask & KindBit(OsmKind::RELATION)) == 0;
+		case 5: // Changesets
+			return (scan_mask & KindBit(OsmKind::CHANGESET)) == 0;
+		default:
+			return false;
+		}
+	}
+
+	//------------------------------------------------------------------------------
+	// Indexing
+	//------------------------------------------------------------------------------
+
+	// Convert a coordinate in nanodegrees to the fixed point representation used by the node store
+	static int32_t ToFixedPoint(int64_t nanodegrees) {
+		return static_cast<int32_t>(nanodegrees / 100);
+	}
+
+	// Index the current block for the phase it is scanned in (given by the kinds emitted in that phase) and return the
+	// kinds of entities the block contains. This reads the whole block up front, so that the next phase can start as
+	// soon as every block has been returned from Next(), without having to wait for the rows to be emitted.
+	uint8_t IndexBlock(uint8_t phase_kinds) {
+		const auto index_nodes = (phase_kinds & KindBit(OsmKind::NODE)) &&
+		                         (kind_mask & (KindBit(OsmKind::WAY) | KindBit(OsmKind::RELATION)));
+		const auto index_members = (kind_mask & KindBit(OsmKind::RELATION)) != 0;
+		const auto index_relations = (phase_kinds & KindBit(OsmKind::NODE)) && index_members;
+		const auto index_ways = (phase_kinds & KindBit(OsmKind::WAY)) && index_members;
+
+		// The kinds contained in the blocks are only needed in the first phase
+		if (!(phase_kinds & KindBit(OsmKind::NODE)) && !index_ways) {
+			return 0;
+		}
+
+		uint8_t contained_kinds = 0;
+		node_buffer.clear();
+		vector<int64_t> member_ways;
+		vector<pair<int64_t, vector<int64_t>>> way_refs;
+
+		auto reader = block_reader;
+		while (reader.next(2)) {
+			auto group = reader.get_message();
+			while (group.next()) {
+				switch (group.tag()) {
+				case 1: { // Node
+					contained_kinds |= KindBit(OsmKind::NODE);
+					if (index_nodes) {
+						IndexNode(group.get_message());
+					} else {
+						group.skip();
+					}
+				} break;
+				case 2: { // Dense nodes
+					contained_kinds |= KindBit(OsmKind::NODE);
+					if (index_nodes) {
+						IndexDenseNodes(group.get_message());
+					} else {
+						group.skip();
+					}
+				} break;
+				case 3: { // Way
+					contained_kinds |= KindBit(OsmKind::WAY);
+					if (index_ways) {
+						IndexWay(group.get_message(), way_refs);
+					} else {
+						group.skip();
+					}
+				} break;
+				case 4: { // Relation
+					contained_kinds |= KindBit(OsmKind::RELATION);
+					if (index_relations) {
+						IndexRelation(group.get_message(), member_ways);
+					} else {
+						group.skip();
+					}
+				} break;
+				default:
+					group.skip();
+				}
+			}
+		}
+
+		if (!node_buffer.empty()) {
+			const auto by_id = [](const OsmNodeLocation &a, const OsmNodeLocation &b) {
+				return a.id < b.id;
+			};
+			if (!std::is_sorted(node_buffer.begin(), node_buffer.end(), by_id)) {
+				std::sort(node_buffer.begin(), node_buffer.end(), by_id);
+			}
+			assembly->nodes.Append(node_append_state, node_buffer.data(), node_buffer.data() + node_buffer.size());
+		}
+		if (!member_ways.empty()) {
+			lock_guard<mutex> guard(assembly->lock);
+			assembly->member_way_ids.insert(member_ways.begin(), member_ways.end());
+		}
+		if (!way_refs.empty()) {
+			lock_guard<mutex> guard(assembly->lock);
+			for (auto &entry : way_refs) {
+				assembly->member_way_refs[entry.first] = std::move(entry.second);
+			}
+		}
+
+		return contained_kinds;
+	}
+
+	void IndexNode(pz::pbf_reader node) {
+		OsmNodeLocation location = {0, 0, 0};
+		while (node.next()) {
+			switch (node.tag()) {
+			case 1: // ID
+				location.id = node.get_int64();
+				break;
+			case 8: // Lat
+				location.lat = ToFixedPoint(lat_offset + (granularity * node.get_sint64()));
+				break;
+			case 9: // Lon
+				location.lon = ToFixedPoint(lon_offset + (granularity * node.get_sint64()));
+				break;
+			default:
+				node.skip();
+			}
+		}
+		node_buffer.push_back(location);
+	}
+
+	void IndexDenseNodes(pz::pbf_reader dense_nodes) {
+		// All fields are delta encoded
+		const auto start = node_buffer.size();
+		idx_t lat_idx = start;
+		idx_t lon_idx = start;
+		int64_t last_id = 0;
+		int64_t last_lat = 0;
+		int64_t last_lon = 0;
+
+		while (dense_nodes.next()) {
+			switch (dense_nodes.tag()) {
+			case 1: { // ID
+				for (auto id : dense_nodes.get_packed_sint64()) {
+					last_id += id;
+					node_buffer.push_back(OsmNodeLocation {last_id, 0, 0});
+				}
+			} break;
+			case 8: { // Lats
+				for (auto lat : dense_nodes.get_packed_sint64()) {
+					last_lat += lat;
+					if (lat_idx < node_buffer.size()) {
+						node_buffer[lat_idx++].lat = ToFixedPoint(lat_offset + (granularity * last_lat));
+					}
+				}
+			} break;
+			case 9: { // Lons
+				for (auto lon : dense_nodes.get_packed_sint64()) {
+					last_lon += lon;
+					if (lon_idx < node_buffer.size()) {
+						node_buffer[lon_idx++].lon = ToFixedPoint(lon_offset + (granularity * last_lon));
+					}
+				}
+			} break;
+			default:
+				dense_nodes.skip();
+			}
+		}
+	}
+
+	void IndexWay(pz::pbf_reader way, vector<pair<int64_t, vector<int64_t>>> &result) {
+		int64_t id = 0;
+		pz::iterator_range<pz::const_svarint_iterator<int64_t>> ref_iter;
+		while (way.next()) {
+			switch (way.tag()) {
+			case 1: // ID
+				id = way.get_int64();
+				break;
+			case 8: // Refs
+				ref_iter = way.get_packed_sint64();
+				break;
+			default:
+				way.skip();
+			}
+		}
+
+		// The member ids are only written in the first phase, so they can be read without locking
+		if (assembly->member_way_ids.find(id) == assembly->member_way_ids.end()) {
+			return;
+		}
+		vector<int64_t> refs;
+		DecodeRefs(ref_iter, refs);
+		result.emplace_back(id, std::move(refs));
+	}
+
+	void IndexRelation(pz::pbf_reader relation, vector<int64_t> &result) {
+		pz::iterator_range<pz::const_varint_iterator<uint32_t>> key_iter;
+		pz::iterator_range<pz::const_varint_iterator<uint32_t>> val_iter;
+		pz::iterator_range<pz::const_svarint_iterator<int64_t>> ref_iter;
+		pz::iterator_range<pz::const_varint_iterator<int32_t>> type_iter;
+		while (relation.next()) {
+			switch (relation.tag()) {
+			case 2: // Tag Keys
+				key_iter = relation.get_packed_uint32();
+				break;
+			case 3: // Tag Vals
+				val_iter = relation.get_packed_uint32();
+				break;
+			case 9: // Refs
+				ref_iter = relation.get_packed_sint64();
+				break;
+			case 10: // Types
+				type_iter = relation.get_packed_int32();
+				break;
+			default:
+				relation.skip();
+			}
+		}
+
+		if (!IsMultiPolygon(key_iter, val_iter) || ref_iter.size() != type_iter.size()) {
+			return;
+		}
+
+		int64_t last_ref = 0;
+		auto types = type_iter.begin();
+		for (auto ref : ref_iter) {
+			last_ref += ref;
+			if (*types++ == 1) { // Way
+				result.push_back(last_ref);
+			}
+		}
+	}
+
+	static void DecodeRefs(pz::iterator_range<pz::const_svarint_iterator<int64_t>> ref_iter, vector<int64_t> &result) {
+		result.clear();
+		// Refs are delta encoded
+		int64_t last_ref = 0;
+		for (auto ref : ref_iter) {
+			last_ref += ref;
+			result.push_back(last_ref);
+		}
+	}
+
+	//------------------------------------------------------------------------------
+	// Geometry Assembly
+	//------------------------------------------------------------------------------
+
+	// Relations tagged type=multipolygon or type=boundary are assembled into MULTIPOLYGONs
+	bool IsMultiPolygon(pz::iterator_range<pz::const_varint_iterator<uint32_t>> key_iter,
+	                    pz::iterator_range<pz::const_varint_iterator<uint32_t>> val_iter) const {
+		auto vals = val_iter.begin();
+		for (auto key : key_iter) {
+			if (vals == val_iter.end()) {
+				break;
+			}
+			const auto &val_str = string_table[*vals++];
+			if (string_table[key] == "type") {
+				return val_str == "multipolygon" || val_str == "boundary";
+			}
+		}
+		return false;
+	}
+
+	// Closed ways are assembled into POLYGONs if they are tagged area=yes, or have one of the keys that usually describe
+	// an area (and are not tagged area=no). Other ways are assembled into LINESTRINGs.
+	bool IsArea(pz::iterator_range<pz::const_varint_iterator<uint32_t>> key_iter,
+	            pz::iterator_range<pz::const_varint_iterator<uint32_t>> val_iter) const {
+		bool has_area_key = false;
+		auto vals = val_iter.begin();
+		for (auto key : key_iter) {
+			if (vals == val_iter.end()) {
+				break;
+			}
+			const auto &key_str = string_table[key];
+			const auto &val_str = string_table[*vals++];
+			if (key_str == "area") {
+				return val_str != "no";
+			}
+			if (key_str == "natural") {
+				// Most natural features are areas, except for these
+				has_area_key |= val_str != "coastline" && val_str != "cliff" && val_str != "ridge" &&
+				                val_str != "arete" && val_str != "tree_row";
+			} else {
+				has_area_key |= key_str == "building" || key_str == "building:part" || key_str == "landuse" ||
+				                key_str == "leisure" || key_str == "amenity" || key_str == "place" ||
+				                key_str == "shop" || key_str == "tourism" || key_str == "water";
+			}
+		}
+		return has_area_key;
+	}
+
+	void WriteGeometry(const sgl::geometry &geom, idx_t index) {
+		auto &geom_vector = *columns[GEOM_COLUMN];
+		const auto size = Serde::GetRequiredSize(geom, format);
+		auto blob = StringVector::EmptyString(geom_vector, size);
+		Serde::Serialize(geom, format, blob.GetDataWriteable(), size);
+		blob.Finalize();
+		FlatVector::GetData<string_t>(geom_vector)[index] = blob;
+	}
+
+	void WritePoint(double lon, double lat, idx_t index) {
+		if (!columns[GEOM_COLUMN]) {
+			return;
+		}
+		const auto vertex_mem = arena.AllocateAligned(sizeof(double) * 2);
+		const auto vertex_ptr = reinterpret_cast<double *>(vertex_mem);
+		vertex_ptr[0] = lon;
+		vertex_ptr[1] = lat;
+
+		sgl::geometry point(sgl::geometry_type::POINT);
+		point.set_vertex_data(vertex_mem, 1);
+		WriteGeometry(point, index);
+	}
+
+	// Create a LINESTRING (or ring) from the locations of the given nodes.
+	// Returns nullptr if any of the nodes can not be found, e.g. because they are outside of the extract.
+	sgl::geometry *TryResolveNodes(const vector<int64_t> &refs) {
+		const auto vertex_mem = arena.AllocateAligned(sizeof(double) * 2 * refs.size());
+		const auto vertex_ptr = reinterpret_cast<double *>(vertex_mem);
+		for (idx_t i = 0; i < refs.size(); i++) {
+			OsmNodeLocation location;
+			if (!assembly->nodes.TryGetLocation(node_lookup_state, refs[i], location)) {
+				return nullptr;
+			}
+			vertex_ptr[i * 2] = location.lon / 10000000.0;
+			vertex_ptr[i * 2 + 1] = location.lat / 10000000.0;
+		}
+		const auto line_mem = arena.AllocateAligned(sizeof(sgl::geometry));
+		const auto line_ptr = new (line_mem) sgl::geometry(sgl::geometry_type::LINESTRING);
+		line_ptr->set_vertex_data(vertex_mem, refs.size());
+		return line_ptr;
+	}
+
+	void WriteWayGeometry(const vector<int64_t> &refs, bool is_area, idx_t index) {
+		if (refs.size() < 2) {
+			FlatVector::SetNull(*columns[GEOM_COLUMN], index, true);
+			return;
+		}
+		const auto line = TryResolveNodes(refs);
+		if (!line) {
+			FlatVector::SetNull(*columns[GEOM_COLUMN], index, true);
+			return;
+		}
+		if (is_area && refs.size() >= 4 && refs.front() == refs.back()) {
+			sgl::geometry polygon(sgl::geometry_type::POLYGON);
+			polygon.append_part(line);
+			WriteGeometry(polygon, index);
+		} else {
+			WriteGeometry(*line, index);
+		}
+	}
+
+	// Join the member ways of a multipolygon into closed rings by matching their end nodes.
+	// Returns false if the ways do not form closed rings.
+	static bool TryAssembleRings(const vector<const vector<int64_t> *> &ways, vector<vector<int64_t>> &rings) {
+		vector<bool> used(ways.size(), false);
+		for (idx_t i = 0; i < ways.size(); i++) {
+			if (used[i]) {
+				continue;
+			}
+			used[i] = true;
+			auto ring = *ways[i];
+			if (ring.empty()) {
+				return false;
+			}
+
+			// Keep appending ways that continue at the end of the ring until it is closed
+			while (ring.size() < 2 || ring.front() != ring.back()) {
+				bool found = false;
+				for (idx_t j = 0; j < ways.size() && !found; j++) {
+					const auto &way = *ways[j];
+					if (used[j] || way.empty()) {
+						continue;
+					}
+					if (way.front() == ring.back()) {
+						ring.insert(ring.end(), way.begin() + 1, way.end());
+						used[j] = found = true;
+					} else if (way.back() == ring.back()) {
+						ring.insert(ring.end(), way.rbegin() + 1, way.rend());
+						used[j] = found = true;
+					}
+				}
+				if (!found) {
+					return false;
+				}
+			}
+			if (ring.size() < 4) {
+				return false;
+			}
+			rings.push_back(std::move(ring));
+		}
+		return true;
+	}
+
+	void WriteRelationGeometry(pz::iterator_range<pz::const_varint_iterator<uint32_t>> key_iter,
+	                           pz::iterator_range<pz::const_varint_iterator<uint32_t>> val_iter,
+	                           pz::iterator_range<pz::const_varint_iterator<int32_t>> role_iter,
+	                           pz::iterator_range<pz::const_svarint_iterator<int64_t>> ref_iter,
+	                           pz::iterator_range<pz::const_varint_iterator<int32_t>> type_iter, idx_t index) {
+		auto &geom_vector = *columns[GEOM_COLUMN];
+		if (!IsMultiPolygon(key_iter, val_iter) || ref_iter.size() != type_iter.size() ||
+		    ref_iter.size() != role_iter.size()) {
+			FlatVector::SetNull(geom_vector, index, true);
+			return;
+		}
+
+		// Collect the member ways, which have been indexed in the previous phase and are no longer modified
+		vector<const vector<int64_t> *> outer_ways;
+		vector<const vector<int64_t> *> inner_ways;
+		int64_t last_ref = 0;
+		auto roles = role_iter.begin();
+		auto types = type_iter.begin();
+		for (auto ref : ref_iter) {
+			last_ref += ref;
+			const auto &role = string_table[*roles++];
+			if (*types++ != 1) {
+				// Not a way
+				continue;
+			}
+			const auto is_inner = role == "inner";
+			if (!is_inner && role != "outer" && !role.empty()) {
+				continue;
+			}
+			const auto entry = assembly->member_way_refs.find(last_ref);
+			if (entry == assembly->member_way_refs.end()) {
+				// The way is missing, e.g. because it is outside of the extract
+				FlatVector::SetNull(geom_vector, index, true);
+				return;
+			}
+			(is_inner ? inner_ways : outer_ways).push_back(&entry->second);
+		}
+
+		vector<vector<int64_t>> outer_rings;
+		vector<vector<int64_t>> inner_rings;
+		if (!TryAssembleRings(outer_ways, outer_rings) || !TryAssembleRings(inner_ways, inner_rings) ||
+		    outer_rings.empty()) {
+			FlatVector::SetNull(geom_vector, index, true);
+			return;
+		}
+
+		// Create a polygon for every outer ring
+		vector<sgl::geometry *> polygons;
+		for (auto &ring : outer_rings) {
+			const auto ring_ptr = TryResolveNodes(ring);
+			if (!ring_ptr) {
+				FlatVector::SetNull(geom_vector, index, true);
+				return;
+			}
+			const auto poly_mem = arena.AllocateAligned(sizeof(sgl::geometry));
+			const auto poly_ptr = new (poly_mem) sgl::geometry(sgl::geometry_type::POLYGON);
+			poly_ptr->append_part(ring_ptr);
+			polygons.push_back(poly_ptr);
+		}
+
+		// Find the polygon each inner ring belongs to, before adding any holes to them.
+		// Inner rings that are not within any outer ring are dropped.
+		vector<pair<sgl::geometry *, sgl::geometry *>> holes;
+		for (auto &ring : inner_rings) {
+			const auto ring_ptr = TryResolveNodes(ring);
+			if (!ring_ptr) {
+				FlatVector::SetNull(geom_vector, index, true);
+				return;
+			}
+			const auto vertex = reinterpret_cast<const double *>(ring_ptr->get_vertex_data());
+			const sgl::vertex_xy point = {vertex[0], vertex[1]};
+			for (auto polygon : polygons) {
+				sgl::ops::point_location location;
+				if (sgl::ops::try_locate_point(polygon, &point, &location) &&
+				    location != sgl::ops::point_location::EXTERIOR) {
+					holes.emplace_back(polygon, ring_ptr);
+					break;
+				}
+			}
+		}
+		for (auto &hole : holes) {
+			hole.first->append_part(hole.second);
+		}
+
+		sgl::geometry multi_polygon(sgl::geometry_type::MULTI_POLYGON);
+		for (auto polygon : polygons) {
+			multi_polygon.append_part(polygon);
+		}
+		WriteGeometry(multi_polygon, index);
+	}
+
+	//------------------------------------------------------------------------------
+	// Scanning
+	//------------------------------------------------------------------------------
+
+	void SetNull(idx_t column, idx_t index) {
+		if (columns[column]) {
+			FlatVector::SetNull(*columns[column], index, true);
+		}
+	}
+
+	void WriteKindAndId(OsmKind kind, int64_t id, idx_t index) {
+		if (columns[KIND_COLUMN]) {
+			FlatVector::GetData<uint8_t>(*columns[KIND_COLUMN])[index] = static_cast<uint8_t>(kind);
+		}
+		if (columns[ID_COLUMN]) {
+			FlatVector::GetData<int64_t>(*columns[ID_COLUMN])[index] = id;
+		}
+	}
+
+	void WriteTags(pz::iterator_range<pz::const_varint_iterator<uint32_t>> key_iter,
+	               pz::iterator_range<pz::const_varint_iterator<uint32_t>> val_iter, idx_t index) {
+		if (!columns[TAGS_COLUMN]) {
+			return;
+		}
+		auto &tags_vector = *columns[TAGS_COLUMN];
+
+		if (key_iter.empty() || val_iter.empty()) {
+			FlatVector::SetNull(tags_vector, index, true);
+			return;
+		}
+
+		auto tag_count = key_iter.size();
+		auto total_tags = ListVector::GetListSize(tags_vector);
+		ListVector::Reserve(tags_vector, total_tags + tag_count);
+		ListVector::SetListSize(tags_vector, total_tags + tag_count);
+		auto &tag_entry = ListVector::GetData(tags_vector)[index];
+
+		tag_entry.offset = total_tags;
+		tag_entry.length = tag_count;
+
+		auto &key_vector = MapVector::GetKeys(tags_vector);
+		auto &value_vector = MapVector::GetValues(tags_vector);
+
+		auto keys = key_iter.begin();
+		auto vals = val_iter.begin();
+		for (idx_t i = tag_entry.offset; i < tag_entry.offset + tag_count; i++) {
+			FlatVector::GetData<string_t>(key_vector)[i] = StringVector::AddString(key_vector, string_table[*keys++]);
+			FlatVector::GetData<string_t>(value_vector)[i] =
+			    StringVector::AddString(value_vector, string_table[*vals++]);
+		}
+	}
+
+	void WriteRefs(pz::iterator_range<pz::const_svarint_iterator<int64_t>> ref_iter, idx_t index) {
+		if (!columns[REFS_COLUMN]) {
+			return;
+		}
+		auto &refs_vector = *columns[REFS_COLUMN];
+
+		if (ref_iter.empty()) {
+			FlatVector::SetNull(refs_vector, index, true);
+			return;
+		}
+
+		auto ref_count = ref_iter.size();
+		auto total_refs = ListVector::GetListSize(refs_vector);
+		ListVector::Reserve(refs_vector, total_refs + ref_count);
+		ListVector::SetListSize(refs_vector, total_refs + ref_count);
+		auto &ref_entry = ListVector::GetData(refs_vector)[index];
+		auto &ref_vector = ListVector::GetEntry(refs_vector);
+		ref_entry.offset = total_refs;
+		ref_entry.length = ref_count;
+
+		auto ref_data = FlatVector::GetData<int64_t>(ref_vector);
+
+		// Refs are delta encoded
+		int64_t last_ref = 0;
+		for (auto ref : ref_iter) {
+			last_ref += ref;
+			ref_data[total_refs++] = last_ref;
+		}
+	}
+
 	void ScanNode(DataChunk &output, idx_t &index, idx_t capacity) {
 
 		auto node = group_reader.get_message();
 
 		pz::iterator_range<pz::const_varint_iterator<uint32_t>> key_iter;
 		pz::iterator_range<pz::const_varint_iterator<uint32_t>> val_iter;
+		double lat = 0;
+		double lon = 0;
 
 		while (node.next()) {
 			switch (node.tag()) {
 			case 1: { // ID
 				auto id = node.get_int64();
-				FlatVector::GetData<uint8_t>(output.data[0])[index] = 0;
-				FlatVector::GetData<int64_t>(output.data[1])[index] = id;
+				WriteKindAndId(OsmKind::NODE, id, index);
 			} break;
 			case 2: { // Tag Keys
 				key_iter = node.get_packed_uint32();
@@ -393,12 +1278,16 @@ struct LocalState final : LocalTableFunctionState {
 				val_iter = node.get_packed_uint32();
 			} break;
 			case 8: { // Lat
-				auto lat = node.get_sint64();
-				FlatVector::GetData<double>(output.data[4])[index] = 0.000000001 * (lat_offset + (granularity * lat));
+				lat = 0.000000001 * (lat_offset + (granularity * node.get_sint64()));
+				if (columns[LAT_COLUMN]) {
+					FlatVector::GetData<double>(*columns[LAT_COLUMN])[index] = lat;
+				}
 			} break;
 			case 9: { // Lon
-				auto lon = node.get_sint64();
-				FlatVector::GetData<double>(output.data[5])[index] = 0.000000001 * (lon_offset + (granularity * lon));
+				lon = 0.000000001 * (lon_offset + (granularity * node.get_sint64()));
+				if (columns[LON_COLUMN]) {
+					FlatVector::GetData<double>(*columns[LON_COLUMN])[index] = lon;
+				}
 			} break;
 			default:
 				node.skip();
@@ -406,35 +1295,14 @@ struct LocalState final : LocalTableFunctionState {
 		}
 
 		// Read tags
-		if (!key_iter.empty() && !val_iter.empty()) {
-			auto tag_count = key_iter.size();
-			auto total_tags = ListVector::GetListSize(output.data[2]);
-			ListVector::Reserve(output.data[2], total_tags + tag_count);
-			ListVector::SetListSize(output.data[2], total_tags + tag_count);
-			auto &tag_entry = ListVector::GetData(output.data[2])[index];
-
-			tag_entry.offset = total_tags;
-			tag_entry.length = tag_count;
-
-			auto &key_vector = MapVector::GetKeys(output.data[2]);
-			auto &value_vector = MapVector::GetValues(output.data[2]);
-
-			auto keys = key_iter.begin();
-			auto vals = val_iter.begin();
-			for (idx_t i = tag_entry.offset; i < tag_entry.offset + tag_count; i++) {
-				FlatVector::GetData<string_t>(key_vector)[i] =
-				    StringVector::AddString(key_vector, string_table[*keys++]);
-				FlatVector::GetData<string_t>(value_vector)[i] =
-				    StringVector::AddString(value_vector, string_table[*vals++]);
-			}
-		} else {
-			FlatVector::SetNull(output.data[2], index, true);
-		}
+		WriteTags(key_iter, val_iter, index);
+
+		WritePoint(lon, lat, index);
 
 		// Node has no refs, ref_roles or ref_types
-		FlatVector::SetNull(output.data[3], index, true);
-		FlatVector::SetNull(output.data[6], index, true);
-		FlatVector::SetNull(output.data[7], index, true);
+		SetNull(REFS_COLUMN, index);
+		SetNull(REF_ROLES_COLUMN, index);
+		SetNull(REF_TYPES_COLUMN, index);
 
 		index++;
 	}
@@ -449,6 +1317,7 @@ struct LocalState final : LocalTableFunctionState {
 
 		auto dense_nodes = group_reader.get_message();
 
+		// The ids are always decoded, as they determine the number of nodes. The other fields only if projected.
 		while (dense_nodes.next()) {
 			switch (dense_nodes.tag()) {
 			case 1: { // ID
@@ -460,6 +1329,10 @@ struct LocalState final : LocalTableFunctionState {
 				}
 			} break;
 			case 8: { // Lats
+				if (!columns[LAT_COLUMN] && !columns[GEOM_COLUMN]) {
+					dense_nodes.skip();
+					break;
+				}
 				auto lats = dense_nodes.get_packed_sint64();
 				int64_t last_lat = 0;
 				for (auto lat : lats) {
@@ -468,6 +1341,10 @@ struct LocalState final : LocalTableFunctionState {
 				}
 			} break;
 			case 9: { // Lons
+				if (!columns[LON_COLUMN] && !columns[GEOM_COLUMN]) {
+					dense_nodes.skip();
+					break;
+				}
 				auto lons = dense_nodes.get_packed_sint64();
 				int64_t last_lon = 0;
 				for (auto lon : lons) {
@@ -476,6 +1353,10 @@ struct LocalState final : LocalTableFunctionState {
 				}
 			} break;
 			case 10: { // Tags
+				if (!columns[TAGS_COLUMN]) {
+					dense_nodes.skip();
+					break;
+				}
 				auto tags = dense_nodes.get_packed_uint32();
 				idx_t entry_offset = 0;
 				for (auto tag : tags) {
@@ -505,12 +1386,11 @@ struct LocalState final : LocalTableFunctionState {
 			switch (way.tag()) {
 			case 1: { // ID
 				auto id = way.get_int64();
-				FlatVector::GetData<uint8_t>(output.data[0])[index] = 1;
-				FlatVector::GetData<int64_t>(output.data[1])[index] = id;
-				FlatVector::SetNull(output.data[4], index, true);
-				FlatVector::SetNull(output.data[5], index, true);
-				FlatVector::SetNull(output.data[6], index, true);
-				FlatVector::SetNull(output.data[7], index, true);
+				WriteKindAndId(OsmKind::WAY, id, index);
+				SetNull(LAT_COLUMN, index);
+				SetNull(LON_COLUMN, index);
+				SetNull(REF_ROLES_COLUMN, index);
+				SetNull(REF_TYPES_COLUMN, index);
 			} break;
 			case 2: { // Tag Keys
 				key_iter = way.get_packed_uint32();
@@ -525,50 +1405,14 @@ struct LocalState final : LocalTableFunctionState {
 				way.skip();
 			}
 		}
-		if (!key_iter.empty() && !val_iter.empty()) {
-			auto tag_count = key_iter.size();
-			auto total_tags = ListVector::GetListSize(output.data[2]);
-			ListVector::Reserve(output.data[2], total_tags + tag_count);
-			ListVector::SetListSize(output.data[2], total_tags + tag_count);
-			auto &tag_entry = ListVector::GetData(output.data[2])[index];
-
-			tag_entry.offset = total_tags;
-			tag_entry.length = tag_count;
 
-			auto &key_vector = MapVector::GetKeys(output.data[2]);
-			auto &value_vector = MapVector::GetValues(output.data[2]);
+		WriteTags(key_iter, val_iter, index);
+		WriteRefs(ref_iter, index);
 
-			auto keys = key_iter.begin();
-			auto vals = val_iter.begin();
-			for (idx_t i = tag_entry.offset; i < tag_entry.offset + tag_count; i++) {
-				FlatVector::GetData<string_t>(key_vector)[i] =
-				    StringVector::AddString(key_vector, string_table[*keys++]);
-				FlatVector::GetData<string_t>(value_vector)[i] =
-				    StringVector::AddString(value_vector, string_table[*vals++]);
-			}
-		} else {
-			FlatVector::SetNull(output.data[2], index, true);
-		}
-
-		if (!ref_iter.empty()) {
-			auto ref_count = ref_iter.size();
-			auto total_refs = ListVector::GetListSize(output.data[3]);
-			ListVector::Reserve(output.data[3], total_refs + ref_count);
-			ListVector::SetListSize(output.data[3], total_refs + ref_count);
-			auto &ref_entry = ListVector::GetData(output.data[3])[index];
-			auto &ref_vector = ListVector::GetEntry(output.data[3]);
-			ref_entry.offset = total_refs;
-			ref_entry.length = ref_count;
-
-			auto ref_data = FlatVector::GetData<int64_t>(ref_vector);
-
-			int64_t last_ref = 0;
-			for (auto ref : ref_iter) {
-				last_ref += ref;
-				ref_data[total_refs++] = last_ref;
-			}
-		} else {
-			FlatVector::SetNull(output.data[3], index, true);
+		// The geometry column is only projected when assembling geometries
+		if (columns[GEOM_COLUMN]) {
+			DecodeRefs(ref_iter, way_refs);
+			WriteWayGeometry(way_refs, IsArea(key_iter, val_iter), index);
 		}
 
 		index++;
@@ -587,10 +1431,9 @@ struct LocalState final : LocalTableFunctionState {
 			switch (relation.tag()) {
 			case 1: { // ID
 				auto id = relation.get_int64();
-				FlatVector::GetData<uint8_t>(output.data[0])[index] = 2;
-				FlatVector::GetData<int64_t>(output.data[1])[index] = id;
-				FlatVector::SetNull(output.data[4], index, true);
-				FlatVector::SetNull(output.data[5], index, true);
+				WriteKindAndId(OsmKind::RELATION, id, index);
+				SetNull(LAT_COLUMN, index);
+				SetNull(LON_COLUMN, index);
 			} break;
 			case 2: { // Tag Keys
 				key_iter = relation.get_packed_uint32();
@@ -613,98 +1456,64 @@ struct LocalState final : LocalTableFunctionState {
 		}
 
 		// Read tags
-		if (!key_iter.empty() && !val_iter.empty()) {
-			auto tag_count = key_iter.size();
-
-			auto total_tags = ListVector::GetListSize(output.data[2]);
-			ListVector::Reserve(output.data[2], total_tags + tag_count);
-			ListVector::SetListSize(output.data[2], total_tags + tag_count);
-			auto &tag_entry = ListVector::GetData(output.data[2])[index];
-
-			tag_entry.offset = total_tags;
-			tag_entry.length = tag_count;
-
-			auto &key_vector = MapVector::GetKeys(output.data[2]);
-			auto &value_vector = MapVector::GetValues(output.data[2]);
-
-			auto keys = key_iter.begin();
-			auto vals = val_iter.begin();
-			for (idx_t i = tag_entry.offset; i < tag_entry.offset + tag_count; i++) {
-				FlatVector::GetData<string_t>(key_vector)[i] =
-				    StringVector::AddString(key_vector, string_table[*keys++]);
-				FlatVector::GetData<string_t>(value_vector)[i] =
-				    StringVector::AddString(value_vector, string_table[*vals++]);
-			}
-		} else {
-			FlatVector::SetNull(output.data[2], index, true);
-		}
+		WriteTags(key_iter, val_iter, index);
 
 		// Roles
-		if (!role_iter.empty()) {
-			auto role_count = role_iter.size();
-
-			auto total_roles = ListVector::GetListSize(output.data[6]);
-			ListVector::Reserve(output.data[6], total_roles + role_count);
-			ListVector::SetListSize(output.data[6], total_roles + role_count);
-			auto &role_entry = ListVector::GetData(output.data[6])[index];
-			auto &role_vector = ListVector::GetEntry(output.data[6]);
-			role_entry.offset = total_roles;
-			role_entry.length = role_count;
-
-			auto roles = role_iter.begin();
-			for (idx_t i = role_entry.offset; i < role_entry.offset + role_count; i++) {
-				auto &role_str = string_table[*roles++];
-				if (role_str.empty()) {
-					FlatVector::SetNull(role_vector, i, true);
-				} else {
-					FlatVector::GetData<string_t>(role_vector)[i] = StringVector::AddString(role_vector, role_str);
+		if (columns[REF_ROLES_COLUMN]) {
+			auto &roles_vector = *columns[REF_ROLES_COLUMN];
+			if (!role_iter.empty()) {
+				auto role_count = role_iter.size();
+
+				auto total_roles = ListVector::GetListSize(roles_vector);
+				ListVector::Reserve(roles_vector, total_roles + role_count);
+				ListVector::SetListSize(roles_vector, total_roles + role_count);
+				auto &role_entry = ListVector::GetData(roles_vector)[index];
+				auto &role_vector = ListVector::GetEntry(roles_vector);
+				role_entry.offset = total_roles;
+				role_entry.length = role_count;
+
+				auto roles = role_iter.begin();
+				for (idx_t i = role_entry.offset; i < role_entry.offset + role_count; i++) {
+					auto &role_str = string_table[*roles++];
+					if (role_str.empty()) {
+						FlatVector::SetNull(role_vector, i, true);
+					} else {
+						FlatVector::GetData<string_t>(role_vector)[i] = StringVector::AddString(role_vector, role_str);
+					}
 				}
+			} else {
+				FlatVector::SetNull(roles_vector, index, true);
 			}
-		} else {
-			FlatVector::SetNull(output.data[6], index, true);
 		}
 
 		// Refs
-		if (!ref_iter.empty()) {
-			auto ref_count = ref_iter.size();
-
-			auto total_refs = ListVector::GetListSize(output.data[3]);
-			ListVector::Reserve(output.data[3], total_refs + ref_count);
-			ListVector::SetListSize(output.data[3], total_refs + ref_count);
-			auto &ref_entry = ListVector::GetData(output.data[3])[index];
-			auto &ref_vector = ListVector::GetEntry(output.data[3]);
-			ref_entry.offset = total_refs;
-			ref_entry.length = ref_count;
+		WriteRefs(ref_iter, index);
 
-			auto ref_data = FlatVector::GetData<int64_t>(ref_vector);
-
-			int64_t last_ref = 0;
-			for (auto ref : ref_iter) {
-				last_ref += ref;
-				ref_data[total_refs++] = last_ref;
+		// Types
+		if (columns[REF_TYPES_COLUMN]) {
+			auto &types_vector = *columns[REF_TYPES_COLUMN];
+			if (!type_iter.empty()) {
+				auto type_count = type_iter.size();
+
+				auto total_types = ListVector::GetListSize(types_vector);
+				ListVector::Reserve(types_vector, total_types + type_count);
+				ListVector::SetListSize(types_vector, total_types + type_count);
+				auto &type_entry = ListVector::GetData(types_vector)[index];
+				auto &type_vector = ListVector::GetEntry(types_vector);
+				type_entry.offset = total_types;
+				type_entry.length = type_count;
+
+				auto type_data = FlatVector::GetData<uint8_t>(type_vector);
+				for (auto type : type_iter) {
+					type_data[total_types++] = (uint8_t)type;
+				}
+			} else {
+				FlatVector::SetNull(types_vector, index, true);
 			}
-		} else {
-			FlatVector::SetNull(output.data[3], index, true);
 		}
 
-		// Types
-		if (!type_iter.empty()) {
-			auto type_count = type_iter.size();
-
-			auto total_types = ListVector::GetListSize(output.data[7]);
-			ListVector::Reserve(output.data[7], total_types + type_count);
-			ListVector::SetListSize(output.data[7], total_types + type_count);
-			auto &type_entry = ListVector::GetData(output.data[7])[index];
-			auto &type_vector = ListVector::GetEntry(output.data[7]);
-			type_entry.offset = total_types;
-			type_entry.length = type_count;
-
-			auto type_data = FlatVector::GetData<uint8_t>(type_vector);
-			for (auto type : type_iter) {
-				type_data[total_types++] = (uint8_t)type;
-			}
-		} else {
-			FlatVector::SetNull(output.data[7], index, true);
+		if (columns[GEOM_COLUMN]) {
+			WriteRelationGeometry(key_iter, val_iter, role_iter, ref_iter, type_iter, index);
 		}
 
 		index++;
@@ -716,37 +1525,41 @@ struct LocalState final : LocalTableFunctionState {
 		auto nodes_to_write = capacity - index;
 		auto nodes_to_read = std::min(nodes_to_write, dense_node_ids.size() - dense_node_index);
 
-		auto kind_data = FlatVector::GetData<uint8_t>(output.data[0]);
-		auto id_data = FlatVector::GetData<int64_t>(output.data[1]);
-		auto lat_data = FlatVector::GetData<double>(output.data[4]);
-		auto lon_data = FlatVector::GetData<double>(output.data[5]);
-
 		for (idx_t i = 0; i < nodes_to_read; i++) {
 			auto id = dense_node_ids[dense_node_index];
 
-			id_data[index] = id;
-			kind_data[index] = 0;
-			lat_data[index] = 0.000000001 * (lat_offset + (granularity * dense_node_lats[dense_node_index]));
-			lon_data[index] = 0.000000001 * (lon_offset + (granularity * dense_node_lons[dense_node_index]));
+			WriteKindAndId(OsmKind::NODE, id, index);
+			if (columns[LAT_COLUMN] || columns[LON_COLUMN] || columns[GEOM_COLUMN]) {
+				const auto lat = 0.000000001 * (lat_offset + (granularity * dense_node_lats[dense_node_index]));
+				const auto lon = 0.000000001 * (lon_offset + (granularity * dense_node_lons[dense_node_index]));
+				if (columns[LAT_COLUMN]) {
+					FlatVector::GetData<double>(*columns[LAT_COLUMN])[index] = lat;
+				}
+				if (columns[LON_COLUMN]) {
+					FlatVector::GetData<double>(*columns[LON_COLUMN])[index] = lon;
+				}
+				WritePoint(lon, lat, index);
+			}
 
 			// Do we have tags in this block?
-			if (!dense_node_tags.empty()) {
+			if (columns[TAGS_COLUMN] && !dense_node_tags.empty()) {
+				auto &tags_vector = *columns[TAGS_COLUMN];
 				auto entry = dense_node_tag_entries[dense_node_index];
 				if (entry.length != 0) {
 					// Dense nodes tags are stored as a list of key/value pairs,
 					// therefore we need to divide the length by 2 to get the number of tags
 					auto tag_count = entry.length / 2;
 
-					auto total_tags = ListVector::GetListSize(output.data[2]);
-					ListVector::Reserve(output.data[2], total_tags + tag_count);
-					ListVector::SetListSize(output.data[2], total_tags + tag_count);
-					auto &tag_entry = ListVector::GetData(output.data[2])[index];
+					auto total_tags = ListVector::GetListSize(tags_vector);
+					ListVector::Reserve(tags_vector, total_tags + tag_count);
+					ListVector::SetListSize(tags_vector, total_tags + tag_count);
+					auto &tag_entry = ListVector::GetData(tags_vector)[index];
 
 					tag_entry.offset = total_tags;
 					tag_entry.length = tag_count;
 
-					auto &key_vector = MapVector::GetKeys(output.data[2]);
-					auto &value_vector = MapVector::GetValues(output.data[2]);
+					auto &key_vector = MapVector::GetKeys(tags_vector);
+					auto &value_vector = MapVector::GetValues(tags_vector);
 
 					idx_t t = entry.offset;
 					idx_t r = tag_entry.offset;
@@ -764,16 +1577,16 @@ struct LocalState final : LocalTableFunctionState {
 						r += 1;
 					}
 				} else {
-					FlatVector::SetNull(output.data[2], index, true);
+					FlatVector::SetNull(tags_vector, index, true);
 				}
 			} else {
-				FlatVector::SetNull(output.data[2], index, true);
+				SetNull(TAGS_COLUMN, index);
 			}
-			FlatVector::SetNull(output.data[3], index, true);
+			SetNull(REFS_COLUMN, index);
 
 			// No ref types or roles for dense nodes
-			FlatVector::SetNull(output.data[6], index, true);
-			FlatVector::SetNull(output.data[7], index, true);
+			SetNull(REF_ROLES_COLUMN, index);
+			SetNull(REF_TYPES_COLUMN, index);
 
 			dense_node_index++;
 			index++;
@@ -788,13 +1601,13 @@ struct LocalState final : LocalTableFunctionState {
 static unique_ptr<LocalTableFunctionState> InitLocal(ExecutionContext &context, TableFunctionInitInput &input,
                                                      GlobalTableFunctionState *global_state) {
 	auto &global = global_state->Cast<GlobalState>();
-	const auto blob = global.GetNextBlob(context.client);
-	if (blob == nullptr) {
+	auto &bind_data = input.bind_data->Cast<BindData>();
+
+	auto result = make_uniq<LocalState>(context.client, global.OpenFile(context.client), input.column_ids,
+	                                    bind_data.kind_mask, global.GetAssemblyState());
+	if (!result->Next(context.client, global)) {
 		return nullptr;
 	}
-	auto block = DecompressBlob(context.client, *blob);
-
-	auto result = make_uniq<LocalState>(std::move(block));
 	return std::move(result);
 }
 
@@ -810,15 +1623,12 @@ static void Execute(ClientContext &context, TableFunctionInput &input, DataChunk
 	idx_t row_id = 0;
 	idx_t capacity = STANDARD_VECTOR_SIZE;
 
+	local_state.SetOutput(output);
+
 	while (row_id < capacity) {
 		bool done = local_state.TryRead(output, row_id, capacity);
-		if (done) {
-			auto next = global_state.GetNextBlob(context);
-			if (next.get() == nullptr) {
-				break;
-			}
-			auto next_block = DecompressBlob(context, *next);
-			local_state.SetBlock(std::move(next_block));
+		if (done && !local_state.Next(context, global_state)) {
+			break;
 		}
 	}
 	output.SetCardinality(row_id);
@@ -838,6 +1648,92 @@ static OperatorPartitionData GetPartitionData(ClientContext &context, TableFunct
 	return OperatorPartitionData(state.block->block_idx);
 }
 
+//------------------------------------------------------------------------------
+// Filter Pushdown
+//------------------------------------------------------------------------------
+// Filters on the "kind" column let us skip entire primitive groups (which only ever contain a single kind of entity)
+// without decoding them. The filters are only inspected, not removed, so they are still evaluated on the output.
+
+static bool IsKindColumn(const LogicalGet &get, const Expression &expr) {
+	auto column_expr = &expr;
+	if (column_expr->GetExpressionClass() == ExpressionClass::BOUND_CAST) {
+		column_expr = column_expr->Cast<BoundCastExpression>().child.get();
+	}
+	if (column_expr->GetExpressionClass() != ExpressionClass::BOUND_COLUMN_REF) {
+		return false;
+	}
+	const auto &binding = column_expr->Cast<BoundColumnRefExpression>().binding;
+	if (binding.table_index != get.table_index) {
+		return false;
+	}
+	const auto &column_ids = get.GetColumnIds();
+	return binding.column_index < column_ids.size() &&
+	       column_ids[binding.column_index].GetPrimaryIndex() == KIND_COLUMN;
+}
+
+static uint8_t GetKindBit(const Value &value) {
+	if (value.IsNull()) {
+		return 0;
+	}
+	const auto kind = value.ToString();
+	if (kind == "node") {
+		return KindBit(OsmKind::NODE);
+	}
+	if (kind == "way") {
+		return KindBit(OsmKind::WAY);
+	}
+	if (kind == "relation") {
+		return KindBit(OsmKind::RELATION);
+	}
+	if (kind == "changeset") {
+		return KindBit(OsmKind::CHANGESET);
+	}
+	return 0;
+}
+
+// Returns the kinds that can pass the filter, or ALL_KINDS if the filter does not restrict the "kind" column
+static uint8_t GetKindMask(const LogicalGet &get, const Expression &filter) {
+	if (filter.GetExpressionType() == ExpressionType::COMPARE_EQUAL) {
+		// kind = 'way'
+		auto &comparison = filter.Cast<BoundComparisonExpression>();
+		auto &lhs = *comparison.left;
+		auto &rhs = *comparison.right;
+		if (IsKindColumn(get, lhs) && rhs.GetExpressionClass() == ExpressionClass::BOUND_CONSTANT) {
+			return GetKindBit(rhs.Cast<BoundConstantExpression>().value);
+		}
+		if (IsKindColumn(get, rhs) && lhs.GetExpressionClass() == ExpressionClass::BOUND_CONSTANT) {
+			return GetKindBit(lhs.Cast<BoundConstantExpression>().value);
+		}
+		return ALL_KINDS;
+	}
+	if (filter.GetExpressionType() == ExpressionType::COMPARE_IN) {
+		// kind IN ('way', 'relation')
+		auto &in_expr = filter.Cast<BoundOperatorExpression>();
+		if (!IsKindColumn(get, *in_expr.children[0])) {
+			return ALL_KINDS;
+		}
+		uint8_t mask = 0;
+		for (idx_t i = 1; i < in_expr.children.size(); i++) {
+			auto &child = *in_expr.children[i];
+			if (child.GetExpressionClass() != ExpressionClass::BOUND_CONSTANT) {
+				return ALL_KINDS;
+			}
+			mask |= GetKindBit(child.Cast<BoundConstantExpression>().value);
+		}
+		return mask;
+	}
+	return ALL_KINDS;
+}
+
+static void PushdownComplexFilter(ClientContext &context, LogicalGet &get, FunctionData *bind_data_p,
+                                  vector<unique_ptr<Expression>> &filters) {
+	auto &bind_data = bind_data_p->Cast<BindData>();
+	// The filters are all AND:ed together
+	for (auto &filter : filters) {
+		bind_data.kind_mask &= GetKindMask(get, *filter);
+	}
+}
+
 static unique_ptr<TableRef> ReadOsmPBFReplacementScan(ClientContext &context, ReplacementScanInput &input,
                                                       optional_ptr<ReplacementScanData> data) {
 	auto &table_name = input.table_name;
@@ -862,7 +1758,15 @@ static unique_ptr<TableRef> ReadOsmPBFReplacementScan(ClientContext &context, Re
 static constexpr const char *DOC_DESCRIPTION = R"(
     The `ST_ReadOsm()` table function enables reading compressed OpenStreetMap data directly from a `.osm.pbf file.`
 
-    This function uses multithreading and zero-copy protobuf parsing which makes it a lot faster than using the `ST_Read()` OSM driver, however it only outputs the raw OSM data (Nodes, Ways, Relations), without constructing any geometries. For simple node entities (like PoI's) you can trivially construct POINT geometries, but it is also possible to construct LINESTRING and POLYGON geometries by manually joining refs and nodes together in SQL, although with available memory usually being a limiting factor.
+    This function uses multithreading and zero-copy protobuf parsing which makes it a lot faster than using the `ST_Read()` OSM driver, however by default it only outputs the raw OSM data (Nodes, Ways, Relations), without constructing any geometries. For simple node entities (like PoI's) you can trivially construct POINT geometries, but it is also possible to construct LINESTRING and POLYGON geometries by manually joining refs and nodes together in SQL, although with available memory usually being a limiting factor.
+
+    Alternatively, pass `assemble_geometry := true` to add a `geom` column with the geometries assembled while scanning:
+    - Nodes become POINTs.
+    - Closed ways become POLYGONs if they are tagged `area=yes` or with a key that usually describes an area (e.g. `building` or `landuse`), other ways become LINESTRINGs.
+    - Relations tagged `type=multipolygon` or `type=boundary` become MULTIPOLYGONs, assembled from their `outer` and `inner` member ways.
+    - Geometries that can not be assembled, e.g. because their nodes are missing from an extract, are NULL.
+
+    To do so, the node locations are kept in a buffer-managed store that can spill to disk, and the blocks containing ways and relations are read a second time once all nodes have been read. Nodes are returned first, followed by the ways and then the relations.
     The `ST_ReadOSM()` function also provides a "replacement scan" to enable reading from a file directly as if it were a table. This is just syntax sugar for calling `ST_ReadOSM()` though. Example:
 
     ```sql
@@ -898,6 +1802,9 @@ void RegisterOSMModule(DatabaseInstance &db) {
 
 	read.get_partition_data = GetPartitionData;
 	read.table_scan_progress = Progress;
+	read.projection_pushdown = true;
+	read.pushdown_complex_filter = PushdownComplexFilter;
+	read.named_parameters["assemble_geometry"] = LogicalType::BOOLEAN;
 
 	ExtensionUtil::RegisterFunction(db, read);
 
@@ -0,0 +1,93 @@
+#include "spatial/modules/osm/osm_node_store.hpp"
+
+#include "duckdb/storage/buffer_manager.hpp"
+
+#include <algorithm>
+
+namespace duckdb {
+
+// The number of blocks a lookup state keeps pinned before unpinning all of them
+static constexpr idx_t MAX_PINNED_BLOCKS = 64;
+
+OsmNodeStore::OsmNodeStore(BufferManager &manager)
+    : manager(manager), block_capacity(manager.GetBlockSize() / sizeof(OsmNodeLocation)) {
+}
+
+void OsmNodeStore::Append(OsmNodeStoreAppendState &state, const OsmNodeLocation *begin, const OsmNodeLocation *end) {
+	while (begin != end) {
+		if (state.block_idx == DConstants::INVALID_INDEX || state.item_count >= block_capacity) {
+			// Allocate a new block, the handle keeps it pinned for as long as we append to it
+			state.handle = manager.Allocate(MemoryTag::EXTENSION, manager.GetBlockSize(), false);
+			state.item_count = 0;
+
+			lock_guard<mutex> guard(lock);
+			state.block_idx = blocks.size();
+			blocks.push_back(state.handle.GetBlockHandle());
+		}
+
+		// A run never spans multiple blocks, so split it if it does not fit in the current block
+		const auto remaining_capacity = block_capacity - state.item_count;
+		const auto to_copy = MinValue<idx_t>(remaining_capacity, end - begin);
+
+		auto ptr = reinterpret_cast<OsmNodeLocation *>(state.handle.Ptr()) + state.item_count;
+		std::copy(begin, begin + to_copy, ptr);
+
+		Run run;
+		run.min_id = begin[0].id;
+		run.max_id = begin[to_copy - 1].id;
+		run.block_idx = state.block_idx;
+		run.offset = state.item_count;
+		run.count = to_copy;
+
+		state.item_count += to_copy;
+		begin += to_copy;
+
+		lock_guard<mutex> guard(lock);
+		runs.push_back(run);
+		node_count += to_copy;
+	}
+}
+
+void OsmNodeStore::Finalize() {
+	std::sort(runs.begin(), runs.end(), [](const Run &a, const Run &b) { return a.min_id < b.min_id; });
+
+	runs_max_id.resize(runs.size());
+	for (idx_t i = 0; i < runs.size(); i++) {
+		runs_max_id[i] = i == 0 ? runs[i].max_id : MaxValue(runs_max_id[i - 1], runs[i].max_id);
+	}
+}
+
+bool OsmNodeStore::TryGetLocation(OsmNodeStoreLookupState &state, int64_t id, OsmNodeLocation &result) const {
+	// Find the last run that starts at or before the id
+	auto it = std::upper_bound(runs.begin(), runs.end(), id, [](int64_t id, const Run &run) { return id < run.min_id; });
+	auto run_idx = static_cast<idx_t>(it - runs.begin());
+
+	// Walk backwards over all the runs that might contain the id. Unless the runs overlap, this is only the first one.
+	while (run_idx > 0 && runs_max_id[run_idx - 1] >= id) {
+		const auto &run = runs[--run_idx];
+		if (run.max_id < id) {
+			continue;
+		}
+
+		auto entry = state.pinned.find(run.block_idx);
+		if (entry == state.pinned.end()) {
+			if (state.pinned.size() >= MAX_PINNED_BLOCKS) {
+				state.pinned.clear();
+			}
+			auto block = blocks[run.block_idx];
+			entry = state.pinned.emplace(run.block_idx, manager.Pin(block)).first;
+		}
+
+		const auto run_begin = reinterpret_cast<const OsmNodeLocation *>(entry->second.Ptr()) + run.offset;
+		const auto run_end = run_begin + run.count;
+		const auto node = std::lower_bound(run_begin, run_end, id,
+		                                   [](const OsmNodeLocation &node, int64_t id) { return node.id < id; });
+		if (node != run_end && node->id == id) {
+			result = *node;
+			return true;
+		}
+	}
+	return false;
+}
+
+} // namespace duckdb
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "duckdb/common/common.hpp"
+#include "duckdb/common/mutex.hpp"
+#include "duckdb/common/unordered_map.hpp"
+#include "duckdb/storage/buffer/buffer_handle.hpp"
+
+namespace duckdb {
+
+class BlockHandle;
+class BufferManager;
+
+// The location of a node, with the coordinates stored as fixed point integers with 7 decimals (like the OSM API)
+struct OsmNodeLocation {
+	int64_t id;
+	int32_t lon;
+	int32_t lat;
+};
+
+struct OsmNodeStoreAppendState {
+	BufferHandle handle;
+	idx_t block_idx = DConstants::INVALID_INDEX;
+	idx_t item_count = 0;
+};
+
+struct OsmNodeStoreLookupState {
+	// The blocks that are currently pinned by this state, cleared once too many are pinned at once
+	unordered_map<idx_t, BufferHandle> pinned;
+};
+
+// A buffer-managed store of node locations, used to resolve the node refs of ways and relations.
+// The nodes are appended in runs (e.g. the nodes of one PBF block) that must be sorted by id. A node is found by
+// binary searching the runs by their id range, and then the nodes within the run. As PBF files are usually sorted by
+// id the runs do not overlap, but overlapping runs are supported too.
+//
+// Appending is thread-safe as long as every thread uses its own append state. All nodes have to be appended and
+// Finalize() called before the first lookup, after which lookups are thread-safe too.
+class OsmNodeStore {
+public:
+	explicit OsmNodeStore(BufferManager &manager);
+
+	void Append(OsmNodeStoreAppendState &state, const OsmNodeLocation *begin, const OsmNodeLocation *end);
+	void Finalize();
+	bool TryGetLocation(OsmNodeStoreLookupState &state, int64_t id, OsmNodeLocation &result) const;
+
+	idx_t Count() const {
+		return node_count;
+	}
+
+private:
+	struct Run {
+		int64_t min_id;
+		int64_t max_id;
+		idx_t block_idx;
+		idx_t offset;
+		idx_t count;
+	};
+
+	BufferManager &manager;
+	const idx_t block_capacity;
+
+	mutex lock;
+	vector<shared_ptr<BlockHandle>> blocks;
+	vector<Run> runs;
+	// The largest max_id of all runs up to and including the run at the same index, after finalizing
+	vector<int64_t> runs_max_id;
+	idx_t node_count = 0;
+};
+
+} // namespace duckdb
@@ -5,6 +5,7 @@
 #include "spatial/geometry/geometry_serialization.hpp"
 
 #include "duckdb/common/vector_operations/generic_executor.hpp"
+#include "duckdb/common/vector_operations/vector_operations.hpp"
 #include "duckdb/parser/parsed_data/create_table_function_info.hpp"
 #include "duckdb/execution/expression_executor.hpp"
 #include "duckdb/planner/expression/bound_function_expression.hpp"
@@ -128,10 +129,16 @@ struct ProjFunctionLocalState final : FunctionLocalState {
 	PJ_CONTEXT *proj_ctx;
 	ArenaAllocator arena;
 	GeometryAllocator allocator;
+	SerdeFormat format;
 
 	// Cache for PJ* objects
 	unordered_map<std::pair<string, string>, ProjCRS> crs_cache;
 
+	// Coordinate buffers, reused across chunks when transforming a whole chunk at once
+	vector<double> x_buffer;
+	vector<double> y_buffer;
+	vector<double> z_buffer;
+
 	// Not copyable
 	ProjFunctionLocalState(const ProjFunctionLocalState &) = delete;
 	ProjFunctionLocalState &operator=(const ProjFunctionLocalState &) = delete;
@@ -141,7 +148,8 @@ struct ProjFunctionLocalState final : FunctionLocalState {
 	ProjFunctionLocalState &operator=(ProjFunctionLocalState &&) = delete;
 
 	explicit ProjFunctionLocalState(ClientContext &context)
-	    : proj_ctx(ProjModule::GetThreadProjContext()), arena(BufferAllocator::Get(context)), allocator(arena) {
+	    : proj_ctx(ProjModule::GetThreadProjContext()), arena(BufferAllocator::Get(context)), allocator(arena),
+	      format(SerdeFormat::Get(context)) {
 	}
 
 	~ProjFunctionLocalState() override {
@@ -188,6 +196,31 @@ struct ProjFunctionLocalState final : FunctionLocalState {
 		crs_cache[{source, target}] = ProjCRS(crs);
 		return crs;
 	}
+
+	// Returns the projection if both the source and target CRS are constant (and not NULL), or nullptr otherwise
+	PJ *TryGetConstantProjection(Vector &source_vec, Vector &target_vec, bool normalize) {
+		if (source_vec.GetVectorType() != VectorType::CONSTANT_VECTOR ||
+		    target_vec.GetVectorType() != VectorType::CONSTANT_VECTOR) {
+			return nullptr;
+		}
+		if (ConstantVector::IsNull(source_vec) || ConstantVector::IsNull(target_vec)) {
+			return nullptr;
+		}
+		const auto source = ConstantVector::GetData<string_t>(source_vec)[0].GetString();
+		const auto target = ConstantVector::GetData<string_t>(target_vec)[0].GetString();
+		return GetOrCreateProjection(source, target, normalize);
+	}
+
+	// Transform the coordinates in the buffers in place, using a single call to PROJ
+	void TransformBuffers(PJ *crs, idx_t count) {
+		if (count == 0) {
+			return;
+		}
+		// We dont pass any time, so use the same (zero) time for all coordinates
+		double time = 0;
+		proj_trans_generic(crs, PJ_FWD, x_buffer.data(), sizeof(double), count, y_buffer.data(), sizeof(double), count,
+		                   z_buffer.data(), sizeof(double), count, &time, 0, 1);
+	}
 };
 
 void ProjFunctionLocalState::Deserialize(const string_t &blob, sgl::geometry &geom) {
@@ -195,9 +228,9 @@ void ProjFunctionLocalState::Deserialize(const string_t &blob, sgl::geometry &ge
 }
 
 string_t ProjFunctionLocalState::Serialize(Vector &vector, const sgl::geometry &geom) {
-	const auto size = Serde::GetRequiredSize(geom);
+	const auto size = Serde::GetRequiredSize(geom, format);
 	auto blob = StringVector::EmptyString(vector, size);
-	Serde::Serialize(geom, blob.GetDataWriteable(), size);
+	Serde::Serialize(geom, format, blob.GetDataWriteable(), size);
 	blob.Finalize();
 	return blob;
 }
@@ -253,6 +286,12 @@ struct ST_Transform {
 		auto &func_expr = state.expr.Cast<BoundFunctionExpression>();
 		const auto &info = func_expr.bind_info->Cast<BindData>();
 
+		const auto crs = lstate.TryGetConstantProjection(args.data[1], args.data[2], info.normalize);
+		if (crs) {
+			ExecutePointBatched(lstate, crs, args.data[0], result, args.size());
+			return;
+		}
+
 		GenericExecutor::ExecuteTernary<POINT_TYPE, PROJ_TYPE, PROJ_TYPE, POINT_TYPE>(
 		    args.data[0], args.data[1], args.data[2], result, args.size(),
 		    [&](const POINT_TYPE &point_in, const PROJ_TYPE &source, const PROJ_TYPE target) {
@@ -270,6 +309,26 @@ struct ST_Transform {
 		    });
 	}
 
+	// If the CRS arguments are constant, we can transform all points in the chunk with a single call to PROJ
+	static void ExecutePointBatched(ProjFunctionLocalState &lstate, PJ *crs, Vector &input, Vector &result,
+	                                idx_t count) {
+		// Copy the input points to the (flat) result, and transform them from there
+		VectorOperations::Copy(input, result, count, 0, 0);
+
+		const auto &children = StructVector::GetEntries(result);
+		const auto x_data = FlatVector::GetData<double>(*children[0]);
+		const auto y_data = FlatVector::GetData<double>(*children[1]);
+
+		lstate.x_buffer.assign(x_data, x_data + count);
+		lstate.y_buffer.assign(y_data, y_data + count);
+		lstate.z_buffer.assign(count, 0);
+
+		lstate.TransformBuffers(crs, count);
+
+		memcpy(x_data, lstate.x_buffer.data(), count * sizeof(double));
+		memcpy(y_data, lstate.y_buffer.data(), count * sizeof(double));
+	}
+
 	//------------------------------------------------------------------------------------------------------------------
 	// Execute (BOX_2D)
 	//------------------------------------------------------------------------------------------------------------------
@@ -307,6 +366,12 @@ struct ST_Transform {
 		auto &func_expr = state.expr.Cast<BoundFunctionExpression>();
 		const auto &info = func_expr.bind_info->Cast<BindData>();
 
+		const auto crs = lstate.TryGetConstantProjection(args.data[1], args.data[2], info.normalize);
+		if (crs) {
+			ExecuteGeometryBatched(lstate, crs, args.data[0], result, args.size());
+			return;
+		}
+
 		TernaryExecutor::Execute<string_t, string_t, string_t, string_t>(
 		    args.data[0], args.data[1], args.data[2], result, args.size(),
 		    [&](const string_t &blob, const string_t &source, const string_t &target) {
@@ -330,6 +395,134 @@ struct ST_Transform {
 		    });
 	}
 
+	// Collect all the parts of a geometry that contain vertices (points and linestrings)
+	static void CollectVertexParts(sgl::geometry *geom, vector<sgl::geometry *> &parts) {
+		auto part = geom;
+		const auto root = geom->get_parent();
+
+		while (true) {
+			switch (part->get_type()) {
+			case sgl::geometry_type::POINT:
+			case sgl::geometry_type::LINESTRING: {
+				if (part->get_count() != 0) {
+					parts.push_back(part);
+				}
+			} break;
+			case sgl::geometry_type::POLYGON:
+			case sgl::geometry_type::MULTI_POINT:
+			case sgl::geometry_type::MULTI_LINESTRING:
+			case sgl::geometry_type::MULTI_POLYGON:
+			case sgl::geometry_type::MULTI_GEOMETRY: {
+				if (!part->is_empty()) {
+					part = part->get_first_part();
+					continue;
+				}
+			} break;
+			default:
+				throw InternalException("Unsupported geometry type in ST_Transform");
+			}
+
+			while (true) {
+				const auto parent = part->get_parent();
+				if (parent == root) {
+					return;
+				}
+				if (part != parent->get_last_part()) {
+					part = part->get_next();
+					break;
+				}
+				part = parent;
+			}
+		}
+	}
+
+	// If the CRS arguments are constant, we can gather the vertices of all geometries in the chunk and transform them
+	// with a single call to PROJ, instead of calling PROJ once per vertex.
+	static void ExecuteGeometryBatched(ProjFunctionLocalState &lstate, PJ *crs, Vector &input, Vector &result,
+	                                   idx_t count) {
+
+		const auto is_constant = input.GetVectorType() == VectorType::CONSTANT_VECTOR;
+		if (is_constant) {
+			count = 1;
+		}
+
+		UnifiedVectorFormat input_format;
+		input.ToUnifiedFormat(count, input_format);
+		const auto input_data = UnifiedVectorFormat::GetData<string_t>(input_format);
+
+		// Deserialize all geometries. The geometries are not moved after this, as the parts point to their parents
+		vector<sgl::geometry> geoms(count);
+		vector<sgl::geometry *> parts;
+
+		for (idx_t i = 0; i < count; i++) {
+			const auto row_idx = input_format.sel->get_index(i);
+			if (input_format.validity.RowIsValid(row_idx)) {
+				lstate.Deserialize(input_data[row_idx], geoms[i]);
+				CollectVertexParts(&geoms[i], parts);
+			}
+		}
+
+		idx_t vertex_count = 0;
+		for (const auto &part : parts) {
+			vertex_count += part->get_count();
+		}
+
+		lstate.x_buffer.resize(vertex_count);
+		lstate.y_buffer.resize(vertex_count);
+		lstate.z_buffer.resize(vertex_count);
+
+		// Gather the vertices
+		idx_t vertex_idx = 0;
+		for (const auto &part : parts) {
+			const auto vertex_size = part->get_vertex_size();
+			const auto vertex_data = part->get_vertex_data();
+
+			sgl::vertex_xyzm vertex = {0, 0, 0, 0};
+			for (uint32_t i = 0; i < part->get_count(); i++) {
+				memcpy(&vertex, vertex_data + i * vertex_size, vertex_size);
+				lstate.x_buffer[vertex_idx] = vertex.x;
+				lstate.y_buffer[vertex_idx] = vertex.y;
+				lstate.z_buffer[vertex_idx] = vertex.zm;
+				vertex_idx++;
+			}
+		}
+
+		lstate.TransformBuffers(crs, vertex_count);
+
+		// Scatter the transformed vertices back into new vertex arrays, the old ones may point into the input blobs
+		vertex_idx = 0;
+		for (const auto &part : parts) {
+			const auto vertex_size = part->get_vertex_size();
+			const auto vertex_count = part->get_count();
+			const auto old_vertex_data = part->get_vertex_data();
+			const auto new_vertex_data = static_cast<uint8_t *>(lstate.allocator.alloc(vertex_count * vertex_size));
+
+			memcpy(new_vertex_data, old_vertex_data, vertex_count * vertex_size);
+			for (uint32_t i = 0; i < vertex_count; i++) {
+				const auto vertex_ptr = new_vertex_data + i * vertex_size;
+				memcpy(vertex_ptr, &lstate.x_buffer[vertex_idx], sizeof(double));
+				memcpy(vertex_ptr + sizeof(double), &lstate.y_buffer[vertex_idx], sizeof(double));
+				vertex_idx++;
+			}
+			part->set_vertex_data(new_vertex_data, vertex_count);
+		}
+
+		// Serialize the results
+		const auto result_data = FlatVector::GetData<string_t>(result);
+		for (idx_t i = 0; i < count; i++) {
+			const auto row_idx = input_format.sel->get_index(i);
+			if (input_format.validity.RowIsValid(row_idx)) {
+				result_data[i] = lstate.Serialize(result, geoms[i]);
+			} else {
+				FlatVector::SetNull(result, i, true);
+			}
+		}
+
+		if (is_constant) {
+			result.SetVectorType(VectorType::CONSTANT_VECTOR);
+		}
+	}
+
 	//------------------------------------------------------------------------------------------------------------------
 	// Documentation
 	//------------------------------------------------------------------------------------------------------------------
@@ -3,8 +3,10 @@
 #include "spatial/geometry/sgl.hpp"
 #include "spatial/spatial_types.hpp"
 
+#include "duckdb/common/atomic.hpp"
 #include "duckdb/common/multi_file/multi_file_reader.hpp"
 #include "duckdb/function/replacement_scan.hpp"
+#include "duckdb/main/database.hpp"
 #include "duckdb/main/extension_util.hpp"
 #include "duckdb/parser/expression/constant_expression.hpp"
 #include "duckdb/parser/expression/function_expression.hpp"
@@ -14,6 +16,9 @@
 
 #include "shapefil.h"
 
+#include <algorithm>
+#include <condition_variable>
+
 void SASetupDefaultHooks(SAHooks *hooks) {
 	// Should never be called, use OpenLL and pass in the hooks
 	throw duckdb::InternalException("SASetupDefaultHooks");
@@ -257,6 +262,90 @@ SHPHandlePtr OpenSHPFile(FileSystem &fs, const string &filename) {
 	return SHPHandlePtr(handle);
 }
 
+// A SHP handle that shares the record index (loaded from the .shx) of another handle opened in read-only mode.
+// This lets every thread read records through its own file handle and read buffer, without every thread loading
+// the whole .shx into memory again. The handle it was opened from has to outlive it.
+struct SHPReaderDeleter {
+	void operator()(SHPInfo *info) const {
+		if (info) {
+			// The record index is owned by the handle it was shared from
+			info->panRecOffset = nullptr;
+			info->panRecSize = nullptr;
+			SHPClose(info);
+		}
+	}
+};
+using SHPReaderPtr = unique_ptr<SHPInfo, SHPReaderDeleter>;
+
+SHPReaderPtr OpenSHPReader(FileSystem &fs, const string &filename, const SHPInfo &source) {
+	// SHPClose frees the handle, so it has to be allocated the same way as shapelib does
+	const auto reader = static_cast<SHPInfo *>(calloc(1, sizeof(SHPInfo)));
+	if (!reader) {
+		throw OutOfMemoryException("Failed to allocate SHP reader for %s", filename);
+	}
+
+	reader->sHooks = GetDuckDBHooks(fs);
+	reader->fpSHP = reader->sHooks.FOpen(reader->sHooks.userData, filename.c_str(), "rb");
+	if (!reader->fpSHP) {
+		free(reader);
+		throw IOException("Failed to open SHP file %s", filename);
+	}
+
+	// The .shx is only read when opening in read-only mode, so it is safe to share the record index between readers
+	D_ASSERT(source.fpSHX == nullptr);
+	reader->nShapeType = source.nShapeType;
+	reader->nFileSize = source.nFileSize;
+	reader->nRecords = source.nRecords;
+	reader->nMaxRecords = source.nMaxRecords;
+	reader->panRecOffset = source.panRecOffset;
+	reader->panRecSize = source.panRecSize;
+	memcpy(reader->adBoundsMin, source.adBoundsMin, sizeof(source.adBoundsMin));
+	memcpy(reader->adBoundsMax, source.adBoundsMax, sizeof(source.adBoundsMax));
+
+	return SHPReaderPtr(reader);
+}
+
+// Search a .qix or .sbn spatial index for the ids of the records that might intersect the given bounds.
+// Returns false if there is no (readable) index, in which case all records have to be checked.
+bool TrySearchSpatialIndex(FileSystem &fs, const string &base_name, double min_bound[4], double max_bound[4],
+                           vector<int> &result) {
+	const auto hooks = GetDuckDBHooks(fs);
+
+	int count = 0;
+	int *ids = nullptr;
+
+	const auto qix_file = base_name + ".qix";
+	const auto sbn_file = base_name + ".sbn";
+
+	if (fs.FileExists(qix_file)) {
+		const auto tree = SHPOpenDiskTree(qix_file.c_str(), &hooks);
+		if (tree) {
+			ids = SHPSearchDiskTreeEx(tree, min_bound, max_bound, &count);
+			SHPCloseDiskTree(tree);
+			if (ids) {
+				result.assign(ids, ids + count);
+				free(ids);
+				return true;
+			}
+		}
+	}
+
+	if (fs.FileExists(sbn_file)) {
+		const auto tree = SBNOpenDiskTree(sbn_file.c_str(), &hooks);
+		if (tree) {
+			ids = SBNSearchDiskTree(tree, min_bound, max_bound, &count);
+			SBNCloseDiskTree(tree);
+			if (ids) {
+				result.assign(ids, ids + count);
+				SBNSearchFreeIds(ids);
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
 //######################################################################################################################
 // Table Functions
 //######################################################################################################################
@@ -273,68 +362,159 @@ struct ST_ReadSHP {
 	//------------------------------------------------------------------------------------------------------------------
 	// Bind
 	//------------------------------------------------------------------------------------------------------------------
+
+	// An attribute column, identified by the name of the DBF field and how many fields with the same name came before
+	// it in the same file (shapefiles can contain duplicate field names)
+	struct ShapefileAttribute {
+		string field_name;
+		idx_t occurrence;
+		LogicalType type;
+	};
+
 	struct ShapefileBindData final : TableFunctionData {
-		string file_name;
+		vector<string> files;
+
+		// The shape count and type of the first file
 		int shape_count;
 		int shape_type;
-		double min_bound[4];
-		double max_bound[4];
+
+		// The attribute columns come first, followed by the geometry and then the (optional) filename column
+		vector<ShapefileAttribute> attributes;
+		bool filename_column;
+		bool union_by_name;
+
+		// If not set, the encoding is determined per file from its .cpg file
+		bool has_attribute_encoding;
 		AttributeEncoding attribute_encoding;
-		vector<LogicalType> attribute_types;
 
-		explicit ShapefileBindData(string file_name_p)
-		    : file_name(std::move(file_name_p)), shape_count(0),
-		      shape_type(0), min_bound {0, 0, 0, 0}, max_bound {0, 0, 0, 0},
-		      attribute_encoding(AttributeEncoding::LATIN1) {
-		}
-	};
+		// Only return records whose bounding box intersects this box, if set
+		bool has_spatial_filter;
+		double filter_min[4];
+		double filter_max[4];
 
-	static unique_ptr<FunctionData> Bind(ClientContext &context, TableFunctionBindInput &input,
-	                                     vector<LogicalType> &return_types, vector<string> &names) {
+		ShapefileBindData()
+		    : shape_count(0), shape_type(0), filename_column(false), union_by_name(false),
+		      has_attribute_encoding(false), attribute_encoding(AttributeEncoding::LATIN1), has_spatial_filter(false),
+		      filter_min {0, 0, 0, 0}, filter_max {0, 0, 0, 0} {
+		}
 
-		auto file_name = StringValue::Get(input.inputs[0]);
-		auto result = make_uniq<ShapefileBindData>(file_name);
+		idx_t GeometryColumnIndex() const {
+			return attributes.size();
+		}
 
-		auto &fs = FileSystem::GetFileSystem(context);
-		auto shp_handle = OpenSHPFile(fs, file_name);
+		idx_t FilenameColumnIndex() const {
+			return attributes.size() + 1;
+		}
+	};
 
-		// Get info about the geometry
-		SHPGetInfo(shp_handle.get(), &result->shape_count, &result->shape_type, result->min_bound, result->max_bound);
+	static string GetBaseName(const string &file_name) {
+		return file_name.substr(0, file_name.find_last_of('.'));
+	}
 
-		// Ensure we have a supported shape type
+	static void ValidateShapeType(const string &file_name, int shape_type) {
 		auto valid_types = {SHPT_NULL, SHPT_POINT, SHPT_ARC, SHPT_POLYGON, SHPT_MULTIPOINT};
-		bool is_valid_type = false;
 		for (auto type : valid_types) {
-			if (result->shape_type == type) {
-				is_valid_type = true;
-				break;
+			if (shape_type == type) {
+				return;
 			}
 		}
-		if (!is_valid_type) {
-			throw InvalidInputException("Invalid shape type %d", result->shape_type);
-		}
-
-		auto base_name = file_name.substr(0, file_name.find_last_of('.'));
+		throw InvalidInputException("Invalid shape type %d in %s", shape_type, file_name);
+	}
 
+	static AttributeEncoding GetAttributeEncoding(FileSystem &fs, const string &base_name) {
 		// A standards compliant shapefile should use ISO-8859-1 encoding for attributes, but it can be overridden
 		// by a .cpg file. So check if there is a .cpg file, if so use that to determine the encoding
 		auto cpg_file = base_name + ".cpg";
-		if (fs.FileExists(cpg_file)) {
-			auto cpg_handle = fs.OpenFile(cpg_file, FileFlags::FILE_FLAGS_READ);
-			auto cpg_type = StringUtil::Lower(cpg_handle->ReadLine());
-			if (cpg_type == "utf-8") {
-				result->attribute_encoding = AttributeEncoding::UTF8;
-			} else if (cpg_type == "iso-8859-1") {
-				result->attribute_encoding = AttributeEncoding::LATIN1;
-			} else {
-				// Otherwise, parse as blob
-				result->attribute_encoding = AttributeEncoding::BLOB;
+		if (!fs.FileExists(cpg_file)) {
+			return AttributeEncoding::LATIN1;
+		}
+		auto cpg_handle = fs.OpenFile(cpg_file, FileFlags::FILE_FLAGS_READ);
+		auto cpg_type = StringUtil::Lower(cpg_handle->ReadLine());
+		if (cpg_type == "utf-8") {
+			return AttributeEncoding::UTF8;
+		}
+		if (cpg_type == "iso-8859-1") {
+			return AttributeEncoding::LATIN1;
+		}
+		// Otherwise, parse as blob
+		return AttributeEncoding::BLOB;
+	}
+
+	static LogicalType GetAttributeType(DBFHandle dbf_handle, int field_idx, AttributeEncoding encoding,
+	                                    char (&field_name)[12]) {
+		int field_width = 0;
+		int field_precision = 0;
+		memset(field_name, 0, sizeof(field_name));
+
+		auto field_type = DBFGetFieldInfo(dbf_handle, field_idx, field_name, &field_width, &field_precision);
+		switch (field_type) {
+		case FTString:
+			return encoding == AttributeEncoding::BLOB ? LogicalType::BLOB : LogicalType::VARCHAR;
+		case FTInteger:
+			return LogicalType::INTEGER;
+		case FTDouble:
+			if (field_precision == 0 && field_width < 19) {
+				return LogicalType::BIGINT;
 			}
+			return LogicalType::DOUBLE;
+		case FTDate:
+			// Dates are stored as 8-char strings
+			// YYYYMMDD
+			return LogicalType::DATE;
+		case FTLogical:
+			return LogicalType::BOOLEAN;
+		default:
+			throw InvalidInputException("DBF field type %d not supported", field_type);
+		}
+	}
+
+	// Call the callback with the attribute and its index in the DBF for every field of the file
+	template <class CALLBACK>
+	static void ForEachAttribute(DBFHandle dbf_handle, AttributeEncoding encoding, CALLBACK &&callback) {
+		case_insensitive_map_t<idx_t> occurrences;
+		char field_name[12]; // Max field name length is 11 + null terminator
+
+		auto field_count = DBFGetFieldCount(dbf_handle);
+		for (int i = 0; i < field_count; i++) {
+			ShapefileAttribute attribute;
+			attribute.type = GetAttributeType(dbf_handle, i, encoding, field_name);
+			attribute.field_name = field_name;
+			attribute.occurrence = occurrences[attribute.field_name]++;
+			callback(attribute, i);
+		}
+	}
+
+	static bool IsSameAttribute(const ShapefileAttribute &a, const ShapefileAttribute &b) {
+		return a.occurrence == b.occurrence && StringUtil::CIEquals(a.field_name, b.field_name);
+	}
+
+	static unique_ptr<FunctionData> Bind(ClientContext &context, TableFunctionBindInput &input,
+	                                     vector<LogicalType> &return_types, vector<string> &names) {
+
+		auto result = make_uniq<ShapefileBindData>();
+
+		auto multi_file_reader = MultiFileReader::Create(input.table_function);
+		auto file_list = multi_file_reader->CreateFileList(context, input.inputs[0]);
+		for (auto &file : file_list->Files()) {
+			result->files.push_back(file.path);
 		}
 
+		auto &fs = FileSystem::GetFileSystem(context);
+		auto &first_file = result->files[0];
+		auto shp_handle = OpenSHPFile(fs, first_file);
+
+		// Get info about the geometry
+		double min_bound[4];
+		double max_bound[4];
+		SHPGetInfo(shp_handle.get(), &result->shape_count, &result->shape_type, min_bound, max_bound);
+
+		// Ensure we have a supported shape type
+		ValidateShapeType(first_file, result->shape_type);
+
 		for (auto &kv : input.named_parameters) {
 			if (kv.first == "encoding") {
 				auto encoding = StringUtil::Lower(StringValue::Get(kv.second));
+				result->has_attribute_encoding = true;
 				if (encoding == "utf-8") {
 					result->attribute_encoding = AttributeEncoding::UTF8;
 				} else if (encoding == "iso-8859-1") {
@@ -349,63 +529,67 @@ struct ST_ReadSHP {
 				}
 			}
 			if (kv.first == "spatial_filter_box") {
-				auto filter_box = StructValue::GetChildren(kv.second);
+				auto &filter_box = StructValue::GetChildren(kv.second);
+				result->has_spatial_filter = true;
+				result->filter_min[0] = DoubleValue::Get(filter_box[0]);
+				result->filter_min[1] = DoubleValue::Get(filter_box[1]);
+				result->filter_max[0] = DoubleValue::Get(filter_box[2]);
+				result->filter_max[1] = DoubleValue::Get(filter_box[3]);
+			}
+			if (kv.first == "filename") {
+				result->filename_column = BooleanValue::Get(kv.second);
+			}
+			if (kv.first == "union_by_name") {
+				result->union_by_name = BooleanValue::Get(kv.second);
 			}
 		}
 
-		// Get info about the attributes
-		// Remove file extension and replace with .dbf
-		auto dbf_handle = OpenDBFFile(fs, base_name + ".dbf");
-
+		// String attributes are returned as BLOB if they are not decoded. Without an explicit encoding, this is the case
+		// if the .cpg file of any of the files has an encoding we don't know. The column type has to be the same for
+		// all files, so then the string attributes of the other files are returned as BLOB as well.
 		// TODO: Try to get the encoding from the dbf if there is no .cpg file
 		// auto code_page = DBFGetCodePage(dbf_handle.get());
 		// if(!has_cpg_file && code_page != 0) { }
-
-		// Then return the attributes
-		auto field_count = DBFGetFieldCount(dbf_handle.get());
-		char field_name[12]; // Max field name length is 11 + null terminator
-		int field_width = 0;
-		int field_precision = 0;
-		memset(field_name, 0, sizeof(field_name));
-
-		for (int i = 0; i < field_count; i++) {
-			auto field_type = DBFGetFieldInfo(dbf_handle.get(), i, field_name, &field_width, &field_precision);
-
-			LogicalType type;
-			switch (field_type) {
-			case FTString:
-				type = result->attribute_encoding == AttributeEncoding::BLOB ? LogicalType::BLOB : LogicalType::VARCHAR;
-				break;
-			case FTInteger:
-				type = LogicalType::INTEGER;
-				break;
-			case FTDouble:
-				if (field_precision == 0 && field_width < 19) {
-					type = LogicalType::BIGINT;
-				} else {
-					type = LogicalType::DOUBLE;
+		auto string_encoding = result->attribute_encoding;
+		if (!result->has_attribute_encoding) {
+			for (auto &file : result->files) {
+				string_encoding = GetAttributeEncoding(fs, GetBaseName(file));
+				if (string_encoding == AttributeEncoding::BLOB) {
+					break;
 				}
-				break;
-			case FTDate:
-				// Dates are stored as 8-char strings
-				// YYYYMMDD
-				type = LogicalType::DATE;
-				break;
-			case FTLogical:
-				type = LogicalType::BOOLEAN;
-				break;
-			default:
-				throw InvalidInputException("DBF field type %d not supported", field_type);
 			}
-			names.emplace_back(field_name);
-			return_types.push_back(type);
-			result->attribute_types.push_back(type);
 		}
 
-		// Always return geometry last
+		// Get info about the attributes. Unless we union by name, the first file determines the schema and the
+		// attributes of the other files are matched to it by name.
+		const auto schema_file_count = result->union_by_name ? result->files.size() : 1;
+		for (idx_t file_idx = 0; file_idx < schema_file_count; file_idx++) {
+			auto dbf_handle = OpenDBFFile(fs, GetBaseName(result->files[file_idx]) + ".dbf");
+			ForEachAttribute(dbf_handle.get(), string_encoding, [&](ShapefileAttribute &attribute, int) {
+				for (auto &existing : result->attributes) {
+					if (IsSameAttribute(existing, attribute)) {
+						existing.type = LogicalType::ForceMaxLogicalType(existing.type, attribute.type);
+						return;
+					}
+				}
+				result->attributes.push_back(std::move(attribute));
+			});
+		}
+
+		for (auto &attribute : result->attributes) {
+			names.push_back(attribute.field_name);
+			return_types.push_back(attribute.type);
+		}
+
+		// Always return geometry last (before the filename)
 		return_types.push_back(GeoTypes::GEOMETRY());
 		names.push_back("geom");
 
+		if (result->filename_column) {
+			return_types.push_back(LogicalType::VARCHAR);
+			names.push_back("filename");
+		}
+
 		// Deduplicate field names if necessary
 		for (size_t i = 0; i < names.size(); i++) {
 			idx_t count = 1;
@@ -422,32 +606,303 @@ struct ST_ReadSHP {
 	//------------------------------------------------------------------------------------------------------------------
 	// Init Global
 	//------------------------------------------------------------------------------------------------------------------
-	struct ShapefileGlobalState final : GlobalTableFunctionState {
-		int shape_idx;
+
+	// The number of records each thread claims at a time. A batch never produces more than one output chunk.
+	static constexpr idx_t BATCH_SIZE = STANDARD_VECTOR_SIZE;
+
+	// A file that is being scanned. Threads read its batches through their own readers.
+	struct ShapefileFileScan {
+		string file_name;
+		string shp_file_name;
+		string dbf_file_name;
+
+		// Owns the record index shared by the readers of all threads
 		SHPHandlePtr shp_handle;
-		DBFHandlePtr dbf_handle;
-		ArenaAllocator arena;
-		vector<idx_t> column_ids;
+		int shape_type;
+		AttributeEncoding attribute_encoding;
+
+		// The index of the field in the DBF of this file for every attribute column, or -1 if it is missing
+		vector<int> field_map;
+
+		// If the scan is filtered and the shapefile has a spatial index, only these records are read
+		bool has_candidates;
+		vector<int> candidates;
 
-		explicit ShapefileGlobalState(ClientContext &context, const string &file_name, vector<idx_t> column_ids_p)
-		    : shape_idx(0), arena(BufferAllocator::Get(context)), column_ids(std::move(column_ids_p)) {
+		idx_t record_count;
+		idx_t batch_count;
+		// The index of the first batch of this file across all files, set once its batches are handed out.
+		// Protected by the lock of the global state, like the next batch to hand out.
+		idx_t batch_offset;
+		idx_t next_batch;
+
+		ShapefileFileScan(ClientContext &context, const ShapefileBindData &bind_data, const string &file_name_p)
+		    : file_name(file_name_p), shape_type(0), attribute_encoding(bind_data.attribute_encoding),
+		      has_candidates(false), record_count(0), batch_count(0), batch_offset(DConstants::INVALID_INDEX),
+		      next_batch(0) {
 			auto &fs = FileSystem::GetFileSystem(context);
 
 			shp_handle = OpenSHPFile(fs, file_name);
 
+			int shape_count = 0;
+			double min_bound[4];
+			double max_bound[4];
+			SHPGetInfo(shp_handle.get(), &shape_count, &shape_type, min_bound, max_bound);
+			ValidateShapeType(file_name, shape_type);
+
 			// Remove file extension and replace with .dbf
-			auto dot_idx = file_name.find_last_of('.');
-			auto base_name = file_name.substr(0, dot_idx);
-			dbf_handle = OpenDBFFile(fs, base_name + ".dbf");
+			auto base_name = GetBaseName(file_name);
+			dbf_file_name = base_name + ".dbf";
+
+			// The readers open the .shp directly, so find out which file SHPOpenLL picked
+			shp_file_name = file_name;
+			for (auto &candidate : {file_name, base_name + ".shp", base_name + ".SHP"}) {
+				if (fs.FileExists(candidate)) {
+					shp_file_name = candidate;
+					break;
+				}
+			}
+
+			// String attributes of this file are only decoded if their column is a VARCHAR column, otherwise the raw
+			// bytes are returned as BLOB
+			if (!bind_data.has_attribute_encoding) {
+				attribute_encoding = GetAttributeEncoding(fs, base_name);
+			}
+
+			// Match the fields of this file to the attribute columns
+			field_map.resize(bind_data.attributes.size(), -1);
+			auto dbf_handle = OpenDBFFile(fs, dbf_file_name);
+			ForEachAttribute(dbf_handle.get(), attribute_encoding, [&](const ShapefileAttribute &attribute, int field_idx) {
+				for (idx_t attr_idx = 0; attr_idx < bind_data.attributes.size(); attr_idx++) {
+					if (IsSameAttribute(bind_data.attributes[attr_idx], attribute)) {
+						field_map[attr_idx] = field_idx;
+						return;
+					}
+				}
+			});
+
+			record_count = static_cast<idx_t>(shape_count);
+
+			if (bind_data.has_spatial_filter) {
+				double filter_min[4];
+				double filter_max[4];
+				memcpy(filter_min, bind_data.filter_min, sizeof(filter_min));
+				memcpy(filter_max, bind_data.filter_max, sizeof(filter_max));
+
+				if (TrySearchSpatialIndex(fs, base_name, filter_min, filter_max, candidates)) {
+					// Drop ids that are out of range, in case the index is out of date
+					candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+					                                [&](int id) { return id < 0 || id >= shape_count; }),
+					                 candidates.end());
+					has_candidates = true;
+					record_count = candidates.size();
+				}
+			}
+
+			batch_count = (record_count + BATCH_SIZE - 1) / BATCH_SIZE;
+		}
+
+		int GetRecordIndex(idx_t position) const {
+			return has_candidates ? candidates[position] : static_cast<int>(position);
+		}
+	};
+
+	struct ShapefileGlobalState final : GlobalTableFunctionState {
+		mutex lock;
+		std::condition_variable file_opened;
+
+		// The files that have been opened, but whose batches have not all been handed out yet. Threads that have no
+		// batch to claim open the upcoming files outside of the lock, but the batches are handed out in file order, so
+		// the batch indices keep increasing across files.
+		vector<shared_ptr<ShapefileFileScan>> files;
+		// The file batches are currently handed out from, and the next file to open
+		idx_t current_file_idx;
+		idx_t next_open_idx;
+		idx_t next_batch_offset;
+		idx_t max_threads;
+		// The number of files that may be open at once, as they keep their record index in memory
+		idx_t max_open_files;
+		bool failed;
+
+		// The number of files batches have been handed out from, and the fraction of batches handed out of the last
+		atomic<idx_t> files_started;
+		atomic<double> file_progress;
+
+		vector<idx_t> column_ids;
+		SerdeFormat format;
+
+		explicit ShapefileGlobalState(ClientContext &context, idx_t file_count, vector<idx_t> column_ids_p)
+		    : files(file_count), current_file_idx(0), next_open_idx(0), next_batch_offset(0), max_threads(1),
+		      max_open_files(1), failed(false), files_started(0), file_progress(0), column_ids(std::move(column_ids_p)),
+		      format(SerdeFormat::Get(context)) {
+		}
+
+		// Claim the next batch, opening the next file if the current one is exhausted.
+		// Returns false once all batches of all files have been claimed.
+		bool ClaimBatch(ClientContext &context, const ShapefileBindData &bind_data,
+		                shared_ptr<ShapefileFileScan> &file, idx_t &batch_idx) {
+			unique_lock<mutex> guard(lock);
+			while (!failed && current_file_idx < files.size()) {
+				auto &current = files[current_file_idx];
+				if (!current) {
+					// The file is not open yet. Open it, or an upcoming file if another thread is already opening it.
+					if (next_open_idx < files.size() && next_open_idx < current_file_idx + max_open_files) {
+						OpenFile(context, bind_data, guard);
+					} else {
+						file_opened.wait(guard);
+					}
+					continue;
+				}
+
+				if (current->batch_offset == DConstants::INVALID_INDEX) {
+					// Start handing out the batches of the file
+					current->batch_offset = next_batch_offset;
+					next_batch_offset += current->batch_count;
+					file_progress = current->batch_count == 0 ? 1.0 : 0.0;
+					files_started++;
+				}
+
+				if (current->next_batch < current->batch_count) {
+					file = current;
+					batch_idx = current->next_batch++;
+					file_progress = static_cast<double>(current->next_batch) / static_cast<double>(file->batch_count);
+					return true;
+				}
+
+				// The file is exhausted, the threads still reading its batches keep it alive
+				current = nullptr;
+				current_file_idx++;
+			}
+			return false;
+		}
+
+		// Open the next file without holding the lock, and publish it once it is open
+		void OpenFile(ClientContext &context, const ShapefileBindData &bind_data, unique_lock<mutex> &guard) {
+			const auto file_idx = next_open_idx++;
+			guard.unlock();
+
+			shared_ptr<ShapefileFileScan> file;
+			try {
+				file = make_shared_ptr<ShapefileFileScan>(context, bind_data, bind_data.files[file_idx]);
+			} catch (...) {
+				// Dont leave the other threads waiting for the file
+				guard.lock();
+				failed = true;
+				file_opened.notify_all();
+				throw;
+			}
+
+			guard.lock();
+			files[file_idx] = std::move(file);
+			file_opened.notify_all();
+		}
+
+		idx_t MaxThreads() const override {
+			return max_threads;
 		}
 	};
 
 	static unique_ptr<GlobalTableFunctionState> InitGlobal(ClientContext &context, TableFunctionInitInput &input) {
 		auto &bind_data = input.bind_data->Cast<ShapefileBindData>();
-		auto result = make_uniq<ShapefileGlobalState>(context, bind_data.file_name, input.column_ids);
+		auto result = make_uniq<ShapefileGlobalState>(context, bind_data.files.size(), input.column_ids);
+
+		// Open the first file up front, so that we know how many threads it can keep busy
+		result->files[0] = make_shared_ptr<ShapefileFileScan>(context, bind_data, bind_data.files[0]);
+		result->next_open_idx = 1;
+		result->max_open_files = MaxValue<idx_t>(context.db->NumberOfThreads(), 1);
+
+		const auto first_batch_count = result->files[0]->batch_count;
+		if (bind_data.files.size() == 1) {
+			result->max_threads = MaxValue<idx_t>(first_batch_count, 1);
+		} else {
+			result->max_threads = MaxValue<idx_t>(first_batch_count, bind_data.files.size());
+		}
+
 		return std::move(result);
 	}
 
+	//------------------------------------------------------------------------------------------------------------------
+	// Init Local
+	//------------------------------------------------------------------------------------------------------------------
+	struct ShapefileLocalState final : LocalTableFunctionState {
+		// The file the readers are opened on
+		shared_ptr<ShapefileFileScan> file;
+		SHPReaderPtr shp_handle;
+		DBFHandlePtr dbf_handle;
+		ArenaAllocator arena;
+
+		// The batch the current output chunk was read from, and the records in it that passed the filter
+		idx_t batch_idx;
+		vector<int> record_ids;
+
+		explicit ShapefileLocalState(ClientContext &context) : arena(BufferAllocator::Get(context)), batch_idx(0) {
+			record_ids.reserve(BATCH_SIZE);
+		}
+
+		void OpenFile(ClientContext &context, shared_ptr<ShapefileFileScan> file_p) {
+			// The reader shares the record index of the file, so close it before letting go of the file
+			shp_handle.reset();
+			dbf_handle.reset();
+			file = std::move(file_p);
+
+			auto &fs = FileSystem::GetFileSystem(context);
+			shp_handle = OpenSHPReader(fs, file->shp_file_name, *file->shp_handle);
+			dbf_handle = OpenDBFFile(fs, file->dbf_file_name);
+		}
+	};
+
+	static unique_ptr<LocalTableFunctionState> InitLocal(ExecutionContext &context, TableFunctionInitInput &input,
+	                                                     GlobalTableFunctionState *global_state) {
+		return make_uniq<ShapefileLocalState>(context.client);
+	}
+
+	//------------------------------------------------------------------------------------------------------------------
+	// Spatial Filter
+	//------------------------------------------------------------------------------------------------------------------
+
+	// Check if the bounding box of a record intersects the filter box. The bounding box (or the coordinates, for
+	// points) is stored right after the shape type in the record, so this avoids reading and parsing the whole record.
+	// Null shapes never intersect the filter box.
+	static bool RecordIntersectsFilter(SHPInfo &shp_handle, int record_idx, const ShapefileBindData &bind_data) {
+		// The shape type followed by either 4 doubles for the bounding box, or 2 doubles for a point
+		data_t buffer[4 + sizeof(double) * 4];
+
+		const auto record_size = shp_handle.panRecSize[record_idx];
+		const auto read_size = MinValue<idx_t>(sizeof(buffer), record_size);
+
+		// If the record is malformed, let the reader deal with it
+		auto &hooks = shp_handle.sHooks;
+		if (read_size < 4 || hooks.FSeek(shp_handle.fpSHP, shp_handle.panRecOffset[record_idx] + 8, 0) != 0 ||
+		    hooks.FRead(buffer, 1, read_size, shp_handle.fpSHP) != read_size) {
+			return true;
+		}
+
+		// Shapefiles are always little-endian
+		const auto shape_type = Load<int32_t>(buffer);
+		if (shape_type == SHPT_NULL) {
+			return false;
+		}
+
+		double min_x, min_y, max_x, max_y;
+		if (shape_type == SHPT_POINT || shape_type == SHPT_POINTZ || shape_type == SHPT_POINTM) {
+			if (read_size < 4 + sizeof(double) * 2) {
+				return true;
+			}
+			min_x = max_x = Load<double>(buffer + 4);
+			min_y = max_y = Load<double>(buffer + 4 + sizeof(double));
+		} else {
+			if (read_size < 4 + sizeof(double) * 4) {
+				return true;
+			}
+			min_x = Load<double>(buffer + 4);
+			min_y = Load<double>(buffer + 4 + sizeof(double));
+			max_x = Load<double>(buffer + 4 + sizeof(double) * 2);
+			max_y = Load<double>(buffer + 4 + sizeof(double) * 3);
+		}
+
+		return !(max_x < bind_data.filter_min[0] || min_x > bind_data.filter_max[0] ||
+		         max_y < bind_data.filter_min[1] || min_y > bind_data.filter_max[1]);
+	}
+
 	//------------------------------------------------------------------------------------------------------------------
 	// Geometry Conversion
 	//------------------------------------------------------------------------------------------------------------------
@@ -632,10 +1087,10 @@ struct ST_ReadSHP {
 	};
 
 	template <class OP>
-	static void ConvertGeomLoop(Vector &result, int record_start, idx_t count, SHPHandle &shp_handle,
-	                            ArenaAllocator &arena) {
+	static void ConvertGeomLoop(Vector &result, const int *record_ids, idx_t count, SHPHandle &shp_handle,
+	                            ArenaAllocator &arena, const SerdeFormat &format) {
 		for (idx_t result_idx = 0; result_idx < count; result_idx++) {
-			auto shape = SHPObjectPtr(SHPReadObject(shp_handle, record_start++));
+			auto shape = SHPObjectPtr(SHPReadObject(shp_handle, record_ids[result_idx]));
 			if (shape->nSHPType == SHPT_NULL) {
 				FlatVector::SetNull(result, result_idx, true);
 				continue;
@@ -646,9 +1101,9 @@ struct ST_ReadSHP {
 			OP::Convert(geom, shape, arena);
 
 			// Serialize into a blob
-			const auto size = Serde::GetRequiredSize(geom);
+			const auto size = Serde::GetRequiredSize(geom, format);
 			auto blob = StringVector::EmptyString(result, size);
-			Serde::Serialize(geom, blob.GetDataWriteable(), size);
+			Serde::Serialize(geom, format, blob.GetDataWriteable(), size);
 			blob.Finalize();
 
 			// Set the blob in the result vector
@@ -656,23 +1111,23 @@ struct ST_ReadSHP {
 		}
 	}
 
-	static void ConvertGeometryVector(Vector &result, int record_start, idx_t count, SHPHandle shp_handle,
-	                                  ArenaAllocator &arena, int geom_type) {
+	static void ConvertGeometryVector(Vector &result, const int *record_ids, idx_t count, SHPHandle shp_handle,
+	                                  ArenaAllocator &arena, const SerdeFormat &format, int geom_type) {
 		switch (geom_type) {
 		case SHPT_NULL:
 			FlatVector::Validity(result).SetAllInvalid(count);
 			break;
 		case SHPT_POINT:
-			ConvertGeomLoop<ConvertPoint>(result, record_start, count, shp_handle, arena);
+			ConvertGeomLoop<ConvertPoint>(result, record_ids, count, shp_handle, arena, format);
 			break;
 		case SHPT_ARC:
-			ConvertGeomLoop<ConvertLineString>(result, record_start, count, shp_handle, arena);
+			ConvertGeomLoop<ConvertLineString>(result, record_ids, count, shp_handle, arena, format);
 			break;
 		case SHPT_POLYGON:
-			ConvertGeomLoop<ConvertPolygon>(result, record_start, count, shp_handle, arena);
+			ConvertGeomLoop<ConvertPolygon>(result, record_ids, count, shp_handle, arena, format);
 			break;
 		case SHPT_MULTIPOINT:
-			ConvertGeomLoop<ConvertMultiPoint>(result, record_start, count, shp_handle, arena);
+			ConvertGeomLoop<ConvertMultiPoint>(result, record_ids, count, shp_handle, arena, format);
 			break;
 		default:
 			throw InvalidInputException("Shape type %d not supported", geom_type);
@@ -737,25 +1192,24 @@ struct ST_ReadSHP {
 	};
 
 	template <class OP>
-	static void ConvertAttributeLoop(Vector &result, int record_start, idx_t count, DBFHandle dbf_handle,
+	static void ConvertAttributeLoop(Vector &result, const int *record_ids, idx_t count, DBFHandle dbf_handle,
 	                                 int field_idx) {
-		int record_idx = record_start;
 		for (idx_t row_idx = 0; row_idx < count; row_idx++) {
+			const auto record_idx = record_ids[row_idx];
 			if (DBFIsAttributeNULL(dbf_handle, record_idx, field_idx)) {
 				FlatVector::SetNull(result, row_idx, true);
 			} else {
 				FlatVector::GetData<typename OP::TYPE>(result)[row_idx] =
 				    OP::Convert(result, dbf_handle, record_idx, field_idx);
 			}
-			record_idx++;
 		}
 	}
 
-	static void ConvertStringAttributeLoop(Vector &result, int record_start, idx_t count, DBFHandle dbf_handle,
+	static void ConvertStringAttributeLoop(Vector &result, const int *record_ids, idx_t count, DBFHandle dbf_handle,
 	                                       int field_idx, AttributeEncoding attribute_encoding) {
-		int record_idx = record_start;
 		vector<data_t> conversion_buffer;
 		for (idx_t row_idx = 0; row_idx < count; row_idx++) {
+			const auto record_idx = record_ids[row_idx];
 			if (DBFIsAttributeNULL(dbf_handle, record_idx, field_idx)) {
 				FlatVector::SetNull(result, row_idx, true);
 			} else {
@@ -776,33 +1230,32 @@ struct ST_ReadSHP {
 				}
 				FlatVector::GetData<string_t>(result)[row_idx] = result_str;
 			}
-			record_idx++;
 		}
 	}
 
-	static void ConvertAttributeVector(Vector &result, int record_start, idx_t count, DBFHandle dbf_handle,
+	static void ConvertAttributeVector(Vector &result, const int *record_ids, idx_t count, DBFHandle dbf_handle,
 	                                   int field_idx, AttributeEncoding attribute_encoding) {
 		switch (result.GetType().id()) {
 		case LogicalTypeId::BLOB:
-			ConvertAttributeLoop<ConvertBlobAttribute>(result, record_start, count, dbf_handle, field_idx);
+			ConvertAttributeLoop<ConvertBlobAttribute>(result, record_ids, count, dbf_handle, field_idx);
 			break;
 		case LogicalTypeId::VARCHAR:
-			ConvertStringAttributeLoop(result, record_start, count, dbf_handle, field_idx, attribute_encoding);
+			ConvertStringAttributeLoop(result, record_ids, count, dbf_handle, field_idx, attribute_encoding);
 			break;
 		case LogicalTypeId::INTEGER:
-			ConvertAttributeLoop<ConvertIntegerAttribute>(result, record_start, count, dbf_handle, field_idx);
+			ConvertAttributeLoop<ConvertIntegerAttribute>(result, record_ids, count, dbf_handle, field_idx);
 			break;
 		case LogicalTypeId::BIGINT:
-			ConvertAttributeLoop<ConvertBigIntAttribute>(result, record_start, count, dbf_handle, field_idx);
+			ConvertAttributeLoop<ConvertBigIntAttribute>(result, record_ids, count, dbf_handle, field_idx);
 			break;
 		case LogicalTypeId::DOUBLE:
-			ConvertAttributeLoop<ConvertDoubleAttribute>(result, record_start, count, dbf_handle, field_idx);
+			ConvertAttributeLoop<ConvertDoubleAttribute>(result, record_ids, count, dbf_handle, field_idx);
 			break;
 		case LogicalTypeId::DATE:
-			ConvertAttributeLoop<ConvertDateAttribute>(result, record_start, count, dbf_handle, field_idx);
+			ConvertAttributeLoop<ConvertDateAttribute>(result, record_ids, count, dbf_handle, field_idx);
 			break;
 		case LogicalTypeId::BOOLEAN:
-			ConvertAttributeLoop<ConvertBooleanAttribute>(result, record_start, count, dbf_handle, field_idx);
+			ConvertAttributeLoop<ConvertBooleanAttribute>(result, record_ids, count, dbf_handle, field_idx);
 			break;
 		default:
 			throw InvalidInputException("Attribute type %s not supported", result.GetType().ToString());
@@ -816,38 +1269,76 @@ struct ST_ReadSHP {
 	static void Execute(ClientContext &context, TableFunctionInput &input, DataChunk &output) {
 		auto &bind_data = input.bind_data->Cast<ShapefileBindData>();
 		auto &gstate = input.global_state->Cast<ShapefileGlobalState>();
+		auto &lstate = input.local_state->Cast<ShapefileLocalState>();
 
 		// Reset the buffer allocator
-		gstate.arena.Reset();
+		lstate.arena.Reset();
+
+		// Claim batches until we find one with records that pass the filter
+		auto &record_ids = lstate.record_ids;
+		record_ids.clear();
+		while (record_ids.empty()) {
+			shared_ptr<ShapefileFileScan> file;
+			idx_t batch_idx;
+			if (!gstate.ClaimBatch(context, bind_data, file, batch_idx)) {
+				output.SetCardinality(0);
+				return;
+			}
+			if (file != lstate.file) {
+				lstate.OpenFile(context, std::move(file));
+			}
 
-		// Calculate how many record we can fit in the output
-		const auto output_size = std::min<int>(STANDARD_VECTOR_SIZE, bind_data.shape_count - gstate.shape_idx);
-		const auto record_start = gstate.shape_idx;
+			const auto &current = *lstate.file;
+			const auto batch_start = batch_idx * BATCH_SIZE;
+			const auto batch_end = MinValue(batch_start + BATCH_SIZE, current.record_count);
+			for (auto position = batch_start; position < batch_end; position++) {
+				const auto record_idx = current.GetRecordIndex(position);
+				if (bind_data.has_spatial_filter &&
+				    !RecordIntersectsFilter(*lstate.shp_handle, record_idx, bind_data)) {
+					continue;
+				}
+				record_ids.push_back(record_idx);
+			}
+			lstate.batch_idx = current.batch_offset + batch_idx;
+		}
+
+		const auto &file = *lstate.file;
+		const auto output_size = record_ids.size();
 		for (idx_t col_idx = 0; col_idx < output.ColumnCount(); col_idx++) {
 
 			// Projected column indices
 			const auto projected_col_idx = gstate.column_ids[col_idx];
 
 			auto &col_vec = output.data[col_idx];
-			if (col_vec.GetType() == GeoTypes::GEOMETRY()) {
-				ConvertGeometryVector(col_vec, record_start, output_size, gstate.shp_handle.get(), gstate.arena,
-				                      bind_data.shape_type);
+			if (projected_col_idx < bind_data.attributes.size()) {
+				const auto field_idx = file.field_map[projected_col_idx];
+				if (field_idx < 0) {
+					// This file does not have the attribute
+					col_vec.SetVectorType(VectorType::CONSTANT_VECTOR);
+					ConstantVector::SetNull(col_vec, true);
+					continue;
+				}
+				ConvertAttributeVector(col_vec, record_ids.data(), output_size, lstate.dbf_handle.get(), field_idx,
+				                       file.attribute_encoding);
+			} else if (projected_col_idx == bind_data.GeometryColumnIndex()) {
+				ConvertGeometryVector(col_vec, record_ids.data(), output_size, lstate.shp_handle.get(), lstate.arena,
+				                      gstate.format, file.shape_type);
+			} else if (bind_data.filename_column && projected_col_idx == bind_data.FilenameColumnIndex()) {
+				col_vec.SetVectorType(VectorType::CONSTANT_VECTOR);
+				ConstantVector::GetData<string_t>(col_vec)[0] = StringVector::AddString(col_vec, file.file_name);
 			} else {
-				// The geometry is always last, so we can use the projected column index directly
-				const auto field_idx = static_cast<int>(projected_col_idx);
-				ConvertAttributeVector(col_vec, record_start, output_size, gstate.dbf_handle.get(), field_idx,
-				                       bind_data.attribute_encoding);
+				// e.g. the row id, when no columns are projected
+				col_vec.SetVectorType(VectorType::CONSTANT_VECTOR);
+				ConstantVector::SetNull(col_vec, true);
 			}
 		}
-		// Update the shape index
-		gstate.shape_idx += output_size;
 
 		// Set the cardinality of the output
 		output.SetCardinality(output_size);
 	}
 
 	//------------------------------------------------------------------------------------------------------------------
-	// Progress, Cardinality and Replacement Scans
+	// Progress, Partitioning, Cardinality and Replacement Scans
 	//------------------------------------------------------------------------------------------------------------------
 
 	static double GetProgress(ClientContext &context, const FunctionData *bind_data_p,
@@ -856,16 +1347,35 @@ struct ST_ReadSHP {
 		auto &gstate = global_state->Cast<ShapefileGlobalState>();
 		auto &bind_data = bind_data_p->Cast<ShapefileBindData>();
 
-		return static_cast<double>(gstate.shape_idx) / static_cast<double>(bind_data.shape_count);
+		const auto files_started = gstate.files_started.load();
+		if (files_started == 0) {
+			return 0;
+		}
+		const auto files_done = static_cast<double>(files_started - 1) + gstate.file_progress.load();
+		return 100.0 * files_done / static_cast<double>(bind_data.files.size());
+	}
+
+	static OperatorPartitionData GetPartitionData(ClientContext &context, TableFunctionGetPartitionInput &input) {
+		if (input.partition_info.RequiresPartitionColumns()) {
+			throw InternalException("ST_ReadSHP::GetPartitionData: partition columns not supported");
+		}
+		auto &lstate = input.local_state->Cast<ShapefileLocalState>();
+		return OperatorPartitionData(lstate.batch_idx);
 	}
 
 	static unique_ptr<NodeStatistics> GetCardinality(ClientContext &context, const FunctionData *data) {
 		auto &bind_data = data->Cast<ShapefileBindData>();
 		auto result = make_uniq<NodeStatistics>();
 
-		// This is the maximum number of shapes in a single file
-		result->has_max_cardinality = true;
-		result->max_cardinality = bind_data.shape_count;
+		if (bind_data.files.size() == 1) {
+			// This is the maximum number of shapes in a single file
+			result->has_max_cardinality = true;
+			result->max_cardinality = bind_data.shape_count;
+		} else {
+			// Assume the other files are about as large as the first one
+			result->has_estimated_cardinality = true;
+			result->estimated_cardinality = bind_data.shape_count * bind_data.files.size();
+		}
 
 		return result;
 	}
@@ -889,13 +1399,17 @@ struct ST_ReadSHP {
 	// Register
 	//------------------------------------------------------------------------------------------------------------------
 	static void Register(DatabaseInstance &db) {
-		TableFunction read_func("ST_ReadSHP", {LogicalType::VARCHAR}, Execute, Bind, InitGlobal);
+		TableFunction read_func("ST_ReadSHP", {LogicalType::VARCHAR}, Execute, Bind, InitGlobal, InitLocal);
 
 		read_func.named_parameters["encoding"] = LogicalType::VARCHAR;
+		read_func.named_parameters["spatial_filter_box"] = GeoTypes::BOX_2D();
+		read_func.named_parameters["filename"] = LogicalType::BOOLEAN;
+		read_func.named_parameters["union_by_name"] = LogicalType::BOOLEAN;
 		read_func.table_scan_progress = GetProgress;
+		read_func.get_partition_data = GetPartitionData;
 		read_func.cardinality = GetCardinality;
 		read_func.projection_pushdown = true;
-		ExtensionUtil::RegisterFunction(db, read_func);
+		ExtensionUtil::RegisterFunction(db, MultiFileReader::CreateFunctionSet(read_func));
 
 		// Replacement scan
 		auto &config = DBConfig::GetConfig(db);
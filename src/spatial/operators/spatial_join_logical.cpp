@@ -1,6 +1,7 @@
 #include "spatial_join_logical.hpp"
 #include "spatial_join_physical.hpp"
 
+#include "duckdb/planner/expression/bound_comparison_expression.hpp"
 #include "duckdb/planner/expression/bound_function_expression.hpp"
 #include "duckdb/planner/operator/logical_filter.hpp"
 #include "duckdb/execution/column_binding_resolver.hpp"
@@ -12,6 +13,13 @@ namespace duckdb {
 LogicalSpatialJoin::LogicalSpatialJoin(JoinType join_type_p) : join_type(join_type_p) {
 }
 
+BoundFunctionExpression &LogicalSpatialJoin::GetKeyFunction(Expression &predicate) {
+	if (predicate.GetExpressionClass() == ExpressionClass::BOUND_COMPARISON) {
+		return predicate.Cast<BoundComparisonExpression>().left->Cast<BoundFunctionExpression>();
+	}
+	return predicate.Cast<BoundFunctionExpression>();
+}
+
 vector<ColumnBinding> LogicalSpatialJoin::GetColumnBindings() {
 	auto left_bindings = MapBindings(children[0]->GetColumnBindings(), left_projection_map);
 	if (join_type == JoinType::SEMI || join_type == JoinType::ANTI) {
@@ -35,15 +43,30 @@ vector<ColumnBinding> LogicalSpatialJoin::GetColumnBindings() {
 
 void LogicalSpatialJoin::ResolveColumnBindings(ColumnBindingResolver &res, vector<ColumnBinding> &bindings) {
 
-	auto &cond = spatial_predicate->Cast<BoundFunctionExpression>();
+	auto &cond = GetKeyFunction(*spatial_predicate);
 
 	res.VisitOperator(*children[0]);
 	res.VisitExpression(&cond.children[0]);
+	for (auto &equality : equality_conditions) {
+		res.VisitExpression(&equality.left);
+	}
+	auto left_bindings = bindings;
 
 	// TODO: Duplicate eliminated joins?
 
 	res.VisitOperator(*children[1]);
 	res.VisitExpression(&cond.children[1]);
+	for (auto &equality : equality_conditions) {
+		res.VisitExpression(&equality.right);
+	}
+
+	// The extra conditions are evaluated on the columns of both sides
+	auto right_bindings = bindings;
+	bindings = std::move(left_bindings);
+	bindings.insert(bindings.end(), right_bindings.begin(), right_bindings.end());
+	for (auto &extra_condition : extra_conditions) {
+		res.VisitExpression(&extra_condition);
+	}
 
 	// Finally, update the bindings
 	bindings = GetColumnBindings();
@@ -75,8 +98,9 @@ PhysicalOperator& LogicalSpatialJoin::CreatePlan(ClientContext &context, Physica
 	auto &left = generator.CreatePlan(*children[0]);
 	auto &right = generator.CreatePlan(*children[1]);
 
-	return generator.Make<PhysicalSpatialJoin>(
-	    *this, left, right, std::move(spatial_predicate), join_type, estimated_cardinality);
+	return generator.Make<PhysicalSpatialJoin>(*this, left, right, std::move(spatial_predicate),
+	                                           std::move(equality_conditions), std::move(extra_conditions), join_type,
+	                                           distance, estimated_cardinality);
 }
 
 void LogicalSpatialJoin::Serialize(Serializer &writer) const {
@@ -89,6 +113,8 @@ void LogicalSpatialJoin::Serialize(Serializer &writer) const {
 	writer.WritePropertyWithDefault<vector<idx_t>>(403, "right_projection_map", right_projection_map);
 	writer.WritePropertyWithDefault<unique_ptr<Expression>>(404, "spatial_predicate", spatial_predicate);
 	writer.WritePropertyWithDefault<vector<unique_ptr<Expression>>>(405, "extra_conditions", extra_conditions);
+	writer.WritePropertyWithDefault<double>(406, "distance", distance, 0);
+	writer.WritePropertyWithDefault<vector<JoinCondition>>(407, "equality_conditions", equality_conditions);
 }
 
 unique_ptr<LogicalExtensionOperator> LogicalSpatialJoin::Deserialize(Deserializer &reader) {
@@ -98,6 +124,8 @@ unique_ptr<LogicalExtensionOperator> LogicalSpatialJoin::Deserialize(Deserialize
 	auto right_projection_map = reader.ReadPropertyWithDefault<vector<idx_t>>(403, "right_projection_map");
 	auto spatial_predicate = reader.ReadPropertyWithDefault<unique_ptr<Expression>>(404, "spatial_predicate");
 	auto extra_conditions = reader.ReadPropertyWithDefault<vector<unique_ptr<Expression>>>(405, "extra_conditions");
+	auto distance = reader.ReadPropertyWithExplicitDefault<double>(406, "distance", 0);
+	auto equality_conditions = reader.ReadPropertyWithDefault<vector<JoinCondition>>(407, "equality_conditions");
 
 	auto result = make_uniq<LogicalSpatialJoin>(join_type);
 	result->mark_index = mark_index;
@@ -105,6 +133,8 @@ unique_ptr<LogicalExtensionOperator> LogicalSpatialJoin::Deserialize(Deserialize
 	result->right_projection_map = std::move(right_projection_map);
 	result->spatial_predicate = std::move(spatial_predicate);
 	result->extra_conditions = std::move(extra_conditions);
+	result->distance = distance;
+	result->equality_conditions = std::move(equality_conditions);
 
 	return std::move(result);
 }
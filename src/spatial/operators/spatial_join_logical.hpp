@@ -1,9 +1,12 @@
 #pragma once
 
 #include "duckdb/planner/operator/logical_extension_operator.hpp"
+#include "duckdb/planner/joinside.hpp"
 
 namespace duckdb {
 
+class BoundFunctionExpression;
+
 class LogicalSpatialJoin final : public LogicalExtensionOperator {
 public:
 	static constexpr auto TYPE = LogicalOperatorType::LOGICAL_EXTENSION_OPERATOR;
@@ -17,8 +20,15 @@ public:
 
 	//! The spatial predicate of the join
 	unique_ptr<Expression> spatial_predicate;
+	//! The distance to grow the build side bounding boxes by (for ST_DWithin and ST_Distance predicates)
+	double distance = 0;
+
+	//! Equality conditions between the two sides. The build side is indexed by a separate R-Tree per key value.
+	vector<JoinCondition> equality_conditions;
 
-	//! Extra conditions to be applied after the join, e.g. for filtering
+	//! Extra conditions, evaluated on every pair that satisfies the spatial predicate.
+	//! These reference the columns of both children, the columns of the RHS following the columns of the LHS.
+	//! This includes the equality conditions too, as the R-Trees are only keyed on the hash of the key values.
 	vector<unique_ptr<Expression>> extra_conditions;
 
 	//! The columns of the LHS that are output by the join
@@ -31,6 +41,10 @@ public:
 public:
 	explicit LogicalSpatialJoin(JoinType join_type_p);
 
+	//! Returns the function whose first two arguments are the probe and build side join keys of the predicate.
+	//! This is the predicate itself, or the ST_Distance function in an "ST_Distance(a, b) < r" comparison.
+	static BoundFunctionExpression &GetKeyFunction(Expression &predicate);
+
 	vector<ColumnBinding> GetColumnBindings() override;
 
 	void ResolveColumnBindings(ColumnBindingResolver &res, vector<ColumnBinding> &bindings) override;
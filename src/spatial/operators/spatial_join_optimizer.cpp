@@ -1,11 +1,16 @@
 #include "spatial_join_optimizer.hpp"
 
 #include "duckdb/main/database.hpp"
+#include "duckdb/planner/expression/bound_comparison_expression.hpp"
+#include "duckdb/planner/expression/bound_constant_expression.hpp"
 #include "duckdb/planner/expression/bound_function_expression.hpp"
 #include "duckdb/planner/operator/logical_any_join.hpp"
+#include "duckdb/planner/operator/logical_comparison_join.hpp"
 #include "spatial_join_logical.hpp"
+#include "spatial/spatial_types.hpp"
 
 #include "duckdb/catalog/catalog_entry/scalar_function_catalog_entry.hpp"
+#include "duckdb/execution/expression_executor.hpp"
 #include "duckdb/planner/operator/logical_filter.hpp"
 
 namespace duckdb {
@@ -56,72 +61,167 @@ unique_ptr<Expression> TryGetInversePredicate(ClientContext &context, unique_ptr
 	                                                           nullptr, func.is_operator);
 }
 
-static void InsertSpatialJoin(OptimizerExtensionInput &input, unique_ptr<LogicalOperator> &plan) {
-	auto &op = *plan;
+static bool IsGeometryFunction(const Expression &expr, const char *name, idx_t arg_count) {
+	if (expr.GetExpressionClass() != ExpressionClass::BOUND_FUNCTION) {
+		return false;
+	}
+	auto &func = expr.Cast<BoundFunctionExpression>();
+	if (!StringUtil::CIEquals(func.function.name, name) || func.children.size() != arg_count) {
+		return false;
+	}
+	return func.children[0]->return_type == GeoTypes::GEOMETRY() &&
+	       func.children[1]->return_type == GeoTypes::GEOMETRY();
+}
 
-	// We only care about ANY_JOIN operators
-	if (op.type != LogicalOperatorType::LOGICAL_ANY_JOIN) {
-		return;
+// Distance predicates imply bounding box intersection once the bounding boxes of one side are grown by the distance.
+// We support ST_DWithin(a, b, r) and ST_Distance(a, b) < r (or <=), as long as the distance r is a constant.
+// On success, the expression is normalized so that the join keys are the first two arguments of the function
+// returned by LogicalSpatialJoin::GetKeyFunction, the distance is folded into a constant and returned in "distance".
+static bool TryGetDistancePredicate(ClientContext &context, unique_ptr<Expression> &expr,
+                                    const unordered_set<idx_t> &left_bindings,
+                                    const unordered_set<idx_t> &right_bindings, double &distance) {
+	optional_ptr<BoundFunctionExpression> key_func;
+	optional_ptr<unique_ptr<Expression>> distance_expr;
+
+	if (IsGeometryFunction(*expr, "ST_DWithin", 3)) {
+		auto &func = expr->Cast<BoundFunctionExpression>();
+		key_func = &func;
+		distance_expr = &func.children[2];
+	} else if (expr->GetExpressionClass() == ExpressionClass::BOUND_COMPARISON) {
+		auto &comp = expr->Cast<BoundComparisonExpression>();
+		if (IsGeometryFunction(*comp.right, "ST_Distance", 2)) {
+			// Normalize "r > ST_Distance(a, b)" to "ST_Distance(a, b) < r"
+			std::swap(comp.left, comp.right);
+			comp.type = FlipComparisonExpression(comp.type);
+		}
+		if (comp.type != ExpressionType::COMPARE_LESSTHAN && comp.type != ExpressionType::COMPARE_LESSTHANOREQUALTO) {
+			return false;
+		}
+		if (!IsGeometryFunction(*comp.left, "ST_Distance", 2)) {
+			return false;
+		}
+		key_func = &comp.left->Cast<BoundFunctionExpression>();
+		distance_expr = &comp.right;
+	} else {
+		return false;
 	}
 
-	auto &any_join = op.Cast<LogicalAnyJoin>();
+	// The distance has to be a constant
+	if (!(*distance_expr)->IsFoldable()) {
+		return false;
+	}
 
-	// We also only support simple join types
-	auto join_supported = false;
-	switch (any_join.join_type) {
-	case JoinType::INNER:
-	case JoinType::LEFT:
-	case JoinType::RIGHT:
-	case JoinType::OUTER:
-		join_supported = true;
-		break;
-	default:
-		break;
+	// The keys have to reference one side each
+	const auto left_side = JoinSide::GetJoinSide(*key_func->children[0], left_bindings, right_bindings);
+	const auto right_side = JoinSide::GetJoinSide(*key_func->children[1], left_bindings, right_bindings);
+	const auto is_normal = left_side == JoinSide::LEFT && right_side == JoinSide::RIGHT;
+	const auto is_flipped = left_side == JoinSide::RIGHT && right_side == JoinSide::LEFT;
+	if (!is_normal && !is_flipped) {
+		return false;
 	}
-	if (!join_supported) {
-		return;
+
+	Value distance_val;
+	if (!ExpressionExecutor::TryEvaluateScalar(context, **distance_expr, distance_val) || distance_val.IsNull()) {
+		return false;
+	}
+	Value distance_dbl;
+	if (!distance_val.DefaultTryCastAs(LogicalType::DOUBLE, distance_dbl, nullptr) || distance_dbl.IsNull()) {
+		return false;
+	}
+	const auto distance_raw = DoubleValue::Get(distance_dbl);
+	if (!Value::IsFinite(distance_raw) || distance_raw < 0) {
+		// Nothing can be within a negative distance, leave that to the regular join
+		return false;
 	}
 
-	// Inspect the join condition
-	vector<unique_ptr<Expression>> expressions;
-	expressions.push_back(any_join.condition->Copy()); // TODO: Maybe move instead of copy
+	// Both distance functions are symmetric, so we can just swap the arguments
+	if (is_flipped) {
+		std::swap(key_func->children[0], key_func->children[1]);
+	}
 
-	// Split by AND
-	LogicalFilter::SplitPredicates(expressions);
+	// Fold the distance expression, so that it does not have to be evaluated again for every candidate pair
+	*distance_expr = make_uniq<BoundConstantExpression>(distance_val);
+	distance = distance_raw;
+	return true;
+}
 
-	// Get the table indexes that are reachable from the left and right children
-	auto &left_child = any_join.children[0];
-	auto &right_child = any_join.children[1];
-	unordered_set<idx_t> left_bindings;
-	unordered_set<idx_t> right_bindings;
-	LogicalJoin::GetTableReferences(*left_child, left_bindings);
-	LogicalJoin::GetTableReferences(*right_child, right_bindings);
+// Equality conditions between the two sides are used to split the build side, so that the spatial predicate is only
+// evaluated on pairs with the same key. On success, the keys are copied into "conditions", with the LHS key first.
+static bool TryGetEqualityCondition(const Expression &expr, const unordered_set<idx_t> &left_bindings,
+                                    const unordered_set<idx_t> &right_bindings, vector<JoinCondition> &conditions) {
+	if (expr.type != ExpressionType::COMPARE_EQUAL) {
+		return false;
+	}
 
-	// TODO: Only support a single predicate for now
-	if (expressions.size() != 1) {
-		return;
+	auto &comp = expr.Cast<BoundComparisonExpression>();
+	const auto left_side = JoinSide::GetJoinSide(*comp.left, left_bindings, right_bindings);
+	const auto right_side = JoinSide::GetJoinSide(*comp.right, left_bindings, right_bindings);
+
+	JoinCondition condition;
+	if (left_side == JoinSide::LEFT && right_side == JoinSide::RIGHT) {
+		condition.left = comp.left->Copy();
+		condition.right = comp.right->Copy();
+	} else if (left_side == JoinSide::RIGHT && right_side == JoinSide::LEFT) {
+		condition.left = comp.right->Copy();
+		condition.right = comp.left->Copy();
+	} else {
+		return false;
 	}
+	condition.comparison = ExpressionType::COMPARE_EQUAL;
+	conditions.push_back(std::move(condition));
+	return true;
+}
 
-	// TODO: This whole logic is a work in progress.
-	// it does a bunch of extra work trying to separate the predicates, which doesnt matter because we only support
-	// a single join condition for now anyway
+// Try to turn the conjuncts of a join condition into a spatial join between the two children.
+// Returns nullptr if none of them is a spatial predicate that we can index the build side by.
+static unique_ptr<LogicalSpatialJoin> TryCreateSpatialJoin(ClientContext &context, JoinType join_type,
+                                                           LogicalOperator &left_child, LogicalOperator &right_child,
+                                                           vector<unique_ptr<Expression>> expressions) {
+	// Get the table indexes that are reachable from the left and right children
+	unordered_set<idx_t> left_bindings;
+	unordered_set<idx_t> right_bindings;
+	LogicalJoin::GetTableReferences(left_child, left_bindings);
+	LogicalJoin::GetTableReferences(right_child, right_bindings);
 
 	// The spatial join condition
 	unique_ptr<Expression> spatial_pred_expr = nullptr;
+	// The distance to grow the build side bounding boxes by, for distance joins
+	double distance = 0;
 
-	// Extra predicates that are not spatial predicates
+	// Equality conditions between the two sides, used to key the build side
+	vector<JoinCondition> equality_conditions;
+
+	// Extra predicates that are evaluated on every pair that satisfies the spatial predicate
 	vector<unique_ptr<Expression>> extra_predicates;
 
-	// Now, check each expression to see if it contains a spatial predicate
+	// Now, check each expression to see if it contains a spatial predicate.
+	// Only the first spatial predicate is used to index the build side, any others are extra predicates.
 	for (auto &expr : expressions) {
 		auto total_side = JoinSide::GetJoinSide(*expr, left_bindings, right_bindings);
 
 		if (total_side != JoinSide::BOTH) {
-			// Throw?. No, push down the filter
+			// This only references one side, so just evaluate it on the pairs
+			extra_predicates.push_back(std::move(expr));
+			continue;
+		}
+
+		if (TryGetEqualityCondition(*expr, left_bindings, right_bindings, equality_conditions)) {
+			// We still have to check the keys, the build side is only partitioned on their hash
 			extra_predicates.push_back(std::move(expr));
 			continue;
 		}
 
+		if (spatial_pred_expr) {
+			extra_predicates.push_back(std::move(expr));
+			continue;
+		}
+
+		// Check if the expression is a distance predicate
+		if (TryGetDistancePredicate(context, expr, left_bindings, right_bindings, distance)) {
+			spatial_pred_expr = std::move(expr);
+			continue;
+		}
+
 		// Check if the expression is a spatial predicate
 		if (expr->type != ExpressionType::BOUND_FUNCTION) {
 			extra_predicates.push_back(std::move(expr));
@@ -146,11 +246,13 @@ static void InsertSpatialJoin(OptimizerExtensionInput &input, unique_ptr<Logical
 		}
 
 		if (left_side == JoinSide::RIGHT) {
-			expr = TryGetInversePredicate(input.context, std::move(expr));
-			if (expr == nullptr) {
-				// We cant flip this, abort!
-				return;
+			auto inverse_expr = TryGetInversePredicate(context, expr->Copy());
+			if (inverse_expr == nullptr) {
+				// We cant flip this, but maybe one of the other predicates works
+				extra_predicates.push_back(std::move(expr));
+				continue;
 			}
+			expr = std::move(inverse_expr);
 		}
 
 		spatial_pred_expr = std::move(expr);
@@ -158,17 +260,61 @@ static void InsertSpatialJoin(OptimizerExtensionInput &input, unique_ptr<Logical
 
 	// Nope! No spatial predicate found
 	if (!spatial_pred_expr) {
+		return nullptr;
+	}
+
+	// Cool, now we have spatial join conditions. Proceed to create a new LogicalSpatialJoin operator
+	auto spatial_join = make_uniq<LogicalSpatialJoin>(join_type);
+	spatial_join->spatial_predicate = std::move(spatial_pred_expr);
+	spatial_join->distance = distance;
+	spatial_join->equality_conditions = std::move(equality_conditions);
+	spatial_join->extra_conditions = std::move(extra_predicates);
+	return spatial_join;
+}
+
+static void InsertSpatialJoin(OptimizerExtensionInput &input, unique_ptr<LogicalOperator> &plan) {
+	auto &op = *plan;
+
+	// We only care about ANY_JOIN operators
+	if (op.type != LogicalOperatorType::LOGICAL_ANY_JOIN) {
 		return;
 	}
 
-	// TODO: Push a filter for the extra conditions?
+	auto &any_join = op.Cast<LogicalAnyJoin>();
 
-	// Cool, now we have spatial join conditions. Proceed to create a new LogicalSpatialJoin operator
-	auto spatial_join = make_uniq<LogicalSpatialJoin>(any_join.join_type);
+	// We also only support simple join types
+	auto join_supported = false;
+	switch (any_join.join_type) {
+	case JoinType::INNER:
+	case JoinType::LEFT:
+	case JoinType::RIGHT:
+	case JoinType::OUTER:
+	case JoinType::SEMI:
+	case JoinType::ANTI:
+	case JoinType::MARK:
+		join_supported = true;
+		break;
+	default:
+		break;
+	}
+	if (!join_supported) {
+		return;
+	}
+
+	// Inspect the join condition
+	vector<unique_ptr<Expression>> expressions;
+	expressions.push_back(any_join.condition->Copy()); // TODO: Maybe move instead of copy
+
+	// Split by AND
+	LogicalFilter::SplitPredicates(expressions);
+
+	auto spatial_join = TryCreateSpatialJoin(input.context, any_join.join_type, *any_join.children[0],
+	                                         *any_join.children[1], std::move(expressions));
+	if (!spatial_join) {
+		return;
+	}
 
 	// Steal the properties from the any join
-	spatial_join->spatial_predicate = std::move(spatial_pred_expr);
-	spatial_join->extra_conditions = std::move(extra_predicates);
 	spatial_join->children = std::move(any_join.children);
 	spatial_join->expressions = std::move(any_join.expressions);
 	spatial_join->types = std::move(any_join.types);
@@ -183,9 +329,58 @@ static void InsertSpatialJoin(OptimizerExtensionInput &input, unique_ptr<Logical
 	plan = std::move(spatial_join);
 }
 
+// Inner joins with equality conditions are planned as a hash join, with the rest of the join condition in a filter
+// on top. If the filter has a spatial predicate, replace both with a spatial join keyed on the equality conditions,
+// so that the spatial predicate is only evaluated on the pairs that are close, and not on every pair with equal keys.
+static void InsertKeyedSpatialJoin(OptimizerExtensionInput &input, unique_ptr<LogicalOperator> &plan) {
+	if (plan->type != LogicalOperatorType::LOGICAL_FILTER) {
+		return;
+	}
+
+	auto &filter = plan->Cast<LogicalFilter>();
+	if (!filter.projection_map.empty() || filter.children[0]->type != LogicalOperatorType::LOGICAL_COMPARISON_JOIN) {
+		return;
+	}
+
+	auto &comp_join = filter.children[0]->Cast<LogicalComparisonJoin>();
+	if (comp_join.join_type != JoinType::INNER) {
+		return;
+	}
+
+	// The join condition is the conjunction of the filter and the join conditions
+	vector<unique_ptr<Expression>> expressions;
+	for (auto &expr : filter.expressions) {
+		expressions.push_back(expr->Copy());
+	}
+	LogicalFilter::SplitPredicates(expressions);
+	for (auto &cond : comp_join.conditions) {
+		expressions.push_back(
+		    make_uniq<BoundComparisonExpression>(cond.comparison, cond.left->Copy(), cond.right->Copy()));
+	}
+
+	auto spatial_join = TryCreateSpatialJoin(input.context, JoinType::INNER, *comp_join.children[0],
+	                                         *comp_join.children[1], std::move(expressions));
+	if (!spatial_join) {
+		return;
+	}
+
+	// Steal the properties from the comparison join
+	spatial_join->children = std::move(comp_join.children);
+	spatial_join->types = std::move(comp_join.types);
+	spatial_join->left_projection_map = std::move(comp_join.left_projection_map);
+	spatial_join->right_projection_map = std::move(comp_join.right_projection_map);
+	spatial_join->join_stats = std::move(comp_join.join_stats);
+	spatial_join->has_estimated_cardinality = filter.has_estimated_cardinality;
+	spatial_join->estimated_cardinality = filter.estimated_cardinality;
+
+	// Replace the filter and the join
+	plan = std::move(spatial_join);
+}
+
 static void TryInsertSpatialJoin(OptimizerExtensionInput &input, unique_ptr<LogicalOperator> &plan) {
 
 	InsertSpatialJoin(input, plan);
+	InsertKeyedSpatialJoin(input, plan);
 
 	// Recursively call this function on all children
 	for (auto &child : plan->children) {
@@ -2,13 +2,27 @@
 #include "spatial/geometry/geometry_type.hpp"
 #include "spatial/geometry/sgl.hpp"
 #include "spatial/spatial_types.hpp"
+#include "spatial/util/math.hpp"
 #include "spatial_join_logical.hpp"
 
+#if SPATIAL_USE_GEOS
+#include "spatial/modules/geos/geos_prepared_cache.hpp"
+#endif
+
+#include "duckdb/common/bit_utils.hpp"
+#include "duckdb/common/types/column/column_data_collection.hpp"
 #include "duckdb/common/types/row/tuple_data_collection.hpp"
 #include "duckdb/common/types/row/tuple_data_iterator.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/common/vector_operations/vector_operations.hpp"
+#include "duckdb/planner/expression/bound_conjunction_expression.hpp"
 #include "duckdb/planner/expression/bound_function_expression.hpp"
 #include "duckdb/planner/expression/bound_reference_expression.hpp"
+#include "duckdb/planner/expression_iterator.hpp"
 #include "duckdb/execution/operator/join/physical_comparison_join.hpp"
+#include "duckdb/main/client_config.hpp"
+#include "duckdb/parallel/base_pipeline_event.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
 #include "duckdb/storage/buffer_manager.hpp"
 
 namespace duckdb {
@@ -57,24 +71,113 @@ public:
 	}
 
 public:
+	// The tree is searched depth first, so the stack never holds more than node_size entries per layer
+	static constexpr idx_t MAX_STACK_SIZE = 256;
+
 	Vector matches;
 	idx_t matches_count = 0;
 	idx_t matches_idx = 0;
 
 private:
-	queue<size_t> search_queue;
+	size_t search_stack[MAX_STACK_SIZE];
+	idx_t search_stack_size = 0;
 	Box search_box;
 	size_t entry_beg = 0;
 	size_t entry_pos = 0;
 	bool exhausted = true;
 };
 
+// Searches the tree for a batch of probe boxes at once. Every node is visited once for the whole batch instead of once
+// per box, and only compared with the boxes that intersect its parent. The batch is filled in by the caller.
+class FlatRTreeBatchScanState {
+	friend class FlatRTree;
+	using Box = Box2D<float>;
+
+public:
+	explicit FlatRTreeBatchScanState() : matches(LogicalType::POINTER) {
+	}
+
+public:
+	static constexpr idx_t MAX_BATCH_SIZE = 64;
+
+	// The boxes to search for, and the probe side row of each
+	Box probe_boxes[MAX_BATCH_SIZE];
+	uint32_t probe_rows[MAX_BATCH_SIZE];
+	idx_t probe_count = 0;
+
+	// The build side rows found, and the probe side row each was found for
+	Vector matches;
+	uint32_t match_rows[STANDARD_VECTOR_SIZE];
+	idx_t matches_count = 0;
+	idx_t matches_idx = 0;
+
+private:
+	// A node to search, and the probe boxes that intersect it (one bit per box)
+	struct StackEntry {
+		size_t node;
+		uint64_t mask;
+	};
+
+	StackEntry search_stack[FlatRTreeScanState::MAX_STACK_SIZE];
+	idx_t search_stack_size = 0;
+	size_t entry_beg = 0;
+	size_t entry_pos = 0;
+	uint64_t node_mask = 0;
+
+	// The leaf entry that did not fit in the previous scan, and the probe boxes it has yet to be paired with
+	data_ptr_t pending_row = nullptr;
+	uint64_t pending_mask = 0;
+	bool exhausted = true;
+};
+
+// Maps the center of a box to its position on a hilbert curve covering the given bounds
+class HilbertEncoder {
+public:
+	using Box = Box2D<float>;
+
+	HilbertEncoder() = default;
+
+	explicit HilbertEncoder(const Box &bounds_p) : bounds(bounds_p) {
+		constexpr auto max_hilbert = std::numeric_limits<uint16_t>::max();
+		const auto bounds_width = bounds.max.x - bounds.min.x;
+		const auto bounds_height = bounds.max.y - bounds.min.y;
+		scale_x = bounds_width > 0 ? max_hilbert / bounds_width : 0;
+		scale_y = bounds_height > 0 ? max_hilbert / bounds_height : 0;
+	}
+
+	uint32_t Encode(const Box &box) const {
+		if (box.min.x > box.max.x) {
+			// This is the box of a NULL or empty geometry, which never intersects anything. Sort it last.
+			return NumericLimits<uint32_t>::Maximum();
+		}
+
+		const auto hx = static_cast<uint32_t>(scale_x * ((box.min.x + box.max.x) / 2 - bounds.min.x));
+		const auto hy = static_cast<uint32_t>(scale_y * ((box.min.y + box.max.y) / 2 - bounds.min.y));
+
+		return sgl::util::hilbert_encode(16, hx, hy);
+	}
+
+private:
+	Box bounds;
+	float scale_x = 0;
+	float scale_y = 0;
+};
+
+struct FlatRTreeSortEntry {
+	uint32_t key;
+	uint32_t idx;
+
+	bool operator<(const FlatRTreeSortEntry &other) const {
+		return key < other.key || (key == other.key && idx < other.idx);
+	}
+};
+
 class FlatRTree {
 public:
 	using Box = Box2D<float>;
 
-	FlatRTree(Allocator &alloc, uint32_t item_count_p, uint32_t node_size_p)
-	    : item_count(item_count_p), node_size(node_size_p) {
+	FlatRTree(Allocator &alloc_p, uint32_t item_count_p, uint32_t node_size_p)
+	    : alloc(alloc_p), item_count(item_count_p), node_size(node_size_p) {
 
 		uint32_t count = item_count;
 		uint32_t nodes = item_count;
@@ -91,6 +194,8 @@ public:
 			layer_bounds.push_back(nodes);
 		} while (count > 1);
 
+		D_ASSERT(layer_bounds.size() * node_size <= FlatRTreeScanState::MAX_STACK_SIZE);
+
 		box_array_mem = alloc.Allocate(sizeof(Box) * nodes);
 		idx_array_mem = alloc.Allocate(sizeof(uint32_t) * nodes);
 		row_array_mem = alloc.Allocate(sizeof(data_ptr_t) * item_count);
@@ -113,6 +218,14 @@ public:
 		return item_count;
 	}
 
+	const Box &GetBox(idx_t idx) const {
+		return box_array[idx];
+	}
+
+	const Box &GetBounds() const {
+		return tree_box;
+	}
+
 	// Return insertion index
 	uint32_t Push(const Box &box, data_ptr_t row) {
 		// Push the index and the box
@@ -128,94 +241,100 @@ public:
 		return current_position++;
 	}
 
-	void Sort(vector<uint32_t> &curve) {
-		Sort(curve, 0, curve.size() - 1);
+	// Compute the hilbert curve key of the center of a box, relative to the bounds of the whole tree
+	uint32_t GetHilbertKey(const Box &box) const {
+		return hilbert.Encode(box);
 	}
 
-	void Sort(vector<uint32_t> &curve, size_t l_idx, size_t r_idx) {
-		if (l_idx < r_idx) {
-			const auto pivot = curve[(l_idx + r_idx) >> 1];
-			auto pivot_l = l_idx - 1;
-			auto pivot_r = r_idx + 1;
-
-			while (true) {
-				do {
-					++pivot_l;
-				} while (curve[pivot_l] < pivot);
-				do {
-					--pivot_r;
-				} while (curve[pivot_r] > pivot);
-
-				if (pivot_l >= pivot_r) {
-					break;
-				}
+	// The leaves only have to be sorted if there is more than one leaf node
+	bool NeedsSort() const {
+		return item_count > node_size;
+	}
 
-				// Reorder the curve, boxes and indices
-				// TODO: Pass callback here and make static
-				std::swap(curve[pivot_l], curve[pivot_r]);
-				std::swap(box_array[pivot_l], box_array[pivot_r]);
-				std::swap(idx_array[pivot_l], idx_array[pivot_r]);
-			}
+	// Prepare to sort the leaves, must be called once all boxes have been pushed
+	void InitSort() {
+		hilbert = HilbertEncoder(tree_box);
 
-			Sort(curve, l_idx, pivot_r);
-			Sort(curve, pivot_r + 1, r_idx);
-		}
+		sorted_box_mem = alloc.Allocate(sizeof(Box) * box_array.size());
+		sorted_idx_mem = alloc.Allocate(sizeof(uint32_t) * idx_array.size());
 	}
 
-	void Build() {
-		D_ASSERT(item_count == current_position);
+	// Move the leaves in the range [beg, end) of the sorted entries to their sorted position.
+	// Ranges can be permuted in parallel, as long as they dont overlap.
+	void Permute(const FlatRTreeSortEntry *entries, idx_t beg, idx_t end) {
+		const auto sorted_box = reinterpret_cast<Box *>(sorted_box_mem.get());
+		const auto sorted_idx = reinterpret_cast<uint32_t *>(sorted_idx_mem.get());
 
-		if (item_count <= node_size) {
-			box_array[current_position++] = tree_box;
-			return;
+		for (idx_t pos = beg; pos < end; pos++) {
+			const auto src = entries[pos].idx;
+			sorted_box[pos] = box_array[src];
+			sorted_idx[pos] = idx_array[src];
 		}
+	}
 
-		// Generate hilbert curve values
-		// TODO: Parallelize this with tasks when the number of items is large?
-		constexpr auto max_hilbert = std::numeric_limits<uint16_t>::max();
-		const auto hw = max_hilbert / (tree_box.max.x - tree_box.min.x);
-		const auto hh = max_hilbert / (tree_box.max.y - tree_box.min.y);
-
-		vector<uint32_t> curve(item_count);
-		for (idx_t i = 0; i < item_count; i++) {
-			const auto &node_box = box_array[i];
-
-			const auto hx = static_cast<uint32_t>(hw * ((node_box.min.x + node_box.max.x) / 2 - tree_box.min.x));
-			const auto hy = static_cast<uint32_t>(hh * ((node_box.min.y + node_box.max.y) / 2 - tree_box.min.y));
-
-			curve[i] = sgl::util::hilbert_encode(16, hx, hy);
-		}
+	// Swap in the sorted leaves, once all of them have been permuted
+	void FinishSort() {
+		std::swap(box_array_mem, sorted_box_mem);
+		std::swap(idx_array_mem, sorted_idx_mem);
+		sorted_box_mem.Reset();
+		sorted_idx_mem.Reset();
 
-		// Now, sort the indices based on their curve value
-		Sort(curve);
+		box_array.set(reinterpret_cast<Box *>(box_array_mem.get()), box_array.size());
+		idx_array.set(reinterpret_cast<uint32_t *>(idx_array_mem.get()), idx_array.size());
+	}
 
-		size_t layer_idx = 0;
-		size_t entry_idx = 0;
+	// The number of layers that need a layer of parent nodes above them
+	idx_t GetLayerCount() const {
+		return layer_bounds.size() - 1;
+	}
 
-		while (layer_idx < layer_bounds.size() - 1) {
-			const auto entry_end = layer_bounds[layer_idx];
+	// The number of parent nodes above a layer
+	idx_t GetParentCount(idx_t layer_idx) const {
+		return layer_bounds[layer_idx + 1] - layer_bounds[layer_idx];
+	}
 
-			while (entry_idx < entry_end) {
-				auto node_idx = entry_idx;
-				auto node_box = box_array[entry_idx];
+	// Pack the parent nodes in the range [parent_beg, parent_end) above a layer.
+	// Ranges of the same layer can be packed in parallel, but the layer below has to be packed first.
+	void PackLayer(idx_t layer_idx, idx_t parent_beg, idx_t parent_end) {
+		const auto entry_beg = layer_idx == 0 ? 0 : layer_bounds[layer_idx - 1];
+		const auto entry_end = layer_bounds[layer_idx];
 
-				size_t child_idx = 0;
-				while (child_idx < node_size && entry_idx < entry_end) {
+		for (idx_t parent_idx = parent_beg; parent_idx < parent_end; parent_idx++) {
+			const auto child_beg = entry_beg + parent_idx * node_size;
+			const auto child_end = MinValue<idx_t>(child_beg + node_size, entry_end);
 
-					node_box.Union(box_array[entry_idx]);
+			auto node_box = box_array[child_beg];
+			for (idx_t child_idx = child_beg + 1; child_idx < child_end; child_idx++) {
+				node_box.Union(box_array[child_idx]);
+			}
 
-					child_idx++;
-					entry_idx++;
-				}
+			// Add a new parent node
+			idx_array[entry_end + parent_idx] = UnsafeNumericCast<uint32_t>(child_beg);
+			box_array[entry_end + parent_idx] = node_box;
+		}
+	}
 
-				// Add a new parent node
-				idx_array[current_position] = node_idx;
-				box_array[current_position] = node_box;
-				current_position++;
+	// Build the tree on a single thread. See the SpatialJoinKeyEvent for the parallel build.
+	void Build() {
+		if (NeedsSort()) {
+			InitSort();
+
+			// Sort the leaves by their hilbert curve value. Break ties by insertion order to keep the result the same
+			// as the parallel build.
+			vector<FlatRTreeSortEntry> entries(item_count);
+			for (uint32_t i = 0; i < item_count; i++) {
+				entries[i].key = GetHilbertKey(box_array[i]);
+				entries[i].idx = i;
 			}
+			std::sort(entries.begin(), entries.end());
+
+			Permute(entries.data(), 0, item_count);
+			FinishSort();
+		}
 
-			// Go to the next layer
-			layer_idx++;
+		// Pack the layers bottom up
+		for (idx_t layer_idx = 0; layer_idx < GetLayerCount(); layer_idx++) {
+			PackLayer(layer_idx, 0, GetParentCount(layer_idx));
 		}
 	}
 
@@ -228,9 +347,7 @@ public:
 	}
 
 	void InitScan(FlatRTreeScanState &state, const Box &box) const {
-		while (!state.search_queue.empty()) {
-			state.search_queue.pop();
-		}
+		state.search_stack_size = 0;
 		state.search_box = box;
 		state.entry_beg = box_array.size() - 1;
 		state.entry_pos = state.entry_beg;
@@ -275,7 +392,8 @@ public:
 
 				if (state.entry_beg >= item_count) {
 					// Internal node
-					state.search_queue.push(idx_array[state.entry_pos]);
+					D_ASSERT(state.search_stack_size < FlatRTreeScanState::MAX_STACK_SIZE);
+					state.search_stack[state.search_stack_size++] = idx_array[state.entry_pos];
 				} else {
 					// Leaf node
 					yield = callback(row_array[idx_array[state.entry_pos]]);
@@ -289,19 +407,102 @@ public:
 				}
 			}
 
-			if (state.search_queue.empty()) {
+			if (state.search_stack_size == 0) {
 				// There is no more nodes to search, return false!
 				state.exhausted = true;
 				return;
 			}
 
-			state.entry_beg = state.search_queue.front();
+			state.entry_beg = state.search_stack[--state.search_stack_size];
 			state.entry_pos = state.entry_beg;
-			state.search_queue.pop();
 		}
 	}
 
+	void InitBatchScan(FlatRTreeBatchScanState &state) const {
+		D_ASSERT(state.probe_count > 0 && state.probe_count <= FlatRTreeBatchScanState::MAX_BATCH_SIZE);
+		state.search_stack_size = 0;
+		state.entry_beg = box_array.size() - 1;
+		state.entry_pos = state.entry_beg;
+		state.node_mask = state.probe_count == FlatRTreeBatchScanState::MAX_BATCH_SIZE ? ~0ULL : (1ULL << state.probe_count) - 1;
+		state.pending_mask = 0;
+
+		state.exhausted = false;
+		state.matches_idx = 0;
+		state.matches_count = 0;
+	}
+
+	bool BatchScan(FlatRTreeBatchScanState &state) const {
+		if (state.exhausted) {
+			return false;
+		}
+
+		idx_t count = 0;
+		const auto ptr = FlatVector::GetData<data_ptr_t>(state.matches);
+
+		while (true) {
+			// Pair the current leaf entry with every probe box it intersects, until the result is full
+			while (state.pending_mask != 0) {
+				if (count == STANDARD_VECTOR_SIZE) {
+					// Yield!, there might be more rows
+					state.matches_count = count;
+					state.matches_idx = 0;
+					return true;
+				}
+				const auto probe_idx = CountZeros<uint64_t>::Trailing(state.pending_mask);
+				state.pending_mask &= state.pending_mask - 1;
+				ptr[count] = state.pending_row;
+				state.match_rows[count] = state.probe_rows[probe_idx];
+				count++;
+			}
+
+			const auto entry_end = std::min(state.entry_beg + node_size, UpperBound(state.entry_beg));
+
+			if (state.entry_pos < entry_end) {
+				// Only compare the entry with the probe boxes that intersect its node
+				const auto &entry_box = box_array[state.entry_pos];
+				uint64_t mask = 0;
+				for (auto bits = state.node_mask; bits != 0; bits &= bits - 1) {
+					const auto probe_idx = CountZeros<uint64_t>::Trailing(bits);
+					if (state.probe_boxes[probe_idx].Intersects(entry_box)) {
+						mask |= 1ULL << probe_idx;
+					}
+				}
+
+				if (mask != 0) {
+					if (state.entry_beg >= item_count) {
+						// Internal node
+						D_ASSERT(state.search_stack_size < FlatRTreeScanState::MAX_STACK_SIZE);
+						state.search_stack[state.search_stack_size++] = {idx_array[state.entry_pos], mask};
+					} else {
+						// Leaf node
+						state.pending_row = row_array[idx_array[state.entry_pos]];
+						state.pending_mask = mask;
+					}
+				}
+
+				state.entry_pos++;
+				continue;
+			}
+
+			if (state.search_stack_size == 0) {
+				// There is no more nodes to search
+				state.exhausted = true;
+				break;
+			}
+
+			const auto &next = state.search_stack[--state.search_stack_size];
+			state.entry_beg = next.node;
+			state.entry_pos = next.node;
+			state.node_mask = next.mask;
+		}
+
+		state.matches_count = count;
+		state.matches_idx = 0;
+		return count > 0;
+	}
+
 private:
+	Allocator &alloc;
 	vector<uint32_t> layer_bounds;
 
 	AllocatedData box_array_mem;
@@ -312,7 +513,12 @@ private:
 	typed_view<Box> box_array;
 	typed_view<data_ptr_t> row_array;
 
+	// The leaves are permuted into these while sorting
+	AllocatedData sorted_box_mem;
+	AllocatedData sorted_idx_mem;
+
 	Box tree_box;
+	HilbertEncoder hilbert;
 
 	uint32_t item_count = 0;
 	uint32_t node_size = 0;
@@ -327,14 +533,16 @@ private:
 
 PhysicalSpatialJoin::PhysicalSpatialJoin(LogicalOperator &op, PhysicalOperator &left,
                                          PhysicalOperator &right, unique_ptr<Expression> condition_p,
-                                         JoinType join_type, idx_t estimated_cardinality)
+                                         vector<JoinCondition> equality_conditions_p,
+                                         vector<unique_ptr<Expression>> extra_conditions, JoinType join_type,
+                                         double distance_p, idx_t estimated_cardinality)
     : PhysicalJoin(op, PhysicalOperatorType::EXTENSION, join_type, estimated_cardinality),
-      condition(std::move(condition_p)) {
+      condition(std::move(condition_p)), distance(distance_p), equality_conditions(std::move(equality_conditions_p)) {
 
 	children.emplace_back(left);
 	children.emplace_back(right);
 
-	auto &func = condition->Cast<BoundFunctionExpression>();
+	auto &func = LogicalSpatialJoin::GetKeyFunction(*condition);
 
 	// Extract the probe side and build side join keys
 	probe_side_key = func.children[0].get();
@@ -342,7 +550,8 @@ PhysicalSpatialJoin::PhysicalSpatialJoin(LogicalOperator &op, PhysicalOperator &
 
 	// Only simple join types are supported
 	D_ASSERT(join_type == JoinType::INNER || join_type == JoinType::LEFT || join_type == JoinType::OUTER ||
-	         join_type == JoinType::RIGHT);
+	         join_type == JoinType::RIGHT || join_type == JoinType::SEMI || join_type == JoinType::ANTI ||
+	         join_type == JoinType::MARK);
 
 	// Always make sure we have a consistent order of the output columns, regardless if we have projection maps or not
 
@@ -375,6 +584,11 @@ PhysicalSpatialJoin::PhysicalSpatialJoin(LogicalOperator &op, PhysicalOperator &
 	// TODO Add rest too
 	build_side_key_types.push_back(build_side_key->return_type);
 
+	if (HasEqualityConditions()) {
+		// The hash of the equality keys follows the spatial key
+		build_side_key_types.push_back(LogicalType::HASH);
+	}
+
 	const auto &build_side_input_types = children[1].get().types;
 	auto right_projection_map_copy = lop.right_projection_map;
 	if (right_projection_map_copy.empty()) {
@@ -384,6 +598,11 @@ PhysicalSpatialJoin::PhysicalSpatialJoin(LogicalOperator &op, PhysicalOperator &
 		}
 	}
 
+	if (!ProjectsBuildSide(join_type)) {
+		// We never gather anything but the key from the build side
+		right_projection_map_copy.clear();
+	}
+
 	for (auto &rhs_col : right_projection_map_copy) {
 		auto &rhs_type = build_side_input_types[rhs_col];
 
@@ -402,6 +621,78 @@ PhysicalSpatialJoin::PhysicalSpatialJoin(LogicalOperator &op, PhysicalOperator &
 		build_side_output_types.push_back(rhs_type);
 	}
 
+	// Combine the extra conditions into a single predicate
+	if (extra_conditions.size() == 1) {
+		extra_condition = std::move(extra_conditions[0]);
+	} else if (!extra_conditions.empty()) {
+		auto conjunction = make_uniq<BoundConjunctionExpression>(ExpressionType::CONJUNCTION_AND);
+		for (auto &extra_expr : extra_conditions) {
+			conjunction->children.push_back(std::move(extra_expr));
+		}
+		extra_condition = std::move(conjunction);
+	}
+
+	if (extra_condition) {
+		// The extra condition references the probe side columns, followed by the build side columns.
+		// Only keep the columns it actually references, and make sure the build side ones are part of the layout.
+		const auto probe_side_column_count = probe_side_input_types.size();
+
+		vector<column_t> build_side_input_columns;
+		ExpressionIterator::EnumerateExpression(extra_condition, [&](Expression &expr) {
+			if (expr.GetExpressionClass() != ExpressionClass::BOUND_REF) {
+				return;
+			}
+			const auto col_idx = expr.Cast<BoundReferenceExpression>().index;
+			if (col_idx < probe_side_column_count) {
+				if (std::find(extra_probe_side_columns.begin(), extra_probe_side_columns.end(), col_idx) ==
+				    extra_probe_side_columns.end()) {
+					extra_probe_side_columns.push_back(col_idx);
+				}
+			} else if (std::find(build_side_input_columns.begin(), build_side_input_columns.end(),
+			                     col_idx - probe_side_column_count) == build_side_input_columns.end()) {
+				build_side_input_columns.push_back(col_idx - probe_side_column_count);
+			}
+		});
+
+		for (const auto &col_idx : extra_probe_side_columns) {
+			extra_condition_types.push_back(probe_side_input_types[col_idx]);
+		}
+
+		for (const auto &rhs_col : build_side_input_columns) {
+			const auto it = conditions_in_layout.find(rhs_col);
+			const auto payload_it =
+			    std::find(build_side_payload_columns.begin(), build_side_payload_columns.end(), rhs_col);
+			if (it != conditions_in_layout.end()) {
+				extra_build_side_columns.push_back(it->second);
+			} else if (payload_it != build_side_payload_columns.end()) {
+				const auto payload_idx = NumericCast<idx_t>(payload_it - build_side_payload_columns.begin());
+				extra_build_side_columns.push_back(build_side_key_types.size() + payload_idx);
+			} else {
+				// Not part of the output, but we still need it in the layout
+				extra_build_side_columns.push_back(build_side_key_types.size() + build_side_payload_types.size());
+				build_side_payload_types.push_back(build_side_input_types[rhs_col]);
+				build_side_payload_columns.push_back(rhs_col);
+			}
+			extra_condition_types.push_back(build_side_input_types[rhs_col]);
+		}
+
+		// Now rewrite the references to point into the chunk of referenced columns
+		ExpressionIterator::EnumerateExpression(extra_condition, [&](Expression &expr) {
+			if (expr.GetExpressionClass() != ExpressionClass::BOUND_REF) {
+				return;
+			}
+			auto &ref = expr.Cast<BoundReferenceExpression>();
+			if (ref.index < probe_side_column_count) {
+				const auto it = std::find(extra_probe_side_columns.begin(), extra_probe_side_columns.end(), ref.index);
+				ref.index = NumericCast<idx_t>(it - extra_probe_side_columns.begin());
+			} else {
+				const auto it = std::find(build_side_input_columns.begin(), build_side_input_columns.end(),
+				                          ref.index - probe_side_column_count);
+				ref.index = extra_probe_side_columns.size() + NumericCast<idx_t>(it - build_side_input_columns.begin());
+			}
+		});
+	}
+
 	vector<LogicalType> layout_types;
 	// Insert all condition types
 	layout_types.insert(layout_types.end(), build_side_key_types.begin(), build_side_key_types.end());
@@ -416,6 +707,11 @@ PhysicalSpatialJoin::PhysicalSpatialJoin(LogicalOperator &op, PhysicalOperator &
 	layout = make_shared_ptr<TupleDataLayout>();
 	layout->Initialize(std::move(layout_types), false);
 
+	// For keyed joins, this is where the hash of the equality keys goes
+	if (HasEqualityConditions()) {
+		build_side_hash_offset = layout->GetOffsets()[1];
+	}
+
 	// For right/outer joins, this is where the build side match column goes
 	if (PropagatesBuildSide(join_type)) {
 		const auto &offsets = layout->GetOffsets();
@@ -423,15 +719,6 @@ PhysicalSpatialJoin::PhysicalSpatialJoin(LogicalOperator &op, PhysicalOperator &
 	}
 }
 
-InsertionOrderPreservingMap<string> PhysicalSpatialJoin::ParamsToString() const {
-	// TODO: Add condition to the result (GetName is wrong)
-	auto result = PhysicalOperator::ParamsToString();
-	result["Join Type"] = EnumUtil::ToString(join_type);
-	result["Conditions"] = condition->GetName();
-	SetEstimatedCardinality(result, estimated_cardinality);
-	return result;
-}
-
 string PhysicalSpatialJoin::GetName() const {
 	return "SPATIAL_JOIN";
 }
@@ -439,12 +726,204 @@ string PhysicalSpatialJoin::GetName() const {
 //----------------------------------------------------------------------------------------------------------------------
 // Sink Interface
 //----------------------------------------------------------------------------------------------------------------------
+namespace {
+
+// Get the box to index a build side geometry by. Returns false for empty geometries.
+bool TryGetBuildSideBox(const geometry_t &geom, double distance, Box2D<float> &bbox) {
+	if (!geom.TryGetCachedBounds(bbox)) {
+		return false;
+	}
+
+	// For distance joins, grow the box so that it intersects every probe box within the distance
+	if (distance > 0) {
+		bbox.min.x = MathUtil::DoubleToFloatDown(static_cast<double>(bbox.min.x) - distance);
+		bbox.min.y = MathUtil::DoubleToFloatDown(static_cast<double>(bbox.min.y) - distance);
+		bbox.max.x = MathUtil::DoubleToFloatUp(static_cast<double>(bbox.max.x) + distance);
+		bbox.max.y = MathUtil::DoubleToFloatUp(static_cast<double>(bbox.max.y) + distance);
+	}
+	return true;
+}
+
+// Call the callback with the row pointer and box of every build side row that is not NULL or empty
+template <class CALLBACK>
+void ScanBuildSideBoxes(TupleDataCollection &collection, TupleDataPinProperties properties, double distance,
+                        CALLBACK &&callback) {
+	TupleDataChunkIterator iterator(collection, properties, true);
+
+	const auto rows_ptr = iterator.GetRowLocations();
+	Vector row_pointer_vector(LogicalType::POINTER, reinterpret_cast<data_ptr_t>(rows_ptr));
+
+	auto &sel = *FlatVector::IncrementalSelectionVector();
+	Vector geom_vec(GeoTypes::GEOMETRY());
+
+	do {
+		const auto row_count = iterator.GetCurrentChunkCount();
+
+		// We only need to fetch the build-side key column.
+		// The key column is always the first column in the layout.
+		constexpr auto build_side_key_col = 0; // TODO: layout_key_col_idx
+
+		collection.Gather(row_pointer_vector, sel, row_count, build_side_key_col, geom_vec, sel, nullptr);
+
+		// Get a pointer to what we just gathered
+		const auto geom_ptr = FlatVector::GetData<geometry_t>(geom_vec);
+		for (idx_t row_idx = 0; row_idx < row_count; row_idx++) {
+			if (FlatVector::IsNull(geom_vec, row_idx)) {
+				// Skip null geometries
+				continue;
+			}
+
+			Box2D<float> bbox;
+			if (!TryGetBuildSideBox(geom_ptr[row_idx], distance, bbox)) {
+				// Skip empty geometries
+				continue;
+			}
+
+			callback(rows_ptr[row_idx], bbox);
+		}
+	} while (iterator.Next());
+}
+
+static constexpr auto RTREE_NODE_SIZE = 32;
+
+// R-Trees with fewer leaves than this are built by a single thread
+static constexpr idx_t PARALLEL_BUILD_THRESHOLD = 1ULL << 17;
+
+// Create a flat R-Tree over a build side collection. This pins the whole collection, so that we can probe the row
+// pointers later. The tree still has to be built.
+unique_ptr<FlatRTree> CreateRTree(ClientContext &context, TupleDataCollection &collection, double distance) {
+	auto rtree = make_uniq<FlatRTree>(BufferAllocator::Get(context), collection.Count(), RTREE_NODE_SIZE);
+	ScanBuildSideBoxes(collection, TupleDataPinProperties::KEEP_EVERYTHING_PINNED, distance,
+	                   [&](data_ptr_t row, const Box2D<float> &bbox) { rtree->Push(bbox, row); });
+	return rtree;
+}
+
+// Create a flat R-Tree per hash of the equality keys over a build side collection. Like CreateRTree, this pins the
+// whole collection, and the trees still have to be built.
+unordered_map<hash_t, unique_ptr<FlatRTree>> CreateKeyedRTrees(ClientContext &context, const PhysicalSpatialJoin &op,
+                                                               TupleDataCollection &collection) {
+	// Count the boxes per key first, so that every tree can be allocated up front
+	unordered_map<hash_t, uint32_t> counts;
+	ScanBuildSideBoxes(collection, TupleDataPinProperties::UNPIN_AFTER_DONE, op.distance,
+	                   [&](data_ptr_t row, const Box2D<float> &) {
+		                   counts[Load<hash_t>(row + op.build_side_hash_offset)]++;
+	                   });
+
+	auto &allocator = BufferAllocator::Get(context);
+	unordered_map<hash_t, unique_ptr<FlatRTree>> rtrees;
+	for (const auto &entry : counts) {
+		rtrees.emplace(entry.first, make_uniq<FlatRTree>(allocator, entry.second, RTREE_NODE_SIZE));
+	}
+
+	ScanBuildSideBoxes(collection, TupleDataPinProperties::KEEP_EVERYTHING_PINNED, op.distance,
+	                   [&](data_ptr_t row, const Box2D<float> &bbox) {
+		                   rtrees[Load<hash_t>(row + op.build_side_hash_offset)]->Push(bbox, row);
+	                   });
+	return rtrees;
+}
+
+// The leaves are sorted in parallel by first radix partitioning them on the most significant bits of their hilbert
+// key, and then sorting each partition on its own. Every partition covers a contiguous range of the sorted leaves.
+struct FlatRTreeSortState {
+	static constexpr idx_t RADIX_BITS = 10;
+	static constexpr idx_t PARTITION_COUNT = 1ULL << RADIX_BITS;
+
+	static idx_t GetPartition(uint32_t key) {
+		return key >> (32 - RADIX_BITS);
+	}
+
+	// The leaves are split into equally sized ranges, one per task
+	idx_t task_count = 0;
+	idx_t task_size = 0;
+
+	AllocatedData keys_mem;
+	AllocatedData entries_mem;
+
+	// The number of entries per task and partition, turned into the write offset of each task within each partition
+	vector<idx_t> task_offsets;
+	// The range of the sorted entries each partition covers
+	vector<idx_t> partition_bounds;
+
+	uint32_t *GetKeys() {
+		return reinterpret_cast<uint32_t *>(keys_mem.get());
+	}
+	FlatRTreeSortEntry *GetEntries() {
+		return reinterpret_cast<FlatRTreeSortEntry *>(entries_mem.get());
+	}
+};
+
+// When the build side does not fit in memory, it is split into partitions of consecutive hilbert key ranges.
+// The first partition stays resident and is probed by the probe pipeline, which spills the probe side rows that
+// intersect the bounds of any other partition. Each of the other partitions is then joined on its own by the source.
+struct SpatialJoinPartition {
+	// The build side rows in this partition, and the union of their (grown) boxes
+	unique_ptr<TupleDataCollection> build_collection;
+	Box2D<float> bounds;
+
+	// The probe side rows that might join with this partition
+	mutex probe_lock;
+	unique_ptr<ColumnDataCollection> probe_collection;
+	ColumnDataAppendState probe_append_state;
+};
+
+// The state used to split the build side into partitions in parallel. The build side is scanned twice: once to count
+// the boxes per range of hilbert keys, and once to scatter the rows into the partition their range is assigned to.
+struct SpatialJoinPartitionState {
+	static constexpr idx_t RADIX_BITS = 10;
+	static constexpr idx_t RANGE_COUNT = 1ULL << RADIX_BITS;
+
+	static idx_t GetRange(uint32_t key) {
+		return key >> (32 - RADIX_BITS);
+	}
+
+	SpatialJoinPartitionState(BufferManager &buffer_manager_p, const Box2D<float> &bounds, idx_t partition_count_p)
+	    : buffer_manager(buffer_manager_p), hilbert(bounds), partition_count(partition_count_p),
+	      range_counts(RANGE_COUNT, 0), range_partitions(RANGE_COUNT, 0) {
+	}
+
+	BufferManager &buffer_manager;
+	const HilbertEncoder hilbert;
+	idx_t partition_count;
+	idx_t task_count = 0;
+
+	TupleDataParallelScanState count_scan_state;
+	TupleDataParallelScanState scatter_scan_state;
+
+	// The tasks merge their results under this lock
+	mutex lock;
+
+	// The number of build side boxes per range, and the partition each range is assigned to
+	vector<idx_t> range_counts;
+	idx_t box_count = 0;
+	vector<idx_t> range_partitions;
+
+	// The build side rows of each partition, and the union of their (grown) boxes
+	vector<unique_ptr<TupleDataCollection>> build_collections;
+	vector<Box2D<float>> partition_bounds;
+};
+
+} // namespace
+
 class SpatialJoinGlobalState final : public GlobalSinkState {
 public:
+	mutex lock;
 	unique_ptr<TupleDataCollection> collection;
 
+	// The bounds of the build side boxes, used to partition the build side if it does not fit in memory
+	Box2D<float> bounds;
+
 	// This is initialized in the finalize state
 	unique_ptr<FlatRTree> rtree = nullptr;
+	// Or, if there are equality conditions, one rtree per hash of the build side keys
+	unordered_map<hash_t, unique_ptr<FlatRTree>> keyed_rtrees;
+
+	// The state used to sort the R-Tree leaves when building it in parallel
+	unique_ptr<FlatRTreeSortState> sort_state = nullptr;
+
+	// The partitions of the build side that did not fit in memory, if any. The "collection" holds the first one.
+	vector<unique_ptr<SpatialJoinPartition>> partitions;
+	// The state used to split the build side into partitions, while partitioning it
+	unique_ptr<SpatialJoinPartitionState> partition_state = nullptr;
 };
 
 unique_ptr<GlobalSinkState> PhysicalSpatialJoin::GetGlobalSinkState(ClientContext &context) const {
@@ -458,14 +937,20 @@ unique_ptr<GlobalSinkState> PhysicalSpatialJoin::GetGlobalSinkState(ClientContex
 class SpatialJoinLocalState final : public LocalSinkState {
 public:
 	SpatialJoinLocalState(const PhysicalSpatialJoin &op, ClientContext &context, const shared_ptr<TupleDataLayout> &layout)
-	    : build_side_key_executor(context) {
+	    : build_side_key_executor(context), build_side_hashes(LogicalType::HASH) {
 		// Dont keep the tuples in memory after appending.
 		collection = make_uniq<TupleDataCollection>(BufferManager::GetBufferManager(context), layout);
 		collection->InitializeAppend(append_state, TupleDataPinProperties::UNPIN_AFTER_DONE);
 
-		// TODO: Add other join condition expressions here
+		// The spatial key, followed by the keys of the equality conditions
+		vector<LogicalType> key_types;
 		build_side_key_executor.AddExpression(*op.build_side_key);
-		build_side_key_chunk.Initialize(context, op.build_side_key_types);
+		key_types.push_back(op.build_side_key->return_type);
+		for (auto &equality : op.equality_conditions) {
+			build_side_key_executor.AddExpression(*equality.right);
+			key_types.push_back(equality.right->return_type);
+		}
+		build_side_key_chunk.Initialize(context, key_types);
 
 		build_side_row_chunk.InitializeEmpty(layout->GetTypes());
 
@@ -482,6 +967,12 @@ public:
 	DataChunk build_side_row_chunk;
 	// Used to execute the build side join key expression
 	ExpressionExecutor build_side_key_executor;
+	// The hash of the equality keys, if any
+	Vector build_side_hashes;
+
+	// The bounds of the build side boxes sunk by this thread
+	UnifiedVectorFormat build_side_key_format;
+	Box2D<float> bounds;
 };
 
 unique_ptr<LocalSinkState> PhysicalSpatialJoin::GetLocalSinkState(ExecutionContext &context) const {
@@ -497,6 +988,18 @@ SinkResultType PhysicalSpatialJoin::Sink(ExecutionContext &context, DataChunk &c
 	lstate.build_side_key_chunk.Reset();
 	lstate.build_side_key_executor.Execute(chunk, lstate.build_side_key_chunk);
 
+	// Keep track of the bounds of the build side
+	lstate.build_side_key_chunk.data[0].ToUnifiedFormat(chunk.size(), lstate.build_side_key_format);
+	const auto keys = UnifiedVectorFormat::GetData<geometry_t>(lstate.build_side_key_format);
+	for (idx_t row_idx = 0; row_idx < chunk.size(); row_idx++) {
+		const auto key_idx = lstate.build_side_key_format.sel->get_index(row_idx);
+		Box2D<float> bbox;
+		if (lstate.build_side_key_format.validity.RowIsValid(key_idx) &&
+		    TryGetBuildSideBox(keys[key_idx], distance, bbox)) {
+			lstate.bounds.Union(bbox);
+		}
+	}
+
 	if (build_side_payload_types.empty()) {
 		// There are only keys. Make the payload chunk empty
 		lstate.build_side_payload_chunk.SetCardinality(chunk.size());
@@ -506,8 +1009,16 @@ SinkResultType PhysicalSpatialJoin::Sink(ExecutionContext &context, DataChunk &c
 
 	// Now reference the key chunk, the payload chunk, and the build side match column (if needed)
 	idx_t layout_col_idx = 0;
-	for (auto &key_col : lstate.build_side_key_chunk.data) {
-		lstate.build_side_row_chunk.data[layout_col_idx++].Reference(key_col);
+	lstate.build_side_row_chunk.data[layout_col_idx++].Reference(lstate.build_side_key_chunk.data[0]);
+
+	if (HasEqualityConditions()) {
+		// Hash the equality keys, so that we can split the build side by them once everything is sunk
+		auto &keys = lstate.build_side_key_chunk;
+		VectorOperations::Hash(keys.data[1], lstate.build_side_hashes, chunk.size());
+		for (idx_t key_idx = 2; key_idx < keys.ColumnCount(); key_idx++) {
+			VectorOperations::CombineHash(lstate.build_side_hashes, keys.data[key_idx], chunk.size());
+		}
+		lstate.build_side_row_chunk.data[layout_col_idx++].Reference(lstate.build_side_hashes);
 	}
 
 	for (auto &payload_col : lstate.build_side_payload_chunk.data) {
@@ -535,68 +1046,712 @@ SinkCombineResultType PhysicalSpatialJoin::Combine(ExecutionContext &context, Op
 	lstate.collection->FinalizePinState(lstate.append_state.pin_state);
 
 	// Append the local collection to the global collection
+	lock_guard<mutex> guard(gstate.lock);
 	gstate.collection->Combine(*lstate.collection);
+	gstate.bounds.Union(lstate.bounds);
 
 	return SinkCombineResultType::FINISHED;
 }
 
-// This is where we would build the rtree, by iterating through the tupledata collection we've created
-SinkFinalizeType PhysicalSpatialJoin::Finalize(Pipeline &pipeline, Event &event, ClientContext &context,
-                                               OperatorSinkFinalizeInput &input) const {
-	auto &gstate = input.global_state.Cast<SpatialJoinGlobalState>();
+//----------------------------------------------------------------------------------------------------------------------
+// Parallel R-Tree Build
+//----------------------------------------------------------------------------------------------------------------------
+// The parallel build runs in four steps:
+// 1. SpatialJoinKeyEvent: compute the hilbert key of each leaf, and count the leaves per radix partition
+// 2. SpatialJoinPartitionEvent: scatter the leaves into their partitions
+// 3. SpatialJoinSortEvent: sort each partition, and move its leaves into their sorted position in the tree
+// 4. SpatialJoinLayerEvent: pack the parent nodes, one event per layer
+namespace {
 
-	if (gstate.collection->Count() == 0) {
-		return EmptyResultIfRHSIsEmpty() ? SinkFinalizeType::NO_OUTPUT_POSSIBLE : SinkFinalizeType::READY;
+class SpatialJoinLayerTask final : public ExecutorTask {
+public:
+	SpatialJoinLayerTask(shared_ptr<Event> event_p, ClientContext &context, SpatialJoinGlobalState &gstate,
+	                     const PhysicalOperator &op, idx_t layer_idx_p, idx_t parent_beg_p, idx_t parent_end_p)
+	    : ExecutorTask(context, std::move(event_p), op), gstate(gstate), layer_idx(layer_idx_p),
+	      parent_beg(parent_beg_p), parent_end(parent_end_p) {
 	}
 
-	// Initialize the flat R-Tree
-	static constexpr auto RTREE_NODE_SIZE = 32;
-	gstate.rtree = make_uniq<FlatRTree>(BufferAllocator::Get(context), gstate.collection->Count(), RTREE_NODE_SIZE);
+	TaskExecutionResult ExecuteTask(TaskExecutionMode mode) override {
+		gstate.rtree->PackLayer(layer_idx, parent_beg, parent_end);
 
-	// Now, this is where we build the rtree, by iterating over the tuples in the collection.
-	// We need to keep everything pinned so that we can probe the pointers later
-	TupleDataChunkIterator iterator(*gstate.collection, TupleDataPinProperties::KEEP_EVERYTHING_PINNED, true);
+		event->FinishTask();
+		return TaskExecutionResult::TASK_FINISHED;
+	}
 
-	const auto rows_ptr = iterator.GetRowLocations();
-	Vector row_pointer_vector(LogicalType::POINTER, reinterpret_cast<data_ptr_t>(rows_ptr));
+private:
+	SpatialJoinGlobalState &gstate;
+	idx_t layer_idx;
+	idx_t parent_beg;
+	idx_t parent_end;
+};
 
-	auto &sel = *FlatVector::IncrementalSelectionVector();
-	Vector geom_vec(GeoTypes::GEOMETRY());
+class SpatialJoinLayerEvent final : public BasePipelineEvent {
+public:
+	SpatialJoinLayerEvent(SpatialJoinGlobalState &gstate_p, Pipeline &pipeline_p, const PhysicalOperator &op_p,
+	                      idx_t layer_idx_p)
+	    : BasePipelineEvent(pipeline_p), gstate(gstate_p), op(op_p), layer_idx(layer_idx_p) {
+	}
 
-	do {
-		const auto row_count = iterator.GetCurrentChunkCount();
+	void Schedule() override {
+		auto &context = pipeline->GetClientContext();
 
-		// We only need to fetch the build-side key column to build the rtree.
-		// The key column is always the first column in the layout.
-		constexpr auto build_side_key_col = 0;      // TODO: layout_key_col_idx
-		D_ASSERT(build_side_key_types.size() == 1); // TODO: remove this
+		// Every task packs a contiguous range of parent nodes
+		static constexpr idx_t PARENTS_PER_TASK = 1024;
 
-		gstate.collection->Gather(row_pointer_vector, sel, row_count, build_side_key_col, geom_vec, sel, nullptr);
+		const auto parent_count = gstate.rtree->GetParentCount(layer_idx);
 
-		// Get a pointer to what we just gathered
-		const auto geom_ptr = FlatVector::GetData<geometry_t>(geom_vec);
-		// Push the bounding boxes into the R-Tree
-		for (idx_t row_idx = 0; row_idx < row_count; row_idx++) {
-			if (FlatVector::IsNull(geom_vec, row_idx)) {
-				// Skip null geometries
-				continue;
-			}
+		vector<shared_ptr<Task>> tasks;
+		for (idx_t parent_beg = 0; parent_beg < parent_count; parent_beg += PARENTS_PER_TASK) {
+			const auto parent_end = MinValue<idx_t>(parent_beg + PARENTS_PER_TASK, parent_count);
+			tasks.push_back(make_uniq<SpatialJoinLayerTask>(shared_from_this(), context, gstate, op, layer_idx,
+			                                                parent_beg, parent_end));
+		}
+		SetTasks(std::move(tasks));
+	}
 
-			const auto &geom = geom_ptr[row_idx];
-			Box2D<float> bbox;
-			if (!geom.TryGetCachedBounds(bbox)) {
-				// Skip empty geometries
-				continue;
+	void FinishEvent() override {
+		if (layer_idx + 1 == gstate.rtree->GetLayerCount()) {
+			// We've reached the root, we are done
+			return;
+		}
+
+		// Otherwise, pack the next layer
+		InsertEvent(make_shared_ptr<SpatialJoinLayerEvent>(gstate, *pipeline, op, layer_idx + 1));
+	}
+
+private:
+	SpatialJoinGlobalState &gstate;
+	const PhysicalOperator &op;
+	idx_t layer_idx;
+};
+
+class SpatialJoinSortTask final : public ExecutorTask {
+public:
+	SpatialJoinSortTask(shared_ptr<Event> event_p, ClientContext &context, SpatialJoinGlobalState &gstate,
+	                    const PhysicalOperator &op, idx_t partition_beg_p, idx_t partition_end_p)
+	    : ExecutorTask(context, std::move(event_p), op), gstate(gstate), partition_beg(partition_beg_p),
+	      partition_end(partition_end_p) {
+	}
+
+	TaskExecutionResult ExecuteTask(TaskExecutionMode mode) override {
+		auto &sort_state = *gstate.sort_state;
+		const auto entries = sort_state.GetEntries();
+
+		for (idx_t partition_idx = partition_beg; partition_idx < partition_end; partition_idx++) {
+			const auto entry_beg = sort_state.partition_bounds[partition_idx];
+			const auto entry_end = sort_state.partition_bounds[partition_idx + 1];
+			std::sort(entries + entry_beg, entries + entry_end);
+		}
+
+		// The partitions are in key order, so the sorted entries of this task are already in their final position
+		gstate.rtree->Permute(entries, sort_state.partition_bounds[partition_beg],
+		                      sort_state.partition_bounds[partition_end]);
+
+		event->FinishTask();
+		return TaskExecutionResult::TASK_FINISHED;
+	}
+
+private:
+	SpatialJoinGlobalState &gstate;
+	idx_t partition_beg;
+	idx_t partition_end;
+};
+
+class SpatialJoinSortEvent final : public BasePipelineEvent {
+public:
+	SpatialJoinSortEvent(SpatialJoinGlobalState &gstate_p, Pipeline &pipeline_p, const PhysicalOperator &op_p)
+	    : BasePipelineEvent(pipeline_p), gstate(gstate_p), op(op_p) {
+	}
+
+	void Schedule() override {
+		auto &context = pipeline->GetClientContext();
+		auto &sort_state = *gstate.sort_state;
+
+		// Group adjacent partitions into tasks of roughly the same size. A single skewed partition still ends up in
+		// a task of its own.
+		const auto item_count = sort_state.partition_bounds.back();
+		const auto target_size = MaxValue<idx_t>(item_count / (sort_state.task_count * 2), 1);
+
+		vector<shared_ptr<Task>> tasks;
+		idx_t partition_beg = 0;
+		for (idx_t partition_idx = 0; partition_idx < FlatRTreeSortState::PARTITION_COUNT; partition_idx++) {
+			const auto partition_end = partition_idx + 1;
+			const auto task_size =
+			    sort_state.partition_bounds[partition_end] - sort_state.partition_bounds[partition_beg];
+			if (task_size >= target_size || partition_end == FlatRTreeSortState::PARTITION_COUNT) {
+				tasks.push_back(make_uniq<SpatialJoinSortTask>(shared_from_this(), context, gstate, op,
+				                                               partition_beg, partition_end));
+				partition_beg = partition_end;
 			}
+		}
+		SetTasks(std::move(tasks));
+	}
+
+	void FinishEvent() override {
+		gstate.rtree->FinishSort();
+		gstate.sort_state.reset();
+
+		// Now pack the layers, starting with the leaves
+		InsertEvent(make_shared_ptr<SpatialJoinLayerEvent>(gstate, *pipeline, op, 0));
+	}
+
+private:
+	SpatialJoinGlobalState &gstate;
+	const PhysicalOperator &op;
+};
+
+class SpatialJoinPartitionTask final : public ExecutorTask {
+public:
+	SpatialJoinPartitionTask(shared_ptr<Event> event_p, ClientContext &context, SpatialJoinGlobalState &gstate,
+	                         const PhysicalOperator &op, idx_t task_idx_p)
+	    : ExecutorTask(context, std::move(event_p), op), gstate(gstate), task_idx(task_idx_p) {
+	}
 
-			// Push the bounding box into the R-Tree
-			gstate.rtree->Push(bbox, rows_ptr[row_idx]);
+	TaskExecutionResult ExecuteTask(TaskExecutionMode mode) override {
+		auto &sort_state = *gstate.sort_state;
+		const auto keys = sort_state.GetKeys();
+		const auto entries = sort_state.GetEntries();
+		const auto offsets = sort_state.task_offsets.data() + task_idx * FlatRTreeSortState::PARTITION_COUNT;
+
+		const auto entry_beg = task_idx * sort_state.task_size;
+		const auto entry_end = MinValue<idx_t>(entry_beg + sort_state.task_size, gstate.rtree->Count());
+
+		for (idx_t entry_idx = entry_beg; entry_idx < entry_end; entry_idx++) {
+			const auto key = keys[entry_idx];
+			auto &entry = entries[offsets[FlatRTreeSortState::GetPartition(key)]++];
+			entry.key = key;
+			entry.idx = UnsafeNumericCast<uint32_t>(entry_idx);
 		}
-	} while (iterator.Next());
 
-	// Build the R-Tree once we've gathered everything
-	gstate.rtree->Build();
+		event->FinishTask();
+		return TaskExecutionResult::TASK_FINISHED;
+	}
+
+private:
+	SpatialJoinGlobalState &gstate;
+	idx_t task_idx;
+};
+
+class SpatialJoinPartitionEvent final : public BasePipelineEvent {
+public:
+	SpatialJoinPartitionEvent(SpatialJoinGlobalState &gstate_p, Pipeline &pipeline_p, const PhysicalOperator &op_p)
+	    : BasePipelineEvent(pipeline_p), gstate(gstate_p), op(op_p) {
+	}
+
+	void Schedule() override {
+		auto &context = pipeline->GetClientContext();
 
+		vector<shared_ptr<Task>> tasks;
+		for (idx_t task_idx = 0; task_idx < gstate.sort_state->task_count; task_idx++) {
+			tasks.push_back(make_uniq<SpatialJoinPartitionTask>(shared_from_this(), context, gstate, op, task_idx));
+		}
+		SetTasks(std::move(tasks));
+	}
+
+	void FinishEvent() override {
+		InsertEvent(make_shared_ptr<SpatialJoinSortEvent>(gstate, *pipeline, op));
+	}
+
+private:
+	SpatialJoinGlobalState &gstate;
+	const PhysicalOperator &op;
+};
+
+class SpatialJoinKeyTask final : public ExecutorTask {
+public:
+	SpatialJoinKeyTask(shared_ptr<Event> event_p, ClientContext &context, SpatialJoinGlobalState &gstate,
+	                   const PhysicalOperator &op, idx_t task_idx_p)
+	    : ExecutorTask(context, std::move(event_p), op), gstate(gstate), task_idx(task_idx_p) {
+	}
+
+	TaskExecutionResult ExecuteTask(TaskExecutionMode mode) override {
+		auto &sort_state = *gstate.sort_state;
+		auto &rtree = *gstate.rtree;
+		const auto keys = sort_state.GetKeys();
+		const auto counts = sort_state.task_offsets.data() + task_idx * FlatRTreeSortState::PARTITION_COUNT;
+
+		const auto entry_beg = task_idx * sort_state.task_size;
+		const auto entry_end = MinValue<idx_t>(entry_beg + sort_state.task_size, rtree.Count());
+
+		for (idx_t entry_idx = entry_beg; entry_idx < entry_end; entry_idx++) {
+			const auto key = rtree.GetHilbertKey(rtree.GetBox(entry_idx));
+			keys[entry_idx] = key;
+			counts[FlatRTreeSortState::GetPartition(key)]++;
+		}
+
+		event->FinishTask();
+		return TaskExecutionResult::TASK_FINISHED;
+	}
+
+private:
+	SpatialJoinGlobalState &gstate;
+	idx_t task_idx;
+};
+
+class SpatialJoinKeyEvent final : public BasePipelineEvent {
+public:
+	SpatialJoinKeyEvent(SpatialJoinGlobalState &gstate_p, Pipeline &pipeline_p, const PhysicalOperator &op_p)
+	    : BasePipelineEvent(pipeline_p), gstate(gstate_p), op(op_p) {
+	}
+
+	void Schedule() override {
+		auto &context = pipeline->GetClientContext();
+
+		vector<shared_ptr<Task>> tasks;
+		for (idx_t task_idx = 0; task_idx < gstate.sort_state->task_count; task_idx++) {
+			tasks.push_back(make_uniq<SpatialJoinKeyTask>(shared_from_this(), context, gstate, op, task_idx));
+		}
+		SetTasks(std::move(tasks));
+	}
+
+	void FinishEvent() override {
+		auto &sort_state = *gstate.sort_state;
+
+		// Turn the counts into write offsets. The tasks write to each partition in task order, which keeps the
+		// entries of a partition in insertion order.
+		sort_state.partition_bounds.resize(FlatRTreeSortState::PARTITION_COUNT + 1);
+		idx_t offset = 0;
+		for (idx_t partition_idx = 0; partition_idx < FlatRTreeSortState::PARTITION_COUNT; partition_idx++) {
+			sort_state.partition_bounds[partition_idx] = offset;
+			for (idx_t task_idx = 0; task_idx < sort_state.task_count; task_idx++) {
+				auto &task_offset =
+				    sort_state.task_offsets[task_idx * FlatRTreeSortState::PARTITION_COUNT + partition_idx];
+				const auto entry_count = task_offset;
+				task_offset = offset;
+				offset += entry_count;
+			}
+		}
+		sort_state.partition_bounds[FlatRTreeSortState::PARTITION_COUNT] = offset;
+
+		InsertEvent(make_shared_ptr<SpatialJoinPartitionEvent>(gstate, *pipeline, op));
+	}
+
+private:
+	SpatialJoinGlobalState &gstate;
+	const PhysicalOperator &op;
+};
+
+// With equality conditions, every key has an R-Tree of its own. These are usually small, so instead of splitting up
+// the build of each tree, every task builds one tree at a time, starting with the largest ones.
+class SpatialJoinKeyedBuildTask final : public ExecutorTask {
+public:
+	SpatialJoinKeyedBuildTask(shared_ptr<Event> event_p, ClientContext &context, const PhysicalOperator &op,
+	                          const vector<reference<FlatRTree>> &rtrees_p, atomic<idx_t> &next_rtree_p)
+	    : ExecutorTask(context, std::move(event_p), op), rtrees(rtrees_p), next_rtree(next_rtree_p) {
+	}
+
+	TaskExecutionResult ExecuteTask(TaskExecutionMode mode) override {
+		for (auto rtree_idx = next_rtree++; rtree_idx < rtrees.size(); rtree_idx = next_rtree++) {
+			rtrees[rtree_idx].get().Build();
+		}
+
+		event->FinishTask();
+		return TaskExecutionResult::TASK_FINISHED;
+	}
+
+private:
+	const vector<reference<FlatRTree>> &rtrees;
+	atomic<idx_t> &next_rtree;
+};
+
+class SpatialJoinKeyedBuildEvent final : public BasePipelineEvent {
+public:
+	SpatialJoinKeyedBuildEvent(SpatialJoinGlobalState &gstate_p, Pipeline &pipeline_p, const PhysicalOperator &op_p)
+	    : BasePipelineEvent(pipeline_p), gstate(gstate_p), op(op_p) {
+	}
+
+	void Schedule() override {
+		auto &context = pipeline->GetClientContext();
+
+		for (auto &entry : gstate.keyed_rtrees) {
+			rtrees.emplace_back(*entry.second);
+		}
+		std::sort(rtrees.begin(), rtrees.end(), [](const FlatRTree &lhs, const FlatRTree &rhs) {
+			return lhs.Count() > rhs.Count();
+		});
+
+		const auto thread_count = NumericCast<idx_t>(TaskScheduler::GetScheduler(context).NumberOfThreads());
+		const auto task_count = MinValue<idx_t>(thread_count, rtrees.size());
+
+		vector<shared_ptr<Task>> tasks;
+		for (idx_t task_idx = 0; task_idx < task_count; task_idx++) {
+			tasks.push_back(
+			    make_uniq<SpatialJoinKeyedBuildTask>(shared_from_this(), context, op, rtrees, next_rtree));
+		}
+		SetTasks(std::move(tasks));
+	}
+
+private:
+	SpatialJoinGlobalState &gstate;
+	const PhysicalOperator &op;
+
+	vector<reference<FlatRTree>> rtrees;
+	atomic<idx_t> next_rtree = {0};
+};
+
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+// Build Side Partitioning
+//----------------------------------------------------------------------------------------------------------------------
+// If the build side does not fit in memory, it is split into partitions of consecutive hilbert key ranges before the
+// R-Tree is built. Every build side row ends up in exactly one partition, so joining the partitions one at a time can
+// not produce duplicate pairs, even though a probe side row might be joined with multiple partitions.
+// The partitioning runs in two steps:
+// 1. SpatialJoinRangeCountEvent: count the build side boxes per range of hilbert keys
+// 2. SpatialJoinScatterEvent: scatter the build side rows into the partition their range is assigned to
+namespace {
+
+// The size of an R-Tree leaf entry of a build side row
+static constexpr idx_t RTREE_ENTRY_SIZE = sizeof(Box2D<float>) + sizeof(uint32_t) + sizeof(data_ptr_t);
+
+// Build the R-Tree over the (first partition of the) build side. Small trees are built right away, but large trees
+// are sorted and packed in parallel by a chain of events.
+void ScheduleRTreeBuild(ClientContext &context, const PhysicalSpatialJoin &op, SpatialJoinGlobalState &gstate,
+                        Pipeline &pipeline, Event &event) {
+	static constexpr idx_t MIN_TASK_SIZE = 1ULL << 16;
+
+	const auto thread_count = NumericCast<idx_t>(TaskScheduler::GetScheduler(context).NumberOfThreads());
+
+	// Now, this is where we build the rtree, by iterating over the tuples in the collection.
+	gstate.rtree = CreateRTree(context, *gstate.collection, op.distance);
+
+	const auto item_count = gstate.rtree->Count();
+
+	if (thread_count == 1 || item_count < PARALLEL_BUILD_THRESHOLD) {
+		gstate.rtree->Build();
+		return;
+	}
+
+	auto &allocator = BufferAllocator::Get(context);
+
+	gstate.sort_state = make_uniq<FlatRTreeSortState>();
+	auto &sort_state = *gstate.sort_state;
+	sort_state.task_count = MinValue<idx_t>((item_count + MIN_TASK_SIZE - 1) / MIN_TASK_SIZE, thread_count * 4);
+	sort_state.task_size = (item_count + sort_state.task_count - 1) / sort_state.task_count;
+	sort_state.keys_mem = allocator.Allocate(sizeof(uint32_t) * item_count);
+	sort_state.entries_mem = allocator.Allocate(sizeof(FlatRTreeSortEntry) * item_count);
+	sort_state.task_offsets.resize(sort_state.task_count * FlatRTreeSortState::PARTITION_COUNT, 0);
+
+	gstate.rtree->InitSort();
+
+	event.InsertEvent(make_shared_ptr<SpatialJoinKeyEvent>(gstate, pipeline, op));
+}
+
+// Returns how many partitions to split the build side into, or 0 if it fits in memory
+idx_t GetBuildSidePartitionCount(ClientContext &context, const TupleDataCollection &collection) {
+	const auto &config = ClientConfig::GetConfig(context);
+
+	// Estimate the size of the build side once it is pinned and indexed. Every thread joins one partition at a time
+	// while the first partition stays resident, so the partitions have to be a lot smaller than the memory limit.
+	const auto build_size = collection.SizeInBytes() + collection.Count() * RTREE_ENTRY_SIZE;
+	const auto max_memory = BufferManager::GetBufferManager(context).GetQueryMaxMemory();
+	const auto thread_count = NumericCast<idx_t>(TaskScheduler::GetScheduler(context).NumberOfThreads());
+
+	if (!config.force_external && build_size <= max_memory / 2) {
+		return 0;
+	}
+
+	const auto partition_budget = MaxValue<idx_t>(max_memory / (2 * (thread_count + 1)), 1);
+	auto partition_count = MaxValue<idx_t>((build_size + partition_budget - 1) / partition_budget, 2);
+	if (config.force_external) {
+		// Make sure there are a couple of partitions to join
+		partition_count = MaxValue<idx_t>(partition_count, 4);
+	}
+	return partition_count;
+}
+
+class SpatialJoinScatterTask final : public ExecutorTask {
+public:
+	SpatialJoinScatterTask(shared_ptr<Event> event_p, ClientContext &context, SpatialJoinGlobalState &gstate,
+	                       const PhysicalSpatialJoin &op)
+	    : ExecutorTask(context, std::move(event_p), op), gstate(gstate), op(op) {
+	}
+
+	TaskExecutionResult ExecuteTask(TaskExecutionMode mode) override {
+		auto &collection = *gstate.collection;
+		auto &partition_state = *gstate.partition_state;
+		const auto partition_count = partition_state.partition_count;
+
+		// Every task scatters into partitions of its own, which are combined once it is done
+		vector<unique_ptr<TupleDataCollection>> build_collections;
+		vector<TupleDataAppendState> append_states(partition_count);
+		vector<Box2D<float>> partition_bounds(partition_count);
+		vector<SelectionVector> partition_sels;
+		vector<idx_t> partition_counts(partition_count, 0);
+
+		for (idx_t i = 0; i < partition_count; i++) {
+			build_collections.push_back(make_uniq<TupleDataCollection>(partition_state.buffer_manager, op.layout));
+			build_collections.back()->InitializeAppend(append_states[i], TupleDataPinProperties::UNPIN_AFTER_DONE);
+			partition_sels.emplace_back(STANDARD_VECTOR_SIZE);
+		}
+
+		TupleDataLocalScanState scan_state;
+		DataChunk scan_chunk;
+		collection.InitializeScanChunk(partition_state.scatter_scan_state.scan_state, scan_chunk);
+
+		// NULL and empty geometries never match anything, so they just go into the first partition
+		UnifiedVectorFormat key_format;
+		while (collection.Scan(partition_state.scatter_scan_state, scan_state, scan_chunk)) {
+			const auto row_count = scan_chunk.size();
+
+			// The key column is always the first column in the layout
+			scan_chunk.data[0].ToUnifiedFormat(row_count, key_format);
+			const auto keys = UnifiedVectorFormat::GetData<geometry_t>(key_format);
+
+			std::fill(partition_counts.begin(), partition_counts.end(), 0);
+			for (idx_t row_idx = 0; row_idx < row_count; row_idx++) {
+				const auto key_idx = key_format.sel->get_index(row_idx);
+
+				idx_t target_idx = 0;
+				Box2D<float> bbox;
+				if (key_format.validity.RowIsValid(key_idx) && TryGetBuildSideBox(keys[key_idx], op.distance, bbox)) {
+					const auto range_idx = SpatialJoinPartitionState::GetRange(partition_state.hilbert.Encode(bbox));
+					target_idx = partition_state.range_partitions[range_idx];
+					partition_bounds[target_idx].Union(bbox);
+				}
+				partition_sels[target_idx].set_index(partition_counts[target_idx]++, row_idx);
+			}
+
+			for (idx_t i = 0; i < partition_count; i++) {
+				if (partition_counts[i] != 0) {
+					build_collections[i]->Append(append_states[i], scan_chunk, partition_sels[i], partition_counts[i]);
+				}
+			}
+		}
+
+		for (idx_t i = 0; i < partition_count; i++) {
+			build_collections[i]->FinalizePinState(append_states[i].pin_state);
+		}
+
+		lock_guard<mutex> guard(partition_state.lock);
+		for (idx_t i = 0; i < partition_count; i++) {
+			partition_state.build_collections[i]->Combine(*build_collections[i]);
+			partition_state.partition_bounds[i].Union(partition_bounds[i]);
+		}
+
+		event->FinishTask();
+		return TaskExecutionResult::TASK_FINISHED;
+	}
+
+private:
+	SpatialJoinGlobalState &gstate;
+	const PhysicalSpatialJoin &op;
+};
+
+class SpatialJoinScatterEvent final : public BasePipelineEvent {
+public:
+	SpatialJoinScatterEvent(SpatialJoinGlobalState &gstate_p, Pipeline &pipeline_p, const PhysicalSpatialJoin &op_p)
+	    : BasePipelineEvent(pipeline_p), gstate(gstate_p), op(op_p) {
+	}
+
+	void Schedule() override {
+		auto &context = pipeline->GetClientContext();
+
+		vector<shared_ptr<Task>> tasks;
+		for (idx_t task_idx = 0; task_idx < gstate.partition_state->task_count; task_idx++) {
+			tasks.push_back(make_uniq<SpatialJoinScatterTask>(shared_from_this(), context, gstate, op));
+		}
+		SetTasks(std::move(tasks));
+	}
+
+	void FinishEvent() override {
+		auto &context = pipeline->GetClientContext();
+		auto &partition_state = *gstate.partition_state;
+		auto &buffer_manager = partition_state.buffer_manager;
+
+		// The first partition stays resident, the others are spilled
+		gstate.collection = std::move(partition_state.build_collections[0]);
+		for (idx_t i = 1; i < partition_state.partition_count; i++) {
+			auto partition = make_uniq<SpatialJoinPartition>();
+			partition->build_collection = std::move(partition_state.build_collections[i]);
+			partition->bounds = partition_state.partition_bounds[i];
+			partition->probe_collection = make_uniq<ColumnDataCollection>(buffer_manager, op.children[0].get().types);
+			partition->probe_collection->InitializeAppend(partition->probe_append_state);
+			gstate.partitions.push_back(std::move(partition));
+		}
+		gstate.partition_state.reset();
+
+		ScheduleRTreeBuild(context, op, gstate, *pipeline, *this);
+	}
+
+private:
+	SpatialJoinGlobalState &gstate;
+	const PhysicalSpatialJoin &op;
+};
+
+class SpatialJoinRangeCountTask final : public ExecutorTask {
+public:
+	SpatialJoinRangeCountTask(shared_ptr<Event> event_p, ClientContext &context, SpatialJoinGlobalState &gstate,
+	                          const PhysicalSpatialJoin &op)
+	    : ExecutorTask(context, std::move(event_p), op), gstate(gstate), op(op) {
+	}
+
+	TaskExecutionResult ExecuteTask(TaskExecutionMode mode) override {
+		auto &collection = *gstate.collection;
+		auto &partition_state = *gstate.partition_state;
+
+		vector<idx_t> range_counts(SpatialJoinPartitionState::RANGE_COUNT, 0);
+		idx_t box_count = 0;
+
+		// Only the key column is scanned, which is always the first column in the layout
+		TupleDataLocalScanState scan_state;
+		DataChunk scan_chunk;
+		collection.InitializeScanChunk(partition_state.count_scan_state.scan_state, scan_chunk);
+
+		UnifiedVectorFormat key_format;
+		while (collection.Scan(partition_state.count_scan_state, scan_state, scan_chunk)) {
+			const auto row_count = scan_chunk.size();
+			scan_chunk.data[0].ToUnifiedFormat(row_count, key_format);
+			const auto keys = UnifiedVectorFormat::GetData<geometry_t>(key_format);
+
+			for (idx_t row_idx = 0; row_idx < row_count; row_idx++) {
+				const auto key_idx = key_format.sel->get_index(row_idx);
+				Box2D<float> bbox;
+				if (key_format.validity.RowIsValid(key_idx) && TryGetBuildSideBox(keys[key_idx], op.distance, bbox)) {
+					range_counts[SpatialJoinPartitionState::GetRange(partition_state.hilbert.Encode(bbox))]++;
+					box_count++;
+				}
+			}
+		}
+
+		lock_guard<mutex> guard(partition_state.lock);
+		for (idx_t range_idx = 0; range_idx < SpatialJoinPartitionState::RANGE_COUNT; range_idx++) {
+			partition_state.range_counts[range_idx] += range_counts[range_idx];
+		}
+		partition_state.box_count += box_count;
+
+		event->FinishTask();
+		return TaskExecutionResult::TASK_FINISHED;
+	}
+
+private:
+	SpatialJoinGlobalState &gstate;
+	const PhysicalSpatialJoin &op;
+};
+
+class SpatialJoinRangeCountEvent final : public BasePipelineEvent {
+public:
+	SpatialJoinRangeCountEvent(SpatialJoinGlobalState &gstate_p, Pipeline &pipeline_p, const PhysicalSpatialJoin &op_p)
+	    : BasePipelineEvent(pipeline_p), gstate(gstate_p), op(op_p) {
+	}
+
+	void Schedule() override {
+		auto &context = pipeline->GetClientContext();
+
+		vector<shared_ptr<Task>> tasks;
+		for (idx_t task_idx = 0; task_idx < gstate.partition_state->task_count; task_idx++) {
+			tasks.push_back(make_uniq<SpatialJoinRangeCountTask>(shared_from_this(), context, gstate, op));
+		}
+		SetTasks(std::move(tasks));
+	}
+
+	void FinishEvent() override {
+		auto &context = pipeline->GetClientContext();
+		auto &partition_state = *gstate.partition_state;
+
+		// Assign consecutive ranges to each partition, so that the partitions are roughly the same size.
+		// A new partition always starts at a non-empty range, so none of the partitions are empty.
+		const auto box_count = partition_state.box_count;
+		const auto partition_size =
+		    MaxValue<idx_t>((box_count + partition_state.partition_count - 1) / partition_state.partition_count, 1);
+		idx_t partition_idx = 0;
+		idx_t current_size = 0;
+		for (idx_t range_idx = 0; range_idx < SpatialJoinPartitionState::RANGE_COUNT; range_idx++) {
+			const auto range_count = partition_state.range_counts[range_idx];
+			if (current_size >= partition_size && range_count != 0) {
+				partition_idx++;
+				current_size = 0;
+			}
+			partition_state.range_partitions[range_idx] = partition_idx;
+			current_size += range_count;
+		}
+		partition_state.partition_count = partition_idx + 1;
+
+		if (partition_state.partition_count == 1) {
+			// Everything ended up in the same range, there is nothing to gain
+			gstate.partition_state.reset();
+			ScheduleRTreeBuild(context, op, gstate, *pipeline, *this);
+			return;
+		}
+
+		for (idx_t i = 0; i < partition_state.partition_count; i++) {
+			partition_state.build_collections.push_back(
+			    make_uniq<TupleDataCollection>(partition_state.buffer_manager, op.layout));
+		}
+		partition_state.partition_bounds.resize(partition_state.partition_count);
+
+		// We dont need the unpartitioned rows after scattering them
+		gstate.collection->InitializeScan(partition_state.scatter_scan_state,
+		                                  TupleDataPinProperties::DESTROY_AFTER_DONE);
+
+		InsertEvent(make_shared_ptr<SpatialJoinScatterEvent>(gstate, *pipeline, op));
+	}
+
+private:
+	SpatialJoinGlobalState &gstate;
+	const PhysicalSpatialJoin &op;
+};
+
+// Start partitioning the build side, if it does not fit in memory. Returns false if it does.
+bool TrySchedulePartitioning(ClientContext &context, const PhysicalSpatialJoin &op, SpatialJoinGlobalState &gstate,
+                             Pipeline &pipeline, Event &event) {
+	auto &collection = *gstate.collection;
+
+	const auto partition_count = GetBuildSidePartitionCount(context, collection);
+	if (partition_count == 0) {
+		return false;
+	}
+
+	auto &buffer_manager = BufferManager::GetBufferManager(context);
+	gstate.partition_state = make_uniq<SpatialJoinPartitionState>(buffer_manager, gstate.bounds, partition_count);
+
+	// Every task scans chunks of the build side until none are left
+	const auto thread_count = NumericCast<idx_t>(TaskScheduler::GetScheduler(context).NumberOfThreads());
+	gstate.partition_state->task_count = MaxValue<idx_t>(MinValue<idx_t>(thread_count, collection.ChunkCount()), 1);
+
+	const vector<column_t> key_column = {0};
+	collection.InitializeScan(gstate.partition_state->count_scan_state, key_column,
+	                          TupleDataPinProperties::UNPIN_AFTER_DONE);
+
+	event.InsertEvent(make_shared_ptr<SpatialJoinRangeCountEvent>(gstate, pipeline, op));
+	return true;
+}
+
+} // namespace
+
+// This is where we would build the rtree, by iterating through the tupledata collection we've created
+SinkFinalizeType PhysicalSpatialJoin::Finalize(Pipeline &pipeline, Event &event, ClientContext &context,
+                                               OperatorSinkFinalizeInput &input) const {
+	auto &gstate = input.global_state.Cast<SpatialJoinGlobalState>();
+
+	if (gstate.collection->Count() == 0) {
+		return EmptyResultIfRHSIsEmpty() ? SinkFinalizeType::NO_OUTPUT_POSSIBLE : SinkFinalizeType::READY;
+	}
+
+	if (HasEqualityConditions()) {
+		// Index each key on its own. This is not partitioned if it does not fit in memory (yet).
+		const auto thread_count = NumericCast<idx_t>(TaskScheduler::GetScheduler(context).NumberOfThreads());
+
+		gstate.keyed_rtrees = CreateKeyedRTrees(context, *this, *gstate.collection);
+
+		if (thread_count == 1 || gstate.collection->Count() < PARALLEL_BUILD_THRESHOLD) {
+			for (auto &entry : gstate.keyed_rtrees) {
+				entry.second->Build();
+			}
+		} else {
+			event.InsertEvent(make_uniq<SpatialJoinKeyedBuildEvent>(gstate, pipeline, *this));
+		}
+		return SinkFinalizeType::READY;
+	}
+
+	// If the build side does not fit in memory, split it into partitions that are joined one at a time by the source
+	if (CanPartitionBuildSide(join_type) && TrySchedulePartitioning(context, *this, gstate, pipeline, event)) {
+		return SinkFinalizeType::READY;
+	}
+
+	// Build the R-Tree once we've gathered everything
+	ScheduleRTreeBuild(context, *this, gstate, pipeline, event);
 	return SinkFinalizeType::READY;
 }
 
@@ -611,12 +1766,14 @@ class SpatialJoinLocalOperatorState final : public CachingOperatorState {
 public:
 	bool is_initialized = false;
 
-	idx_t input_index = 0;
 	SpatialJoinState state = SpatialJoinState::START;
 
 	DataChunk overflow_matches;
 
+	// Used to probe one row at a time, for SEMI, ANTI and MARK joins
 	FlatRTreeScanState scan;
+	// Used to probe a batch of rows at a time, for every other join
+	FlatRTreeBatchScanState batch_scan;
 
 	DataChunk probe_side_row_chunk; // holds the projected lhs columns
 	DataChunk probe_side_key_chunk; // holds the lhs probe key
@@ -639,13 +1796,54 @@ public:
 
 	uint8_t left_outer_marker[STANDARD_VECTOR_SIZE] = {};
 
+	// Which probe side rows have a match, for SEMI, ANTI and MARK joins
+	bool found_match[STANDARD_VECTOR_SIZE] = {};
+
 	idx_t build_side_match_offset = 0;
 	unsafe_unique_array<data_ptr_t> build_side_pointers = nullptr;
 
+	// When joining a partition of the build side in the source, the partition to probe instead of the resident one
+	optional_ptr<FlatRTree> partition_rtree;
+	optional_ptr<TupleDataCollection> partition_collection;
+
+	// The R-Tree every probe side row has to probe (if any), and the one of the row we are currently probing
+	optional_ptr<const FlatRTree> probe_side_rtrees[STANDARD_VECTOR_SIZE];
+	optional_ptr<const FlatRTree> probe_rtree;
+	// The hash of the probe side equality keys, if any
+	Vector probe_side_hashes;
+
+	// Used to evaluate the extra conditions on the pairs that satisfy the spatial predicate
+	ExpressionExecutor extra_condition_executor;
+	DataChunk extra_condition_chunk;
+	SelectionVector extra_probe_side_sel;
+	SelectionVector extra_sel;
+
+	// The box of every probe side row, and the rows to probe sorted by the hilbert key of their box
+	Box2D<float> probe_side_boxes[STANDARD_VECTOR_SIZE];
+	FlatRTreeSortEntry probe_order[STANDARD_VECTOR_SIZE];
+	idx_t probe_count = 0;
+	idx_t probe_pos = 0;
+	// The end of the batch of rows we are currently probing
+	idx_t probe_batch_end = 0;
+
+	// Used to spill the probe side rows that might join with the other partitions of the build side
+	SelectionVector spill_sel;
+	DataChunk spill_chunk;
+
+#if SPATIAL_USE_GEOS
+	// Evaluates the predicate with prepared build side geometries, if supported for the predicate
+	unique_ptr<GeosPreparedCache> prepared_cache;
+	// The cache statistics we have already added to the global state
+	idx_t prepared_cache_hits = 0;
+	idx_t prepared_cache_misses = 0;
+#endif
+
 	explicit SpatialJoinLocalOperatorState(ClientContext &context)
 	    : join_probe_executor(context), join_match_executor(context), probe_side_source_sel(STANDARD_VECTOR_SIZE),
 	      build_side_source_sel(STANDARD_VECTOR_SIZE), build_side_target_sel(STANDARD_VECTOR_SIZE),
-	      match_sel(STANDARD_VECTOR_SIZE), lhs_match_sel(STANDARD_VECTOR_SIZE) {
+	      match_sel(STANDARD_VECTOR_SIZE), lhs_match_sel(STANDARD_VECTOR_SIZE), probe_side_hashes(LogicalType::HASH),
+	      extra_condition_executor(context), extra_probe_side_sel(STANDARD_VECTOR_SIZE),
+	      extra_sel(STANDARD_VECTOR_SIZE), spill_sel(STANDARD_VECTOR_SIZE) {
 
 		build_side_pointers = make_unsafe_uniq_array<data_ptr_t>(STANDARD_VECTOR_SIZE);
 	}
@@ -654,28 +1852,70 @@ public:
 class SpatialJoinGlobalOperatorState final : public GlobalOperatorState {
 public:
 	unique_ptr<FlatRTree> rtree;
+	unordered_map<hash_t, unique_ptr<FlatRTree>> keyed_rtrees;
 	unique_ptr<TupleDataCollection> collection;
+
+	// The bounds of the build side, used to order the probe side rows when probing the keyed rtrees
+	Box2D<float> bounds;
+
+	// Prepared geometry cache statistics, summed over all threads
+	atomic<idx_t> prepared_cache_hits = {0};
+	atomic<idx_t> prepared_cache_misses = {0};
 };
 
+// The memory budget for the prepared geometry cache of each thread
+static constexpr idx_t PREPARED_CACHE_MEMORY_LIMIT = 64ULL * 1024ULL * 1024ULL;
+
+static bool HasPreparedCache(const SpatialJoinLocalOperatorState &lstate) {
+#if SPATIAL_USE_GEOS
+	return lstate.prepared_cache != nullptr;
+#else
+	return false;
+#endif
+}
+
 unique_ptr<OperatorState> PhysicalSpatialJoin::GetOperatorState(ExecutionContext &context) const {
 	auto lstate = make_uniq<SpatialJoinLocalOperatorState>(context.client);
 
 	// Create a match expression using the condition, that will be used to filter the results
 	lstate->match_expr = condition->Copy();
-	auto &func_expr = lstate->match_expr->Cast<BoundFunctionExpression>();
+	auto &func_expr = LogicalSpatialJoin::GetKeyFunction(*lstate->match_expr);
 	func_expr.children[0] = make_uniq<BoundReferenceExpression>(probe_side_key->return_type, 0);
 	func_expr.children[1] = make_uniq<BoundReferenceExpression>(build_side_key->return_type, 1);
 
 	lstate->join_match_executor.AddExpression(*lstate->match_expr);
 
-	// Add the probe side join key expression
+#if SPATIAL_USE_GEOS
+	// If both sides are GEOMETRY, try to keep the build side geometries prepared between candidate pairs
+	if (condition->GetExpressionClass() == ExpressionClass::BOUND_FUNCTION &&
+	    probe_side_key->return_type == GeoTypes::GEOMETRY() && build_side_key->return_type == GeoTypes::GEOMETRY()) {
+		const auto &predicate_name = condition->Cast<BoundFunctionExpression>().function.name;
+		lstate->prepared_cache = GeosPreparedCache::TryCreate(predicate_name, PREPARED_CACHE_MEMORY_LIMIT);
+	}
+#endif
+
+	// Add the probe side join key expression, followed by the keys of the equality conditions
+	vector<LogicalType> probe_side_key_types;
 	lstate->join_probe_executor.AddExpression(*probe_side_key);
+	probe_side_key_types.push_back(probe_side_key->return_type);
+	for (auto &equality : equality_conditions) {
+		lstate->join_probe_executor.AddExpression(*equality.left);
+		probe_side_key_types.push_back(equality.left->return_type);
+	}
+
+	if (extra_condition) {
+		lstate->extra_condition_executor.AddExpression(*extra_condition);
+		if (!extra_condition_types.empty()) {
+			lstate->extra_condition_chunk.Initialize(context.client, extra_condition_types);
+		}
+	}
 
 	// The chunks we need for the join
 	lstate->probe_side_row_chunk.Initialize(context.client, probe_side_output_types);
-	lstate->probe_side_key_chunk.Initialize(context.client, {probe_side_key->return_type});
+	lstate->probe_side_key_chunk.Initialize(context.client, probe_side_key_types);
 	lstate->build_side_key_chunk.Initialize(context.client, {build_side_key->return_type});
 	lstate->match_pred_arg_chunk.Initialize(context.client, {probe_side_key->return_type, build_side_key->return_type});
+	lstate->spill_chunk.InitializeEmpty(children[0].get().types);
 
 	return std::move(lstate);
 }
@@ -686,16 +1926,306 @@ unique_ptr<GlobalOperatorState> PhysicalSpatialJoin::GetGlobalOperatorState(Clie
 	auto result = make_uniq<SpatialJoinGlobalOperatorState>();
 	// Steal the built rtree from the sink state.
 	result->rtree = std::move(gstate.rtree);
+	result->keyed_rtrees = std::move(gstate.keyed_rtrees);
+	result->bounds = gstate.bounds;
 	// Steal the tuple data collection
 	result->collection = std::move(gstate.collection);
 
 	return std::move(result);
 }
 
+InsertionOrderPreservingMap<string> PhysicalSpatialJoin::ParamsToString() const {
+	// TODO: Add condition to the result (GetName is wrong)
+	auto result = PhysicalOperator::ParamsToString();
+	result["Join Type"] = EnumUtil::ToString(join_type);
+	string condition_info = condition->GetName();
+	for (auto &equality : equality_conditions) {
+		condition_info += "\n" + equality.left->GetName() + " = " + equality.right->GetName();
+	}
+	result["Conditions"] = condition_info;
+	if (distance > 0) {
+		result["Distance"] = Value::DOUBLE(distance).ToString();
+	}
+
+	// Once executed, report how often the prepared build side geometries could be reused
+	if (op_state) {
+		const auto &gstate = op_state->Cast<SpatialJoinGlobalOperatorState>();
+		const auto hits = gstate.prepared_cache_hits.load();
+		const auto misses = gstate.prepared_cache_misses.load();
+		if (hits + misses > 0) {
+			const auto hit_rate = static_cast<double>(hits) / static_cast<double>(hits + misses) * 100.0;
+			result["Prepared Cache Hit Rate"] = StringUtil::Format("%.2f%% (%llu/%llu)", hit_rate, hits, hits + misses);
+		}
+	}
+
+	SetEstimatedCardinality(result, estimated_cardinality);
+	return result;
+}
+
+// Find the R-Tree to probe for every probe side row. Without equality conditions this is the same one for every row,
+// otherwise it is the one of the hash of the probe side keys (if the build side has any row with that hash at all).
+static void GetProbeSideRTrees(const PhysicalSpatialJoin &op, const SpatialJoinGlobalOperatorState &gstate,
+                               optional_ptr<const FlatRTree> rtree, SpatialJoinLocalOperatorState &lstate,
+                               idx_t count) {
+	if (!op.HasEqualityConditions()) {
+		for (idx_t row_idx = 0; row_idx < count; row_idx++) {
+			lstate.probe_side_rtrees[row_idx] = rtree;
+		}
+		return;
+	}
+
+	// The equality keys follow the spatial key
+	auto &keys = lstate.probe_side_key_chunk;
+	VectorOperations::Hash(keys.data[1], lstate.probe_side_hashes, count);
+	for (idx_t key_idx = 2; key_idx < keys.ColumnCount(); key_idx++) {
+		VectorOperations::CombineHash(lstate.probe_side_hashes, keys.data[key_idx], count);
+	}
+
+	UnifiedVectorFormat hash_format;
+	lstate.probe_side_hashes.ToUnifiedFormat(count, hash_format);
+	const auto hashes = UnifiedVectorFormat::GetData<hash_t>(hash_format);
+
+	for (idx_t row_idx = 0; row_idx < count; row_idx++) {
+		const auto entry = gstate.keyed_rtrees.find(hashes[hash_format.sel->get_index(row_idx)]);
+		lstate.probe_side_rtrees[row_idx] = entry == gstate.keyed_rtrees.end() ? nullptr : entry->second.get();
+	}
+
+	// NULL keys are never equal to anything, so dont bother probing them
+	for (idx_t key_idx = 1; key_idx < keys.ColumnCount(); key_idx++) {
+		UnifiedVectorFormat key_format;
+		keys.data[key_idx].ToUnifiedFormat(count, key_format);
+		if (key_format.validity.AllValid()) {
+			continue;
+		}
+		for (idx_t row_idx = 0; row_idx < count; row_idx++) {
+			if (!key_format.validity.RowIsValid(key_format.sel->get_index(row_idx))) {
+				lstate.probe_side_rtrees[row_idx] = nullptr;
+			}
+		}
+	}
+}
+
+// Compute the box of every probe side row, and sort the rows to probe by their R-Tree and the hilbert key of their box.
+// Consecutive probes then mostly visit the same nodes of the same tree, so they are probed together in batches.
+static void OrderProbeSide(const Box2D<float> &bounds, SpatialJoinLocalOperatorState &lstate, idx_t count) {
+	const auto &key_format = lstate.probe_side_key_vformat;
+	const auto keys = UnifiedVectorFormat::GetData<geometry_t>(key_format);
+	const HilbertEncoder hilbert(bounds);
+
+	lstate.probe_count = 0;
+	lstate.probe_pos = 0;
+
+	for (idx_t row_idx = 0; row_idx < count; row_idx++) {
+		const auto key_idx = key_format.sel->get_index(row_idx);
+		auto &bbox = lstate.probe_side_boxes[row_idx];
+		if (!key_format.validity.RowIsValid(key_idx) || !keys[key_idx].TryGetCachedBounds(bbox)) {
+			// NULL and empty geometries never match, the empty box does not intersect anything
+			bbox = Box2D<float>();
+			continue;
+		}
+
+		if (!lstate.probe_side_rtrees[row_idx]) {
+			// There is nothing to probe for this row
+			continue;
+		}
+
+		auto &entry = lstate.probe_order[lstate.probe_count++];
+		entry.key = hilbert.Encode(bbox);
+		entry.idx = UnsafeNumericCast<uint32_t>(row_idx);
+	}
+
+	// With equality conditions the rows probe different trees, keep the rows of each tree next to each other
+	const auto rtrees = lstate.probe_side_rtrees;
+	std::sort(lstate.probe_order, lstate.probe_order + lstate.probe_count,
+	          [&](const FlatRTreeSortEntry &a, const FlatRTreeSortEntry &b) {
+		          const auto a_rtree = rtrees[a.idx].get();
+		          const auto b_rtree = rtrees[b.idx].get();
+		          if (a_rtree != b_rtree) {
+			          return std::less<const FlatRTree *>()(a_rtree, b_rtree);
+		          }
+		          return a < b;
+	          });
+}
+
+// Evaluate the extra conditions on the "count" pairs selected by the match selection vector, and remove the pairs
+// that dont satisfy them from it. Returns the number of pairs left.
+static idx_t SelectExtraConditions(const PhysicalSpatialJoin &op, SpatialJoinLocalOperatorState &lstate,
+                                   TupleDataCollection &collection, DataChunk &input, const data_ptr_t *build_ptrs,
+                                   idx_t count) {
+	auto &extra_chunk = lstate.extra_condition_chunk;
+	extra_chunk.Reset();
+
+	// Reference the probe side columns of each pair
+	for (idx_t i = 0; i < count; i++) {
+		const auto pair_idx = lstate.match_sel.get_index(i);
+		lstate.extra_probe_side_sel.set_index(i, lstate.probe_side_source_sel.get_index(pair_idx));
+	}
+	for (idx_t col_idx = 0; col_idx < op.extra_probe_side_columns.size(); col_idx++) {
+		extra_chunk.data[col_idx].Slice(input.data[op.extra_probe_side_columns[col_idx]],
+		                                lstate.extra_probe_side_sel, count);
+	}
+
+	// And gather the build side columns of each pair
+	Vector build_ptr_vector(LogicalType::POINTER, reinterpret_cast<data_ptr_t>(const_cast<data_ptr_t *>(build_ptrs)));
+	const auto probe_side_column_count = op.extra_probe_side_columns.size();
+	for (idx_t col_idx = 0; col_idx < op.extra_build_side_columns.size(); col_idx++) {
+		collection.Gather(build_ptr_vector, lstate.match_sel, count, op.extra_build_side_columns[col_idx],
+		                  extra_chunk.data[probe_side_column_count + col_idx],
+		                  *FlatVector::IncrementalSelectionVector(), nullptr);
+	}
+	extra_chunk.SetCardinality(count);
+
+	const auto result_count = lstate.extra_condition_executor.SelectExpression(extra_chunk, lstate.extra_sel);
+
+	// The selection is in ascending order, so we can compact the match selection in place
+	for (idx_t i = 0; i < result_count; i++) {
+		lstate.match_sel.set_index(i, lstate.match_sel.get_index(lstate.extra_sel.get_index(i)));
+	}
+	return result_count;
+}
+
+// Evaluate the join predicate on the candidate pairs gathered into the local state, and write the index of every pair
+// that matched to the match selection vector. Returns the number of matches.
+// The i'th pair is the probe side row at probe_side_source_sel[i] and the build side row at build_ptrs[i], with its key
+// gathered at row i of the build side key chunk.
+static idx_t SelectMatches(const PhysicalSpatialJoin &op, SpatialJoinGlobalOperatorState &gstate,
+                           SpatialJoinLocalOperatorState &lstate, TupleDataCollection &collection, DataChunk &input,
+                           const data_ptr_t *build_ptrs, idx_t count) {
+	idx_t filtered = 0;
+#if SPATIAL_USE_GEOS
+	if (lstate.prepared_cache) {
+		auto &cache = *lstate.prepared_cache;
+		filtered = cache.Select(lstate.probe_side_key_vformat, lstate.probe_side_source_sel,
+		                        lstate.build_side_key_chunk.data[0], build_ptrs, count, lstate.match_sel);
+
+		// Publish the cache statistics
+		gstate.prepared_cache_hits += cache.GetHitCount() - lstate.prepared_cache_hits;
+		gstate.prepared_cache_misses += cache.GetMissCount() - lstate.prepared_cache_misses;
+		lstate.prepared_cache_hits = cache.GetHitCount();
+		lstate.prepared_cache_misses = cache.GetMissCount();
+	} else
+#endif
+	{
+		lstate.match_pred_arg_chunk.data[0].Slice(lstate.probe_side_key_chunk.data[0], lstate.probe_side_source_sel,
+		                                          count);
+		lstate.match_pred_arg_chunk.data[1].Reference(lstate.build_side_key_chunk.data[0]);
+		lstate.match_pred_arg_chunk.SetCardinality(count);
+
+		filtered = lstate.join_match_executor.SelectExpression(lstate.match_pred_arg_chunk, lstate.match_sel);
+	}
+
+	if (op.extra_condition && filtered != 0) {
+		filtered = SelectExtraConditions(op, lstate, collection, input, build_ptrs, filtered);
+	}
+	return filtered;
+}
+
+// SEMI, ANTI and MARK joins only have to know whether each probe side row has a match.
+// So instead of emitting the candidate pairs, evaluate the predicate on the candidates of one probe row at a time,
+// and stop searching the tree for the row as soon as one of them matches.
+static void ExecuteExistenceJoin(const PhysicalSpatialJoin &op, optional_ptr<const FlatRTree> rtree,
+                                 TupleDataCollection &collection, SpatialJoinGlobalOperatorState &gstate,
+                                 SpatialJoinLocalOperatorState &lstate, DataChunk &input, DataChunk &chunk) {
+	lstate.join_probe_executor.Execute(input, lstate.probe_side_key_chunk);
+	lstate.probe_side_key_chunk.data[0].ToUnifiedFormat(input.size(), lstate.probe_side_key_vformat);
+	lstate.probe_side_row_chunk.ReferenceColumns(input, op.probe_side_output_columns);
+
+	GetProbeSideRTrees(op, gstate, rtree, lstate, input.size());
+	OrderProbeSide(rtree ? rtree->GetBounds() : gstate.bounds, lstate, input.size());
+	memset(lstate.found_match, 0, sizeof(lstate.found_match));
+
+	auto &sel = *FlatVector::IncrementalSelectionVector();
+	const auto build_ptrs = FlatVector::GetData<data_ptr_t>(lstate.scan.matches);
+
+	for (idx_t probe_pos = 0; probe_pos < lstate.probe_count; probe_pos++) {
+		const auto row_idx = lstate.probe_order[probe_pos].idx;
+		const auto &row_rtree = *lstate.probe_side_rtrees[row_idx];
+		row_rtree.InitScan(lstate.scan, lstate.probe_side_boxes[row_idx]);
+
+		while (!lstate.found_match[row_idx] && row_rtree.Scan(lstate.scan)) {
+			const auto candidate_count = lstate.scan.matches_count;
+			for (idx_t i = 0; i < candidate_count; i++) {
+				lstate.probe_side_source_sel.set_index(i, row_idx);
+			}
+
+			// The key column is always the first column in the layout
+			collection.Gather(lstate.scan.matches, sel, candidate_count, 0, lstate.build_side_key_chunk.data[0], sel,
+			                  nullptr);
+
+			if (SelectMatches(op, gstate, lstate, collection, input, build_ptrs, candidate_count) != 0) {
+				lstate.found_match[row_idx] = true;
+			}
+		}
+	}
+
+	switch (op.join_type) {
+	case JoinType::SEMI:
+		PhysicalJoin::ConstructSemiJoinResult(lstate.probe_side_row_chunk, chunk, lstate.found_match);
+		break;
+	case JoinType::ANTI:
+		PhysicalJoin::ConstructAntiJoinResult(lstate.probe_side_row_chunk, chunk, lstate.found_match);
+		break;
+	case JoinType::MARK: {
+		// Like any other join condition, a predicate on a NULL geometry is not a match, so the marker is never NULL
+		auto &probe_rows = lstate.probe_side_row_chunk;
+		for (idx_t col_idx = 0; col_idx < probe_rows.ColumnCount(); col_idx++) {
+			chunk.data[col_idx].Reference(probe_rows.data[col_idx]);
+		}
+		auto &mark_vector = chunk.data.back();
+		mark_vector.SetVectorType(VectorType::FLAT_VECTOR);
+		const auto mark_data = FlatVector::GetData<bool>(mark_vector);
+		for (idx_t row_idx = 0; row_idx < input.size(); row_idx++) {
+			mark_data[row_idx] = lstate.found_match[row_idx];
+		}
+		chunk.SetCardinality(input.size());
+	} break;
+	default:
+		throw InternalException("Unsupported join type for spatial existence join");
+	}
+}
+
+// Spill the probe side rows that might join with the partitions of the build side that are not resident
+static void SpillProbeSide(SpatialJoinGlobalState &sink, SpatialJoinLocalOperatorState &lstate, DataChunk &input) {
+	for (auto &partition_ptr : sink.partitions) {
+		auto &partition = *partition_ptr;
+
+		idx_t spill_count = 0;
+		for (idx_t row_idx = 0; row_idx < input.size(); row_idx++) {
+			if (partition.bounds.Intersects(lstate.probe_side_boxes[row_idx])) {
+				lstate.spill_sel.set_index(spill_count++, row_idx);
+			}
+		}
+
+		if (spill_count == 0) {
+			continue;
+		}
+
+		lstate.spill_chunk.Slice(input, lstate.spill_sel, spill_count);
+
+		lock_guard<mutex> guard(partition.probe_lock);
+		partition.probe_collection->Append(partition.probe_append_state, lstate.spill_chunk);
+	}
+}
+
 OperatorResultType PhysicalSpatialJoin::ExecuteInternal(ExecutionContext &context, DataChunk &input, DataChunk &chunk,
                                                         GlobalOperatorState &gstate_p, OperatorState &lstate_p) const {
 	auto &gstate = gstate_p.Cast<SpatialJoinGlobalOperatorState>();
 	auto &lstate = lstate_p.Cast<SpatialJoinLocalOperatorState>();
+	auto &sink = sink_state->Cast<SpatialJoinGlobalState>();
+
+	// When joining a partition of the build side, probe that instead of the resident build side
+	const auto probing_partition = lstate.partition_rtree != nullptr;
+	const auto rtree = probing_partition ? lstate.partition_rtree.get() : gstate.rtree.get();
+	const auto collection = probing_partition ? lstate.partition_collection.get() : gstate.collection.get();
+
+	// With equality conditions, there is no single rtree but one per key
+	const auto build_side_empty =
+	    HasEqualityConditions() ? gstate.keyed_rtrees.empty() : rtree == nullptr || rtree->Count() == 0;
+
+	if (!ProjectsBuildSide(join_type) && !build_side_empty) {
+		ExecuteExistenceJoin(*this, rtree, *collection, gstate, lstate, input, chunk);
+		return OperatorResultType::NEED_MORE_INPUT;
+	}
 
 	idx_t output_index = 0;
 	idx_t output_count = chunk.GetCapacity();
@@ -707,7 +2237,7 @@ OperatorResultType PhysicalSpatialJoin::ExecuteInternal(ExecutionContext &contex
 		//--------------------------------------------------------------------------------------------------------------
 		case SpatialJoinState::START: {
 			// Check if the build side is empty
-			if (gstate.rtree == nullptr || gstate.rtree->Count() == 0) {
+			if (build_side_empty) {
 				if (EmptyResultIfRHSIsEmpty()) {
 					return OperatorResultType::FINISHED;
 				}
@@ -731,14 +2261,22 @@ OperatorResultType PhysicalSpatialJoin::ExecuteInternal(ExecutionContext &contex
 			lstate.join_probe_executor.Execute(input, lstate.probe_side_key_chunk);
 			lstate.probe_side_key_chunk.data[0].ToUnifiedFormat(input.size(), lstate.probe_side_key_vformat);
 
+			// Decide which rtree to probe for each row, and in which order to probe the rows
+			GetProbeSideRTrees(*this, gstate, rtree, lstate, input.size());
+			OrderProbeSide(rtree ? rtree->GetBounds() : gstate.bounds, lstate, input.size());
+
+			// If the build side is partitioned, spill the rows that might join with the other partitions
+			if (!probing_partition && !sink.partitions.empty()) {
+				SpillProbeSide(sink, lstate, input);
+			}
+
 			// Reference the columns that we actually care about
 			lstate.probe_side_row_chunk.ReferenceColumns(input, probe_side_output_columns);
 
 			// zero miss vector
 			memset(lstate.left_outer_marker, 0, sizeof(lstate.left_outer_marker));
 
-			// Reset the input index and move on to the next state
-			lstate.input_index = 0;
+			// Move on to the next state
 			lstate.state = SpatialJoinState::PROBE;
 
 		} // fall through
@@ -746,30 +2284,34 @@ OperatorResultType PhysicalSpatialJoin::ExecuteInternal(ExecutionContext &contex
 		// PROBE
 		//--------------------------------------------------------------------------------------------------------------
 		case SpatialJoinState::PROBE: {
-			if (lstate.input_index == input.size()) {
+			if (lstate.probe_pos == lstate.probe_count) {
 				lstate.state = SpatialJoinState::EMIT;
 				continue;
 			}
 
-			const auto geom_idx = lstate.probe_side_key_vformat.sel->get_index(lstate.input_index);
-			if (!lstate.probe_side_key_vformat.validity.RowIsValid(geom_idx)) {
-				lstate.input_index++;
-				continue;
-			}
-
-			const auto geom_ptr = UnifiedVectorFormat::GetData<geometry_t>(lstate.probe_side_key_vformat);
-			const auto &geom = geom_ptr[geom_idx];
-
-			Box2D<float> bbox;
-			if (!geom.TryGetCachedBounds(bbox)) {
-				lstate.input_index++;
-				continue;
+			// Get the next batch of rows to probe. These are next to each other on the hilbert curve, so they mostly
+			// visit the same nodes of the tree, which are then only visited once for the whole batch.
+			auto &batch = lstate.batch_scan;
+			lstate.probe_rtree = lstate.probe_side_rtrees[lstate.probe_order[lstate.probe_pos].idx];
+			batch.probe_count = 0;
+			lstate.probe_batch_end = lstate.probe_pos;
+			while (lstate.probe_batch_end < lstate.probe_count &&
+			       batch.probe_count < FlatRTreeBatchScanState::MAX_BATCH_SIZE) {
+				const auto row_idx = lstate.probe_order[lstate.probe_batch_end].idx;
+				if (lstate.probe_side_rtrees[row_idx] != lstate.probe_rtree) {
+					// With equality conditions, every batch only probes the rtree of a single key
+					break;
+				}
+				batch.probe_boxes[batch.probe_count] = lstate.probe_side_boxes[row_idx];
+				batch.probe_rows[batch.probe_count] = row_idx;
+				batch.probe_count++;
+				lstate.probe_batch_end++;
 			}
 
-			gstate.rtree->InitScan(lstate.scan, bbox);
+			lstate.probe_rtree->InitBatchScan(batch);
 
-			if (!gstate.rtree->Scan(lstate.scan)) {
-				lstate.input_index++;
+			if (!lstate.probe_rtree->BatchScan(batch)) {
+				lstate.probe_pos = lstate.probe_batch_end;
 				continue;
 			}
 
@@ -779,14 +2321,15 @@ OperatorResultType PhysicalSpatialJoin::ExecuteInternal(ExecutionContext &contex
 		// SCAN
 		//--------------------------------------------------------------------------------------------------------------
 		case SpatialJoinState::SCAN: {
-			const auto matches_remaining = lstate.scan.matches_count - lstate.scan.matches_idx;
+			auto &batch = lstate.batch_scan;
+			const auto matches_remaining = batch.matches_count - batch.matches_idx;
 			if (matches_remaining == 0) {
 				// We are out of matches. Try to get the next probe
-				if (gstate.rtree->Scan(lstate.scan)) {
+				if (lstate.probe_rtree->BatchScan(batch)) {
 					continue;
 				}
-				// Otherwise, we are done with this probe
-				lstate.input_index++;
+				// Otherwise, we are done with this batch
+				lstate.probe_pos = lstate.probe_batch_end;
 				lstate.state = SpatialJoinState::PROBE;
 				continue;
 			}
@@ -799,23 +2342,22 @@ OperatorResultType PhysicalSpatialJoin::ExecuteInternal(ExecutionContext &contex
 			for (idx_t i = 0; i < scan_count; i++) {
 				// These control what we gather from the build side
 				lstate.build_side_target_sel.set_index(i, output_index + i);
-				lstate.build_side_source_sel.set_index(i, lstate.scan.matches_idx + i);
+				lstate.build_side_source_sel.set_index(i, batch.matches_idx + i);
 
 				// This stores which probe side row we used to gather the build side
-				lstate.probe_side_source_sel.set_index(output_index + i, lstate.input_index);
+				lstate.probe_side_source_sel.set_index(output_index + i, batch.match_rows[batch.matches_idx + i]);
 			}
 
 			// Fetch each column from the build side
-			D_ASSERT(build_side_key_types.size() == 1);
-			// TODO: Add more key conditions here
+			// The spatial key is always the first column in the layout
 			constexpr auto build_side_key_col = 0;
 
-			auto &row_pointers = lstate.scan.matches;
+			auto &row_pointers = batch.matches;
 
 			// Collect the build side join key(s)
 			// TODO: Multiple join keys
-			gstate.collection->Gather(row_pointers, lstate.build_side_source_sel, scan_count, build_side_key_col,
-			                          lstate.build_side_key_chunk.data[0], lstate.build_side_target_sel, nullptr);
+			collection->Gather(row_pointers, lstate.build_side_source_sel, scan_count, build_side_key_col,
+			                   lstate.build_side_key_chunk.data[0], lstate.build_side_target_sel, nullptr);
 
 			// Now, lets collect the rest of the build side columns
 			for (idx_t i = 0; i < build_side_output_columns.size(); i++) {
@@ -824,12 +2366,13 @@ OperatorResultType PhysicalSpatialJoin::ExecuteInternal(ExecutionContext &contex
 				D_ASSERT(target.GetType() == build_side_output_types[i]);
 
 				// TODO: We should use cached cast vectors here to improve performance of nested array payloads
-				gstate.collection->Gather(row_pointers, lstate.build_side_source_sel, scan_count, build_side_col_idx,
-				                          target, lstate.build_side_target_sel, nullptr);
+				collection->Gather(row_pointers, lstate.build_side_source_sel, scan_count, build_side_col_idx, target,
+				                   lstate.build_side_target_sel, nullptr);
 			}
 
-			// Also collect the build side row pointers (if we have a match column)
-			if (IsRightOuterJoin(join_type)) {
+			// Also collect the build side row pointers (if we have a match column, key the prepared cache on them, or
+			// have to gather the columns of the extra conditions)
+			if (IsRightOuterJoin(join_type) || HasPreparedCache(lstate) || extra_condition) {
 				const auto ptrs = FlatVector::GetData<data_ptr_t>(row_pointers);
 				for (idx_t i = 0; i < scan_count; i++) {
 					lstate.build_side_pointers[output_index + i] = ptrs[i];
@@ -838,7 +2381,7 @@ OperatorResultType PhysicalSpatialJoin::ExecuteInternal(ExecutionContext &contex
 
 			// Increment the output and match index
 			output_index += scan_count;
-			lstate.scan.matches_idx += scan_count;
+			batch.matches_idx += scan_count;
 
 			if (output_index != output_count) {
 				// We still have space left. Scan more!
@@ -856,13 +2399,8 @@ OperatorResultType PhysicalSpatialJoin::ExecuteInternal(ExecutionContext &contex
 			chunk.Slice(lstate.probe_side_row_chunk, lstate.probe_side_source_sel, output_index);
 
 			// Now, lets actually evaluate the predicate
-			lstate.match_pred_arg_chunk.data[0].Slice(lstate.probe_side_key_chunk.data[0], lstate.probe_side_source_sel,
-			                                          output_index);
-			lstate.match_pred_arg_chunk.data[1].Reference(lstate.build_side_key_chunk.data[0]);
-			lstate.match_pred_arg_chunk.SetCardinality(output_index);
-
-			const auto filtered =
-			    lstate.join_match_executor.SelectExpression(lstate.match_pred_arg_chunk, lstate.match_sel);
+			const auto filtered = SelectMatches(*this, gstate, lstate, *collection, input,
+			                                    lstate.build_side_pointers.get(), output_index);
 
 			if (IsLeftOuterJoin(join_type)) {
 				for (idx_t i = 0; i < filtered; i++) {
@@ -892,7 +2430,7 @@ OperatorResultType PhysicalSpatialJoin::ExecuteInternal(ExecutionContext &contex
 
 			chunk.Slice(lstate.match_sel, filtered);
 
-			if (lstate.input_index != input.size()) {
+			if (lstate.probe_pos != lstate.probe_count) {
 				// We still have more input rows to process
 				lstate.state = SpatialJoinState::SCAN;
 				return OperatorResultType::HAVE_MORE_OUTPUT;
@@ -947,22 +2485,34 @@ OperatorResultType PhysicalSpatialJoin::ExecuteInternal(ExecutionContext &contex
 //----------------------------------------------------------------------------------------------------------------------
 // Source Interface
 //----------------------------------------------------------------------------------------------------------------------
+// The build side columns to scan when emitting the build side rows that did not match, for RIGHT/OUTER joins
+static vector<column_t> GetUnmatchedScanColumns(const PhysicalSpatialJoin &op) {
+	vector<column_t> column_ids;
+
+	column_ids.insert(column_ids.end(), op.build_side_output_columns.begin(), op.build_side_output_columns.end());
+
+	// Also add the match column
+	column_ids.push_back(op.build_side_key_types.size() + op.build_side_payload_types.size());
+
+	return column_ids;
+}
+
 class SpatialJoinGlobalSourceState final : public GlobalSourceState {
 public:
 	explicit SpatialJoinGlobalSourceState(const PhysicalSpatialJoin &op) : op(op) {
 		D_ASSERT(op.sink_state);
-		const auto &state = op.op_state->Cast<SpatialJoinGlobalOperatorState>();
-
-		// Initialize a parallel scan
-		vector<column_t> column_ids;
 
-		column_ids.insert(column_ids.end(), op.build_side_output_columns.begin(), op.build_side_output_columns.end());
+		if (!PropagatesBuildSide(op.join_type)) {
+			// We only have to join the partitions of the build side that did not fit in memory
+			return;
+		}
 
-		// Also add the match column
-		column_ids.push_back(op.build_side_key_types.size() + op.build_side_payload_types.size());
+		const auto &state = op.op_state->Cast<SpatialJoinGlobalOperatorState>();
 
+		// Initialize a parallel scan
 		// We dont need to keep the tuples aroun after scanning
-		state.collection->InitializeScan(scan_state, std::move(column_ids), TupleDataPinProperties::DESTROY_AFTER_DONE);
+		state.collection->InitializeScan(scan_state, GetUnmatchedScanColumns(op),
+		                                 TupleDataPinProperties::DESTROY_AFTER_DONE);
 
 		tuples_maximum = state.collection->Count();
 	}
@@ -970,42 +2520,70 @@ public:
 	const PhysicalSpatialJoin &op;
 	TupleDataParallelScanState scan_state;
 
+	// The next partition of the build side to join
+	atomic<idx_t> next_partition = {0};
+
 	// How many tuples we have scanned so far
 	idx_t tuples_maximum = 0;
 	atomic<idx_t> tuples_scanned = {0};
 
 public:
 	idx_t MaxThreads() override {
-		const auto &state = op.op_state->Cast<SpatialJoinGlobalOperatorState>();
-		const auto count = state.collection->Count();
+		// Every thread joins a partition of the build side at a time
+		const auto &sink = op.sink_state->Cast<SpatialJoinGlobalState>();
+		idx_t max_threads = sink.partitions.size();
+
+		if (PropagatesBuildSide(op.join_type)) {
+			const auto &state = op.op_state->Cast<SpatialJoinGlobalOperatorState>();
+			const auto count = state.collection->Count();
 
-		// Rough approximation of the number of threads to use
-		return count / (STANDARD_VECTOR_SIZE * 10ULL);
+			// Rough approximation of the number of threads to use
+			max_threads = MaxValue<idx_t>(max_threads, count / (STANDARD_VECTOR_SIZE * 10ULL));
+		}
+
+		return max_threads;
 	}
 };
 
 class SpatialJoinLocalSourceState final : public LocalSourceState {
 public:
-	explicit SpatialJoinLocalSourceState(const PhysicalSpatialJoin &op) : match_sel(STANDARD_VECTOR_SIZE) {
+	SpatialJoinLocalSourceState(const PhysicalSpatialJoin &op, ClientContext &context)
+	    : match_sel(STANDARD_VECTOR_SIZE) {
 
 		D_ASSERT(op.sink_state);
-		const auto &state = op.op_state->Cast<SpatialJoinGlobalOperatorState>();
 
-		vector<column_t> column_ids;
+		const auto &sink = op.sink_state->Cast<SpatialJoinGlobalState>();
+		if (!sink.partitions.empty()) {
+			probe_chunk.Initialize(context, op.children[0].get().types);
+		}
 
-		column_ids.insert(column_ids.end(), op.build_side_output_columns.begin(), op.build_side_output_columns.end());
+		if (!PropagatesBuildSide(op.join_type)) {
+			return;
+		}
 
-		// Also add the match column
-		column_ids.push_back(op.build_side_key_types.size() + op.build_side_payload_types.size());
+		const auto &state = op.op_state->Cast<SpatialJoinGlobalOperatorState>();
 
 		// We dont need to keep the tuples aroun after scanning
-		state.collection->InitializeScan(scan_state, std::move(column_ids), TupleDataPinProperties::DESTROY_AFTER_DONE);
+		state.collection->InitializeScan(scan_state, GetUnmatchedScanColumns(op),
+		                                 TupleDataPinProperties::DESTROY_AFTER_DONE);
 		state.collection->InitializeScanChunk(scan_state, scan_chunk);
 	}
 
 	TupleDataLocalScanState scan_state;
 	DataChunk scan_chunk;
 	SelectionVector match_sel;
+
+	// The partition of the build side this thread is joining, if any
+	optional_ptr<SpatialJoinPartition> partition;
+	unique_ptr<FlatRTree> partition_rtree;
+	// The operator state used to probe the partition with the spilled probe side rows
+	unique_ptr<OperatorState> probe_state;
+	ColumnDataScanState probe_scan_state;
+	DataChunk probe_chunk;
+	bool probe_needs_input = true;
+	// Used to emit the rows of the partition that did not match, for RIGHT joins
+	bool scanning_unmatched = false;
+	TupleDataScanState partition_scan_state;
 };
 
 unique_ptr<GlobalSourceState> PhysicalSpatialJoin::GetGlobalSourceState(ClientContext &context) const {
@@ -1015,51 +2593,135 @@ unique_ptr<GlobalSourceState> PhysicalSpatialJoin::GetGlobalSourceState(ClientCo
 
 unique_ptr<LocalSourceState> PhysicalSpatialJoin::GetLocalSourceState(ExecutionContext &context,
                                                                       GlobalSourceState &gstate_p) const {
-	auto lstate = make_uniq<SpatialJoinLocalSourceState>(*this);
+	auto lstate = make_uniq<SpatialJoinLocalSourceState>(*this, context.client);
 	return std::move(lstate);
 }
 
+// Select the build side rows of a scanned chunk that did not match any probe side row, and emit them with the probe
+// side columns set to NULL. Returns false if all rows matched.
+static bool EmitUnmatchedBuildSide(const PhysicalSpatialJoin &op, DataChunk &scan_chunk, SelectionVector &match_sel,
+                                   DataChunk &chunk) {
+	const auto matches = FlatVector::GetData<bool>(scan_chunk.data.back());
+
+	idx_t result_count = 0;
+	for (idx_t i = 0; i < scan_chunk.size(); i++) {
+		if (!matches[i]) {
+			match_sel.set_index(result_count++, i);
+		}
+	}
+
+	if (result_count == 0) {
+		return false;
+	}
+
+	const auto lhs_col_count = op.probe_side_output_columns.size();
+	const auto rhs_col_count = op.build_side_output_columns.size();
+
+	// Null the LHS columns
+	for (idx_t i = 0; i < lhs_col_count; i++) {
+		auto &target = chunk.data[i];
+		target.SetVectorType(VectorType::CONSTANT_VECTOR);
+		ConstantVector::SetNull(target, true);
+	}
+
+	// Set the RHS columns
+	for (idx_t i = 0; i < rhs_col_count; i++) {
+		auto &target = chunk.data[lhs_col_count + i];
+		// Offset by one here to skip the match column
+		target.Slice(scan_chunk.data[i], match_sel, result_count);
+	}
+
+	chunk.SetCardinality(result_count);
+	return true;
+}
+
 SourceResultType PhysicalSpatialJoin::GetData(ExecutionContext &context, DataChunk &chunk,
                                               OperatorSourceInput &input) const {
-	D_ASSERT(PropagatesBuildSide(join_type));
-
 	auto &gstate = input.global_state.Cast<SpatialJoinGlobalSourceState>();
 	auto &lstate = input.local_state.Cast<SpatialJoinLocalSourceState>();
+	auto &sink = sink_state->Cast<SpatialJoinGlobalState>();
+
+	// First, join the partitions of the build side that did not fit in memory. Every thread joins a partition at a
+	// time, by indexing it and probing it with the probe side rows that were spilled for it.
+	while (!sink.partitions.empty()) {
+		if (!lstate.partition) {
+			const auto partition_idx = gstate.next_partition++;
+			if (partition_idx >= sink.partitions.size()) {
+				break;
+			}
 
-	const auto &tuples = gstate.op.op_state->Cast<SpatialJoinGlobalOperatorState>().collection;
+			lstate.partition = sink.partitions[partition_idx].get();
+			lstate.partition_rtree = CreateRTree(context.client, *lstate.partition->build_collection, distance);
+			lstate.partition_rtree->Build();
 
-	while (tuples->Scan(gstate.scan_state, lstate.scan_state, lstate.scan_chunk)) {
-		gstate.tuples_scanned += lstate.scan_chunk.size();
+			// Use a new operator state for every partition. Row pointers (which the prepared geometry cache is keyed
+			// on) might be reused once the previous partition has been destroyed.
+			lstate.probe_state = GetOperatorState(context);
+			auto &probe_state = lstate.probe_state->Cast<SpatialJoinLocalOperatorState>();
+			probe_state.partition_rtree = lstate.partition_rtree.get();
+			probe_state.partition_collection = lstate.partition->build_collection.get();
+
+			lstate.partition->probe_collection->InitializeScan(lstate.probe_scan_state);
+			lstate.probe_needs_input = true;
+			lstate.scanning_unmatched = false;
+		}
 
-		const auto matches = FlatVector::GetData<bool>(lstate.scan_chunk.data.back());
+		auto &partition = *lstate.partition;
+
+		if (!lstate.scanning_unmatched) {
+			if (lstate.probe_needs_input) {
+				if (!partition.probe_collection->Scan(lstate.probe_scan_state, lstate.probe_chunk)) {
+					// We've probed all spilled rows
+					if (PropagatesBuildSide(join_type)) {
+						partition.build_collection->InitializeScan(lstate.partition_scan_state,
+						                                           GetUnmatchedScanColumns(*this),
+						                                           TupleDataPinProperties::DESTROY_AFTER_DONE);
+					}
+					lstate.scanning_unmatched = true;
+					continue;
+				}
+				lstate.probe_needs_input = false;
+			}
 
-		idx_t result_count = 0;
-		for (idx_t i = 0; i < lstate.scan_chunk.size(); i++) {
-			if (!matches[i]) {
-				lstate.match_sel.set_index(result_count++, i);
+			chunk.Reset();
+			const auto result = ExecuteInternal(context, lstate.probe_chunk, chunk, *op_state, *lstate.probe_state);
+			if (result == OperatorResultType::NEED_MORE_INPUT) {
+				lstate.probe_needs_input = true;
 			}
+			if (chunk.size() != 0) {
+				return SourceResultType::HAVE_MORE_OUTPUT;
+			}
+			continue;
 		}
 
-		if (result_count > 0) {
+		// For RIGHT joins, emit the rows of the partition that did not match
+		if (PropagatesBuildSide(join_type)) {
+			while (partition.build_collection->Scan(lstate.partition_scan_state, lstate.scan_chunk)) {
+				if (EmitUnmatchedBuildSide(*this, lstate.scan_chunk, lstate.match_sel, chunk)) {
+					return SourceResultType::HAVE_MORE_OUTPUT;
+				}
+			}
+		}
 
-			const auto lhs_col_count = probe_side_output_columns.size();
-			const auto rhs_col_count = build_side_output_columns.size();
+		// We are done with this partition, release it
+		lstate.probe_state.reset();
+		lstate.partition_rtree.reset();
+		partition.build_collection.reset();
+		partition.probe_collection.reset();
+		lstate.partition = nullptr;
+	}
 
-			// Null the LHS columns
-			for (idx_t i = 0; i < lhs_col_count; i++) {
-				auto &target = chunk.data[i];
-				target.SetVectorType(VectorType::CONSTANT_VECTOR);
-				ConstantVector::SetNull(target, true);
-			}
+	if (!PropagatesBuildSide(join_type)) {
+		return SourceResultType::FINISHED;
+	}
 
-			// Set the RHS columns
-			for (idx_t i = 0; i < rhs_col_count; i++) {
-				auto &target = chunk.data[lhs_col_count + i];
-				// Offset by one here to skip the match column
-				target.Slice(lstate.scan_chunk.data[i], lstate.match_sel, result_count);
-			}
+	// Emit the rows of the resident build side that did not match
+	const auto &tuples = gstate.op.op_state->Cast<SpatialJoinGlobalOperatorState>().collection;
+
+	while (tuples->Scan(gstate.scan_state, lstate.scan_state, lstate.scan_chunk)) {
+		gstate.tuples_scanned += lstate.scan_chunk.size();
 
-			chunk.SetCardinality(result_count);
+		if (EmitUnmatchedBuildSide(*this, lstate.scan_chunk, lstate.match_sel, chunk)) {
 			return SourceResultType::HAVE_MORE_OUTPUT;
 		}
 	}
@@ -1,6 +1,7 @@
 #pragma once
 #include "duckdb/execution/operator/join/physical_join.hpp"
 #include "duckdb/planner/operator/logical_join.hpp"
+#include "duckdb/planner/joinside.hpp"
 #include "duckdb/common/types/row/tuple_data_layout.hpp"
 
 namespace duckdb {
@@ -11,13 +12,29 @@ public:
 
 public:
 	PhysicalSpatialJoin(LogicalOperator &op, PhysicalOperator &left, PhysicalOperator &right,
-	                    unique_ptr<Expression> spatial_predicate, JoinType join_type, idx_t estimated_cardinality);
+	                    unique_ptr<Expression> spatial_predicate, vector<JoinCondition> equality_conditions,
+	                    vector<unique_ptr<Expression>> extra_conditions, JoinType join_type, double distance,
+	                    idx_t estimated_cardinality);
 
 	//! The condition of the join
 	unique_ptr<Expression> condition;
+	//! The distance to grow the build side bounding boxes by, non-zero for distance joins
+	double distance;
 	optional_ptr<Expression> build_side_key;
 	optional_ptr<Expression> probe_side_key;
 
+	//! Equality conditions between the two sides. If there are any, the build side is split into one R-Tree per hash
+	//! of the build side keys, and every probe side row only probes the R-Tree of its own key hash.
+	vector<JoinCondition> equality_conditions;
+	idx_t build_side_hash_offset = 0; // This is the byte offset to the hash of the equality keys in the layout
+
+	//! The conjunction of the extra conditions, evaluated on every pair that satisfies the spatial predicate.
+	//! It references a chunk holding the extra_probe_side_columns, followed by the extra_build_side_columns.
+	unique_ptr<Expression> extra_condition;
+	vector<LogicalType> extra_condition_types;
+	vector<column_t> extra_probe_side_columns; // The probe side input columns referenced by the extra condition
+	vector<column_t> extra_build_side_columns; // The layout columns referenced by the extra condition
+
 	vector<column_t> build_side_output_columns;
 	vector<column_t> probe_side_output_columns;
 	vector<column_t> build_side_payload_columns;
@@ -31,6 +48,21 @@ public:
 	shared_ptr<TupleDataLayout> layout;
 	idx_t build_side_match_offset = 0; // This is the byte offset to the match column for right/outer joins
 
+	//! Whether the build side can be split into partitions that are joined one at a time, if it does not fit in
+	//! memory. Probe side rows might be joined with multiple partitions, so this is not possible for LEFT/OUTER joins.
+	static bool CanPartitionBuildSide(JoinType join_type) {
+		return join_type == JoinType::INNER || join_type == JoinType::RIGHT;
+	}
+
+	bool HasEqualityConditions() const {
+		return !equality_conditions.empty();
+	}
+
+	//! SEMI, ANTI and MARK joins only output the probe side (and a match marker)
+	static bool ProjectsBuildSide(JoinType join_type) {
+		return join_type != JoinType::SEMI && join_type != JoinType::ANTI && join_type != JoinType::MARK;
+	}
+
 public:
 	// Operator Interface
 	unique_ptr<OperatorState> GetOperatorState(ExecutionContext &context) const override;
@@ -70,8 +102,10 @@ public:
 	SourceResultType GetData(ExecutionContext &context, DataChunk &chunk, OperatorSourceInput &input) const override;
 
 	bool IsSource() const override {
-		// The PhysicalSpatialJoin is only a source if the join type is RIGHT/OUTER
-		return PropagatesBuildSide(join_type);
+		// The PhysicalSpatialJoin is a source if the join type is RIGHT/OUTER, or if the build side might have to be
+		// partitioned. Whether it is, is only known once the build side has been sunk, so the source joins the
+		// partitions that are not resident (if any). Keyed joins are not partitioned (yet).
+		return PropagatesBuildSide(join_type) || (CanPartitionBuildSide(join_type) && !HasEqualityConditions());
 	}
 
 	bool ParallelSource() const override {
@@ -5,12 +5,14 @@
 #include "duckdb.hpp"
 #include "index/rtree/rtree.hpp"
 #include "spatial/index/rtree/rtree_module.hpp"
+#include "spatial/geometry/geometry_serialization.hpp"
 #include "spatial/modules/gdal/gdal_module.hpp"
 #if SPATIAL_USE_GEOS
 #include "spatial/modules/geos/geos_module.hpp"
 #endif
 #include "operators/spatial_operator_extension.hpp"
 #include "spatial/modules/main/spatial_functions.hpp"
+#include "spatial/modules/mvt/mvt_module.hpp"
 #include "spatial/modules/osm/osm_module.hpp"
 #include "spatial/modules/proj/proj_module.hpp"
 #include "spatial/modules/shapefile/shapefile_module.hpp"
@@ -26,6 +28,9 @@ static void LoadInternal(DatabaseInstance &instance) {
 	// Register the types
 	GeoTypes::Register(instance);
 
+	// Register the settings
+	SerdeFormat::RegisterSettings(instance);
+
 	RegisterSpatialCastFunctions(instance);
 	RegisterSpatialScalarFunctions(instance);
 	RegisterSpatialAggregateFunctions(instance);
@@ -38,6 +43,7 @@ static void LoadInternal(DatabaseInstance &instance) {
 #if SPATIAL_USE_GEOS
 	RegisterGEOSModule(instance);
 #endif
+	RegisterMapboxVectorTileModule(instance);
 	RegisterOSMModule(instance);
 	RegisterShapefileModule(instance);
 
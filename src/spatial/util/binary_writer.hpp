@@ -48,6 +48,10 @@ public:
 		return beg;
 	}
 
+	char *GetPtr() const {
+		return ptr;
+	}
+
 	char *GetEnd() const {
 		return end;
 	}